@@ -326,6 +326,17 @@ namespace Drill4dotNet
         }
     };
 
+    // Tells the profiler a test session has started or stopped.
+    class SessionChange
+    {
+    public:
+        // The session, which has started or stopped.
+        std::wstring sessionId;
+
+        // Whether the session has started.
+        bool isActive;
+    };
+
     // Determines whether the given functor can be
     // used as a source of classes tree.
     template <typename F>
@@ -342,6 +353,22 @@ namespace Drill4dotNet
         { f(prefixes) } -> std::same_as<void>;
     };
 
+    // Determines whether the given functor can be used
+    // as a handler of test sessions starting and stopping.
+    template <typename F>
+    concept IsSessionHandler = requires (F f, SessionChange change)
+    {
+        { f(change) } -> std::same_as<void>;
+    };
+
+    // Determines whether the given functor can be used as
+    // a source of the coverage sent when a test session stops.
+    template <typename F>
+    concept IsCoverageProvider = requires (const F& f)
+    {
+        { f() } -> std::same_as<std::vector<ExecClassData>>;
+    };
+
     // Determines whether the given type can be used for
     // communication between Drill admin and the profiler.
     template <typename T>
@@ -367,5 +394,7 @@ namespace Drill4dotNet
 
         { x.TreeProvider() } -> IsTreeProvider;
         { x.PackagesPrefixesHandler() } -> IsPackagesPrefixesHandler;
+        { x.SessionHandler() } -> IsSessionHandler;
+        { x.CoverageProvider() } -> IsCoverageProvider;
     };
 }
@@ -757,7 +757,9 @@ namespace Drill4dotNet
 
     template <
         IsTreeProvider TreeProvider,
-        IsPackagesPrefixesHandler PackagesPrefixesHandler>
+        IsPackagesPrefixesHandler PackagesPrefixesHandler,
+        IsSessionHandler SessionHandler,
+        IsCoverageProvider CoverageProvider>
     class Connector
     {
     protected:
@@ -765,6 +767,8 @@ namespace Drill4dotNet
 
         TreeProvider m_treeProvider;
         PackagesPrefixesHandler m_packagesPrefixesHandler;
+        SessionHandler m_sessionHandler;
+        CoverageProvider m_coverageProvider;
         std::queue<ConnectorQueueItem> m_messages;
         std::mutex m_mutex;
         Event m_event { NULL, TRUE, FALSE, NULL };
@@ -817,6 +821,10 @@ namespace Drill4dotNet
                     if (discriminator == StartSession::Discriminator)
                     {
                         StartSession startSession { messageText.get<StartSession>() };
+                        s_connector->m_sessionHandler(SessionChange {
+                            startSession.payload.startPayload.sessionId,
+                            true });
+
                         nlohmann::json startMessage = SessionStarted {
                             startSession.payload.startPayload.sessionId,
                             startSession.payload.startPayload.testType,
@@ -828,16 +836,13 @@ namespace Drill4dotNet
                     else if (discriminator == StopSession::Discriminator)
                     {
                         StopSession stopSession{ messageText.get<StopSession>() };
+                        s_connector->m_sessionHandler(SessionChange {
+                            stopSession.payload.sessionId,
+                            false });
+
                         nlohmann::json coverageDataPart = CoverDataPart{
                             stopSession.payload.sessionId,
-                            std::vector{
-                                ExecClassData{
-                                    .id = 0,
-                                    .className = L"my_path/my_name",
-                                    .probes = { true },
-                                    .testName = L"my_test"
-                                }
-                            }
+                            s_connector->m_coverageProvider()
                         };
 
                         s_connector->SendPluginMessage(
@@ -872,9 +877,13 @@ namespace Drill4dotNet
     public:
         Connector(
             TreeProvider treeProvider,
-            PackagesPrefixesHandler packagesPrefixesHandler)
+            PackagesPrefixesHandler packagesPrefixesHandler,
+            SessionHandler sessionHandler,
+            CoverageProvider coverageProvider)
             : m_treeProvider { std::move(treeProvider) },
-            m_packagesPrefixesHandler { std::move(packagesPrefixesHandler) }
+            m_packagesPrefixesHandler { std::move(packagesPrefixesHandler) },
+            m_sessionHandler { std::move(sessionHandler) },
+            m_coverageProvider { std::move(coverageProvider) }
         {
             s_connector = this;
         }
@@ -895,6 +904,16 @@ namespace Drill4dotNet
             return m_packagesPrefixesHandler;
         }
 
+        SessionHandler& SessionHandler() &
+        {
+            return m_sessionHandler;
+        }
+
+        CoverageProvider& CoverageProvider() &
+        {
+            return m_coverageProvider;
+        }
+
         void InitializeAgent()
         {
             std::wcout << "Connector::InitializeAgent start." << std::endl;
@@ -995,5 +1014,26 @@ namespace Drill4dotNet
         }
     };
 
-    static_assert(IsConnector<Connector<TrivialTreeProvider, TrivialPackagesPrefixesHandler>>);
+    class TrivialSessionHandler
+    {
+    public:
+        void operator()(const SessionChange change) const
+        {
+        }
+    };
+
+    class TrivialCoverageProvider
+    {
+    public:
+        std::vector<ExecClassData> operator()() const
+        {
+            return {};
+        }
+    };
+
+    static_assert(IsConnector<Connector<
+        TrivialTreeProvider,
+        TrivialPackagesPrefixesHandler,
+        TrivialSessionHandler,
+        TrivialCoverageProvider>>);
 }
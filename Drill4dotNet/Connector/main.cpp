@@ -64,6 +64,14 @@ int main(int argc, char** argv)
                 {
                     std::wcout << L'\t' << item << std::endl;
                 }
+            },
+            [](const SessionChange& change)
+            {
+                std::wcout
+                    << L"Session "
+                    << change.sessionId
+                    << (change.isActive ? L" started" : L" stopped")
+                    << std::endl;
             }
         };
 
@@ -0,0 +1,292 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory_resource>
+#include <random>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "Signature.h"
+
+// The benchmarks are disabled tests, named DISABLED_Benchmark*, so they
+// do not slow down the usual runs. To run them, use a release build and
+// --gtest_also_run_disabled_tests --gtest_filter=*Benchmark*
+namespace Drill4dotNet
+{
+    // Runs the action repeatedly for about the given time, after one
+    // warm-up run, and returns the average duration of one run, in
+    // nanoseconds.
+    // TAction : callable with no parameters.
+    // @param action : the code to measure.
+    // @param duration : how long to repeat the action.
+    template <typename TAction>
+    double MeasureNanoseconds(
+        TAction&& action,
+        const std::chrono::milliseconds duration = std::chrono::milliseconds { 300 })
+    {
+        using Clock = std::chrono::steady_clock;
+        action();
+
+        size_t runs { 0 };
+        const Clock::time_point start { Clock::now() };
+        Clock::duration elapsed {};
+        do
+        {
+            action();
+            ++runs;
+            elapsed = Clock::now() - start;
+        } while (elapsed < duration);
+
+        return std::chrono::duration<double, std::nano>(elapsed).count() / runs;
+    }
+
+    // Runs the action on the given count of threads at once, and returns
+    // the time from the start of the threads to the end of the last one,
+    // in nanoseconds.
+    // TAction : callable accepting size_t index of the thread.
+    // @param threadsCount : the count of threads to run.
+    // @param action : the code each thread runs.
+    template <typename TAction>
+    double MeasureThreadsNanoseconds(const size_t threadsCount, TAction&& action)
+    {
+        using Clock = std::chrono::steady_clock;
+        std::atomic<bool> isStarted { false };
+        std::vector<std::thread> threads {};
+        threads.reserve(threadsCount);
+        for (size_t i = 0; i != threadsCount; ++i)
+        {
+            threads.emplace_back([&isStarted, &action, i]()
+            {
+                while (!isStarted.load(std::memory_order_acquire))
+                {
+                    std::this_thread::yield();
+                }
+
+                action(i);
+            });
+        }
+
+        const Clock::time_point start { Clock::now() };
+        isStarted.store(true, std::memory_order_release);
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    }
+
+    // Keeps the given result observable, so the
+    // compiler cannot drop the code computing it.
+    // Can be called from several threads at once.
+    // @param value : the result to keep.
+    inline void KeepResult(const size_t value) noexcept
+    {
+        static volatile std::atomic<size_t> s_sink;
+        s_sink.store(value, std::memory_order_relaxed);
+    }
+
+    // Prints a measured value to the test output.
+    // @param name : what was measured.
+    // @param value : the measured value.
+    // @param unit : the unit of the value.
+    inline void ReportBenchmark(const std::string_view name, const double value, const std::string_view unit)
+    {
+        std::cout << "[ BENCHMARK ] " << name << ": " << value << ' ' << unit << std::endl;
+    }
+
+    // Takes memory from the heap, counting the allocations
+    // and the bytes in use.
+    class CountingResource final : public std::pmr::memory_resource
+    {
+    private:
+        // The amount of allocations done.
+        size_t m_allocationsCount { 0 };
+
+        // The amount of bytes allocated and not freed.
+        size_t m_bytesInUse { 0 };
+
+        void* do_allocate(const size_t bytes, const size_t alignment) override
+        {
+            ++m_allocationsCount;
+            m_bytesInUse += bytes;
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void* const pointer, const size_t bytes, const size_t alignment) override
+        {
+            m_bytesInUse -= bytes;
+            std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+        {
+            return this == &other;
+        }
+
+    public:
+        // Gets the amount of allocations done.
+        size_t AllocationsCount() const noexcept
+        {
+            return m_allocationsCount;
+        }
+
+        // Gets the amount of bytes allocated and not freed.
+        size_t BytesInUse() const noexcept
+        {
+            return m_bytesInUse;
+        }
+    };
+
+    // The token of the method called by the methods of MakeMethodCorpus().
+    inline constexpr mdToken s_CorpusCallee { 0x06000001 };
+
+    // Gets the signature of the method called by the methods of
+    // MakeMethodCorpus(): static void ().
+    inline MethodSignature CorpusCallSignature(const mdToken)
+    {
+        const std::vector<std::byte> bytes { std::byte { 0x00 }, std::byte { 0x00 }, std::byte { 0x01 } };
+        return MethodSignature::Parse(bytes.cbegin(), bytes.cend()).ParsedValue;
+    }
+
+    // Generates a method body with a fat header and no exception clauses.
+    // The code is a sequence of pieces each leaving the stack empty:
+    // arithmetic, calls of s_CorpusCallee, forward and backward
+    // conditional branches and switches, all jumping to the piece starts,
+    // so the stack depth is the same on all paths.
+    // @param pieces : the count of the pieces.
+    // @param random : the source of the choices.
+    inline std::vector<std::byte> MakeCorpusMethod(const size_t pieces, std::minstd_rand& random)
+    {
+        std::vector<std::byte> code {};
+        std::vector<size_t> pieceStarts {};
+
+        // Places of the 4-byte jump offsets, with the pieces they target,
+        // and the ends of the instructions the offsets are counted from.
+        struct Fixup
+        {
+            size_t Position;
+            size_t Target;
+            size_t InstructionEnd;
+        };
+
+        std::vector<Fixup> fixups {};
+        const auto emit = [&code](const std::initializer_list<int> bytes)
+        {
+            for (const int value : bytes)
+            {
+                code.push_back(static_cast<std::byte>(value));
+            }
+        };
+
+        const auto emitInt32 = [&code](const uint32_t value)
+        {
+            for (int shift = 0; shift != 32; shift += 8)
+            {
+                code.push_back(static_cast<std::byte>(value >> shift));
+            }
+        };
+
+        const auto forward = [&random, pieces](const size_t piece)
+        {
+            return std::min(pieces, piece + 1 + random() % 8);
+        };
+
+        for (size_t piece = 0; piece != pieces; ++piece)
+        {
+            pieceStarts.push_back(code.size());
+            switch (random() % 16)
+            {
+            case 0: case 1: case 2: case 3:
+                emit({ 0x02, 0x17, 0x58, 0x26 }); // ldarg.0; ldc.i4.1; add; pop
+                break;
+            case 4: case 5:
+                emit({ 0x20 }); // ldc.i4 value; pop
+                emitInt32(static_cast<uint32_t>(random()));
+                emit({ 0x26 });
+                break;
+            case 6: case 7:
+                emit({ 0x28 }); // call s_CorpusCallee
+                emitInt32(s_CorpusCallee);
+                break;
+            case 8:
+                emit({ 0x00 }); // nop
+                break;
+            case 9: case 10: case 11:
+                emit({ 0x02, 0x3A }); // ldarg.0; brtrue forward
+                fixups.push_back({ code.size(), forward(piece), code.size() + 4 });
+                emitInt32(0);
+                break;
+            case 12:
+                emit({ 0x02, 0x39 }); // ldarg.0; brfalse backward
+                fixups.push_back({ code.size(), piece - random() % (piece + 1), code.size() + 4 });
+                emitInt32(0);
+                break;
+            case 13:
+            {
+                emit({ 0x02, 0x45 }); // ldarg.0; switch of 3 forward targets
+                emitInt32(3);
+                const size_t instructionEnd { code.size() + 3 * 4 };
+                for (int i = 0; i != 3; ++i)
+                {
+                    fixups.push_back({ code.size(), forward(piece), instructionEnd });
+                    emitInt32(0);
+                }
+
+                break;
+            }
+            default:
+                emit({ 0x02, 0x02, 0xFE, 0x01, 0x26 }); // ldarg.0; ldarg.0; ceq; pop
+                break;
+            }
+        }
+
+        pieceStarts.push_back(code.size());
+        emit({ 0x2A }); // ret
+
+        for (const Fixup& fixup : fixups)
+        {
+            const auto offset { static_cast<int32_t>(pieceStarts[fixup.Target] - fixup.InstructionEnd) };
+            for (int i = 0; i != 4; ++i)
+            {
+                code[fixup.Position + i] = static_cast<std::byte>(static_cast<uint32_t>(offset) >> (8 * i));
+            }
+        }
+
+        std::vector<std::byte> result {
+            std::byte { 0x13 }, std::byte { 0x30 }, // fat header flags and size
+            std::byte { 0x02 }, std::byte { 0x00 } }; // max stack
+        for (int shift = 0; shift != 32; shift += 8)
+        {
+            result.push_back(static_cast<std::byte>(code.size() >> shift));
+        }
+
+        result.insert(result.end(), 4, std::byte { 0x00 }); // local variables
+        result.insert(result.end(), code.cbegin(), code.cend());
+        return result;
+    }
+
+    // Generates the same set of method bodies on each call, for the
+    // benchmarks to compare. The sizes are mostly small, as in usual
+    // assemblies, with a few methods of several hundred instructions.
+    // @param count : the count of the methods.
+    inline std::vector<std::vector<std::byte>> MakeMethodCorpus(const size_t count = 1000)
+    {
+        std::minstd_rand random { 20200601 };
+        std::vector<std::vector<std::byte>> result {};
+        result.reserve(count);
+        for (size_t i = 0; i != count; ++i)
+        {
+            const size_t pieces { i % 20 == 0
+                ? 100 + random() % 200
+                : 2 + random() % 40 };
+            result.push_back(MakeCorpusMethod(pieces, random));
+        }
+
+        return result;
+    }
+}
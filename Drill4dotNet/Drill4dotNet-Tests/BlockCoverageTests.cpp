@@ -0,0 +1,246 @@
+#include "pch.h"
+
+#include "Benchmark.h"
+#include "BlockCoverage.h"
+#include "ProbeArray.h"
+
+using namespace Drill4dotNet;
+
+// Creates method body representing
+// public static int F(bool x)
+// {
+//     return x ? 1 : 0;
+// }
+static std::vector<std::byte> CreateIfElseFunction()
+{
+    return {
+        std::byte { 0x22 }, // tiny header, 8 bytes of code
+        std::byte { 0x02 }, // ldarg.0
+        std::byte { 0x2C }, // brfalse.s ELSE
+        std::byte { 0x03 },
+        std::byte { 0x17 }, // ldc.i4.1
+        std::byte { 0x2B }, // br.s END
+        std::byte { 0x01 },
+        std::byte { 0x16 }, // ELSE: ldc.i4.0
+        std::byte { 0x2A }  // END: ret
+    };
+}
+
+// Creates method body representing
+//     br.s CONDITION
+// BODY:
+//     nop
+// CONDITION:
+//     ldarg.0
+//     brtrue.s BODY
+//     ret
+static std::vector<std::byte> CreateLoopFunction()
+{
+    return {
+        std::byte { 0x1E }, // tiny header, 7 bytes of code
+        std::byte { 0x2B }, // br.s CONDITION
+        std::byte { 0x01 },
+        std::byte { 0x00 }, // BODY: nop
+        std::byte { 0x02 }, // CONDITION: ldarg.0
+        std::byte { 0x2D }, // brtrue.s BODY
+        std::byte { 0xFC },
+        std::byte { 0x2A }  // ret
+    };
+}
+
+// Checks a method without jumps gets one probe.
+TEST(BlockCoverageTests, StraightLineHasOneProbe)
+{
+    // Arrange
+    const std::vector<std::byte> bodyBytes {
+        std::byte { 0x0E }, // tiny header, 3 bytes of code
+        std::byte { 0x00 }, // nop
+        std::byte { 0x00 }, // nop
+        std::byte { 0x2A }  // ret
+    };
+
+    const MethodBody method(bodyBytes);
+    const ControlFlowGraph graph { method };
+
+    // Act
+    const BlockCoveragePlan plan { graph };
+
+    // Assert
+    EXPECT_EQ(1, plan.BlocksCount());
+    EXPECT_EQ((std::vector<BlockIndex> { 0 }), plan.ProbedBlocks());
+    EXPECT_EQ((std::vector<bool> { true }), plan.ReconstructCoverage({ true }));
+}
+
+// Checks the block branching to both arms of if-else
+// gets no probe, and is covered if any arm is covered.
+TEST(BlockCoverageTests, IfElseSkipsBranchingBlock)
+{
+    // Arrange
+    const MethodBody method(CreateIfElseFunction());
+    const ControlFlowGraph graph { method };
+
+    // Act
+    const BlockCoveragePlan plan { graph };
+
+    // Assert
+    EXPECT_EQ(4, plan.BlocksCount());
+    EXPECT_EQ((std::vector<BlockIndex> { 1, 2, 3 }), plan.ProbedBlocks());
+    EXPECT_EQ((std::vector<bool> { true, true, false, true }), plan.ReconstructCoverage({ true, false, true }));
+    EXPECT_EQ((std::vector<bool> { true, false, true, false }), plan.ReconstructCoverage({ false, true, false }));
+    EXPECT_EQ((std::vector<bool> { false, false, false, false }), plan.ReconstructCoverage({ false, false, false }));
+}
+
+// Checks the loop condition, which dominates both the loop body
+// and the exit, is covered by the probe of the exit.
+TEST(BlockCoverageTests, LoopConditionIsInferred)
+{
+    // Arrange
+    const MethodBody method(CreateLoopFunction());
+    const ControlFlowGraph graph { method };
+
+    // Act
+    const BlockCoveragePlan plan { graph };
+
+    // Assert
+    EXPECT_EQ((std::vector<BlockIndex> { 1, 3 }), plan.ProbedBlocks());
+    EXPECT_EQ((std::vector<bool> { true, false, true, true }), plan.ReconstructCoverage({ false, true }));
+    EXPECT_EQ((std::vector<bool> { true, true, true, true }), plan.ReconstructCoverage({ true, true }));
+}
+
+// Checks std::logic_error is thrown if the count
+// of probe hits differs from the count of probes.
+TEST(BlockCoverageTests, ReconstructThrowsOnWrongProbesCount)
+{
+    // Arrange
+    const MethodBody method(CreateLoopFunction());
+    const ControlFlowGraph graph { method };
+    const BlockCoveragePlan plan { graph };
+
+    // Assert
+    EXPECT_THROW(plan.ReconstructCoverage({ true }), std::logic_error);
+}
+
+// Checks probes are inserted after the labels of their
+// blocks, so the jumps to the blocks execute the probes.
+TEST(BlockCoverageTests, InsertProbesAfterLabels)
+{
+    // Arrange
+    MethodBody method(CreateIfElseFunction());
+    const ControlFlowGraph graph { method };
+    const BlockCoveragePlan plan { graph };
+    const std::vector<std::byte> expectedBytes {
+        std::byte { 0x2E }, // tiny header, 11 bytes of code
+        std::byte { 0x02 }, // ldarg.0
+        std::byte { 0x2C }, // brfalse.s ELSE
+        std::byte { 0x04 },
+        std::byte { 0x00 }, // probe
+        std::byte { 0x17 }, // ldc.i4.1
+        std::byte { 0x2B }, // br.s END
+        std::byte { 0x02 },
+        std::byte { 0x00 }, // ELSE: probe
+        std::byte { 0x16 }, // ldc.i4.0
+        std::byte { 0x00 }, // END: probe
+        std::byte { 0x2A }  // ret
+    };
+
+    std::vector<size_t> probesMade {};
+
+    // Act
+    plan.InsertProbes(
+        method,
+        graph,
+        [&probesMade](const size_t probe)
+        {
+            probesMade.push_back(probe);
+            return std::vector<OpCodeVariant> { OpCode::CEE_NOP{} };
+        });
+
+    // Assert
+    EXPECT_EQ((std::vector<size_t> { 0, 1, 2 }), probesMade);
+    EXPECT_FALSE(method.IsEditInProgress());
+    EXPECT_EQ(expectedBytes, method.Compile());
+}
+
+// Inserts native probes into the given method, either where
+// the plan puts them, or at the start of each block, and
+// returns the size of the compiled method.
+// @param bodyBytes : the method body bytes.
+// @param everyBlock : whether to put a probe into each block.
+static size_t InstrumentedSize(const std::vector<std::byte>& bodyBytes, const bool everyBlock)
+{
+    constexpr uint64_t address { 0x7FF012345678 };
+    MethodBody method(bodyBytes);
+    const ControlFlowGraph graph { method };
+    if (everyBlock)
+    {
+        method.BeginEdit();
+        for (const BasicBlock& block : graph.Blocks())
+        {
+            const ConstStreamPosition position { SkipLabels(method.begin() + block.Begin, method.end()) };
+            for (const OpCodeVariant& instruction : MakeNativeProbe(address, 8))
+            {
+                method.Insert(position, instruction);
+            }
+        }
+
+        method.CommitEdit();
+    }
+    else
+    {
+        const BlockCoveragePlan plan { graph };
+        plan.InsertProbes(
+            method,
+            graph,
+            [](const size_t)
+            {
+                return MakeNativeProbe(address, 8);
+            });
+    }
+
+    return method.Compile().size();
+}
+
+// Measures the probes per method and the code growth with the
+// probes the plan chooses, compared with a probe in each block.
+TEST(BlockCoverageTests, DISABLED_BenchmarkProbesPerMethod)
+{
+    size_t blocksCount { 0 };
+    size_t probesCount { 0 };
+    size_t originalSize { 0 };
+    size_t plannedSize { 0 };
+    size_t everyBlockSize { 0 };
+    const std::vector<std::vector<std::byte>> corpus { MakeMethodCorpus() };
+    for (const std::vector<std::byte>& bytes : corpus)
+    {
+        const MethodBody method(bytes);
+        const BlockCoveragePlan plan { ControlFlowGraph { method } };
+        blocksCount += plan.BlocksCount();
+        probesCount += plan.ProbedBlocks().size();
+        originalSize += bytes.size();
+        plannedSize += InstrumentedSize(bytes, false);
+        everyBlockSize += InstrumentedSize(bytes, true);
+    }
+
+    const double planned { MeasureNanoseconds([&corpus]()
+    {
+        for (const std::vector<std::byte>& bytes : corpus)
+        {
+            KeepResult(InstrumentedSize(bytes, false));
+        }
+    }) };
+
+    const double everyBlock { MeasureNanoseconds([&corpus]()
+    {
+        for (const std::vector<std::byte>& bytes : corpus)
+        {
+            KeepResult(InstrumentedSize(bytes, true));
+        }
+    }) };
+
+    ReportBenchmark("probes, planned", static_cast<double>(probesCount) / corpus.size(), "per method");
+    ReportBenchmark("probes, every block", static_cast<double>(blocksCount) / corpus.size(), "per method");
+    ReportBenchmark("code growth, planned", 100.0 * (plannedSize - originalSize) / originalSize, "%");
+    ReportBenchmark("code growth, every block", 100.0 * (everyBlockSize - originalSize) / originalSize, "%");
+    ReportBenchmark("instrumentation, planned", planned / corpus.size(), "ns per method");
+    ReportBenchmark("instrumentation, every block", everyBlock / corpus.size(), "ns per method");
+}
@@ -1,5 +1,6 @@
 #include "pch.h"
 
+#include "Benchmark.h"
 #include "ByteUtils.h"
 
 using namespace Drill4dotNet;
@@ -76,6 +77,133 @@ TEST(ByteUtilsTests, Overflows)
     EXPECT_TRUE(overflows);
 }
 
+TEST(ByteUtilsTests, ByteWriterAppendsWithByteOrder)
+{
+    // Arrange
+    const std::vector<std::byte> expectedBytes
+    {
+        std::byte{ 0x2A },
+        std::byte{ 0xB5 },
+        std::byte{ 0xBD },
+        std::byte{ 0x34 },
+        std::byte{ 0x07 },
+        std::byte{ 0x07 },
+        std::byte{ 0x34 },
+        std::byte{ 0xBD },
+        std::byte{ 0xB5 },
+        std::byte{ 0x00 },
+        std::byte{ 0x00 },
+        std::byte{ 0x00 }
+    };
+
+    std::vector<std::byte> bytes{};
+    ByteWriter writer{ bytes };
+
+    // Act
+    writer.Reserve(expectedBytes.size());
+    writer.Write(std::byte{ 0x2A });
+    writer.Write(uint32_t{ 0x0734BDB5 });
+    writer.Write<ByteOrder::BigEndian>(uint32_t{ 0x0734BDB5 });
+    writer.AlignTo<4>();
+
+    // Assert
+    EXPECT_EQ(expectedBytes, bytes);
+    EXPECT_EQ(expectedBytes.size(), writer.Written());
+}
+
+TEST(ByteUtilsTests, ByteWriterThrowsOnFullBuffer)
+{
+    // Arrange
+    std::array<std::byte, 6> buffer{};
+    ByteWriter writer{ std::span<std::byte>{ buffer } };
+    writer.Write(uint32_t{ 0x0734BDB5 });
+
+    // Act & Assert
+    EXPECT_THROW(
+        writer.Write(uint32_t{ 0x0734BDB5 }),
+        std::overflow_error);
+    EXPECT_EQ(4, writer.Written());
+}
+
+TEST(ByteUtilsTests, ByteReaderReadsWithByteOrder)
+{
+    // Arrange
+    const std::vector<std::byte> bytes
+    {
+        std::byte{ 0xB5 },
+        std::byte{ 0xBD },
+        std::byte{ 0x34 },
+        std::byte{ 0x07 },
+        std::byte{ 0x07 },
+        std::byte{ 0x34 },
+        std::byte{ 0xBD }
+    };
+
+    ByteReader reader{ bytes };
+
+    // Act
+    const uint32_t littleEndian{ reader.Read<uint32_t>() };
+    const uint16_t bigEndian{ reader.Read<uint16_t, ByteOrder::BigEndian>() };
+    const std::byte next{ reader.Peek() };
+
+    // Assert
+    EXPECT_EQ(0x0734BDB5, littleEndian);
+    EXPECT_EQ(0x0734, bigEndian);
+    EXPECT_EQ(std::byte{ 0xBD }, next);
+    EXPECT_EQ(6, reader.Position());
+    EXPECT_EQ(1, reader.Remaining());
+    EXPECT_THROW(reader.Read<uint16_t>(), std::runtime_error);
+}
+
+// Appends the bytes of the value one at a time,
+// as AppendAsBytes did before ByteWriter.
+template <typename T>
+static void AppendByteByByte(std::vector<std::byte>& target, const T& value)
+{
+    const auto bytes{ reinterpret_cast<const std::byte*>(&value) };
+    for (size_t i = 0; i != sizeof(T); ++i)
+    {
+        target.push_back(bytes[i]);
+    }
+}
+
+// Measures the bytes per second written by ByteWriter, and by
+// appending byte by byte, for the mix of values of the instructions.
+TEST(ByteUtilsTests, DISABLED_BenchmarkByteWriterThroughput)
+{
+    constexpr size_t valuesCount{ 100000 };
+    constexpr size_t bytesCount{ valuesCount / 4 * (1 + 2 + 4 + 8) };
+    std::vector<std::byte> bytes{};
+    const auto writeAll = [&bytes](const auto& write)
+    {
+        bytes.clear();
+        for (uint32_t i = 0; i != valuesCount / 4; ++i)
+        {
+            write(static_cast<uint8_t>(i));
+            write(static_cast<uint16_t>(i));
+            write(i);
+            write(uint64_t{ i } << 20);
+        }
+
+        KeepResult(bytes.size());
+    };
+
+    const double byteByByte{ MeasureNanoseconds([&bytes, &writeAll]()
+    {
+        writeAll([&bytes](const auto value) { AppendByteByByte(bytes, value); });
+    }) };
+
+    const double byteWriter{ MeasureNanoseconds([&bytes, &writeAll]()
+    {
+        ByteWriter writer{ bytes };
+        writer.Reserve(bytesCount);
+        writeAll([&writer](const auto value) { writer.Write(value); });
+    }) };
+
+    ReportBenchmark("byte by byte", bytesCount / byteByByte * 1e3, "MB/s");
+    ReportBenchmark("ByteWriter", bytesCount / byteWriter * 1e3, "MB/s");
+}
+
 static_assert(!Overflows<int8_t>(int8_t{ 0 }));
 static_assert(!Overflows<int>(int{ 0 }));
 static_assert(!Overflows<uint8_t>(uint8_t{ 0 }));
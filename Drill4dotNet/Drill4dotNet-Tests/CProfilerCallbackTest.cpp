@@ -1,4 +1,5 @@
 #include "pch.h"
+#include "Benchmark.h"
 #include "ComWrapperBase.h"
 #include "CoreInteractMock.h"
 #include "MetaDataAssemblyImportMock.h"
@@ -54,9 +55,15 @@ TEST_F(CProfilerCallbackTest, Initialize_Shutdown)
         TrivialLogger logger)
     {
         EXPECT_CALL(corInteractMock, TryGetRuntimeInformation()).WillOnce(Return(rti_expected));
-        EXPECT_CALL(corInteractMock, SetEventMask(_)).WillOnce(Return());
-        EXPECT_CALL(corInteractMock, SetEnterLeaveFunctionHooks(_,_,_)).WillOnce(Return());
-        EXPECT_CALL(corInteractMock, SetFunctionIDMapper(_)).WillOnce(Return());
+        // The calls are counted by the instrumented bodies,
+        // so no function is hooked, see EVENTS_WE_MONITOR.
+        EXPECT_CALL(corInteractMock, SetEventMask(Truly([](const uint32_t eventMask)
+        {
+            return (eventMask & COR_PRF_MONITOR_ENTERLEAVE) == 0
+                && (eventMask & COR_PRF_ENABLE_REJIT) != 0;
+        }))).WillOnce(Return());
+        EXPECT_CALL(corInteractMock, SetEnterLeaveFunctionHooks(_,_,_)).Times(0);
+        EXPECT_CALL(corInteractMock, SetFunctionIDMapper(_)).Times(0);
     }) };
 
     const InjectionMetaData expectedInjection { 0x69'6D'71'EF, 0x9A'F0'D6'D8, 0xE9'C2'80'22 };
@@ -78,6 +85,10 @@ TEST_F(CProfilerCallbackTest, Initialize_Shutdown)
 
     std::function<std::vector<AstEntity>()> treeProvider{};
     EXPECT_CALL(proClient->GetConnector(), TreeProvider()).WillOnce(ReturnRef(treeProvider));
+    std::function<void(const SessionChange&)> sessionHandler{};
+    EXPECT_CALL(proClient->GetConnector(), SessionHandler()).WillOnce(ReturnRef(sessionHandler));
+    std::function<std::vector<ExecClassData>()> coverageProvider{};
+    EXPECT_CALL(proClient->GetConnector(), CoverageProvider()).WillOnce(ReturnRef(coverageProvider));
 
     IUnknown* p = reinterpret_cast<IUnknown*>(this);
     EXPECT_HRESULT_SUCCEEDED(profilerCallback->Initialize(p));
@@ -87,7 +98,541 @@ TEST_F(CProfilerCallbackTest, Initialize_Shutdown)
     EXPECT_EQ(expectedInjection.Assembly, actualInjection.Assembly);
     EXPECT_EQ(expectedInjection.Class, actualInjection.Class);
     EXPECT_EQ(expectedInjection.Function, actualInjection.Function);
+    EXPECT_TRUE(static_cast<bool>(coverageProvider));
 
     EXPECT_HRESULT_SUCCEEDED(profilerCallback->Shutdown());
     EXPECT_FALSE(profilerCallback->GetCorProfilerInfo().has_value());
 }
+
+// Does what the first block coverage probe of the
+// instrumented method does, when it is executed.
+// @param instrumentedBody : the instrumented method.
+static void ExecuteFirstProbe(const std::vector<std::byte>& instrumentedBody)
+{
+    const MethodBody method(instrumentedBody);
+    for (const auto& item : method)
+    {
+        if (const OpCodeVariant* const instruction { std::get_if<OpCodeVariant>(&item) }
+            ; instruction != nullptr)
+        {
+            if (const auto load { instruction->GetIf<OpCode::CEE_LDC_I8>() }; load.has_value())
+            {
+                *reinterpret_cast<std::byte*>(static_cast<uintptr_t>(load->Argument())) = std::byte { 1 };
+                return;
+            }
+
+            if (const auto load { instruction->GetIf<OpCode::CEE_LDC_I4>() }; load.has_value())
+            {
+                *reinterpret_cast<std::byte*>(static_cast<uintptr_t>(static_cast<uint32_t>(load->Argument()))) = std::byte { 1 };
+                return;
+            }
+        }
+    }
+}
+
+// Does what all block coverage probes of the instrumented method
+// do, when they are executed: stores 1 to the address each probe
+// loads. The probes are found by the load of the address followed
+// by conv.u. Returns the count of the probes executed.
+// @param instrumentedBody : the instrumented method.
+static size_t ExecuteAllProbes(const std::vector<std::byte>& instrumentedBody)
+{
+    const MethodBody method(instrumentedBody);
+    size_t executed { 0 };
+    std::optional<uintptr_t> address {};
+    for (const auto& item : method)
+    {
+        const OpCodeVariant* const instruction { std::get_if<OpCodeVariant>(&item) };
+        if (instruction == nullptr)
+        {
+            continue;
+        }
+
+        if (address.has_value() && instruction->GetIf<OpCode::CEE_CONV_U>().has_value())
+        {
+            *reinterpret_cast<std::byte*>(*address) = std::byte { 1 };
+            ++executed;
+        }
+
+        address.reset();
+        if (const auto load { instruction->GetIf<OpCode::CEE_LDC_I8>() }; load.has_value())
+        {
+            address = static_cast<uintptr_t>(load->Argument());
+        }
+        else if (const auto load { instruction->GetIf<OpCode::CEE_LDC_I4>() }; load.has_value())
+        {
+            address = static_cast<uintptr_t>(static_cast<uint32_t>(load->Argument()));
+        }
+    }
+
+    return executed;
+}
+
+// Checks the ReJIT is requested once for the methods,
+// all block coverage probes of which have been hit,
+// and their original bodies are given for the ReJIT.
+TEST(RetireFullyCoveredMethodsTest, RequestsReJitOnce)
+{
+    // Arrange
+    const CoreInteractMock corProfilerInfo { static_cast<IUnknown*>(nullptr), TrivialLogger {} };
+    CoverageRegistry coverage {};
+    coverage.StartSession();
+    const MethodKey covered { 0x1000, 0x06000001 };
+    const MethodKey notCovered { 0x1000, 0x06000002 };
+    const std::vector<std::byte> body {
+        std::byte { 0x06 }, // tiny header, 1 byte of code
+        std::byte { 0x2A }  // ret
+    };
+
+    const auto noCalls { [](const mdToken) -> MethodSignature
+    {
+        throw std::logic_error("No calls expected");
+    } };
+
+    ExecuteFirstProbe(coverage.Instrument(covered, body, noCalls));
+    coverage.Instrument(notCovered, body, noCalls);
+
+    EXPECT_CALL(
+        corProfilerInfo,
+        RequestReJIT(std::vector<ModuleID> { covered.Module }, std::vector<mdMethodDef> { covered.Method }))
+        .WillOnce(Return());
+
+    // Act
+    const std::vector<MethodKey> first { RetireFullyCoveredMethods(corProfilerInfo, coverage) };
+    const std::vector<MethodKey> second { RetireFullyCoveredMethods(corProfilerInfo, coverage) };
+
+    // Assert
+    EXPECT_EQ(std::vector<MethodKey> { covered }, first);
+    EXPECT_TRUE(second.empty());
+    EXPECT_EQ(body, coverage.CurrentBody(covered, noCalls));
+    EXPECT_NE(body, coverage.CurrentBody(notCovered, noCalls));
+}
+
+// Measures the retirement step the admin thread runs each second,
+// RetireFullyCoveredMethods with the ReJIT requested through the mock,
+// over the instrumented corpus methods: while none of them is fully
+// covered, and when all of them are, which happens once for each
+// method. Also reports the probes executed to cover the methods,
+// and the code of the methods before and after they are retired.
+TEST(RetireFullyCoveredMethodsTest, DISABLED_BenchmarkRetirement)
+{
+    constexpr size_t rounds { 20 };
+    const std::vector<std::vector<std::byte>> corpus { MakeMethodCorpus() };
+    const CoreInteractMock corProfilerInfo { static_cast<IUnknown*>(nullptr), TrivialLogger {} };
+    size_t reJitRequested { 0 };
+    EXPECT_CALL(corProfilerInfo, RequestReJIT(_, _))
+        .WillRepeatedly(Invoke([&reJitRequested](const std::vector<ModuleID>& moduleIds, const std::vector<mdMethodDef>&)
+        {
+            reJitRequested += moduleIds.size();
+        }));
+
+    double noneCovered { 0.0 };
+    std::chrono::duration<double, std::nano> allCovered { 0.0 };
+    size_t probesExecuted { 0 };
+    size_t instrumentedSize { 0 };
+    size_t retiredSize { 0 };
+    for (size_t round = 0; round != rounds; ++round)
+    {
+        CoverageRegistry coverage {};
+        coverage.StartSession();
+        std::vector<MethodKey> keys {};
+        std::vector<std::vector<std::byte>> instrumented {};
+        for (size_t i = 0; i != corpus.size(); ++i)
+        {
+            keys.push_back(MethodKey { 0x1000, static_cast<mdToken>(0x06000001 + i) });
+            instrumented.push_back(coverage.Instrument(keys.back(), corpus[i], CorpusCallSignature));
+        }
+
+        if (round == 0)
+        {
+            noneCovered = MeasureNanoseconds([&corProfilerInfo, &coverage]()
+            {
+                KeepResult(RetireFullyCoveredMethods(corProfilerInfo, coverage).size());
+            });
+
+            for (const std::vector<std::byte>& body : instrumented)
+            {
+                probesExecuted += ExecuteAllProbes(body);
+                instrumentedSize += body.size();
+            }
+        }
+        else
+        {
+            for (const std::vector<std::byte>& body : instrumented)
+            {
+                ExecuteAllProbes(body);
+            }
+        }
+
+        const auto start { std::chrono::steady_clock::now() };
+        const std::vector<MethodKey> retired { RetireFullyCoveredMethods(corProfilerInfo, coverage) };
+        allCovered += std::chrono::steady_clock::now() - start;
+
+        EXPECT_EQ(corpus.size(), retired.size());
+        if (round == 0)
+        {
+            for (const MethodKey key : keys)
+            {
+                retiredSize += coverage.CurrentBody(key, CorpusCallSignature)->size();
+            }
+        }
+    }
+
+    EXPECT_EQ(corpus.size() * rounds, reJitRequested);
+    ReportBenchmark("retirement step, none covered", noneCovered / corpus.size(), "ns per method");
+    ReportBenchmark("retirement step, all covered", allCovered.count() / rounds / corpus.size(), "ns per method");
+    ReportBenchmark("probes executed to cover", static_cast<double>(probesExecuted) / corpus.size(), "per method");
+    ReportBenchmark("code, instrumented", static_cast<double>(instrumentedSize) / corpus.size(), "bytes per method");
+    ReportBenchmark("code, retired", static_cast<double>(retiredSize) / corpus.size(), "bytes per method");
+}
+
+// Checks starting a session requests the ReJIT of the instrumented
+// methods with the probes, and stopping it requests the ReJIT of
+// the same methods with their original bodies.
+TEST(SwitchCoverageSessionTest, RequestsReJitOnStartAndStop)
+{
+    // Arrange
+    const CoreInteractMock corProfilerInfo { static_cast<IUnknown*>(nullptr), TrivialLogger {} };
+    CoverageRegistry coverage {};
+    const MethodKey method { 0x1000, 0x06000001 };
+    const std::vector<std::byte> body {
+        std::byte { 0x06 }, // tiny header, 1 byte of code
+        std::byte { 0x2A }  // ret
+    };
+
+    const auto noCalls { [](const mdToken) -> MethodSignature
+    {
+        throw std::logic_error("No calls expected");
+    } };
+
+    coverage.Instrument(method, body, noCalls);
+
+    EXPECT_CALL(
+        corProfilerInfo,
+        RequestReJIT(std::vector<ModuleID> { method.Module }, std::vector<mdMethodDef> { method.Method }))
+        .Times(2);
+
+    // Act
+    const std::vector<MethodKey> started { SwitchCoverageSession(corProfilerInfo, coverage, true) };
+    const std::optional<std::vector<std::byte>> bodyInSession { coverage.CurrentBody(method, noCalls) };
+    const std::vector<MethodKey> stopped { SwitchCoverageSession(corProfilerInfo, coverage, false) };
+
+    // Assert
+    EXPECT_EQ(std::vector<MethodKey> { method }, started);
+    EXPECT_NE(body, bodyInSession);
+    EXPECT_EQ(std::vector<MethodKey> { method }, stopped);
+    EXPECT_EQ(body, coverage.CurrentBody(method, noCalls));
+}
+
+// Checks the coverage sent when a session stops has the coverage
+// of the blocks of each instrumented method, with the name of
+// the assembly and the class of the method.
+TEST(MakeSessionCoverageTest, GivesCoverageOfInstrumentedMethods)
+{
+    // Arrange
+    const CoreInteractMock corProfilerInfo { static_cast<IUnknown*>(nullptr), TrivialLogger {} };
+    const std::shared_ptr<const MetadataImportMock> metadataImport {
+        std::make_shared<const MetadataImportMock>(TrivialLogger {}) };
+    CoverageRegistry coverage {};
+    coverage.StartSession();
+    const MethodKey covered { 0x1000, 0x06000001 };
+    const MethodKey notCovered { 0x1000, 0x06000002 };
+    const std::vector<std::byte> body {
+        std::byte { 0x06 }, // tiny header, 1 byte of code
+        std::byte { 0x2A }  // ret
+    };
+
+    const auto noCalls { [](const mdToken) -> MethodSignature
+    {
+        throw std::logic_error("No calls expected");
+    } };
+
+    ExecuteFirstProbe(coverage.Instrument(covered, body, noCalls));
+    coverage.Instrument(notCovered, body, noCalls);
+    coverage.StopSession();
+
+    const mdTypeDef program { 0x02000002 };
+    EXPECT_CALL(corProfilerInfo, GetModuleInfo(covered.Module))
+        .WillRepeatedly(Return(ModuleInfo { .name = L"C:\\HelloWorld\\HelloWorld.dll" }));
+    EXPECT_CALL(*metadataImport, GetMethodProps(covered.Method))
+        .WillOnce(Return(MethodProps { .EnclosingClass = program, .Name = L"Main" }));
+    EXPECT_CALL(*metadataImport, GetMethodProps(notCovered.Method))
+        .WillOnce(Return(MethodProps { .EnclosingClass = program, .Name = L"Run" }));
+    EXPECT_CALL(*metadataImport, GetTypeDefProps(program))
+        .WillRepeatedly(Return(TypeDefProps { .Name = L"HelloWorld.Program" }));
+
+    // Act
+    const std::vector<ExecClassData> data { MakeSessionCoverage(
+        corProfilerInfo,
+        coverage,
+        [&metadataImport](const ModuleID)
+        {
+            return metadataImport;
+        }) };
+
+    // Assert
+    ASSERT_EQ(2, data.size());
+    EXPECT_EQ(L"HelloWorld/HelloWorld.Program", data[0].className);
+    EXPECT_EQ(std::vector<bool> { true }, data[0].probes);
+    EXPECT_EQ(L"HelloWorld/HelloWorld.Program", data[1].className);
+    EXPECT_EQ(std::vector<bool> { false }, data[1].probes);
+}
+
+// Checks the names of the methods of one module are read
+// with the name of each class read once.
+TEST(TryGetFunctionNamesTest, ReadsClassNamesOnce)
+{
+    // Arrange
+    const std::shared_ptr<const MetadataImportMock> metadataImport {
+        std::make_shared<const MetadataImportMock>(TrivialLogger {}) };
+    const mdTypeDef program { 0x02000002 };
+    EXPECT_CALL(*metadataImport, TryGetMethodProps(0x06000001))
+        .WillOnce(Return(MethodProps { .EnclosingClass = program, .Name = L"Main" }));
+    EXPECT_CALL(*metadataImport, TryGetMethodProps(0x06000002))
+        .WillOnce(Return(MethodProps { .EnclosingClass = program, .Name = L"Run" }));
+    EXPECT_CALL(*metadataImport, TryGetMethodProps(0x06000003))
+        .WillOnce(Return(std::nullopt));
+    EXPECT_CALL(*metadataImport, TryGetTypeDefProps(program))
+        .WillOnce(Return(TypeDefProps { .Name = L"HelloWorld.Program" }));
+
+    // Act
+    const std::vector<std::optional<FunctionName>> names { TryGetFunctionNames(
+        metadataImport,
+        std::vector<mdMethodDef> { 0x06000001, 0x06000003, 0x06000002 }) };
+
+    // Assert
+    ASSERT_EQ(3, names.size());
+    ASSERT_TRUE(names[0].has_value());
+    EXPECT_EQ(L"Main", names[0]->ownName);
+    EXPECT_EQ(L"HelloWorld.Program", names[0]->className);
+    EXPECT_FALSE(names[1].has_value());
+    ASSERT_TRUE(names[2].has_value());
+    EXPECT_EQ(L"Run", names[2]->ownName);
+    EXPECT_EQ(L"HelloWorld.Program", names[2]->className);
+}
+
+// Discards the text written to it, so the log of the
+// profiler does not flood the output of the benchmarks.
+class DiscardingBuffer : public std::wstreambuf
+{
+protected:
+    int_type overflow(const int_type character) override
+    {
+        return traits_type::not_eof(character);
+    }
+};
+
+// Sends the text written to std::wcout to a DiscardingBuffer,
+// till the instance is destroyed.
+class DiscardWideOutput
+{
+private:
+    DiscardingBuffer m_buffer {};
+    std::wstreambuf* const m_previous { std::wcout.rdbuf(&m_buffer) };
+
+public:
+    DiscardWideOutput() = default;
+    DiscardWideOutput(const DiscardWideOutput&) = delete;
+    DiscardWideOutput& operator=(const DiscardWideOutput&) & = delete;
+
+    ~DiscardWideOutput()
+    {
+        std::wcout.rdbuf(m_previous);
+    }
+};
+
+// Gets the address of the counter of the calls, which
+// the instrumented method adds its calls to on entry.
+// @param instrumentedBody : the instrumented method.
+static uintptr_t CallCounterAddress(const std::vector<std::byte>& instrumentedBody)
+{
+    const MethodBody method(instrumentedBody);
+    const OpCodeVariant load { std::get<OpCodeVariant>(*method.begin()) };
+    if (const auto load64 { load.GetIf<OpCode::CEE_LDC_I8>() }; load64.has_value())
+    {
+        return static_cast<uintptr_t>(load64->Argument());
+    }
+
+    return static_cast<uintptr_t>(static_cast<uint32_t>(load.GetIf<OpCode::CEE_LDC_I4>()->Argument()));
+}
+
+// Measures the cost the profiler adds to the functions of an application,
+// by running the profiler against the mocks: the decision whether to
+// instrument a function, taken once for each function compiled, for the
+// functions of the modules not chosen, and of the classes not chosen by
+// the rules; the instrumentation of the functions chosen, while a session
+// is active; and the counter of the calls, which the instrumented functions
+// run on each call. The decisions include the cost of the calls of the
+// mocks, which is higher than the cost of the calls of the runtime.
+TEST_F(CProfilerCallbackTest, DISABLED_BenchmarkJitDecision)
+{
+    constexpr size_t batchSize { 1'000 };
+    constexpr size_t callsCount { 10'000'000 };
+    constexpr size_t classesPerModule { 200 };
+    constexpr FunctionID firstFunction { 0x10'0000 };
+    constexpr ModuleID firstModule { 0x1000 };
+    constexpr mdTypeDef firstClass { 0x02000001 };
+    constexpr mdMethodDef firstMethod { 0x06000001 };
+
+    // One function of ten is in the application module, the first class of
+    // which is HelloWorld.Program. Before the packages prefixes are set, the
+    // rules choose only one method of that class, not compiled here.
+    const std::vector<std::wstring> moduleNames {
+        L"HelloWorld.dll",
+        L"System.Private.CoreLib.dll",
+        L"System.Runtime.dll",
+        L"System.Collections.dll",
+        L"System.Linq.dll",
+        L"System.Text.RegularExpressions.dll",
+        L"System.Net.Http.dll",
+        L"Microsoft.Extensions.DependencyInjection.dll",
+        L"Newtonsoft.Json.dll",
+        L"Serilog.dll" };
+
+    const std::vector<std::byte> body {
+        std::byte { 0x22 }, // tiny header, 8 bytes of code
+        std::byte { 0x02 }, // ldarg.0
+        std::byte { 0x2C }, // brfalse.s ELSE
+        std::byte { 0x03 },
+        std::byte { 0x17 }, // ldc.i4.1
+        std::byte { 0x2B }, // br.s END
+        std::byte { 0x01 },
+        std::byte { 0x16 }, // ELSE: ldc.i4.0
+        std::byte { 0x2A }  // END: ret
+    };
+
+    // The function i is in the module i % 10, and in the
+    // class i / 10 % classesPerModule of the module.
+    const auto functionOf { [](const mdMethodDef token)
+    {
+        return static_cast<size_t>(token - firstMethod);
+    } };
+
+    std::vector<uintptr_t> callCounters {};
+    const auto coreInteractCreation { CoreInteractMock::SetCreationCallBack([&](
+        CoreInteractMock& corInteractMock,
+        IUnknown*,
+        TrivialLogger)
+    {
+        EXPECT_CALL(corInteractMock, TryGetRuntimeInformation()).WillRepeatedly(Return(std::nullopt));
+        EXPECT_CALL(corInteractMock, SetEventMask(_)).WillRepeatedly(Return());
+        EXPECT_CALL(corInteractMock, RequestReJIT(_, _)).WillRepeatedly(Return());
+        EXPECT_CALL(corInteractMock, GetFunctionInfo(_)).WillRepeatedly(Invoke([&moduleNames](const FunctionID functionId)
+        {
+            const size_t function { static_cast<size_t>(functionId - firstFunction) };
+            return FunctionInfoWithoutName {
+                .classId = 0,
+                .moduleId = firstModule + function % moduleNames.size(),
+                .token = static_cast<mdToken>(firstMethod + function) };
+        }));
+        EXPECT_CALL(corInteractMock, GetModuleInfo(_)).WillRepeatedly(Invoke([&moduleNames](const ModuleID moduleId)
+        {
+            return ModuleInfo { .name = L"C:\\HelloWorld\\" + moduleNames[moduleId - firstModule] };
+        }));
+        EXPECT_CALL(corInteractMock, GetMethodIntermediateLanguageBody(_)).WillRepeatedly(Return(body));
+        EXPECT_CALL(corInteractMock, SetILFunctionBody(_, Matcher<const std::vector<std::byte>&>(_)))
+            .WillRepeatedly(Invoke([&callCounters](const FunctionInfo&, const std::vector<std::byte>& instrumentedBody)
+            {
+                callCounters.push_back(CallCounterAddress(instrumentedBody));
+            }));
+    }) };
+
+    const auto metaDataAssemblyImportCreation { MetaDataAssemblyImportMock::SetOnCreate([](MetaDataAssemblyImportMock& metaDataAssemblyImportMock)
+    {
+        EXPECT_CALL(metaDataAssemblyImportMock, GetAssemblyFromScope()).WillRepeatedly(Return(0x20000001));
+        EXPECT_CALL(metaDataAssemblyImportMock, GetAssemblyProps(_)).WillRepeatedly(Return(AssemblyProps { L"Injection", 0 }));
+    }) };
+
+    const auto metaDataImportCreation { MetadataImportMock::SetOnCreate([&moduleNames, &functionOf](MetadataImportMock& metaDataImportMock)
+    {
+        EXPECT_CALL(metaDataImportMock, FindTypeDefByName(_, _)).WillRepeatedly(Return(firstClass));
+        EXPECT_CALL(metaDataImportMock, EnumMethodsWithName(_, _)).WillRepeatedly(Return(std::vector { firstMethod }));
+        EXPECT_CALL(metaDataImportMock, GetMethodProps(_)).WillRepeatedly(Invoke([&moduleNames, &functionOf](const mdToken token)
+        {
+            const size_t function { functionOf(token) };
+            return MethodProps {
+                .EnclosingClass = static_cast<mdTypeDef>(firstClass + function / moduleNames.size() % classesPerModule),
+                .Name = L"Method" + std::to_wstring(function),
+                // static int F(bool)
+                .SignatureBlob { std::byte { 0x00 }, std::byte { 0x01 }, std::byte { 0x08 }, std::byte { 0x02 } } };
+        }));
+        EXPECT_CALL(metaDataImportMock, GetTypeDefProps(_)).WillRepeatedly(Invoke([](const mdTypeDef token)
+        {
+            return TypeDefProps { .Name = token == firstClass
+                ? L"HelloWorld.Program"
+                : L"HelloWorld.Class" + std::to_wstring(token - firstClass) };
+        }));
+    }) };
+
+    std::function<std::vector<AstEntity>()> treeProvider {};
+    EXPECT_CALL(proClient->GetConnector(), TreeProvider()).WillRepeatedly(ReturnRef(treeProvider));
+    std::function<void(const PackagesPrefixes&)> packagesPrefixesHandler {};
+    EXPECT_CALL(proClient->GetConnector(), PackagesPrefixesHandler()).WillRepeatedly(ReturnRef(packagesPrefixesHandler));
+    std::function<void(const SessionChange&)> sessionHandler {};
+    EXPECT_CALL(proClient->GetConnector(), SessionHandler()).WillRepeatedly(ReturnRef(sessionHandler));
+    std::function<std::vector<ExecClassData>()> coverageProvider {};
+    EXPECT_CALL(proClient->GetConnector(), CoverageProvider()).WillRepeatedly(ReturnRef(coverageProvider));
+    EXPECT_CALL(proClient->GetConnector(), InitializeAgent()).WillRepeatedly(Return());
+
+    const DiscardWideOutput discardLog {};
+    EXPECT_HRESULT_SUCCEEDED(profilerCallback->Initialize(reinterpret_cast<IUnknown*>(this)));
+
+    // Each function is compiled once, so the batches go on with the
+    // functions not compiled yet, of the application module, or of the
+    // other ones.
+    FunctionID nextFunction { firstFunction };
+    const auto compileBatch { [this, &nextFunction, &moduleNames](const bool application)
+    {
+        for (size_t compiled = 0; compiled != batchSize; ++nextFunction)
+        {
+            if (((nextFunction - firstFunction) % moduleNames.size() == 0) == application)
+            {
+                profilerCallback->JITCompilationStarted(nextFunction, TRUE);
+                ++compiled;
+            }
+        }
+    } };
+
+    const double otherModules { MeasureNanoseconds([&compileBatch]()
+    {
+        compileBatch(false);
+    }) };
+
+    const double classesNotChosen { MeasureNanoseconds([&compileBatch]()
+    {
+        compileBatch(true);
+    }) };
+
+    packagesPrefixesHandler(PackagesPrefixes { { L"HelloWorld" } });
+    sessionHandler(SessionChange { .sessionId = L"Benchmark", .isActive = true });
+    const double instrumented { MeasureNanoseconds([&compileBatch]()
+    {
+        compileBatch(true);
+    }) };
+
+    // What ldind.i8; ldc.i4.1; conv.i8; add; stind.i8 do.
+    std::mt19937 random { 42 };
+    std::vector<uintptr_t> calls(callsCount);
+    for (uintptr_t& call : calls)
+    {
+        call = callCounters[random() % callCounters.size()];
+    }
+
+    const double counted { MeasureNanoseconds([&calls]()
+    {
+        for (const uintptr_t counter : calls)
+        {
+            volatile uint64_t& count { *reinterpret_cast<volatile uint64_t*>(counter) };
+            count = count + 1;
+        }
+    }) };
+
+    sessionHandler(SessionChange { .sessionId = L"Benchmark", .isActive = false });
+    EXPECT_HRESULT_SUCCEEDED(profilerCallback->Shutdown());
+    EXPECT_FALSE(callCounters.empty());
+
+    ReportBenchmark("JIT decision, other modules", otherModules / batchSize, "ns per function");
+    ReportBenchmark("JIT decision, classes not chosen", classesNotChosen / batchSize, "ns per function");
+    ReportBenchmark("JIT with instrumentation, functions chosen", instrumented / batchSize, "ns per function");
+    ReportBenchmark("entry counter", counted / callsCount, "ns per call");
+}
@@ -0,0 +1,184 @@
+#include "pch.h"
+
+#include "Benchmark.h"
+#include "ConcurrentRegistry.h"
+
+#include <atomic>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+using namespace Drill4dotNet;
+
+// Checks the values are found by their keys,
+// and the missing keys are not found.
+TEST(ConcurrentRegistryTests, FindsEmplacedValues)
+{
+    // Arrange
+    ConcurrentRegistry<uintptr_t, std::wstring> registry {};
+
+    // Act
+    registry.Emplace(0x1000, L"first");
+    registry.Emplace(0x2000, 3, L'x');
+
+    // Assert
+    ASSERT_NE(nullptr, registry.Find(0x1000));
+    EXPECT_EQ(L"first", *registry.Find(0x1000));
+    ASSERT_NE(nullptr, registry.Find(0x2000));
+    EXPECT_EQ(L"xxx", *registry.Find(0x2000));
+    EXPECT_EQ(nullptr, registry.Find(0x3000));
+    EXPECT_EQ(2, registry.Size());
+}
+
+// Checks a replaced value is not found anymore, but stays in
+// memory, as readers may still use it; the key is counted once.
+TEST(ConcurrentRegistryTests, ReplacingKeepsOldValue)
+{
+    // Arrange
+    ConcurrentRegistry<uintptr_t, std::atomic<int>> registry {};
+    std::atomic<int>& old { registry.Emplace(0x1000, 1) };
+
+    // Act
+    std::atomic<int>& replacement { registry.Emplace(0x1000, 2) };
+    old.fetch_add(10);
+
+    // Assert
+    EXPECT_EQ(&replacement, registry.Find(0x1000));
+    EXPECT_EQ(11, old.load());
+    EXPECT_EQ(2, replacement.load());
+    EXPECT_EQ(1, registry.Size());
+}
+
+// Checks the values keep their addresses, while
+// the table grows, and all of them are visited.
+TEST(ConcurrentRegistryTests, GrowingKeepsValues)
+{
+    // Arrange
+    ConcurrentRegistry<uintptr_t, size_t> registry {};
+    const size_t* const first { &registry.Emplace(0, 0) };
+
+    // Act
+    for (size_t i = 1; i != 10000; ++i)
+    {
+        registry.Emplace(i * 16, i);
+    }
+
+    // Assert
+    EXPECT_EQ(first, registry.Find(0));
+    EXPECT_EQ(10000, registry.Size());
+    size_t sum { 0 };
+    registry.ForEach([&sum](const uintptr_t key, const size_t value)
+    {
+        EXPECT_EQ(key, value * 16);
+        sum += value;
+    });
+
+    EXPECT_EQ(10000 * 9999 / 2, sum);
+}
+
+// Checks the readers find either nothing or the right
+// value, while a writer adds the keys and grows the table.
+TEST(ConcurrentRegistryTests, ReadersRunWithWriter)
+{
+    // Arrange
+    constexpr size_t count { 20000 };
+    ConcurrentRegistry<uintptr_t, size_t> registry {};
+    std::atomic<bool> isWriting { true };
+    std::atomic<size_t> wrongValues { 0 };
+    std::vector<std::thread> readers {};
+
+    // Act
+    for (size_t reader = 0; reader != 4; ++reader)
+    {
+        readers.emplace_back([&registry, &isWriting, &wrongValues, reader]()
+        {
+            while (isWriting)
+            {
+                for (size_t i = reader; i < count; i += 7)
+                {
+                    if (const size_t* const value { registry.Find(i * 8) }
+                        ; value != nullptr && *value != i)
+                    {
+                        ++wrongValues;
+                    }
+                }
+            }
+        });
+    }
+
+    for (size_t i = 0; i != count; ++i)
+    {
+        registry.Emplace(i * 8, i);
+    }
+
+    isWriting = false;
+    for (std::thread& reader : readers)
+    {
+        reader.join();
+    }
+
+    // Assert
+    EXPECT_EQ(0, wrongValues.load());
+    EXPECT_EQ(count, registry.Size());
+    for (size_t i = 0; i != count; ++i)
+    {
+        ASSERT_NE(nullptr, registry.Find(i * 8));
+        EXPECT_EQ(i, *registry.Find(i * 8));
+    }
+}
+
+// Measures the lookups per second of many threads at once, in the
+// registry, and in a map guarded by a reader-writer lock.
+TEST(ConcurrentRegistryTests, DISABLED_BenchmarkLookupScaling)
+{
+    constexpr size_t keysCount { 10'000 };
+    constexpr size_t lookupsPerThread { 4'000'000 };
+    ConcurrentRegistry<uintptr_t, size_t> registry {};
+    std::unordered_map<uintptr_t, size_t> lockedMap {};
+    std::shared_mutex mutex {};
+    for (size_t i = 0; i != keysCount; ++i)
+    {
+        registry.Emplace(0x7000 + i * 8, i);
+        lockedMap.try_emplace(0x7000 + i * 8, i);
+    }
+
+    std::minstd_rand random { 42 };
+    std::vector<uintptr_t> keys(lookupsPerThread);
+    for (uintptr_t& key : keys)
+    {
+        key = 0x7000 + random() % keysCount * 8;
+    }
+
+    for (const size_t threadsCount : { 1, 2, 4, 8 })
+    {
+        const double registryDuration { MeasureThreadsNanoseconds(threadsCount, [&keys, &registry](size_t)
+        {
+            size_t sum { 0 };
+            for (const uintptr_t key : keys)
+            {
+                sum += *registry.Find(key);
+            }
+
+            KeepResult(sum);
+        }) };
+
+        const double lockedDuration { MeasureThreadsNanoseconds(threadsCount, [&keys, &lockedMap, &mutex](size_t)
+        {
+            size_t sum { 0 };
+            for (const uintptr_t key : keys)
+            {
+                std::shared_lock lock { mutex };
+                sum += lockedMap.find(key)->second;
+            }
+
+            KeepResult(sum);
+        }) };
+
+        const std::string threads { std::to_string(threadsCount) + (threadsCount == 1 ? " thread" : " threads") };
+        const double lookupsCount { static_cast<double>(lookupsPerThread * threadsCount) };
+        ReportBenchmark("registry, " + threads, lookupsCount * 1000 / registryDuration, "million lookups per second");
+        ReportBenchmark("locked map, " + threads, lookupsCount * 1000 / lockedDuration, "million lookups per second");
+    }
+}
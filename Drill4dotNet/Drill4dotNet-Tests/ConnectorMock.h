@@ -11,6 +11,8 @@ namespace Drill4dotNet
     public:
         MOCK_METHOD(std::function<std::vector<AstEntity>()>&, TreeProvider, ());
         MOCK_METHOD(std::function<void(const PackagesPrefixes&)>&, PackagesPrefixesHandler, ());
+        MOCK_METHOD(std::function<void(const SessionChange&)>&, SessionHandler, ());
+        MOCK_METHOD(std::function<std::vector<ExecClassData>()>&, CoverageProvider, ());
         MOCK_METHOD(void, InitializeAgent, ());
         MOCK_METHOD(void, SendAgentMessage, (const std::string&, const std::string&, const std::string&));
         MOCK_METHOD(void, SendPluginMessage, (const std::string&, const std::string&));
@@ -24,7 +26,9 @@ namespace Drill4dotNet
 
         ConnectorMock(
             const std::function<std::vector<AstEntity>()>&,
-            const std::function<void(const PackagesPrefixes&)>&)
+            const std::function<void(const PackagesPrefixes&)>&,
+            const std::function<void(const SessionChange&)>&,
+            const std::function<std::vector<ExecClassData>()>&)
             : ConnectorMock()
         {
         }
@@ -0,0 +1,348 @@
+#include "pch.h"
+
+#include "Benchmark.h"
+#include "ControlFlowGraph.h"
+#include "MethodArena.h"
+
+using namespace Drill4dotNet;
+
+// Gets the targets of the given edges.
+// @param edges : the edges to take the targets of.
+static std::vector<BlockIndex> BlocksOf(std::span<const ControlFlowEdge> edges)
+{
+    std::vector<BlockIndex> result {};
+    for (const ControlFlowEdge& edge : edges)
+    {
+        result.push_back(edge.Block);
+    }
+
+    return result;
+}
+
+// Gets the kinds of the given edges.
+// @param edges : the edges to take the kinds of.
+static std::vector<EdgeKind> KindsOf(std::span<const ControlFlowEdge> edges)
+{
+    std::vector<EdgeKind> result {};
+    for (const ControlFlowEdge& edge : edges)
+    {
+        result.push_back(edge.Kind);
+    }
+
+    return result;
+}
+
+// Checks a method without jumps is a single block,
+// which is the entry and the exit.
+TEST(ControlFlowGraphTests, StraightLineIsOneBlock)
+{
+    // Arrange
+    const std::vector<std::byte> bodyBytes {
+        std::byte { 0x16 }, // tiny header, 5 bytes of code
+        std::byte { 0x02 }, // ldarg.0
+        std::byte { 0x03 }, // ldarg.1
+        std::byte { 0x58 }, // add
+        std::byte { 0x00 }, // nop
+        std::byte { 0x2A }  // ret
+    };
+
+    const MethodBody method(bodyBytes);
+
+    // Act
+    const ControlFlowGraph graph { method };
+
+    // Assert
+    ASSERT_EQ(1, graph.Blocks().size());
+    EXPECT_EQ(0, graph.Blocks()[0].Begin);
+    EXPECT_EQ(4, graph.Blocks()[0].Last);
+    EXPECT_EQ(5, graph.Blocks()[0].End);
+    EXPECT_EQ(0, graph.EdgesCount());
+    EXPECT_EQ(NoBlock, graph.Dominators().Parent(0));
+    EXPECT_EQ(NoBlock, graph.PostDominators().Parent(0));
+    EXPECT_TRUE(graph.Dominators().Dominates(0, 0));
+}
+
+// Checks the blocks, the edges, and the dominators of
+// public static int F(bool x)
+// {
+//     return x ? 1 : 0;
+// }
+TEST(ControlFlowGraphTests, IfElseMakesDiamond)
+{
+    // Arrange
+    const std::vector<std::byte> bodyBytes {
+        std::byte { 0x22 }, // tiny header, 8 bytes of code
+        std::byte { 0x02 }, // ldarg.0
+        std::byte { 0x2C }, // brfalse.s ELSE
+        std::byte { 0x03 },
+        std::byte { 0x17 }, // ldc.i4.1
+        std::byte { 0x2B }, // br.s END
+        std::byte { 0x01 },
+        std::byte { 0x16 }, // ELSE: ldc.i4.0
+        std::byte { 0x2A }  // END: ret
+    };
+
+    const MethodBody method(bodyBytes);
+
+    // Act
+    const ControlFlowGraph graph { method };
+
+    // Assert
+    ASSERT_EQ(4, graph.Blocks().size());
+    EXPECT_EQ(4, graph.EdgesCount());
+    EXPECT_EQ((std::vector<BlockIndex> { 2, 1 }), BlocksOf(graph.Successors(0)));
+    EXPECT_EQ((std::vector<EdgeKind> { EdgeKind::Branch, EdgeKind::FallThrough }), KindsOf(graph.Successors(0)));
+    EXPECT_EQ((std::vector<BlockIndex> { 3 }), BlocksOf(graph.Successors(1)));
+    EXPECT_EQ((std::vector<BlockIndex> { 3 }), BlocksOf(graph.Successors(2)));
+    EXPECT_EQ((std::vector<BlockIndex> { 1, 2 }), BlocksOf(graph.Predecessors(3)));
+    EXPECT_EQ((std::vector<EdgeKind> { EdgeKind::Branch, EdgeKind::FallThrough }), KindsOf(graph.Predecessors(3)));
+
+    const DominatorTree& dominators { graph.Dominators() };
+    EXPECT_EQ(0, dominators.Parent(1));
+    EXPECT_EQ(0, dominators.Parent(2));
+    EXPECT_EQ(0, dominators.Parent(3));
+    EXPECT_EQ((std::vector<BlockIndex> { 1, 2, 3 }), (std::vector<BlockIndex>(dominators.Children(0).begin(), dominators.Children(0).end())));
+    EXPECT_FALSE(dominators.Dominates(1, 3));
+
+    const DominatorTree& postDominators { graph.PostDominators() };
+    EXPECT_EQ(3, postDominators.Parent(0));
+    EXPECT_EQ(3, postDominators.Parent(1));
+    EXPECT_EQ(3, postDominators.Parent(2));
+    EXPECT_EQ(NoBlock, postDominators.Parent(3));
+    EXPECT_TRUE(postDominators.Dominates(3, 0));
+}
+
+// Checks the back edge of a loop and the dominators of
+//     br.s CONDITION
+// BODY:
+//     nop
+// CONDITION:
+//     ldarg.0
+//     brtrue.s BODY
+//     ret
+TEST(ControlFlowGraphTests, LoopHasBackEdge)
+{
+    // Arrange
+    const std::vector<std::byte> bodyBytes {
+        std::byte { 0x1E }, // tiny header, 7 bytes of code
+        std::byte { 0x2B }, // br.s CONDITION
+        std::byte { 0x01 },
+        std::byte { 0x00 }, // BODY: nop
+        std::byte { 0x02 }, // CONDITION: ldarg.0
+        std::byte { 0x2D }, // brtrue.s BODY
+        std::byte { 0xFC },
+        std::byte { 0x2A }  // ret
+    };
+
+    const MethodBody method(bodyBytes);
+
+    // Act
+    const ControlFlowGraph graph { method };
+
+    // Assert
+    ASSERT_EQ(4, graph.Blocks().size());
+    EXPECT_EQ((std::vector<BlockIndex> { 2 }), BlocksOf(graph.Successors(1)));
+    EXPECT_EQ((std::vector<BlockIndex> { 1, 3 }), BlocksOf(graph.Successors(2)));
+    EXPECT_EQ((std::vector<BlockIndex> { 0, 1 }), BlocksOf(graph.Predecessors(2)));
+    EXPECT_EQ(0, graph.Dominators().Parent(2));
+    EXPECT_EQ(2, graph.Dominators().Parent(1));
+    EXPECT_EQ(2, graph.Dominators().Parent(3));
+    EXPECT_TRUE(graph.Dominators().Dominates(2, 1));
+    EXPECT_FALSE(graph.Dominators().Dominates(1, 2));
+    EXPECT_EQ(2, graph.PostDominators().Parent(0));
+    EXPECT_EQ(2, graph.PostDominators().Parent(1));
+    EXPECT_EQ(3, graph.PostDominators().Parent(2));
+}
+
+// Checks each target of a switch gets an edge, and blocks
+// ending with different returns have no common post-dominator.
+//     ldarg.0
+//     switch (CASE_0, CASE_1)
+//     ldc.i4.m1
+//     ret
+// CASE_0:
+//     ldc.i4.0
+//     ret
+// CASE_1:
+//     ldc.i4.1
+//     ret
+TEST(ControlFlowGraphTests, SwitchHasEdgePerTarget)
+{
+    // Arrange
+    const std::vector<std::byte> bodyBytes {
+        std::byte { 0x52 }, // tiny header, 20 bytes of code
+        std::byte { 0x02 }, // ldarg.0
+        std::byte { 0x45 }, // switch
+        std::byte { 0x02 }, std::byte { 0x00 }, std::byte { 0x00 }, std::byte { 0x00 },
+        std::byte { 0x02 }, std::byte { 0x00 }, std::byte { 0x00 }, std::byte { 0x00 },
+        std::byte { 0x04 }, std::byte { 0x00 }, std::byte { 0x00 }, std::byte { 0x00 },
+        std::byte { 0x15 }, // ldc.i4.m1
+        std::byte { 0x2A }, // ret
+        std::byte { 0x16 }, // CASE_0: ldc.i4.0
+        std::byte { 0x2A }, // ret
+        std::byte { 0x17 }, // CASE_1: ldc.i4.1
+        std::byte { 0x2A }  // ret
+    };
+
+    const MethodBody method(bodyBytes);
+
+    // Act
+    const ControlFlowGraph graph { method };
+
+    // Assert
+    ASSERT_EQ(4, graph.Blocks().size());
+    EXPECT_EQ((std::vector<BlockIndex> { 2, 3, 1 }), BlocksOf(graph.Successors(0)));
+    EXPECT_EQ(
+        (std::vector<EdgeKind> { EdgeKind::Switch, EdgeKind::Switch, EdgeKind::FallThrough }),
+        KindsOf(graph.Successors(0)));
+
+    for (BlockIndex block = 1; block != 4; ++block)
+    {
+        EXPECT_TRUE(graph.Successors(block).empty());
+        EXPECT_EQ(0, graph.Dominators().Parent(block));
+        EXPECT_EQ(NoBlock, graph.PostDominators().Parent(block));
+    }
+
+    EXPECT_EQ(NoBlock, graph.PostDominators().Parent(0));
+    EXPECT_TRUE(graph.PostDominators().Contains(0));
+}
+
+// Checks the blocks of a try block get edges to the handler.
+//     nop
+// TRY:
+//     ldarg.0
+//     pop
+//     leave.s END
+// CATCH:
+//     pop
+//     leave.s END
+// END:
+//     ret
+TEST(ControlFlowGraphTests, TryBlockHasExceptionEdge)
+{
+    // Arrange
+    const std::vector<std::byte> bodyBytes {
+        std::byte { 0x1B }, std::byte { 0x30 }, // fat header flags and size
+        std::byte { 0x02 }, std::byte { 0x00 }, // max stack
+        std::byte { 0x09 }, std::byte { 0x00 }, std::byte { 0x00 }, std::byte { 0x00 }, // code size
+        std::byte { 0x00 }, std::byte { 0x00 }, std::byte { 0x00 }, std::byte { 0x00 }, // local variables
+        std::byte { 0x00 }, // nop
+        std::byte { 0x02 }, // TRY: ldarg.0
+        std::byte { 0x26 }, // pop
+        std::byte { 0xDE }, // leave.s END
+        std::byte { 0x03 },
+        std::byte { 0x26 }, // CATCH: pop
+        std::byte { 0xDE }, // leave.s END
+        std::byte { 0x00 },
+        std::byte { 0x2A }, // END: ret
+        std::byte { 0x00 }, std::byte { 0x00 }, std::byte { 0x00 }, // alignment
+        std::byte { 0x01 }, std::byte { 0x10 }, std::byte { 0x00 }, std::byte { 0x00 }, // small section header
+        std::byte { 0x00 }, std::byte { 0x00 }, // catch
+        std::byte { 0x01 }, std::byte { 0x00 }, std::byte { 0x04 }, // try offset and length
+        std::byte { 0x05 }, std::byte { 0x00 }, std::byte { 0x03 }, // handler offset and length
+        std::byte { 0x01 }, std::byte { 0x00 }, std::byte { 0x00 }, std::byte { 0x01 } // exception type
+    };
+
+    const MethodBody method(bodyBytes);
+    ASSERT_EQ(bodyBytes, method.Compile());
+
+    // Act
+    const ControlFlowGraph graph { method };
+
+    // Assert
+    ASSERT_EQ(4, graph.Blocks().size());
+    EXPECT_EQ((std::vector<BlockIndex> { 1 }), BlocksOf(graph.Successors(0)));
+    EXPECT_EQ((std::vector<BlockIndex> { 3, 2 }), BlocksOf(graph.Successors(1)));
+    EXPECT_EQ((std::vector<EdgeKind> { EdgeKind::Branch, EdgeKind::Exception }), KindsOf(graph.Successors(1)));
+    EXPECT_EQ((std::vector<BlockIndex> { 3 }), BlocksOf(graph.Successors(2)));
+    EXPECT_EQ(1, graph.Dominators().Parent(2));
+    EXPECT_EQ(1, graph.Dominators().Parent(3));
+    EXPECT_EQ(3, graph.PostDominators().Parent(1));
+    EXPECT_EQ(1, graph.PostDominators().Parent(0));
+
+    const BlockIndex catchBlock { graph.BlockOf(static_cast<size_t>(graph.Blocks()[2].Last)) };
+    EXPECT_EQ(2, catchBlock);
+}
+
+// Checks the blocks following an unconditional jump
+// without being its target are not in the dominator tree.
+TEST(ControlFlowGraphTests, UnreachableBlockIsNotDominated)
+{
+    // Arrange
+    const std::vector<std::byte> bodyBytes {
+        std::byte { 0x12 }, // tiny header, 4 bytes of code
+        std::byte { 0x2B }, // br.s END
+        std::byte { 0x01 },
+        std::byte { 0x00 }, // nop
+        std::byte { 0x2A }  // END: ret
+    };
+
+    const MethodBody method(bodyBytes);
+
+    // Act
+    const ControlFlowGraph graph { method };
+
+    // Assert
+    ASSERT_EQ(3, graph.Blocks().size());
+    EXPECT_TRUE(graph.Predecessors(1).empty());
+    EXPECT_FALSE(graph.Dominators().Contains(1));
+    EXPECT_FALSE(graph.Dominators().Dominates(0, 1));
+    EXPECT_EQ(0, graph.Dominators().Parent(2));
+    EXPECT_TRUE(graph.PostDominators().Dominates(2, 1));
+}
+
+// Measures the time to build the graphs of the corpus methods,
+// including the dominator and post-dominator trees, with the heap
+// and with an arena, compared with the time to decode the methods.
+TEST(ControlFlowGraphTests, DISABLED_BenchmarkBuild)
+{
+    std::vector<MethodBody> methods {};
+    size_t blocksCount { 0 };
+    size_t edgesCount { 0 };
+    for (const std::vector<std::byte>& bytes : MakeMethodCorpus())
+    {
+        const MethodBody& method { methods.emplace_back(bytes) };
+        const ControlFlowGraph graph { method };
+        blocksCount += graph.Blocks().size();
+        edgesCount += graph.EdgesCount();
+    }
+
+    const double build { MeasureNanoseconds([&methods]()
+    {
+        for (const MethodBody& method : methods)
+        {
+            const ControlFlowGraph graph { method };
+            KeepResult(graph.EdgesCount());
+        }
+    }) };
+
+    MethodArena arena {};
+    const double buildInArena { MeasureNanoseconds([&methods, &arena]()
+    {
+        for (const MethodBody& method : methods)
+        {
+            {
+                const ControlFlowGraph graph { method, arena.Resource() };
+                KeepResult(graph.EdgesCount());
+            }
+
+            arena.Reset();
+        }
+    }) };
+
+    const std::vector<std::vector<std::byte>> corpus { MakeMethodCorpus() };
+    const double decode { MeasureNanoseconds([&corpus]()
+    {
+        for (const std::vector<std::byte>& bytes : corpus)
+        {
+            const MethodBody method(bytes);
+            KeepResult(method.Stream().size());
+        }
+    }) };
+
+    ReportBenchmark("blocks", static_cast<double>(blocksCount) / methods.size(), "per method");
+    ReportBenchmark("edges", static_cast<double>(edgesCount) / methods.size(), "per method");
+    ReportBenchmark("ControlFlowGraph, heap", build / methods.size(), "ns per method");
+    ReportBenchmark("ControlFlowGraph, arena", buildInArena / methods.size(), "ns per method");
+    ReportBenchmark("MethodBody decoding", decode / methods.size(), "ns per method");
+}
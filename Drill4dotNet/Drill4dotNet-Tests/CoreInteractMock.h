@@ -7,6 +7,7 @@
 #include "CorDataStructures.h"
 #include "ComWrapperBase.h"
 #include "MetadataImportMock.h"
+#include "MethodBody.h"
 
 namespace Drill4dotNet
 {
@@ -59,8 +60,8 @@ namespace Drill4dotNet
         MOCK_METHOD(bool, TrySetEventMask, (const uint32_t eventMask), (const));
         MOCK_METHOD(void, SetFunctionIDMapper, (FunctionIDMapper* pFunc), (const));
         MOCK_METHOD(bool, TrySetFunctionIDMapper, (FunctionIDMapper* pFunc), (const));
-        MOCK_METHOD(void, SetEnterLeaveFunctionHooks, (FunctionEnter2* pFuncEnter, FunctionLeave2* pFuncLeave, FunctionTailcall2* pFuncTailcall), (const));
-        MOCK_METHOD(bool, TrySetEnterLeaveFunctionHooks, (FunctionEnter2* pFuncEnter, FunctionLeave2* pFuncLeave, FunctionTailcall2* pFuncTailcall), (const));
+        MOCK_METHOD(void, SetEnterLeaveFunctionHooks, (FunctionEnter3* pFuncEnter, FunctionLeave3* pFuncLeave, FunctionTailcall3* pFuncTailcall), (const));
+        MOCK_METHOD(bool, TrySetEnterLeaveFunctionHooks, (FunctionEnter3* pFuncEnter, FunctionLeave3* pFuncLeave, FunctionTailcall3* pFuncTailcall), (const));
         MOCK_METHOD(AppDomainInfo, GetAppDomainInfo, (const AppDomainID appDomainId), (const));
         MOCK_METHOD(std::optional<AppDomainInfo>, TryGetAppDomainInfo, (const AppDomainID appDomainId), (const));
         MOCK_METHOD(AssemblyInfo, GetAssemblyInfo, (const AssemblyID assemblyId), (const));
@@ -73,8 +74,11 @@ namespace Drill4dotNet
         MOCK_METHOD(std::vector<std::byte>, GetMethodIntermediateLanguageBody, (const FunctionInfo& functionInfo), (const));
         MOCK_METHOD(std::optional<std::vector<std::byte>>, TryGetMethodIntermediateLanguageBody, (const FunctionInfo& functionInfo), (const));
         MOCK_METHOD(void, SetILFunctionBody, (const FunctionInfo& target, const std::vector<std::byte>& newILMethodBody), (const));
+        MOCK_METHOD(void, SetILFunctionBody, (const FunctionInfo& target, const MethodBody& newILMethodBody), (const));
         MOCK_METHOD(bool, TrySetILFunctionBody, (const FunctionInfo& target, const std::vector<std::byte>& newILMethodBody), (const));
         MOCK_METHOD(ClassInfoWithoutName, GetClassInfo, (const ClassID classId), (const));
+        MOCK_METHOD(void, RequestReJIT, (const std::vector<ModuleID>& moduleIds, const std::vector<mdMethodDef>& methodIds), (const));
+        MOCK_METHOD(bool, TryRequestReJIT, (const std::vector<ModuleID>& moduleIds, const std::vector<mdMethodDef>& methodIds), (const));
 
         MetadataImportMock GetModuleMetadata(const ModuleID moduleId, const TrivialLogger logger) const
         {
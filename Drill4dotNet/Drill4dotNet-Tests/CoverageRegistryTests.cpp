@@ -0,0 +1,333 @@
+#include "pch.h"
+
+#include "CoverageRegistry.h"
+#include "MethodBody.h"
+
+using namespace Drill4dotNet;
+
+// The method instrumented in the tests.
+static constexpr MethodKey s_Key { 0x1000, 0x06000001 };
+
+// Creates method body representing
+// public static int F(bool x)
+// {
+//     return x ? 1 : 0;
+// }
+// It gets 3 probes.
+static std::vector<std::byte> CreateIfElseFunction()
+{
+    return {
+        std::byte { 0x22 }, // tiny header, 8 bytes of code
+        std::byte { 0x02 }, // ldarg.0
+        std::byte { 0x2C }, // brfalse.s ELSE
+        std::byte { 0x03 },
+        std::byte { 0x17 }, // ldc.i4.1
+        std::byte { 0x2B }, // br.s END
+        std::byte { 0x01 },
+        std::byte { 0x16 }, // ELSE: ldc.i4.0
+        std::byte { 0x2A }  // END: ret
+    };
+}
+
+// Fails the test, if the instrumentation asks for a signature.
+static MethodSignature NoCallsExpected(const mdToken)
+{
+    throw std::logic_error("No calls expected");
+}
+
+// Does what the given count of the first probes of
+// the instrumented method do, when they are executed:
+// stores 1 to the address each probe loads. The probes
+// are found by the load of the address followed by conv.u.
+// @param instrumentedBody : the instrumented method.
+// @param count : the count of probes to execute.
+static void ExecuteProbes(const std::vector<std::byte>& instrumentedBody, size_t count)
+{
+    const MethodBody method(instrumentedBody);
+    std::optional<uintptr_t> address {};
+    for (const auto& item : method)
+    {
+        const OpCodeVariant* const instruction { std::get_if<OpCodeVariant>(&item) };
+        if (count == 0 || instruction == nullptr)
+        {
+            continue;
+        }
+
+        if (address.has_value() && instruction->GetIf<OpCode::CEE_CONV_U>().has_value())
+        {
+            *reinterpret_cast<std::byte*>(*address) = std::byte { 1 };
+            --count;
+        }
+
+        address.reset();
+        if (const auto load { instruction->GetIf<OpCode::CEE_LDC_I8>() }; load.has_value())
+        {
+            address = static_cast<uintptr_t>(load->Argument());
+        }
+        else if (const auto load { instruction->GetIf<OpCode::CEE_LDC_I4>() }; load.has_value())
+        {
+            address = static_cast<uintptr_t>(static_cast<uint32_t>(load->Argument()));
+        }
+    }
+}
+
+// Checks the instrumented method gets the probes,
+// and its coverage follows the probes executed.
+TEST(CoverageRegistryTests, InstrumentInsertsProbes)
+{
+    // Arrange
+    CoverageRegistry registry {};
+    registry.StartSession();
+
+    // Act
+    const std::vector<std::byte> instrumented { registry.Instrument(s_Key, CreateIfElseFunction(), NoCallsExpected) };
+    const std::optional<std::vector<bool>> initialCoverage { registry.Coverage(s_Key) };
+    ExecuteProbes(instrumented, 3);
+
+    // Assert
+    EXPECT_NE(CreateIfElseFunction(), instrumented);
+    EXPECT_EQ((std::vector<bool> { false, false, false, false }), initialCoverage);
+    EXPECT_EQ((std::vector<bool> { true, true, true, true }), registry.Coverage(s_Key));
+    EXPECT_EQ(instrumented, registry.CurrentBody(s_Key, NoCallsExpected));
+    const std::optional<ProbesCount> count { registry.CountProbes(s_Key) };
+    ASSERT_TRUE(count.has_value());
+    EXPECT_EQ(3, count->Probes);
+    EXPECT_EQ(4, count->Blocks);
+}
+
+// Checks a method instrumented before is not instrumented
+// again, so the code compiled twice shares the probes.
+TEST(CoverageRegistryTests, InstrumentTwiceKeepsProbes)
+{
+    // Arrange
+    CoverageRegistry registry {};
+    registry.StartSession();
+    const std::vector<std::byte> first { registry.Instrument(s_Key, CreateIfElseFunction(), NoCallsExpected) };
+
+    // Act
+    const std::vector<std::byte> second { registry.Instrument(s_Key, CreateIfElseFunction(), NoCallsExpected) };
+
+    // Assert
+    EXPECT_EQ(first, second);
+}
+
+// Creates method body representing
+// public static void F(bool x)
+// {
+//     while (x) { }
+// }
+// The first instruction is the target of the jump back.
+static std::vector<std::byte> CreateLoopFunction()
+{
+    return {
+        std::byte { 0x12 }, // tiny header, 4 bytes of code
+        std::byte { 0x02 }, // LOOP: ldarg.0
+        std::byte { 0x2D }, // brtrue.s LOOP
+        std::byte { 0xFD },
+        std::byte { 0x2A }  // ret
+    };
+}
+
+// Checks the body instrumented for a session starts with the counter
+// of the calls, before the label of the first instruction, so the jumps
+// back to it are not counted, and the body outside the session does
+// not count the calls.
+TEST(CoverageRegistryTests, InstrumentCountsCallsOnEntry)
+{
+    // Arrange
+    CoverageRegistry registry {};
+    const uint64_t calls { 0 };
+    const uintptr_t callCounter { reinterpret_cast<uintptr_t>(&calls) };
+    const std::vector<std::byte> outsideSession {
+        registry.Instrument(s_Key, CreateLoopFunction(), NoCallsExpected, callCounter) };
+
+    registry.StartSession();
+
+    // Act
+    const std::optional<std::vector<std::byte>> inSession { registry.CurrentBody(s_Key, NoCallsExpected) };
+
+    // Assert
+    EXPECT_EQ(CreateLoopFunction(), outsideSession);
+    ASSERT_TRUE(inSession.has_value());
+    const MethodBody method(*inSession);
+    auto position { method.begin() };
+    for (const OpCodeVariant& instruction : MakeNativeCounter(callCounter))
+    {
+        ASSERT_NE(method.end(), position);
+        EXPECT_EQ(StreamElement { instruction }, *position);
+        ++position;
+    }
+
+    ASSERT_NE(method.end(), position);
+    EXPECT_TRUE(std::holds_alternative<Label>(*position));
+}
+
+// Checks a method is retired only when all its probes are hit,
+// only once, and its original body is restored, and its
+// coverage is kept.
+TEST(CoverageRegistryTests, RetireFullyCovered)
+{
+    // Arrange
+    CoverageRegistry registry {};
+    registry.StartSession();
+    const std::vector<std::byte> instrumented { registry.Instrument(s_Key, CreateIfElseFunction(), NoCallsExpected) };
+    ExecuteProbes(instrumented, 2);
+    const std::vector<MethodKey> retiredPartially { registry.RetireFullyCovered() };
+    ExecuteProbes(instrumented, 3);
+
+    // Act
+    const std::vector<MethodKey> retired { registry.RetireFullyCovered() };
+
+    // Assert
+    EXPECT_TRUE(retiredPartially.empty());
+    ASSERT_EQ(1, retired.size());
+    EXPECT_EQ(s_Key, retired.front());
+    EXPECT_TRUE(registry.RetireFullyCovered().empty());
+    EXPECT_TRUE(registry.IsRetired(s_Key));
+    EXPECT_EQ(CreateIfElseFunction(), registry.CurrentBody(s_Key, NoCallsExpected));
+    EXPECT_EQ(CreateIfElseFunction(), registry.Instrument(s_Key, CreateIfElseFunction(), NoCallsExpected));
+    EXPECT_EQ((std::vector<bool> { true, true, true, true }), registry.Coverage(s_Key));
+}
+
+// Checks nothing is known about a method not instrumented,
+// including the method the instrumentation has failed for.
+TEST(CoverageRegistryTests, UnknownMethod)
+{
+    // Arrange
+    CoverageRegistry registry {};
+    registry.StartSession();
+    const std::vector<std::byte> malformed {
+        std::byte { 0x0A }, // tiny header, 2 bytes of code
+        std::byte { 0x2B }, // br.s past the end
+        std::byte { 0x10 }
+    };
+
+    // Act
+    EXPECT_THROW(registry.Instrument(s_Key, malformed, NoCallsExpected), std::runtime_error);
+
+    // Assert
+    EXPECT_EQ(std::nullopt, registry.CurrentBody(s_Key, NoCallsExpected));
+    EXPECT_EQ(std::nullopt, registry.Coverage(s_Key));
+    EXPECT_FALSE(registry.IsRetired(s_Key));
+}
+
+// Checks the probes are not made for a method compiled outside
+// sessions, till a session needs them for the ReJIT.
+TEST(CoverageRegistryTests, ProbesWaitForSession)
+{
+    // Arrange
+    CoverageRegistry registry {};
+    const std::vector<std::byte> malformed {
+        std::byte { 0x0A }, // tiny header, 2 bytes of code
+        std::byte { 0x2B }, // br.s past the end
+        std::byte { 0x10 }
+    };
+
+    // Act
+    const std::vector<std::byte> bodyOutsideSession { registry.Instrument(s_Key, malformed, NoCallsExpected) };
+    const std::optional<ProbesCount> countOutsideSession { registry.CountProbes(s_Key) };
+    const std::vector<MethodKey> started { registry.StartSession() };
+
+    // Assert
+    EXPECT_EQ(malformed, bodyOutsideSession);
+    EXPECT_EQ(std::nullopt, countOutsideSession);
+    EXPECT_EQ(std::vector<MethodKey> { s_Key }, started);
+    EXPECT_THROW(registry.CurrentBody(s_Key, NoCallsExpected), std::runtime_error);
+    EXPECT_EQ(std::nullopt, registry.CurrentBody(s_Key, NoCallsExpected));
+}
+
+// Checks the methods of an unloaded module are forgotten,
+// and the methods of the other modules are kept.
+TEST(CoverageRegistryTests, ForgetModule)
+{
+    // Arrange
+    CoverageRegistry registry {};
+    registry.StartSession();
+    const MethodKey otherModuleKey { s_Key.Module + 1, s_Key.Method };
+    const MethodKey sameModuleKey { s_Key.Module, s_Key.Method + 1 };
+    registry.Instrument(s_Key, CreateIfElseFunction(), NoCallsExpected);
+    registry.Instrument(sameModuleKey, CreateIfElseFunction(), NoCallsExpected);
+    const std::vector<std::byte> otherModuleBody { registry.Instrument(otherModuleKey, CreateIfElseFunction(), NoCallsExpected) };
+
+    // Act
+    registry.ForgetModule(s_Key.Module);
+
+    // Assert
+    EXPECT_EQ(std::nullopt, registry.CurrentBody(s_Key, NoCallsExpected));
+    EXPECT_EQ(std::nullopt, registry.CurrentBody(sameModuleKey, NoCallsExpected));
+    EXPECT_EQ(std::nullopt, registry.Coverage(s_Key));
+    EXPECT_EQ(otherModuleBody, registry.CurrentBody(otherModuleKey, NoCallsExpected));
+    EXPECT_EQ(std::vector<MethodKey> { otherModuleKey }, registry.StopSession());
+}
+
+// Checks the methods run the original bodies outside sessions,
+// and starting and stopping a session gives them for ReJIT.
+TEST(CoverageRegistryTests, SessionSwitchesBodies)
+{
+    // Arrange
+    CoverageRegistry registry {};
+    const std::vector<std::byte> bodyOutsideSession { registry.Instrument(s_Key, CreateIfElseFunction(), NoCallsExpected) };
+
+    // Act
+    const std::vector<MethodKey> started { registry.StartSession() };
+    const std::optional<std::vector<std::byte>> bodyInSession { registry.CurrentBody(s_Key, NoCallsExpected) };
+    ExecuteProbes(*bodyInSession, 1);
+    const std::vector<MethodKey> stopped { registry.StopSession() };
+
+    // Assert
+    EXPECT_EQ(CreateIfElseFunction(), bodyOutsideSession);
+    EXPECT_EQ(std::vector<MethodKey> { s_Key }, started);
+    EXPECT_NE(CreateIfElseFunction(), bodyInSession);
+    EXPECT_EQ(std::vector<MethodKey> { s_Key }, stopped);
+    EXPECT_FALSE(registry.IsSessionActive());
+    EXPECT_EQ(CreateIfElseFunction(), registry.CurrentBody(s_Key, NoCallsExpected));
+    EXPECT_EQ((std::vector<bool> { true, true, false, false }), registry.Coverage(s_Key));
+    EXPECT_TRUE(registry.RetireFullyCovered().empty());
+    EXPECT_TRUE(registry.StopSession().empty());
+}
+
+// Checks a new session clears the coverage and the retired marks,
+// and the methods retired in a session are not given for ReJIT
+// when the session stops.
+TEST(CoverageRegistryTests, NewSessionClearsRetirement)
+{
+    // Arrange
+    CoverageRegistry registry {};
+    registry.StartSession();
+    const std::vector<std::byte> instrumented { registry.Instrument(s_Key, CreateIfElseFunction(), NoCallsExpected) };
+    ExecuteProbes(instrumented, 3);
+    registry.RetireFullyCovered();
+
+    // Act
+    const std::vector<MethodKey> stopped { registry.StopSession() };
+    const std::vector<MethodKey> started { registry.StartSession() };
+
+    // Assert
+    EXPECT_TRUE(stopped.empty());
+    EXPECT_EQ(std::vector<MethodKey> { s_Key }, started);
+    EXPECT_FALSE(registry.IsRetired(s_Key));
+    EXPECT_EQ(instrumented, registry.CurrentBody(s_Key, NoCallsExpected));
+    EXPECT_EQ((std::vector<bool> { false, false, false, false }), registry.Coverage(s_Key));
+    EXPECT_TRUE(registry.StartSession().empty());
+}
+
+// Checks only the methods, which have got the probes,
+// are given as the methods with the coverage.
+TEST(CoverageRegistryTests, MethodsWithProbes)
+{
+    // Arrange
+    CoverageRegistry registry {};
+    const MethodKey otherKey { s_Key.Module, s_Key.Method + 1 };
+    registry.Instrument(s_Key, CreateIfElseFunction(), NoCallsExpected);
+    registry.Instrument(otherKey, CreateIfElseFunction(), NoCallsExpected);
+    const std::vector<MethodKey> outsideSession { registry.MethodsWithProbes() };
+    registry.StartSession();
+
+    // Act
+    registry.CurrentBody(s_Key, NoCallsExpected);
+    const std::vector<MethodKey> inSession { registry.MethodsWithProbes() };
+
+    // Assert
+    EXPECT_TRUE(outsideSession.empty());
+    EXPECT_EQ(std::vector<MethodKey> { s_Key }, inSession);
+}
@@ -90,7 +90,8 @@ static void AssertLabelAt(
     const ConstStreamPosition position,
     const Label::Id expectedId)
 {
-    const Label* streamLabel = std::get_if<Label>(&*position);
+    const StreamElement element { *position };
+    const Label* streamLabel = std::get_if<Label>(&element);
 
     EXPECT_NE(nullptr, streamLabel);
     if (streamLabel == nullptr)
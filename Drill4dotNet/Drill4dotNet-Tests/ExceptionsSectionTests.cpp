@@ -439,4 +439,5 @@ TEST(ExceptionsSectionTests, ExtendSectionOfSmallClauses)
     EXPECT_TRUE(section.Clauses()[0].CanPutToSmallHeader());
     EXPECT_FALSE(section.Clauses()[1].CanPutToSmallHeader());
     EXPECT_EQ(expectedBytes, serialized);
+    EXPECT_EQ(expectedBytes.size(), section.Size());
 }
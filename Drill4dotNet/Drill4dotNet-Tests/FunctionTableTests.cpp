@@ -0,0 +1,353 @@
+#include "pch.h"
+
+#include <chrono>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "Benchmark.h"
+#include "FunctionTable.h"
+
+using namespace Drill4dotNet;
+
+// Creates the data of a function.
+static FunctionInfoWithoutName MakeFunctionInfo(const ModuleID moduleId, const mdToken token)
+{
+    FunctionInfoWithoutName result {};
+    result.moduleId = moduleId;
+    result.classId = moduleId + 1;
+    result.token = token;
+    return result;
+}
+
+// Checks the elements keep their addresses and
+// values, while more segments are added.
+TEST(FunctionTableTests, SegmentedArrayKeepsElements)
+{
+    // Arrange
+    SegmentedArray<uint32_t> array {};
+    const uint32_t first { array.Add([](uint32_t& element) { element = 7; }) };
+    const uint32_t* const firstAddress { &array[first] };
+
+    // Act
+    for (uint32_t i = 1; i != 10000; ++i)
+    {
+        array.Add([i](uint32_t& element) { element = i; });
+    }
+
+    // Assert
+    EXPECT_EQ(0, first);
+    EXPECT_EQ(firstAddress, &array[0]);
+    EXPECT_EQ(10000, array.Size());
+    EXPECT_EQ(9999, array[9999]);
+    uint32_t index { 0 };
+    array.ForEach([&index](const uint32_t element)
+    {
+        EXPECT_EQ(index == 0 ? 7 : index, element);
+        ++index;
+    });
+
+    EXPECT_EQ(10000, index);
+}
+
+// Checks equal strings get the same index.
+TEST(FunctionTableTests, StringPoolInternsOnce)
+{
+    // Arrange
+    StringPool pool {};
+
+    // Act
+    const uint32_t first { pool.Intern(L"HelloWorld.Program") };
+    const uint32_t second { pool.Intern(L"Main") };
+    const uint32_t again { pool.Intern(std::wstring { L"HelloWorld.Program" }) };
+
+    // Assert
+    EXPECT_EQ(first, again);
+    EXPECT_NE(first, second);
+    EXPECT_EQ(2, pool.Size());
+    EXPECT_EQ(L"HelloWorld.Program", pool[first]);
+    EXPECT_EQ(L"Main", pool[second]);
+}
+
+// Checks the functions get dense indices, and
+// their data are found by the runtime ids.
+TEST(FunctionTableTests, FunctionsGetDenseIndices)
+{
+    // Arrange
+    FunctionTable table {};
+
+    // Act
+    const uint32_t main { table.Add(0x7000, MakeFunctionInfo(0x100, 0x06000001)) };
+    const uint32_t run { table.Add(0x7100, MakeFunctionInfo(0x100, 0x06000002)) };
+    table.SetName(run, FunctionName { L"Run", L"HelloWorld.Program" });
+
+    // Assert
+    EXPECT_EQ(0, main);
+    EXPECT_EQ(1, run);
+    EXPECT_EQ(2, table.Count());
+    EXPECT_EQ(run, table.IndexOf(0x7100));
+    EXPECT_EQ(std::nullopt, table.IndexOf(0x7200));
+
+    const FunctionInfoWithoutName info { table.Info(run) };
+    EXPECT_EQ(0x100, info.moduleId);
+    EXPECT_EQ(0x101, info.classId);
+    EXPECT_EQ(0x06000002, info.token);
+    EXPECT_EQ(std::nullopt, table.TryGetName(main));
+    const std::optional<FunctionName> name { table.TryGetName(run) };
+    ASSERT_TRUE(name.has_value());
+    EXPECT_EQ(L"HelloWorld.Program", name->className);
+    EXPECT_EQ(L"Run", name->ownName);
+}
+
+// Checks the functions called are counted by the counters.
+TEST(FunctionTableTests, CountsCalledFunctions)
+{
+    // Arrange
+    FunctionTable table {};
+    for (uint32_t i = 0; i != 3000; ++i)
+    {
+        table.Add(0x7000 + i * 8, MakeFunctionInfo(0x100, 0x06000001 + i));
+    }
+
+    FunctionRuntimeInfo& runtimeInfo { table.RuntimeInfo(*table.IndexOf(0x7000 + 2500 * 8)) };
+
+    // Act
+    runtimeInfo.callCount.fetch_add(2);
+    table.RuntimeInfo(0).callCount.fetch_add(1);
+    table.Add(0x9000, MakeFunctionInfo(0x100, 0x06001000));
+
+    // Assert
+    EXPECT_EQ(&runtimeInfo, &table.RuntimeInfo(2500));
+    EXPECT_EQ(2, table.CountCalled());
+    EXPECT_EQ(2, runtimeInfo.callCount.load());
+}
+
+// Checks the names of the chosen functions are resolved once,
+// in one batch for each module, and the names not resolved
+// are asked for again.
+TEST(FunctionTableTests, ResolvesNamesByModule)
+{
+    // Arrange
+    FunctionTable table {};
+    const uint32_t first { table.Add(0x7000, MakeFunctionInfo(0x100, 0x06000001)) };
+    const uint32_t notChosen { table.Add(0x7100, MakeFunctionInfo(0x100, 0x06000002)) };
+    const uint32_t second { table.Add(0x7200, MakeFunctionInfo(0x100, 0x06000003)) };
+    const uint32_t unknown { table.Add(0x7300, MakeFunctionInfo(0x200, 0x06000001)) };
+
+    std::vector<std::pair<ModuleID, std::vector<mdToken>>> batches {};
+    const auto choose { [notChosen](const uint32_t index) { return index != notChosen; } };
+    const auto resolveModule { [&batches](const ModuleID moduleId, const std::vector<mdToken>& tokens)
+    {
+        batches.emplace_back(moduleId, tokens);
+        std::vector<std::optional<FunctionName>> result(tokens.size());
+        if (moduleId == 0x100)
+        {
+            for (size_t i = 0; i != tokens.size(); ++i)
+            {
+                result[i] = FunctionName { L"M" + std::to_wstring(tokens[i] & 0xFF), L"C" };
+            }
+        }
+
+        return result;
+    } };
+
+    // Act
+    table.ResolveNames(choose, resolveModule);
+    table.ResolveNames(choose, resolveModule);
+
+    // Assert
+    const std::vector<std::pair<ModuleID, std::vector<mdToken>>> expected {
+        { 0x100, { 0x06000001, 0x06000003 } },
+        { 0x200, { 0x06000001 } },
+        { 0x200, { 0x06000001 } } };
+    EXPECT_EQ(expected, batches);
+    EXPECT_EQ(L"M1", table.TryGetName(first)->ownName);
+    EXPECT_EQ(L"M3", table.TryGetName(second)->ownName);
+    EXPECT_EQ(L"C", table.TryGetName(second)->className);
+    EXPECT_EQ(std::nullopt, table.TryGetName(notChosen));
+    EXPECT_EQ(std::nullopt, table.TryGetName(unknown));
+}
+
+// Measures mapping many functions with their names read at once, and
+// with the tokens only, the names of the called functions resolved
+// for a report, together with the characters of the names kept.
+TEST(FunctionTableTests, DISABLED_BenchmarkDeferredNames)
+{
+    constexpr uint32_t functionsCount { 100'000 };
+    constexpr uint32_t methodsPerClass { 50 };
+    constexpr ModuleID moduleId { 0x100 };
+
+    // The names the metadata give by the method tokens.
+    std::vector<FunctionName> metadataNames {};
+    metadataNames.reserve(functionsCount);
+    for (uint32_t i = 0; i != functionsCount; ++i)
+    {
+        metadataNames.push_back(FunctionName {
+            L"ProcessOrderItem" + std::to_wstring(i),
+            L"MyCompany.Product.Services.OrderProcessingService" + std::to_wstring(i / methodsPerClass) });
+    }
+
+    // Reads the names, as the metadata do, making new strings.
+    const auto readName { [&metadataNames](const mdToken token)
+    {
+        return metadataNames[token - 0x06000001];
+    } };
+
+    // The functions of one class of ten are called, and need their names in the report.
+    const auto isCalled { [](const uint32_t index) { return index / methodsPerClass % 10 == 0; } };
+    const auto resolveModule { [&readName](ModuleID, const std::vector<mdToken>& tokens)
+    {
+        std::vector<std::optional<FunctionName>> result {};
+        result.reserve(tokens.size());
+        for (const mdToken token : tokens)
+        {
+            result.push_back(readName(token));
+        }
+
+        return result;
+    } };
+
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point eagerStart { Clock::now() };
+    {
+        FunctionTable table {};
+        for (uint32_t i = 0; i != functionsCount; ++i)
+        {
+            const mdToken token { 0x06000001 + i };
+            const uint32_t index { table.Add(0x7000 + i * 8, MakeFunctionInfo(moduleId, token)) };
+            table.SetName(index, readName(token));
+        }
+    }
+
+    const double eagerDuration { std::chrono::duration<double, std::nano>(Clock::now() - eagerStart).count() };
+
+    const Clock::time_point deferredStart { Clock::now() };
+    FunctionTable table {};
+    for (uint32_t i = 0; i != functionsCount; ++i)
+    {
+        table.Add(0x7000 + i * 8, MakeFunctionInfo(moduleId, 0x06000001 + i));
+    }
+
+    const double deferredDuration { std::chrono::duration<double, std::nano>(Clock::now() - deferredStart).count() };
+
+    const Clock::time_point resolveStart { Clock::now() };
+    table.ResolveNames(isCalled, resolveModule);
+    const double resolveDuration { std::chrono::duration<double, std::nano>(Clock::now() - resolveStart).count() };
+
+    // The names are interned, so each distinct name is kept once.
+    const auto countNameBytes { [&metadataNames](const auto& isKept)
+    {
+        std::unordered_set<std::wstring> names {};
+        for (uint32_t i = 0; i != functionsCount; ++i)
+        {
+            if (isKept(i))
+            {
+                names.insert(metadataNames[i].className);
+                names.insert(metadataNames[i].ownName);
+            }
+        }
+
+        size_t bytes { 0 };
+        for (const std::wstring& name : names)
+        {
+            bytes += (name.size() + 1) * sizeof(wchar_t);
+        }
+
+        return bytes;
+    } };
+
+    EXPECT_EQ(L"ProcessOrderItem1", table.TryGetName(1)->ownName);
+    EXPECT_EQ(std::nullopt, table.TryGetName(methodsPerClass));
+    ReportBenchmark("mapping, names read", eagerDuration / functionsCount, "ns per function");
+    ReportBenchmark("mapping, tokens only", deferredDuration / functionsCount, "ns per function");
+    ReportBenchmark("report, names of called functions", resolveDuration / functionsCount, "ns per mapped function");
+    ReportBenchmark("names kept, read at mapping", countNameBytes([](uint32_t) { return true; }) / 1024.0, "KiB");
+    ReportBenchmark("names kept, resolved for report", countNameBytes(isCalled) / 1024.0, "KiB");
+}
+
+// Measures the cost of counting a call in the Enter hook: by the
+// function id, with a lookup of the function data, the full name built,
+// and a lookup of the counter, and by the client data, which is the
+// index of the function, with one relaxed atomic increment, from
+// several threads at once.
+TEST(FunctionTableTests, DISABLED_BenchmarkEnterHook)
+{
+    constexpr uint32_t functionsCount { 10'000 };
+    constexpr size_t callsPerThread { 2'000'000 };
+    FunctionTable table {};
+    std::unordered_map<FunctionID, FunctionInfo> functionInfos {};
+    std::unordered_map<FunctionID, size_t> callCounts {};
+    for (uint32_t i = 0; i != functionsCount; ++i)
+    {
+        const FunctionID id { 0x7000 + i * 8 };
+        const FunctionInfoWithoutName info { MakeFunctionInfo(0x100, 0x06000001 + i) };
+        table.Add(id, info);
+        FunctionInfo& functionInfo { functionInfos[id] };
+        static_cast<FunctionInfoWithoutName&>(functionInfo) = info;
+        functionInfo.name = FunctionName { L"Method" + std::to_wstring(i), L"HelloWorld.Program" };
+        callCounts.try_emplace(id, 0);
+    }
+
+    std::minstd_rand random { 42 };
+    std::vector<uint32_t> calls(callsPerThread);
+    for (uint32_t& call : calls)
+    {
+        call = random() % functionsCount;
+    }
+
+    // The hooks are called through pointers, as the runtime does.
+    static void (* volatile s_lookupHook)(
+        std::unordered_map<FunctionID, FunctionInfo>&,
+        std::unordered_map<FunctionID, size_t>&,
+        FunctionID) {
+        [](std::unordered_map<FunctionID, FunctionInfo>& infos,
+            std::unordered_map<FunctionID, size_t>& counts,
+            const FunctionID id)
+        {
+            const auto found { infos.find(id) };
+            if (found != infos.cend())
+            {
+                KeepResult(found->second.fullName().size());
+                ++counts.find(id)->second;
+            }
+        } };
+
+    static void (* volatile s_clientDataHook)(FunctionTable&, UINT_PTR) {
+        [](FunctionTable& functions, const UINT_PTR clientData)
+        {
+            functions.RuntimeInfo(static_cast<uint32_t>(clientData)).callCount.fetch_add(1, std::memory_order_relaxed);
+        } };
+
+    // The maps are not synchronized, so they are called from one thread only.
+    const double lookupDuration { MeasureThreadsNanoseconds(1, [&calls, &functionInfos, &callCounts](size_t)
+    {
+        for (const uint32_t call : calls)
+        {
+            s_lookupHook(functionInfos, callCounts, 0x7000 + call * 8);
+        }
+    }) };
+
+    ReportBenchmark("lookup by id, 1 thread", lookupDuration / callsPerThread, "ns per call");
+    for (const size_t threadsCount : { 1, 2, 4, 8 })
+    {
+        const double spreadDuration { MeasureThreadsNanoseconds(threadsCount, [&calls, &table](size_t)
+        {
+            for (const uint32_t call : calls)
+            {
+                s_clientDataHook(table, call);
+            }
+        }) };
+
+        const double hotDuration { MeasureThreadsNanoseconds(threadsCount, [&table](size_t)
+        {
+            for (size_t i = 0; i != callsPerThread; ++i)
+            {
+                s_clientDataHook(table, 0);
+            }
+        }) };
+
+        const std::string threads { std::to_string(threadsCount) + (threadsCount == 1 ? " thread" : " threads") };
+        const double callsCount { static_cast<double>(callsPerThread * threadsCount) };
+        ReportBenchmark("client data, " + threads + ", spread calls", spreadDuration / callsCount, "ns per call");
+        ReportBenchmark("client data, " + threads + ", one hot function", hotDuration / callsCount, "ns per call");
+    }
+}
@@ -1,6 +1,8 @@
 #include "pch.h"
 
+#include "Benchmark.h"
 #include "InstructionStream.h"
+#include "MethodBody.h"
 
 using namespace Drill4dotNet;
 
@@ -723,3 +725,230 @@ TEST(InstructionStreamTests, CreateLabelUnique)
     // Assert
     EXPECT_FALSE(first == second);
 }
+
+TEST(InstructionStreamTests, OffsetsUpdatedAfterInsert)
+{
+    // Arrange
+    LabelCreator creator{};
+    InstructionStream stream(10, OpCode::CEE_NOP{ });
+    const AbsoluteOffset offsetBeforeInsert { CalculateAbsoluteOffset(stream, stream.cbegin() + 5) };
+
+    // Act
+    stream.insert(stream.cbegin() + 2, OpCode::CEE_LDC_I4{ 42 });
+    stream.insert(stream.cbegin() + 2, creator.CreateLabel());
+    const AbsoluteOffset offsetAfterInsert { CalculateAbsoluteOffset(stream, stream.cbegin() + 7) };
+    const ConstStreamPosition sixthInstruction { GetNthInstruction(stream, 5) };
+    const ConstStreamPosition atOffset { ResolveAbsoluteOffset(stream, 2) };
+
+    // Assert
+    EXPECT_EQ(5, offsetBeforeInsert);
+    EXPECT_EQ(10, offsetAfterInsert);
+    EXPECT_EQ(stream.cbegin() + 6, sixthInstruction);
+    EXPECT_EQ(stream.cbegin() + 3, atOffset);
+}
+
+TEST(InstructionStreamTests, OffsetsUpdatedAfterReplace)
+{
+    // Arrange
+    InstructionStream stream(10, OpCode::CEE_NOP{ });
+    const AbsoluteOffset offsetBeforeReplace { CalculateAbsoluteOffset(stream, stream.cend()) };
+
+    // Act
+    stream.Replace(stream.cbegin() + 3, OpCode::CEE_LDC_I4{ 42 });
+    const AbsoluteOffset offsetAfterReplace { CalculateAbsoluteOffset(stream, stream.cend()) };
+    const ConstStreamPosition afterReplaced { ResolveAbsoluteOffset(stream, 8) };
+    const ConstStreamPosition insideReplaced { ResolveAbsoluteOffset(stream, 5) };
+
+    // Assert
+    EXPECT_EQ(10, offsetBeforeReplace);
+    EXPECT_EQ(14, offsetAfterReplace);
+    EXPECT_EQ(stream.cbegin() + 4, afterReplaced);
+    EXPECT_EQ(stream.cend(), insideReplaced);
+    AssertHolds<OpCode::CEE_LDC_I4>(stream.cbegin() + 3, stream);
+}
+
+// Checks the indexed queries against a walk over
+// a stream big enough to have a deep index.
+TEST(InstructionStreamTests, ResolveOffsetsInLargeStream)
+{
+    // Arrange
+    LabelCreator creator{};
+    InstructionStream stream{};
+    for (int32_t i { 0 }; i != 1000; ++i)
+    {
+        if (i % 7 == 0)
+        {
+            stream.push_back(creator.CreateLabel());
+        }
+
+        if (i % 3 == 0)
+        {
+            stream.push_back(OpCode::CEE_LDC_I4{ i });
+        }
+        else
+        {
+            stream.push_back(OpCode::CEE_NOP{});
+        }
+    }
+
+    // Jumps from the first instruction, which is ldc.i4, are
+    // relative to the end of it.
+    const LongJump::Offset firstInstructionSize { 5 };
+
+    // Act & Assert
+    AbsoluteOffset expectedOffset { 0 };
+    size_t expectedNumber { 0 };
+    for (ConstStreamPosition current { stream.cbegin() }; current != stream.cend(); ++current)
+    {
+        ASSERT_EQ(expectedOffset, CalculateAbsoluteOffset(stream, current));
+        const StreamElement element { *current };
+        if (const OpCodeVariant* const instruction = std::get_if<OpCodeVariant>(&element)
+            ; instruction != nullptr)
+        {
+            ASSERT_EQ(current, ResolveAbsoluteOffset(stream, expectedOffset));
+            ASSERT_EQ(current, GetNthInstruction(stream, expectedNumber));
+            ASSERT_EQ(current, ResolveJumpOffset(stream, stream.cbegin(), static_cast<LongJump::Offset>(expectedOffset) - firstInstructionSize));
+            expectedOffset += instruction->SizeWithArgument();
+            ++expectedNumber;
+        }
+    }
+
+    EXPECT_EQ(expectedOffset, CalculateAbsoluteOffset(stream, stream.cend()));
+    EXPECT_EQ(stream.cend(), GetNthInstruction(stream, expectedNumber));
+}
+
+TEST(InstructionStreamTests, FindLabelAfterInsert)
+{
+    // Arrange
+    LabelCreator creator{};
+    const Label first { creator.CreateLabel() };
+    const Label second { creator.CreateLabel() };
+    const Label notMarked { creator.CreateLabel() };
+    InstructionStream stream {
+        first,
+        OpCode::CEE_NOP{},
+        OpCode::CEE_NOP{},
+        second,
+        OpCode::CEE_NOP{}
+    };
+
+    const ptrdiff_t secondBeforeInsert { FindLabel(stream, second) - stream.cbegin() };
+
+    // Act
+    stream.insert(stream.cbegin() + 1, OpCode::CEE_ADD{});
+    const ConstStreamPosition firstAfterInsert { FindLabel(stream, first) };
+    const ConstStreamPosition secondAfterInsert { FindLabel(stream, second) };
+    const ConstStreamPosition notFound { FindLabel(stream, notMarked) };
+
+    // Assert
+    EXPECT_EQ(3, secondBeforeInsert);
+    EXPECT_EQ(stream.cbegin(), firstAfterInsert);
+    EXPECT_EQ(stream.cbegin() + 4, secondAfterInsert);
+    EXPECT_EQ(stream.cend(), notFound);
+}
+
+// Measures the memory the streams of the corpus methods
+// take from their resource, with the offsets index built.
+TEST(InstructionStreamTests, DISABLED_BenchmarkMemoryPerInstruction)
+{
+    CountingResource resource {};
+    std::vector<InstructionStream> streams {};
+    size_t instructionsCount { 0 };
+    for (const std::vector<std::byte>& bytes : MakeMethodCorpus())
+    {
+        InstructionStream stream { MethodBody(bytes, &resource).Stream() };
+        KeepResult(stream.OffsetOf(stream.cend()));
+        instructionsCount += stream.InstructionsBefore(stream.cend());
+        streams.push_back(std::move(stream));
+    }
+
+    ReportBenchmark("stream memory", static_cast<double>(resource.BytesInUse()) / instructionsCount, "bytes per instruction");
+}
+
+// Measures the time per instruction to scan the corpus methods:
+// to find the calls, to tell the instructions from the labels,
+// and to visit each instruction, by the elements, and to do the
+// same by the positions, without making the elements.
+TEST(InstructionStreamTests, DISABLED_BenchmarkScan)
+{
+    std::vector<MethodBody> methods {};
+    size_t instructionsCount { 0 };
+    for (const std::vector<std::byte>& bytes : MakeMethodCorpus())
+    {
+        const MethodBody& method { methods.emplace_back(bytes) };
+        instructionsCount += method.Stream().InstructionsBefore(method.end());
+    }
+
+    const double findCalls { MeasureNanoseconds([&methods]()
+    {
+        size_t callsCount { 0 };
+        for (const MethodBody& method : methods)
+        {
+            for (ConstStreamPosition call { FindInstruction<OpCode::CEE_CALL>(method.begin(), method.end()) }
+                ; call != method.end()
+                ; call = FindInstruction<OpCode::CEE_CALL>(call + 1, method.end()))
+            {
+                ++callsCount;
+            }
+        }
+
+        KeepResult(callsCount);
+    }) };
+
+    const double skipLabels { MeasureNanoseconds([&methods]()
+    {
+        size_t count { 0 };
+        for (const MethodBody& method : methods)
+        {
+            for (const StreamElement& element : method.Stream())
+            {
+                count += std::holds_alternative<OpCodeVariant>(element);
+            }
+        }
+
+        KeepResult(count);
+    }) };
+
+    const double visit { MeasureNanoseconds([&methods]()
+    {
+        size_t withArgument { 0 };
+        for (const MethodBody& method : methods)
+        {
+            for (const StreamElement& element : method.Stream())
+            {
+                if (const OpCodeVariant* const instruction { std::get_if<OpCodeVariant>(&element) }
+                    ; instruction != nullptr)
+                {
+                    instruction->Visit([&withArgument](const auto& opcode)
+                    {
+                        withArgument += std::decay_t<decltype(opcode)>::HasArgument();
+                    });
+                }
+            }
+        }
+
+        KeepResult(withArgument);
+    }) };
+
+    const double positions { MeasureNanoseconds([&methods]()
+    {
+        size_t withArgument { 0 };
+        for (const MethodBody& method : methods)
+        {
+            for (ConstStreamPosition current { method.begin() }; current != method.end(); ++current)
+            {
+                if (!current.IsLabel())
+                {
+                    withArgument += current.Info().ArgumentKind != OpCodeArgumentKind::InlineNone;
+                }
+            }
+        }
+
+        KeepResult(withArgument);
+    }) };
+
+    ReportBenchmark("FindInstruction<CEE_CALL>", findCalls / instructionsCount, "ns per instruction");
+    ReportBenchmark("holds_alternative", skipLabels / instructionsCount, "ns per instruction");
+    ReportBenchmark("Visit", visit / instructionsCount, "ns per instruction");
+    ReportBenchmark("IsLabel and Info", positions / instructionsCount, "ns per instruction");
+}
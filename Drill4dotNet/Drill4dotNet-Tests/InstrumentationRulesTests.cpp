@@ -0,0 +1,136 @@
+#include "pch.h"
+
+#include "InstrumentationRules.h"
+
+using namespace Drill4dotNet;
+
+// Checks '*' and '?' in patterns, and the characters matching themselves.
+TEST(InstrumentationRulesTests, MatchesPattern)
+{
+    // Assert
+    EXPECT_TRUE(MatchesPattern(L"Program", L"Program"));
+    EXPECT_TRUE(MatchesPattern(L"Program", L"P?og*"));
+    EXPECT_TRUE(MatchesPattern(L"HelloWorld.Program", L"*.Pro*ram"));
+    EXPECT_TRUE(MatchesPattern(L"", L"*"));
+    EXPECT_TRUE(MatchesPattern(L"aaab", L"*a*b"));
+    EXPECT_FALSE(MatchesPattern(L"Program", L"program"));
+    EXPECT_FALSE(MatchesPattern(L"Program", L"Prog"));
+    EXPECT_FALSE(MatchesPattern(L"Prog", L"Prog?"));
+    EXPECT_FALSE(MatchesPattern(L"aaab", L"*a*c"));
+}
+
+// Checks all the prefixes of a text are found, in
+// the order of their lengths, including the empty one.
+TEST(InstrumentationRulesTests, PrefixTrieFindsAllPrefixes)
+{
+    // Arrange
+    PrefixTrie trie { true };
+    trie.Insert(L"Hello", 0);
+    trie.Insert(L"", 1);
+    trie.Insert(L"HelloWorld", 2);
+    trie.Insert(L"help", 3);
+    trie.Insert(L"hello", 4);
+    std::vector<size_t> found {};
+
+    // Act
+    trie.ForEachPrefixOf(L"HELLOWORLD.dll", [&found](const size_t value) { found.push_back(value); });
+
+    // Assert
+    EXPECT_EQ((std::vector<size_t> { 1, 0, 4, 2 }), found);
+}
+
+// Checks the rules made from the packages prefixes
+// instrument all methods of the matching modules only.
+TEST(InstrumentationRulesTests, PackagesPrefixesChooseModules)
+{
+    // Arrange
+    const InstrumentationRules rules { RulesFromPackagesPrefixes({ L"HelloWorld", L"MyCompany." }) };
+
+    // Assert
+    EXPECT_EQ(ModuleRules::Scope::All, rules.ForModule(L"helloworld.dll").GetScope());
+    EXPECT_EQ(ModuleRules::Scope::All, rules.ForModule(L"MyCompany.Core.dll").GetScope());
+    EXPECT_EQ(ModuleRules::Scope::None, rules.ForModule(L"mscorlib.dll").GetScope());
+    EXPECT_EQ(ModuleRules::Scope::None, rules.ForModule(L"MyCompanyCore.dll").GetScope());
+    EXPECT_TRUE(rules.ForModule(L"HelloWorld.dll").Matches(L"Any.Class", L"Any"));
+    EXPECT_FALSE(rules.ForModule(L"System.dll").Matches(L"Any.Class", L"Any"));
+}
+
+// Checks the methods are chosen by names in the modules having
+// such rules, and the excluding rules win over the including ones.
+TEST(InstrumentationRulesTests, NamesChooseMethods)
+{
+    // Arrange
+    const InstrumentationRules rules { {
+        InstrumentationRule {
+            .Include = true,
+            .ModulePrefix = L"HelloWorld",
+            .NamespacePrefix = L"HelloWorld." },
+        InstrumentationRule {
+            .Include = false,
+            .ModulePrefix = L"HelloWorld",
+            .ClassPattern = L"*Tests",
+            .MethodPattern = L"Setup*" },
+        InstrumentationRule {
+            .Include = false,
+            .ModulePrefix = L"Generated" } } };
+
+    // Act
+    const ModuleRules moduleRules { rules.ForModule(L"HelloWorld.dll") };
+
+    // Assert
+    EXPECT_EQ(ModuleRules::Scope::ByName, moduleRules.GetScope());
+    EXPECT_TRUE(moduleRules.Matches(L"HelloWorld.Program", L"Main"));
+    EXPECT_TRUE(moduleRules.Matches(L"HelloWorld.ProgramTests", L"Run"));
+    EXPECT_FALSE(moduleRules.Matches(L"HelloWorld.ProgramTests", L"SetupAll"));
+    EXPECT_FALSE(moduleRules.Matches(L"Other.Program", L"Main"));
+    EXPECT_EQ(ModuleRules::Scope::None, rules.ForModule(L"Generated.dll").GetScope());
+}
+
+// Checks an excluding rule without names
+// excludes the whole module.
+TEST(InstrumentationRulesTests, ExcludingModuleWins)
+{
+    // Arrange
+    const InstrumentationRules rules { {
+        InstrumentationRule {
+            .Include = true,
+            .ModulePrefix = L"HelloWorld" },
+        InstrumentationRule {
+            .Include = false,
+            .ModulePrefix = L"HelloWorld.Tests" } } };
+
+    // Assert
+    EXPECT_EQ(ModuleRules::Scope::All, rules.ForModule(L"HelloWorld.dll").GetScope());
+    EXPECT_EQ(ModuleRules::Scope::None, rules.ForModule(L"HelloWorld.Tests.dll").GetScope());
+}
+
+// Checks the classes are decided without method names,
+// unless some rule for the class looks at them.
+TEST(InstrumentationRulesTests, ClassesChooseScope)
+{
+    // Arrange
+    const InstrumentationRules rules { {
+        InstrumentationRule {
+            .Include = true,
+            .ModulePrefix = L"HelloWorld",
+            .NamespacePrefix = L"HelloWorld." },
+        InstrumentationRule {
+            .Include = false,
+            .ModulePrefix = L"HelloWorld",
+            .ClassPattern = L"*Generated" },
+        InstrumentationRule {
+            .Include = false,
+            .ModulePrefix = L"HelloWorld",
+            .ClassPattern = L"*Tests",
+            .MethodPattern = L"Setup*" } } };
+
+    // Act
+    const ModuleRules moduleRules { rules.ForModule(L"HelloWorld.dll") };
+
+    // Assert
+    EXPECT_EQ(ModuleRules::Scope::All, moduleRules.ForClass(L"HelloWorld.Program"));
+    EXPECT_EQ(ModuleRules::Scope::None, moduleRules.ForClass(L"HelloWorld.ProgramGenerated"));
+    EXPECT_EQ(ModuleRules::Scope::ByName, moduleRules.ForClass(L"HelloWorld.ProgramTests"));
+    EXPECT_EQ(ModuleRules::Scope::None, moduleRules.ForClass(L"System.Object"));
+    EXPECT_EQ(ModuleRules::Scope::None, rules.ForModule(L"mscorlib.dll").ForClass(L"HelloWorld.Program"));
+}
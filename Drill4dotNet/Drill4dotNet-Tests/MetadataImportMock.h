@@ -59,6 +59,8 @@ namespace Drill4dotNet
         MOCK_METHOD(std::optional<MemberReferenceProps>, TryGetMemberReferenceProps, (const mdMemberRef memberToken), (const));
         MOCK_METHOD(std::vector<std::byte>, GetSignatureBlob, (const mdSignature signatureToken), (const));
         MOCK_METHOD(std::optional<std::vector<std::byte>>, TryGetSignatureBlob, (const mdSignature signatureToken), (const));
+        MOCK_METHOD(mdToken, GetMethodSpecificationParent, (const mdMethodSpec methodSpecificationToken), (const));
+        MOCK_METHOD(std::optional<mdToken>, TryGetMethodSpecificationParent, (const mdMethodSpec methodSpecificationToken), (const));
         MOCK_METHOD(std::vector<mdTypeDef>, EnumTypeDefinitions, (), (const));
         MOCK_METHOD(std::optional<std::vector<mdTypeDef>>, TryEnumTypeDefinitions, (), (const));
         MOCK_METHOD(std::vector<mdMethodDef>, EnumMethods, (const mdTypeDef enclosingType), (const));
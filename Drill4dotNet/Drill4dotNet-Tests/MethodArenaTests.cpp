@@ -0,0 +1,238 @@
+#include "pch.h"
+
+#include "Benchmark.h"
+#include "MethodArena.h"
+#include "MethodBody.h"
+
+#include <atomic>
+#include <cstdlib>
+
+using namespace Drill4dotNet;
+
+// The count of the calls of the global operator new in the tests.
+// Allows to see the heap allocations, which bypass the memory resources.
+static std::atomic<size_t> s_globalAllocations { 0 };
+
+// Replaces the global operator new of the tests,
+// counting the calls in s_globalAllocations.
+void* operator new(const size_t size)
+{
+    s_globalAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* const result { std::malloc(size == 0 ? 1 : size) }
+        ; result != nullptr)
+    {
+        return result;
+    }
+
+    throw std::bad_alloc();
+}
+
+// Replaces the global operator delete, to match operator new.
+void operator delete(void* const pointer) noexcept
+{
+    std::free(pointer);
+}
+
+// Replaces the global sized operator delete, to match operator new.
+void operator delete(void* const pointer, size_t) noexcept
+{
+    std::free(pointer);
+}
+
+// Creates method body representing
+// public static int F(bool x)
+// {
+//     if (x) { }
+//     return 1;
+// }
+static std::vector<std::byte> CreateBranchingFunction()
+{
+    return {
+        std::byte { 0x1A }, // tiny header, 6 bytes of code
+        std::byte { 0x02 }, // ldarg.0
+        std::byte { 0x2C }, // brfalse.s
+        std::byte { 0x01 }, //     +1
+        std::byte { 0x00 }, // nop
+        std::byte { 0x17 }, // ldc.i4.1
+        std::byte { 0x2A }  // ret
+    };
+}
+
+// Creates method body representing
+// public static void F(int x)
+// {
+//     switch (x) { case 0: case 1: }
+// }
+static std::vector<std::byte> CreateSwitchFunction()
+{
+    return {
+        std::byte { 0x46 }, // tiny header, 17 bytes of code
+        std::byte { 0x02 }, // ldarg.0
+        std::byte { 0x45 }, // switch
+        std::byte { 0x02 }, //     2 targets
+        std::byte { 0x00 },
+        std::byte { 0x00 },
+        std::byte { 0x00 },
+        std::byte { 0x00 }, //     +0
+        std::byte { 0x00 },
+        std::byte { 0x00 },
+        std::byte { 0x00 },
+        std::byte { 0x01 }, //     +1
+        std::byte { 0x00 },
+        std::byte { 0x00 },
+        std::byte { 0x00 },
+        std::byte { 0x00 }, // nop
+        std::byte { 0x00 }, // nop
+        std::byte { 0x2A }  // ret
+    };
+}
+
+// Decodes the given method with memory from the given arena,
+// inserts an instruction, and compiles the method.
+// @param bodyBytes : the method body bytes.
+// @param arena : the arena to take memory from.
+static std::vector<std::byte> InstrumentInArena(
+    const std::vector<std::byte>& bodyBytes,
+    MethodArena& arena)
+{
+    MethodBody method(bodyBytes, arena.Resource());
+    method.BeginEdit();
+    method.Insert(method.begin(), OpCode::CEE_NOP{});
+    method.CommitEdit();
+    return method.Compile();
+}
+
+// Decodes the given method with memory from the given resource,
+// inserts an instruction, and compiles the method into the target,
+// as JITCompilationStarted does.
+// @param bodyBytes : the method body bytes.
+// @param resource : the resource to take memory from.
+// @param target : receives the compiled method.
+static void InstrumentInto(
+    const std::vector<std::byte>& bodyBytes,
+    std::pmr::memory_resource* const resource,
+    std::vector<std::byte>& target)
+{
+    MethodBody method(bodyBytes, resource);
+    method.BeginEdit();
+    method.Insert(method.begin(), OpCode::CEE_NOP{});
+    method.CommitEdit();
+    target.resize(method.ComputeCompiledSize());
+    method.CompileInto(target);
+}
+
+// Checks a method is decoded, edited and compiled
+// without heap allocations, when it fits the arena,
+// and the result is the same as without the arena.
+TEST(MethodArenaTests, InstrumentWithoutHeapAllocations)
+{
+    // Arrange
+    const std::vector<std::byte> bodyBytes { CreateBranchingFunction() };
+    MethodBody expectedMethod(bodyBytes);
+    expectedMethod.Insert(expectedMethod.begin(), OpCode::CEE_NOP{});
+    const std::vector<std::byte> expectedBytes { expectedMethod.Compile() };
+    MethodArena arena {};
+
+    // Act
+    const std::vector<std::byte> actualBytes { InstrumentInArena(bodyBytes, arena) };
+
+    // Assert
+    EXPECT_EQ(expectedBytes, actualBytes);
+    EXPECT_EQ(0, arena.HeapAllocationsCount());
+}
+
+// Checks the arena grows after a method has not fitted,
+// so the next methods of the same size do not use the heap.
+TEST(MethodArenaTests, GrowsAfterOverflow)
+{
+    // Arrange
+    const std::vector<std::byte> bodyBytes { CreateBranchingFunction() };
+    constexpr size_t initialSize { 64 };
+    MethodArena arena { initialSize };
+
+    // Act
+    const std::vector<std::byte> firstBytes { InstrumentInArena(bodyBytes, arena) };
+    const size_t firstHeapAllocations { arena.HeapAllocationsCount() };
+    arena.Reset();
+    const std::vector<std::byte> secondBytes { InstrumentInArena(bodyBytes, arena) };
+    const size_t secondHeapAllocations { arena.HeapAllocationsCount() };
+    arena.Reset();
+
+    // Assert
+    EXPECT_EQ(firstBytes, secondBytes);
+    EXPECT_NE(0, firstHeapAllocations);
+    EXPECT_EQ(0, secondHeapAllocations);
+    EXPECT_LT(initialSize, arena.BufferSize());
+}
+
+// Checks a method with a switch is decoded, edited and compiled
+// without calls of the global operator new, when it fits the arena.
+TEST(MethodArenaTests, InstrumentSwitchWithoutGlobalAllocations)
+{
+    // Arrange
+    const std::vector<std::byte> bodyBytes { CreateSwitchFunction() };
+    MethodBody expectedMethod(bodyBytes);
+    expectedMethod.Insert(expectedMethod.begin(), OpCode::CEE_NOP{});
+    const std::vector<std::byte> expectedBytes { expectedMethod.Compile() };
+    MethodArena arena {};
+    std::vector<std::byte> actualBytes(expectedBytes.size());
+    const size_t allocationsBefore { s_globalAllocations.load() };
+
+    // Act
+    InstrumentInto(bodyBytes, arena.Resource(), actualBytes);
+    const size_t allocations { s_globalAllocations.load() - allocationsBefore };
+
+    // Assert
+    EXPECT_EQ(expectedBytes, actualBytes);
+    EXPECT_EQ(0, allocations);
+}
+
+// Measures the calls of the global operator new and the time
+// per method to decode, edit and compile the corpus methods
+// with the heap, and with an arena.
+TEST(MethodArenaTests, DISABLED_BenchmarkHeapAllocationsPerMethod)
+{
+    const std::vector<std::vector<std::byte>> corpus { MakeMethodCorpus() };
+    std::vector<std::byte> compiled {};
+
+    std::pmr::memory_resource* const heap { std::pmr::new_delete_resource() };
+    const double heapDuration { MeasureNanoseconds([&corpus, heap, &compiled]()
+    {
+        for (const std::vector<std::byte>& bytes : corpus)
+        {
+            InstrumentInto(bytes, heap, compiled);
+        }
+    }) };
+
+    const size_t heapAllocationsBefore { s_globalAllocations.load() };
+    for (const std::vector<std::byte>& bytes : corpus)
+    {
+        InstrumentInto(bytes, heap, compiled);
+    }
+
+    const size_t heapAllocations { s_globalAllocations.load() - heapAllocationsBefore };
+
+    MethodArena arena {};
+    const double arenaDuration { MeasureNanoseconds([&corpus, &arena, &compiled]()
+    {
+        for (const std::vector<std::byte>& bytes : corpus)
+        {
+            InstrumentInto(bytes, arena.Resource(), compiled);
+            arena.Reset();
+        }
+    }) };
+
+    const size_t arenaAllocationsBefore { s_globalAllocations.load() };
+    for (const std::vector<std::byte>& bytes : corpus)
+    {
+        InstrumentInto(bytes, arena.Resource(), compiled);
+        arena.Reset();
+    }
+
+    const size_t arenaAllocations { s_globalAllocations.load() - arenaAllocationsBefore };
+
+    ReportBenchmark("operator new calls, heap", static_cast<double>(heapAllocations) / corpus.size(), "per method");
+    ReportBenchmark("operator new calls, arena", static_cast<double>(arenaAllocations) / corpus.size(), "per method");
+    ReportBenchmark("instrumentation, heap", heapDuration / corpus.size(), "ns per method");
+    ReportBenchmark("instrumentation, arena", arenaDuration / corpus.size(), "ns per method");
+}
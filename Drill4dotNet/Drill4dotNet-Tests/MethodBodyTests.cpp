@@ -1,9 +1,48 @@
 #include "pch.h"
 
+#include "Benchmark.h"
 #include "MethodBody.h"
+#include "MethodPatcher.h"
 
 using namespace Drill4dotNet;
 
+// Checks MethodPatcher gives the same bytes as MethodBody::Compile(),
+// when nothing is inserted, and when instructions are inserted
+// before each instruction of the given method.
+// @param sourceBytes : the method body bytes.
+static void ExpectPatcherAgreesWithMethodBody(const std::vector<std::byte>& sourceBytes)
+{
+    EXPECT_EQ(sourceBytes, MethodPatcher(sourceBytes).Patch());
+
+    // Enough to make the short jumps over the inserted instructions long,
+    // if the tiny header does not limit the code size.
+    const size_t nopsCount { MethodHeader(sourceBytes).Size() == 1 ? 1 : 130 };
+    const std::vector<std::byte> nops(nopsCount, std::byte { 0x00 });
+    const MethodBody source(sourceBytes);
+    for (ConstStreamPosition position = source.begin(); position != source.end(); ++position)
+    {
+        if (!std::holds_alternative<OpCodeVariant>(*position))
+        {
+            continue;
+        }
+
+        const size_t index = position - source.begin();
+        MethodBody expected(sourceBytes);
+        expected.BeginEdit();
+        for (size_t i = 0; i != nopsCount; ++i)
+        {
+            expected.Insert(expected.begin() + index, OpCode::CEE_NOP{});
+        }
+
+        expected.CommitEdit();
+
+        MethodPatcher patcher(sourceBytes);
+        patcher.Insert(source.Stream().OffsetOf(position), nops);
+
+        EXPECT_EQ(expected.Compile(), patcher.Patch());
+    }
+}
+
 // Checks that an std::runtime_error is thrown if
 // the method bytes end unexpectedly in the middle of
 // the instructions stream.
@@ -112,7 +151,7 @@ TEST(MethodBodyTests, InsertSimpleFunction)
 
     const InstructionStream actualSourceStream(method.Stream());
     const std::vector<std::byte> actualRoundtripBytes(method.Compile());
-    const std::vector<ExceptionsSection> actualExceptionSections(method.ExceptionSections());
+    const std::pmr::vector<ExceptionsSection> actualExceptionSections(method.ExceptionSections());
 
     method.Insert(method.begin() + 3, OpCode::CEE_LDC_I4_2{});
     method.Insert(method.begin() + 4, OpCode::CEE_MUL{});
@@ -121,6 +160,7 @@ TEST(MethodBodyTests, InsertSimpleFunction)
     const std::vector<std::byte> actualInjectionBytes(method.Compile());
 
     // Assert
+    ExpectPatcherAgreesWithMethodBody(sourceBytes);
     EXPECT_EQ(expectedSourceStream, actualSourceStream);
     EXPECT_EQ(expectedRoundtripBytes, actualRoundtripBytes);
     EXPECT_EQ(0, actualExceptionSections.size());
@@ -179,8 +219,7 @@ TEST(MethodBodyTests, InsertFunctionWithIf)
 
     LabelCreator sourceStreamLabelCreator{};
     const Label elseLabel{ sourceStreamLabelCreator.CreateLabel() };
-    const Label endLabel1{ sourceStreamLabelCreator.CreateLabel() };
-    const Label endLabel2{ sourceStreamLabelCreator.CreateLabel() };
+    const Label endLabel{ sourceStreamLabelCreator.CreateLabel() };
     // Got these values from MS IL decompiler.
     const InstructionStream expectedSourceStream{
         // if (a)
@@ -196,18 +235,17 @@ TEST(MethodBodyTests, InsertFunctionWithIf)
         OpCode::CEE_LDARG_2{},
         OpCode::CEE_MUL{},
         OpCode::CEE_STLOC_1{},
-        OpCode::CEE_BR_S{endLabel1},
+        OpCode::CEE_BR_S{endLabel},
 
         // return 0; // <- 0;
         elseLabel,
         OpCode::CEE_NOP{},
         OpCode::CEE_LDC_I4_0{},
         OpCode::CEE_STLOC_1{},
-        OpCode::CEE_BR_S{endLabel2},
+        OpCode::CEE_BR_S{endLabel},
 
         // return
-        endLabel1,
-        endLabel2,
+        endLabel,
         OpCode::CEE_LDLOC_1{},
         OpCode::CEE_RET{}
     };
@@ -226,7 +264,7 @@ TEST(MethodBodyTests, InsertFunctionWithIf)
         OpCode::CEE_LDARG_2{},
         OpCode::CEE_MUL{},
         OpCode::CEE_STLOC_1{},
-        OpCode::CEE_BR_S{endLabel1},
+        OpCode::CEE_BR_S{endLabel},
 
         // return 0 + x + y; // <- 0 + x + y;
         elseLabel,
@@ -237,11 +275,10 @@ TEST(MethodBodyTests, InsertFunctionWithIf)
         OpCode::CEE_LDARG_2{},
         OpCode::CEE_ADD{},
         OpCode::CEE_STLOC_1{},
-        OpCode::CEE_BR_S{endLabel2},
+        OpCode::CEE_BR_S{endLabel},
 
         // return
-        endLabel1,
-        endLabel2,
+        endLabel,
         OpCode::CEE_LDLOC_1{},
         OpCode::CEE_RET{}
     };
@@ -251,7 +288,7 @@ TEST(MethodBodyTests, InsertFunctionWithIf)
 
     const InstructionStream actualSourceStream(method.Stream());
     const std::vector<std::byte> actualRoundtripBytes(method.Compile());
-    const std::vector<ExceptionsSection> actualExceptionSections(method.ExceptionSections());
+    const std::pmr::vector<ExceptionsSection> actualExceptionSections(method.ExceptionSections());
 
     method.Insert(method.begin() + 14, OpCode::CEE_LDARG_1{});
     method.Insert(method.begin() + 15, OpCode::CEE_ADD{});
@@ -262,6 +299,7 @@ TEST(MethodBodyTests, InsertFunctionWithIf)
     const std::vector<std::byte> actualInjectionBytes(method.Compile());
 
     // Assert
+    ExpectPatcherAgreesWithMethodBody(sourceBytes);
     EXPECT_EQ(expectedSourceStream, actualSourceStream);
     EXPECT_EQ(expectedRoundtripBytes, actualRoundtripBytes);
     EXPECT_EQ(0, actualExceptionSections.size());
@@ -346,10 +384,9 @@ TEST(MethodBodyTests, InsertFunctionWithLoop)
 
     LabelCreator sourceStreamLabelCreator{};
     const Label elseLabel{ sourceStreamLabelCreator.CreateLabel() };
-    const Label endLabel1{ sourceStreamLabelCreator.CreateLabel() };
+    const Label endLabel{ sourceStreamLabelCreator.CreateLabel() };
     const Label loopConditionLabel{ sourceStreamLabelCreator.CreateLabel() };
     const Label loopBodyLabel{ sourceStreamLabelCreator.CreateLabel() };
-    const Label endLabel2{ sourceStreamLabelCreator.CreateLabel() };
     // Got these values from MS IL decompiler.
     const InstructionStream expectedSourceStream{
         // if (x < 2)
@@ -365,7 +402,7 @@ TEST(MethodBodyTests, InsertFunctionWithLoop)
         OpCode::CEE_NOP{},
         OpCode::CEE_LDARG_0{},
         OpCode::CEE_STLOC_3{},
-        OpCode::CEE_BR_S{endLabel1},
+        OpCode::CEE_BR_S{endLabel},
 
         // int previous = 0;
         elseLabel,
@@ -418,11 +455,10 @@ TEST(MethodBodyTests, InsertFunctionWithLoop)
         // return current; // <- current
         OpCode::CEE_LDLOC_1{},
         OpCode::CEE_STLOC_3{},
-        OpCode::CEE_BR_S{endLabel2},
+        OpCode::CEE_BR_S{endLabel},
 
         // return
-        endLabel1,
-        endLabel2,
+        endLabel,
         OpCode::CEE_LDLOC_3{},
         OpCode::CEE_RET{}
     };
@@ -441,7 +477,7 @@ TEST(MethodBodyTests, InsertFunctionWithLoop)
         OpCode::CEE_NOP{},
         OpCode::CEE_LDARG_0{},
         OpCode::CEE_STLOC_3{},
-        OpCode::CEE_BR_S{endLabel1},
+        OpCode::CEE_BR_S{endLabel},
 
         // int previous = 0;
         elseLabel,
@@ -496,11 +532,10 @@ TEST(MethodBodyTests, InsertFunctionWithLoop)
         // return current; // <- current
         OpCode::CEE_LDLOC_1{},
         OpCode::CEE_STLOC_3{},
-        OpCode::CEE_BR_S{endLabel2},
+        OpCode::CEE_BR_S{endLabel},
 
         // return
-        endLabel1,
-        endLabel2,
+        endLabel,
         OpCode::CEE_LDLOC_3{},
         OpCode::CEE_RET{}
     };
@@ -510,7 +545,7 @@ TEST(MethodBodyTests, InsertFunctionWithLoop)
 
     const InstructionStream actualSourceStream(method.Stream());
     const std::vector<std::byte> actualRoundtripBytes(method.Compile());
-    const std::vector<ExceptionsSection> actualExceptionSections(method.ExceptionSections());
+    const std::pmr::vector<ExceptionsSection> actualExceptionSections(method.ExceptionSections());
 
     method.Insert(method.begin() + 27, OpCode::CEE_LDC_I4_2{});
     method.Insert(method.begin() + 29, OpCode::CEE_MUL{});
@@ -519,6 +554,7 @@ TEST(MethodBodyTests, InsertFunctionWithLoop)
     const std::vector<std::byte> actualInjectionBytes(method.Compile());
 
     // Assert
+    ExpectPatcherAgreesWithMethodBody(sourceBytes);
     EXPECT_EQ(expectedSourceStream, actualSourceStream);
     EXPECT_EQ(expectedRoundtripBytes, actualRoundtripBytes);
     EXPECT_EQ(0, actualExceptionSections.size());
@@ -611,15 +647,10 @@ TEST(MethodBodyTests, InsertFunctionWithSwitch)
 
     LabelCreator sourceStreamLabelCreator{};
     const Label case0Label{ sourceStreamLabelCreator.CreateLabel() };
-    const Label case1Label{ sourceStreamLabelCreator.CreateLabel() };
-    const Label case2Label{ sourceStreamLabelCreator.CreateLabel() };
+    const Label case1And2Label{ sourceStreamLabelCreator.CreateLabel() };
     const Label case3Label{ sourceStreamLabelCreator.CreateLabel() };
     const Label defaultLabel{ sourceStreamLabelCreator.CreateLabel() };
-    const Label defaultLabel2{ sourceStreamLabelCreator.CreateLabel() };
-    const Label endLabel1{ sourceStreamLabelCreator.CreateLabel() };
-    const Label endLabel2{ sourceStreamLabelCreator.CreateLabel() };
-    const Label endLabel3{ sourceStreamLabelCreator.CreateLabel() };
-    const Label endLabel4{ sourceStreamLabelCreator.CreateLabel() };
+    const Label endLabel{ sourceStreamLabelCreator.CreateLabel() };
     // Got these values from MS IL decompiler.
     const InstructionStream expectedSourceStream{
         // switch (x)
@@ -629,8 +660,8 @@ TEST(MethodBodyTests, InsertFunctionWithSwitch)
         OpCode::CEE_LDLOC_1{},
         OpCode::CEE_STLOC_0{},
         OpCode::CEE_LDLOC_0{},
-        OpCode::CEE_SWITCH{{ case0Label, case1Label, case2Label, case3Label, defaultLabel }},
-        OpCode::CEE_BR_S{defaultLabel2},
+        OpCode::CEE_SWITCH{{ case0Label, case1And2Label, case1And2Label, case3Label, defaultLabel }},
+        OpCode::CEE_BR_S{defaultLabel},
 
         // case 0:
         case0Label,
@@ -642,12 +673,11 @@ TEST(MethodBodyTests, InsertFunctionWithSwitch)
         OpCode::CEE_STLOC_2{},
 
         // break;
-        OpCode::CEE_BR_S{endLabel1},
+        OpCode::CEE_BR_S{endLabel},
 
         // case 1:
         // case 2:
-        case1Label,
-        case2Label,
+        case1And2Label,
         // return x * y; // <- x * y
         OpCode::CEE_NOP{},
         OpCode::CEE_LDARG_0{},
@@ -656,7 +686,7 @@ TEST(MethodBodyTests, InsertFunctionWithSwitch)
         OpCode::CEE_STLOC_2{},
 
         // break;
-        OpCode::CEE_BR_S{endLabel2},
+        OpCode::CEE_BR_S{endLabel},
 
         // case 3:
         case3Label,
@@ -669,12 +699,11 @@ TEST(MethodBodyTests, InsertFunctionWithSwitch)
         OpCode::CEE_STLOC_2{},
 
         // break;
-        OpCode::CEE_BR_S{endLabel3},
+        OpCode::CEE_BR_S{endLabel},
 
         // case 4:
         // default:
         defaultLabel,
-        defaultLabel2,
 
         // return x / y; // <- x / y
         OpCode::CEE_NOP{},
@@ -684,13 +713,10 @@ TEST(MethodBodyTests, InsertFunctionWithSwitch)
         OpCode::CEE_STLOC_2{},
 
         // break;
-        OpCode::CEE_BR_S{endLabel4},
+        OpCode::CEE_BR_S{endLabel},
 
         // return
-        endLabel1,
-        endLabel2,
-        endLabel3,
-        endLabel4,
+        endLabel,
         OpCode::CEE_LDLOC_2{},
         OpCode::CEE_RET{}
     };
@@ -703,8 +729,8 @@ TEST(MethodBodyTests, InsertFunctionWithSwitch)
         OpCode::CEE_LDLOC_1{},
         OpCode::CEE_STLOC_0{},
         OpCode::CEE_LDLOC_0{},
-        OpCode::CEE_SWITCH{{ case0Label, case1Label, case2Label, case3Label, defaultLabel }},
-        OpCode::CEE_BR_S{defaultLabel2},
+        OpCode::CEE_SWITCH{{ case0Label, case1And2Label, case1And2Label, case3Label, defaultLabel }},
+        OpCode::CEE_BR_S{defaultLabel},
 
         // case 0:
         case0Label,
@@ -717,12 +743,11 @@ TEST(MethodBodyTests, InsertFunctionWithSwitch)
         OpCode::CEE_STLOC_2{},
 
         // break;
-        OpCode::CEE_BR_S{endLabel1},
+        OpCode::CEE_BR_S{endLabel},
 
         // case 1:
         // case 2:
-        case1Label,
-        case2Label,
+        case1And2Label,
         // return x * y * 3; // <- x * y * 3
         OpCode::CEE_NOP{},
         OpCode::CEE_LDARG_0{},
@@ -733,7 +758,7 @@ TEST(MethodBodyTests, InsertFunctionWithSwitch)
         OpCode::CEE_STLOC_2{},
 
         // break;
-        OpCode::CEE_BR_S{endLabel2},
+        OpCode::CEE_BR_S{endLabel},
 
         // case 3:
         case3Label,
@@ -748,12 +773,11 @@ TEST(MethodBodyTests, InsertFunctionWithSwitch)
         OpCode::CEE_STLOC_2{},
 
         // break;
-        OpCode::CEE_BR_S{endLabel3},
+        OpCode::CEE_BR_S{endLabel},
 
         // case 4:
         // default:
         defaultLabel,
-        defaultLabel2,
 
         // return x / y / 5; // <- x / y / 5
         OpCode::CEE_NOP{},
@@ -765,13 +789,10 @@ TEST(MethodBodyTests, InsertFunctionWithSwitch)
         OpCode::CEE_STLOC_2{},
 
         // break;
-        OpCode::CEE_BR_S{endLabel4},
+        OpCode::CEE_BR_S{endLabel},
 
         // return
-        endLabel1,
-        endLabel2,
-        endLabel3,
-        endLabel4,
+        endLabel,
         OpCode::CEE_LDLOC_2{},
         OpCode::CEE_RET{}
     };
@@ -781,23 +802,24 @@ TEST(MethodBodyTests, InsertFunctionWithSwitch)
 
     const InstructionStream actualSourceStream(method.Stream());
     const std::vector<std::byte> actualRoundtripBytes(method.Compile());
-    const std::vector<ExceptionsSection> actualExceptionSections(method.ExceptionSections());
+    const std::pmr::vector<ExceptionsSection> actualExceptionSections(method.ExceptionSections());
 
     method.Insert(method.begin() + 13, OpCode::CEE_NEG{});
 
-    method.Insert(method.begin() + 22, OpCode::CEE_LDC_I4_3{});
-    method.Insert(method.begin() + 23, OpCode::CEE_MUL{});
+    method.Insert(method.begin() + 21, OpCode::CEE_LDC_I4_3{});
+    method.Insert(method.begin() + 22, OpCode::CEE_MUL{});
 
-    method.Insert(method.begin() + 31, OpCode::CEE_LDC_I4{42});
-    method.Insert(method.begin() + 32, OpCode::CEE_ADD{});
+    method.Insert(method.begin() + 30, OpCode::CEE_LDC_I4{42});
+    method.Insert(method.begin() + 31, OpCode::CEE_ADD{});
 
-    method.Insert(method.begin() + 41, OpCode::CEE_LDC_I4_5{});
-    method.Insert(method.begin() + 42, OpCode::CEE_DIV{});
+    method.Insert(method.begin() + 39, OpCode::CEE_LDC_I4_5{});
+    method.Insert(method.begin() + 40, OpCode::CEE_DIV{});
 
     const InstructionStream actualInjectionStream(method.Stream());
     const std::vector<std::byte> actualInjectionBytes(method.Compile());
 
     // Assert
+    ExpectPatcherAgreesWithMethodBody(sourceBytes);
     EXPECT_EQ(expectedSourceStream, actualSourceStream);
     EXPECT_EQ(expectedRoundtripBytes, actualRoundtripBytes);
     EXPECT_EQ(0, actualExceptionSections.size());
@@ -858,8 +880,7 @@ TEST(MethodBodyTests, InsertFunctionWithTryCatch)
     };
 
     LabelCreator sourceStreamLabelCreator{};
-    const Label endLabel1{ sourceStreamLabelCreator.CreateLabel() };
-    const Label endLabel2{ sourceStreamLabelCreator.CreateLabel() };
+    const Label endLabel{ sourceStreamLabelCreator.CreateLabel() };
     const Label tryLabel{ sourceStreamLabelCreator.CreateLabel() };
     const Label tryEndLabel{ sourceStreamLabelCreator.CreateLabel() };
     const Label handlerLabel{ sourceStreamLabelCreator.CreateLabel() };
@@ -879,7 +900,7 @@ TEST(MethodBodyTests, InsertFunctionWithTryCatch)
         OpCode::CEE_STLOC_0{},
 
         // } // end of try {
-        OpCode::CEE_LEAVE_S{endLabel1},
+        OpCode::CEE_LEAVE_S{endLabel},
         tryEndLabel,
 
         // catch (DivideByZeroException)
@@ -893,12 +914,11 @@ TEST(MethodBodyTests, InsertFunctionWithTryCatch)
         OpCode::CEE_STLOC_0{},
 
         // }
-        OpCode::CEE_LEAVE_S{endLabel2},
+        OpCode::CEE_LEAVE_S{endLabel},
         handlerEndLabel,
 
         // return
-        endLabel1,
-        endLabel2,
+        endLabel,
         OpCode::CEE_LDLOC_0{},
         OpCode::CEE_RET{}
     };
@@ -919,7 +939,7 @@ TEST(MethodBodyTests, InsertFunctionWithTryCatch)
         OpCode::CEE_STLOC_0{},
 
         // } // end of try {
-        OpCode::CEE_LEAVE_S{endLabel1},
+        OpCode::CEE_LEAVE_S{endLabel},
         tryEndLabel,
 
         // catch (DivideByZeroException)
@@ -933,12 +953,11 @@ TEST(MethodBodyTests, InsertFunctionWithTryCatch)
         OpCode::CEE_STLOC_0{},
 
         // }
-        OpCode::CEE_LEAVE_S{endLabel2},
+        OpCode::CEE_LEAVE_S{endLabel},
         handlerEndLabel,
 
         // return
-        endLabel1,
-        endLabel2,
+        endLabel,
         OpCode::CEE_LDLOC_0{},
         OpCode::CEE_RET{}
     };
@@ -948,7 +967,7 @@ TEST(MethodBodyTests, InsertFunctionWithTryCatch)
 
     const InstructionStream actualSourceStream(method.Stream());
     const std::vector<std::byte> actualRoundtripBytes(method.Compile());
-    const std::vector<ExceptionsSection> actualExceptionSections(method.ExceptionSections());
+    const std::pmr::vector<ExceptionsSection> actualExceptionSections(method.ExceptionSections());
 
     method.Insert(method.begin() + 5, OpCode::CEE_LDC_I4_1{});
     method.Insert(method.begin() + 6, OpCode::CEE_ADD{});
@@ -957,6 +976,7 @@ TEST(MethodBodyTests, InsertFunctionWithTryCatch)
     const std::vector<std::byte> actualInjectionBytes(method.Compile());
 
     // Assert
+    ExpectPatcherAgreesWithMethodBody(sourceBytes);
     EXPECT_EQ(expectedSourceStream, actualSourceStream);
     EXPECT_EQ(expectedRoundtripBytes, actualRoundtripBytes);
     EXPECT_EQ(1, actualExceptionSections.size());
@@ -1140,7 +1160,7 @@ TEST(MethodBodyTests, InsertFunctionWithTryFinally)
 
     const InstructionStream actualSourceStream(method.Stream());
     const std::vector<std::byte> actualRoundtripBytes(method.Compile());
-    const std::vector<ExceptionsSection> actualExceptionSections(method.ExceptionSections());
+    const std::pmr::vector<ExceptionsSection> actualExceptionSections(method.ExceptionSections());
 
     method.Insert(method.begin() + 16, OpCode::CEE_LDC_I4_0{});
     method.Insert(method.begin() + 17, OpCode::CEE_STARG_S{0});
@@ -1149,6 +1169,7 @@ TEST(MethodBodyTests, InsertFunctionWithTryFinally)
     const std::vector<std::byte> actualInjectionBytes(method.Compile());
 
     // Assert
+    ExpectPatcherAgreesWithMethodBody(sourceBytes);
     EXPECT_EQ(expectedSourceStream, actualSourceStream);
     EXPECT_EQ(expectedRoundtripBytes, actualRoundtripBytes);
     EXPECT_EQ(1, actualExceptionSections.size());
@@ -1239,7 +1260,6 @@ TEST(MethodBodyTests, InsertFunctionWithTryCatchWhen)
     const Label endLabel{ sourceStreamLabelCreator.CreateLabel() };
     const Label isInstanceLabel{ sourceStreamLabelCreator.CreateLabel() };
     const Label endFilterLabel{ sourceStreamLabelCreator.CreateLabel() };
-    const Label endLabel2{ sourceStreamLabelCreator.CreateLabel() };
     const Label retLabel{ sourceStreamLabelCreator.CreateLabel() };
     const Label tryLabel{ sourceStreamLabelCreator.CreateLabel() };
     const Label tryEndLabel{ sourceStreamLabelCreator.CreateLabel() };
@@ -1309,12 +1329,11 @@ TEST(MethodBodyTests, InsertFunctionWithTryCatchWhen)
 
         // } // end of catch {
         OpCode::CEE_NOP{},
-        OpCode::CEE_LEAVE_S{endLabel2},
+        OpCode::CEE_LEAVE_S{endLabel},
         handlerEndLabel,
 
         // return z + y; // <- z + y
         endLabel,
-        endLabel2,
         OpCode::CEE_LDLOC_0{},
         OpCode::CEE_LDARG_1{},
         OpCode::CEE_ADD{},
@@ -1391,12 +1410,11 @@ TEST(MethodBodyTests, InsertFunctionWithTryCatchWhen)
 
         // } // end of catch {
         OpCode::CEE_NOP{},
-        OpCode::CEE_LEAVE_S{endLabel2},
+        OpCode::CEE_LEAVE_S{endLabel},
         handlerEndLabel,
 
         // return z + y; // <- z + y
         endLabel,
-        endLabel2,
         OpCode::CEE_LDLOC_0{},
         OpCode::CEE_LDARG_1{},
         OpCode::CEE_ADD{},
@@ -1414,7 +1432,7 @@ TEST(MethodBodyTests, InsertFunctionWithTryCatchWhen)
 
     const InstructionStream actualSourceStream(method.Stream());
     const std::vector<std::byte> actualRoundtripBytes(method.Compile());
-    const std::vector<ExceptionsSection> actualExceptionSections(method.ExceptionSections());
+    const std::pmr::vector<ExceptionsSection> actualExceptionSections(method.ExceptionSections());
 
     method.Insert(method.begin() + 27, OpCode::CEE_LDC_I4_1{});
     method.Insert(method.begin() + 28, OpCode::CEE_ADD{});
@@ -1423,6 +1441,7 @@ TEST(MethodBodyTests, InsertFunctionWithTryCatchWhen)
     const std::vector<std::byte> actualInjectionBytes(method.Compile());
 
     // Assert
+    ExpectPatcherAgreesWithMethodBody(sourceBytes);
     EXPECT_EQ(expectedSourceStream, actualSourceStream);
     EXPECT_EQ(expectedRoundtripBytes, actualRoundtripBytes);
     EXPECT_EQ(1, actualExceptionSections.size());
@@ -1508,8 +1527,7 @@ TEST(MethodBodyTests, TransformJumpToLongIfNeeded)
 
     LabelCreator sourceStreamLabelCreator{};
     const Label elseLabel{ sourceStreamLabelCreator.CreateLabel() };
-    const Label endLabel1{ sourceStreamLabelCreator.CreateLabel() };
-    const Label endLabel2{ sourceStreamLabelCreator.CreateLabel() };
+    const Label endLabel{ sourceStreamLabelCreator.CreateLabel() };
     const InstructionStream expectedSourceStream{
         // if (x == 1) // <- x == 1
         OpCode::CEE_NOP{},
@@ -1526,17 +1544,16 @@ TEST(MethodBodyTests, TransformJumpToLongIfNeeded)
         OpCode::CEE_NOP{},
         OpCode::CEE_LDC_I4_S{42},
         OpCode::CEE_STLOC_1{},
-        OpCode::CEE_BR_S{endLabel1},
+        OpCode::CEE_BR_S{endLabel},
 
         // return 0; // <- 0
         elseLabel,
         OpCode::CEE_LDC_I4_0{},
         OpCode::CEE_STLOC_1{},
-        OpCode::CEE_BR_S{endLabel2},
+        OpCode::CEE_BR_S{endLabel},
 
         // return
-        endLabel1,
-        endLabel2,
+        endLabel,
         OpCode::CEE_LDLOC_1{},
         OpCode::CEE_RET{}
     };
@@ -1544,7 +1561,9 @@ TEST(MethodBodyTests, TransformJumpToLongIfNeeded)
     const size_t insertionLength{ 128 };
     const ptrdiff_t insertionPosition{ 10 };
     InstructionStream expectedInjectionStream(expectedSourceStream);
-    expectedInjectionStream[6] = OpCode::CEE_BRFALSE{ elseLabel };
+    expectedInjectionStream.Replace(
+        expectedInjectionStream.cbegin() + 6,
+        OpCode::CEE_BRFALSE{ elseLabel });
     expectedInjectionStream.insert(
         expectedInjectionStream.cbegin() + insertionPosition,
         insertionLength,
@@ -1555,7 +1574,7 @@ TEST(MethodBodyTests, TransformJumpToLongIfNeeded)
 
     const InstructionStream actualSourceStream(method.Stream());
     const std::vector<std::byte> actualRoundtripBytes(method.Compile());
-    const std::vector<ExceptionsSection> actualExceptionSections(method.ExceptionSections());
+    const std::pmr::vector<ExceptionsSection> actualExceptionSections(method.ExceptionSections());
 
     for (size_t i{ 0 }; i != insertionLength; ++i)
     {
@@ -1566,6 +1585,7 @@ TEST(MethodBodyTests, TransformJumpToLongIfNeeded)
     const std::vector<std::byte> actualInjectionBytes(method.Compile());
 
     // Assert
+    ExpectPatcherAgreesWithMethodBody(sourceBytes);
     EXPECT_EQ(expectedSourceStream, actualSourceStream);
     EXPECT_EQ(expectedRoundtripBytes, actualRoundtripBytes);
     EXPECT_EQ(0, actualExceptionSections.size());
@@ -1711,7 +1731,7 @@ TEST(MethodBodyTests, InsertTransformJumpToLongIfNeeded)
 
     const InstructionStream actualSourceStream(method.Stream());
     const std::vector<std::byte> actualRoundtripBytes(method.Compile());
-    const std::vector<ExceptionsSection> actualExceptionSections(method.ExceptionSections());
+    const std::pmr::vector<ExceptionsSection> actualExceptionSections(method.ExceptionSections());
 
     // if (x == 1) // <- x == 1
     method.Insert(method.begin() + 1, OpCode::CEE_LDARG_0{});
@@ -1742,6 +1762,7 @@ TEST(MethodBodyTests, InsertTransformJumpToLongIfNeeded)
     const std::vector<std::byte> actualInjectionBytes(method.Compile());
 
     // Assert
+    ExpectPatcherAgreesWithMethodBody(sourceBytes);
     EXPECT_EQ(expectedSourceStream, actualSourceStream);
     EXPECT_EQ(expectedRoundtripBytes, actualRoundtripBytes);
     EXPECT_EQ(0, actualExceptionSections.size());
@@ -1844,7 +1865,7 @@ TEST(MethodBodyTests, 
 
     const InstructionStream actualSourceStream(method.Stream());
     const std::vector<std::byte> actualRoundtripBytes(method.Compile());
-    const std::vector<ExceptionsSection> actualExceptionSections(method.ExceptionSections());
+    const std::pmr::vector<ExceptionsSection> actualExceptionSections(method.ExceptionSections());
 
     // if (x == 1) // <- x == 1
     method.Insert(method.begin() + 1, OpCode::CEE_LDARG_0{});
@@ -1869,6 +1890,7 @@ TEST(MethodBodyTests, 
     const std::vector<std::byte> actualInjectionBytes(method.Compile());
 
     // Assert
+    ExpectPatcherAgreesWithMethodBody(sourceBytes);
     EXPECT_EQ(expectedSourceStream, actualSourceStream);
     EXPECT_EQ(expectedRoundtripBytes, actualRoundtripBytes);
     EXPECT_EQ(0, actualExceptionSections.size());
@@ -1876,6 +1898,87 @@ TEST(MethodBodyTests, 
     EXPECT_EQ(expectedInjectionBytes, actualInjectionBytes);
 }
 
+// Creates method body representing a method, which
+// returns its argument value by a switch statement
+// with the given amount of cases, the way generated
+// parsers do:
+// public static int Select(int x)
+// {
+//     switch (x)
+//     {
+//     case 0: return 0;
+//     case 1: return 1;
+//     ...
+//     }
+//
+//     return -1;
+// }
+// @param casesCount : the amount of switch cases.
+static std::vector<std::byte> CreateFunctionWithLargeSwitch(const uint32_t casesCount)
+{
+    // ldarg.0; switch; ldc.i4.m1; ret; then ldc.i4 and ret for each case.
+    const uint32_t switchSize { 1 + sizeof(uint32_t) + casesCount * sizeof(int32_t) };
+    const uint32_t defaultCaseSize { 2 };
+    const uint32_t caseSize { 6 };
+    const uint32_t codeSize { 1 + switchSize + defaultCaseSize + casesCount * caseSize };
+
+    std::vector<std::byte> result {
+        // Fat header: flags and size, max stack
+        std::byte { 0x03 }, std::byte { 0x30 }, std::byte { 0x01 }, std::byte { 0x00 }
+    };
+
+    AppendAsBytes(result, codeSize);
+    AppendAsBytes(result, uint32_t { 0 });
+
+    result.push_back(std::byte { 0x02 });
+    result.push_back(std::byte { 0x45 });
+    AppendAsBytes(result, casesCount);
+    for (uint32_t i { 0 }; i != casesCount; ++i)
+    {
+        AppendAsBytes(result, static_cast<int32_t>(defaultCaseSize + i * caseSize));
+    }
+
+    result.push_back(std::byte { 0x15 });
+    result.push_back(std::byte { 0x2A });
+    for (uint32_t i { 0 }; i != casesCount; ++i)
+    {
+        result.push_back(std::byte { 0x20 });
+        AppendAsBytes(result, i);
+        result.push_back(std::byte { 0x2A });
+    }
+
+    return result;
+}
+
+// Checks that a switch with thousands of cases
+// survives the parse and compile roundtrip, and
+// that inserting an instruction before the cases
+// keeps all the switch targets pointing to the same
+// instructions.
+TEST(MethodBodyTests, InsertFunctionWithLargeSwitch)
+{
+    // Arrange
+    const uint32_t casesCount { 5000 };
+    const std::vector<std::byte> sourceBytes { CreateFunctionWithLargeSwitch(casesCount) };
+
+    // Act
+    MethodBody method(sourceBytes);
+    const std::vector<std::byte> actualRoundtripBytes(method.Compile());
+    method.Insert(method.begin() + 1, OpCode::CEE_NOP{});
+    const std::vector<std::byte> actualInjectionBytes(method.Compile());
+
+    // Assert
+    EXPECT_EQ(sourceBytes, actualRoundtripBytes);
+    ASSERT_EQ(sourceBytes.size() + 1, actualInjectionBytes.size());
+
+    // Only the code size in the header and the inserted
+    // instruction differ, switch targets are relative.
+    std::vector<std::byte> expectedInjectionBytes { sourceBytes };
+    expectedInjectionBytes[4] = std::byte { static_cast<uint8_t>(expectedInjectionBytes[4]) + 1 };
+    expectedInjectionBytes.insert(expectedInjectionBytes.cbegin() + 13, std::byte { 0x00 });
+    EXPECT_EQ(expectedInjectionBytes, actualInjectionBytes);
+}
+
 // Checks that method Compile() throws an
 // std::logic_error if there is a branching
 // instruction with some label, but MarkLabel()
@@ -1915,3 +2018,290 @@ TEST(MethodBodyTests, MarkLabelThrowsOnLabelMarkedTwice)
         method.MarkLabel(method.begin() + 2, label),
         std::logic_error);
 }
+
+// Checks that changes queued between BeginEdit() and
+// CommitEdit() give the same method as the same changes
+// made one by one, including the conversion of a short
+// jump, which became too far, to the long form.
+TEST(MethodBodyTests, CommitEditMatchesSequentialInsert)
+{
+    // Arrange
+    const std::vector<std::byte> sourceBytes { CreateFunctionWithLargeSwitch(16) };
+    MethodBody expectedMethod(sourceBytes);
+    MethodBody actualMethod(sourceBytes);
+    const InstructionStream sourceStream(expectedMethod.Stream());
+    const size_t insertionLength { 128 };
+
+    // Inserts a jump over insertionLength No Operation
+    // instructions before the switch, and a No Operation
+    // instruction before each ret. Returns the label of the jump.
+    // @param method : the method to change.
+    // @param inEdit : true if positions refer to the source stream,
+    //     false if they have to account for previous insertions.
+    const auto inject = [&sourceStream, insertionLength](MethodBody& method, const bool inEdit)
+    {
+        size_t inserted { 0 };
+        const auto at = [&method, &inserted, inEdit](const size_t sourceIndex)
+        {
+            return method.begin() + static_cast<ptrdiff_t>(sourceIndex + (inEdit ? 0 : inserted++));
+        };
+
+        const Label label { method.CreateLabel() };
+        method.Insert(at(1), OpCode::CEE_BR_S{ label });
+        for (size_t i { 0 }; i != insertionLength; ++i)
+        {
+            method.Insert(at(1), OpCode::CEE_NOP{});
+        }
+
+        method.MarkLabel(at(1), label);
+        for (size_t i { 0 }; i != sourceStream.size(); ++i)
+        {
+            if (sourceStream[i] == StreamElement { OpCode::CEE_RET{} })
+            {
+                method.Insert(at(i), OpCode::CEE_NOP{});
+            }
+        }
+
+        return label;
+    };
+
+    // Act
+    const Label expectedLabel { inject(expectedMethod, false) };
+    actualMethod.BeginEdit();
+    const Label actualLabel { inject(actualMethod, true) };
+    const InstructionStream actualStreamBeforeCommit(actualMethod.Stream());
+    actualMethod.CommitEdit();
+
+    // Assert
+    EXPECT_EQ(expectedLabel, actualLabel);
+    EXPECT_EQ(sourceStream, actualStreamBeforeCommit);
+    EXPECT_EQ(StreamElement { OpCode::CEE_BR{ actualLabel } }, actualMethod.Stream()[1]);
+    EXPECT_EQ(expectedMethod.Stream(), actualMethod.Stream());
+    EXPECT_EQ(expectedMethod.Compile(), actualMethod.Compile());
+}
+
+// Checks that method Compile() throws an
+// std::logic_error if it was called between
+// BeginEdit() and CommitEdit().
+TEST(MethodBodyTests, CompileThrowsWhileEditInProgress)
+{
+    // Arrange
+    std::vector<std::byte> rawBytes(CreateSimpleFunction());
+    MethodBody method(rawBytes);
+
+    // Act
+    method.BeginEdit();
+    method.Insert(method.begin() + 2, OpCode::CEE_NOP{});
+
+    // Assert
+    EXPECT_TRUE(method.IsEditInProgress());
+    EXPECT_THROW(method.Compile(), std::logic_error);
+}
+
+// Checks that method MarkLabel() throws an
+// std::logic_error if it was called again for
+// the same label between BeginEdit() and CommitEdit().
+TEST(MethodBodyTests, MarkLabelThrowsOnLabelMarkedTwiceInEdit)
+{
+    // Arrange
+    std::vector<std::byte> rawBytes(CreateSimpleFunction());
+    MethodBody method(rawBytes);
+
+    // Act
+    const Label label { method.CreateLabel() };
+    method.BeginEdit();
+    method.MarkLabel(method.begin(), label);
+
+    // Assert
+    EXPECT_THROW(
+        method.MarkLabel(method.begin() + 2, label),
+        std::logic_error);
+}
+
+// Checks that MinimizeSize() replaces a long jump and
+// a constant load with their short forms, and reports
+// the amount of bytes saved.
+TEST(MethodBodyTests, MinimizeSizeShortensInstructions)
+{
+    // Arrange
+    std::vector<std::byte> rawBytes(CreateSimpleFunction());
+    MethodBody method(rawBytes);
+    const Label label { method.CreateLabel() };
+    method.Insert(method.begin() + 3, OpCode::CEE_LDC_I4{ 2 });
+    method.Insert(method.begin() + 4, OpCode::CEE_MUL{});
+    method.Insert(method.begin(), OpCode::CEE_BR{ label });
+    method.MarkLabel(method.begin() + 1, label);
+
+    const InstructionStream expectedStream {
+        OpCode::CEE_BR_S{ label },
+        label,
+        OpCode::CEE_LDARG_0{},
+        OpCode::CEE_LDARG_1{},
+        OpCode::CEE_ADD{},
+        OpCode::CEE_LDC_I4_2{},
+        OpCode::CEE_MUL{},
+        OpCode::CEE_RET{}
+    };
+
+    const std::vector<std::byte> expectedBytes {
+        std::byte { 0x22 }, // size updated
+        std::byte { 0x2B }, // br.s
+        std::byte { 0x00 },
+        std::byte { 0x02 },
+        std::byte { 0x03 },
+        std::byte { 0x58 },
+        std::byte { 0x18 }, // ldc.i4.2
+        std::byte { 0x5A },
+        std::byte { 0x2A }
+    };
+
+    // Act
+    const AbsoluteOffset savedBytes { method.MinimizeSize() };
+
+    // Assert
+    EXPECT_EQ(7, savedBytes);
+    EXPECT_EQ(expectedStream, method.Stream());
+    EXPECT_EQ(expectedBytes, method.Compile());
+}
+
+// Checks that MinimizeSize() keeps a jump long if
+// the jump is too far for the short form, while still
+// shortening the instructions in between.
+TEST(MethodBodyTests, MinimizeSizeKeepsFarJumpsLong)
+{
+    // Arrange
+    const uint32_t casesCount { 16 };
+    const std::vector<std::byte> sourceBytes { CreateFunctionWithLargeSwitch(casesCount) };
+    MethodBody method(sourceBytes);
+    const Label label { method.CreateLabel() };
+    method.BeginEdit();
+    method.Insert(method.begin() + 1, OpCode::CEE_BR{ label });
+    for (size_t i { 0 }; i != 128; ++i)
+    {
+        method.Insert(method.begin() + 1, OpCode::CEE_NOP{});
+    }
+
+    method.MarkLabel(method.begin() + 1, label);
+    method.Insert(method.begin() + 1, OpCode::CEE_LDC_I4{ 42 });
+    method.CommitEdit();
+    const std::vector<std::byte> bytesBeforeMinimize(method.Compile());
+
+    // ldc.i4 42 becomes ldc.i4.s, each ldc.i4 of the cases
+    // becomes either ldc.i4.N for 0-8 or ldc.i4.s.
+    const AbsoluteOffset expectedSavedBytes { 3 + 9 * 4 + (casesCount - 9) * 3 };
+
+    // Act
+    const AbsoluteOffset savedBytes { method.MinimizeSize() };
+    const std::vector<std::byte> bytesAfterMinimize(method.Compile());
+
+    // Assert
+    EXPECT_EQ(expectedSavedBytes, savedBytes);
+    EXPECT_EQ(StreamElement { OpCode::CEE_BR{ label } }, method.Stream()[1]);
+    EXPECT_EQ(bytesBeforeMinimize.size() - expectedSavedBytes, bytesAfterMinimize.size());
+    EXPECT_EQ(bytesAfterMinimize, MethodBody(bytesAfterMinimize).Compile());
+}
+
+// Checks that CompileInto() writes the same bytes as
+// Compile() into a buffer of ComputeCompiledSize() bytes.
+TEST(MethodBodyTests, CompileIntoMatchesCompile)
+{
+    // Arrange
+    MethodBody method(CreateFunctionWithLargeSwitch(16));
+    method.Insert(method.begin() + 1, OpCode::CEE_NOP{});
+    const std::vector<std::byte> expectedBytes(method.Compile());
+
+    // Act
+    const size_t compiledSize { method.ComputeCompiledSize() };
+    std::vector<std::byte> actualBytes(compiledSize);
+    method.CompileInto(actualBytes);
+
+    // Assert
+    EXPECT_EQ(expectedBytes.size(), compiledSize);
+    EXPECT_EQ(expectedBytes, actualBytes);
+}
+
+// Checks that CompileInto() throws an
+// std::overflow_error if the buffer is smaller
+// than ComputeCompiledSize().
+TEST(MethodBodyTests, CompileIntoThrowsOnSmallBuffer)
+{
+    // Arrange
+    MethodBody method(CreateSimpleFunction());
+    std::vector<std::byte> buffer(method.ComputeCompiledSize() - 1);
+
+    // Act & Assert
+    EXPECT_THROW(
+        method.CompileInto(buffer),
+        std::overflow_error);
+}
+
+// Checks that Insert() turns the tiny header into a fat one,
+// once the code does not fit the tiny header, and that the
+// fat header keeps the evaluation stack depth of the tiny one.
+TEST(MethodBodyTests, InsertPromotesSmallHeader)
+{
+    // Arrange
+    MethodBody method(CreateSimpleFunction());
+    std::vector<std::byte> expectedBytes {
+        std::byte { 0x03 }, std::byte { 0x30 }, // fat header flags and size
+        std::byte { 0x08 }, std::byte { 0x00 }, // max stack
+        std::byte { 0x44 }, std::byte { 0x00 }, std::byte { 0x00 }, std::byte { 0x00 }, // code size
+        std::byte { 0x00 }, std::byte { 0x00 }, std::byte { 0x00 }, std::byte { 0x00 } // local variables
+    };
+
+    expectedBytes.insert(expectedBytes.end(), 64, std::byte { 0x00 }); // nop
+    expectedBytes.insert(expectedBytes.end(), { std::byte { 0x02 }, std::byte { 0x03 }, std::byte { 0x58 }, std::byte { 0x2A } });
+
+    // Act
+    method.BeginEdit();
+    for (int i = 0; i != 64; ++i)
+    {
+        method.Insert(method.begin(), OpCode::CEE_NOP{});
+    }
+
+    method.CommitEdit();
+
+    // Assert
+    EXPECT_EQ(8, method.MaxStack());
+    EXPECT_EQ(expectedBytes, method.Compile());
+}
+
+// Measures the bytes per second compiled by MethodBody::Compile()
+// for the method corpus.
+TEST(MethodBodyTests, DISABLED_BenchmarkCompileThroughput)
+{
+    std::vector<MethodBody> methods {};
+    size_t bytesCount { 0 };
+    for (const std::vector<std::byte>& bytes : MakeMethodCorpus())
+    {
+        methods.emplace_back(bytes);
+        bytesCount += bytes.size();
+        ASSERT_EQ(bytes, methods.back().Compile());
+    }
+
+    const double duration { MeasureNanoseconds([&methods]()
+    {
+        for (const MethodBody& method : methods)
+        {
+            KeepResult(method.Compile().size());
+        }
+    }) };
+
+    ReportBenchmark("MethodBody::Compile", bytesCount / duration * 1e3, "MB/s");
+}
+
+// Measures the time MethodBody::Compile() takes for a method
+// with a 5000 cases switch, like the ones of generated parsers.
+TEST(MethodBodyTests, DISABLED_BenchmarkCompileLargeSwitch)
+{
+    const std::vector<std::byte> bytes { CreateFunctionWithLargeSwitch(5000) };
+    const MethodBody method(bytes);
+    ASSERT_EQ(bytes, method.Compile());
+
+    const double duration { MeasureNanoseconds([&method]()
+    {
+        KeepResult(method.Compile().size());
+    }) };
+
+    ReportBenchmark("MethodBody::Compile, 5000 cases switch", duration / 1e3, "us");
+}
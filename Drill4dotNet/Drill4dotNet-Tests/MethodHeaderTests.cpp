@@ -209,3 +209,137 @@ static_assert(MethodHeader::IsValidCodeSize(0x38));
 static_assert(MethodHeader::IsValidCodeSize(0x8D1C9D5E));
 static_assert(!MethodHeader::IsValidCodeSize(0x000000018D1C9D5E));
 static_assert(!MethodHeader::IsValidCodeSize(-1));
+
+// Checks the SetCodeSize() turns a tiny header into
+// a fat one, if the size does not fit the tiny header.
+TEST(MethodHeaderTests, SetCodeSizePromotesSmallHeader)
+{
+    // Arrange
+    const int newCodeSize { 0x40 };
+    // Header is 1 byte combining size and tiny header flag.
+    const std::vector<std::byte> headerBytes { std::byte { 0xC2 } };
+    const std::vector<std::byte> expectedSerialized
+    {
+        std::byte { 0x03 }, // fat header flag
+        std::byte { 0x30 }, // header size, in 4-byte words
+        std::byte { 0x08 }, // max stack
+        std::byte { 0x00 },
+        std::byte { 0x40 }, // code size
+        std::byte { 0x00 },
+        std::byte { 0x00 },
+        std::byte { 0x00 },
+        std::byte { 0x00 }, // no local variables
+        std::byte { 0x00 },
+        std::byte { 0x00 },
+        std::byte { 0x00 }
+    };
+
+    // Act
+    MethodHeader header(headerBytes);
+    header.SetCodeSize(newCodeSize);
+    std::vector<std::byte> serialized{};
+    header.AppendToBytes(serialized);
+
+    // Assert
+    EXPECT_FALSE(header.IsTiny());
+    EXPECT_EQ(12, header.Size());
+    EXPECT_EQ(newCodeSize, header.CodeSize());
+    EXPECT_EQ(8, header.MaxStack());
+    EXPECT_EQ(expectedSerialized, serialized);
+    EXPECT_FALSE(header.HasExceptionsSections());
+}
+
+// Checks the SetMaxStack() keeps a tiny header,
+// while the amount of items fits the tiny header.
+TEST(MethodHeaderTests, SetMaxStackKeepsSmallHeader)
+{
+    // Arrange
+    // Header is 1 byte combining size and tiny header flag.
+    const std::vector<std::byte> headerBytes { std::byte { 0xC2 } };
+
+    // Act
+    MethodHeader header(headerBytes);
+    header.SetMaxStack(3);
+    std::vector<std::byte> serialized{};
+    header.AppendToBytes(serialized);
+
+    // Assert
+    EXPECT_TRUE(header.IsTiny());
+    EXPECT_EQ(8, header.MaxStack());
+    EXPECT_EQ(headerBytes, serialized);
+}
+
+// Checks the SetMaxStack() turns a tiny header into
+// a fat one, if the amount of items does not fit
+// the tiny header.
+TEST(MethodHeaderTests, SetMaxStackPromotesSmallHeader)
+{
+    // Arrange
+    // Header is 1 byte combining size and tiny header flag.
+    const std::vector<std::byte> headerBytes { std::byte { 0xC2 } };
+
+    // Act
+    MethodHeader header(headerBytes);
+    header.SetMaxStack(9);
+
+    // Assert
+    EXPECT_FALSE(header.IsTiny());
+    EXPECT_EQ(12, header.Size());
+    EXPECT_EQ(0x30, header.CodeSize());
+    EXPECT_EQ(9, header.MaxStack());
+    EXPECT_EQ(std::nullopt, header.LocalVariables());
+}
+
+// Checks the SetMaxStack() sets the exact amount
+// of items to a fat header, even if it is smaller.
+TEST(MethodHeaderTests, SetMaxStackAffectsFatHeader)
+{
+    // Arrange
+    const std::vector<std::byte> headerBytes
+    {
+        std::byte { 0x13 }, // fat header flag, init locals
+        std::byte { 0x30 }, // header size, in 4-byte words
+        std::byte { 0x10 }, // max stack
+        std::byte { 0x00 },
+        std::byte { 0x01 }, // code size
+        std::byte { 0x00 },
+        std::byte { 0x00 },
+        std::byte { 0x00 },
+        std::byte { 0x01 }, // local variables signature
+        std::byte { 0x00 },
+        std::byte { 0x00 },
+        std::byte { 0x11 }
+    };
+
+    std::vector<std::byte> expectedSerialized { headerBytes };
+    expectedSerialized[2] = std::byte { 0x02 };
+
+    // Act
+    MethodHeader header(headerBytes);
+    header.SetMaxStack(2);
+    std::vector<std::byte> serialized{};
+    header.AppendToBytes(serialized);
+
+    // Assert
+    EXPECT_EQ(2, header.MaxStack());
+    EXPECT_EQ(mdSignature { 0x11000001 }, header.LocalVariables());
+    EXPECT_EQ(expectedSerialized, serialized);
+}
+
+// Checks the SetLocalVariables() turns
+// a tiny header into a fat one.
+TEST(MethodHeaderTests, SetLocalVariablesPromotesSmallHeader)
+{
+    // Arrange
+    // Header is 1 byte combining size and tiny header flag.
+    const std::vector<std::byte> headerBytes { std::byte { 0xC2 } };
+
+    // Act
+    MethodHeader header(headerBytes);
+    header.SetLocalVariables(0x11000002);
+
+    // Assert
+    EXPECT_FALSE(header.IsTiny());
+    EXPECT_EQ(8, header.MaxStack());
+    EXPECT_EQ(mdSignature { 0x11000002 }, header.LocalVariables());
+}
@@ -0,0 +1,133 @@
+#include "pch.h"
+
+#include "MethodBody.h"
+#include "MethodPatcher.h"
+
+using namespace Drill4dotNet;
+
+// Creates method body with a fat header representing
+//     br.s RETURN
+//     nop
+// RETURN:
+//     ret
+static std::vector<std::byte> CreateFunctionWithShortJump()
+{
+    return {
+        std::byte { 0x13 }, std::byte { 0x30 }, // fat header flags and size
+        std::byte { 0x08 }, std::byte { 0x00 }, // max stack
+        std::byte { 0x04 }, std::byte { 0x00 }, std::byte { 0x00 }, std::byte { 0x00 }, // code size
+        std::byte { 0x00 }, std::byte { 0x00 }, std::byte { 0x00 }, std::byte { 0x00 }, // local variables
+        std::byte { 0x2B }, std::byte { 0x01 }, // br.s RETURN
+        std::byte { 0x00 }, // nop
+        std::byte { 0x2A }  // ret
+    };
+}
+
+// Checks the method bytes are not changed if nothing is inserted.
+TEST(MethodPatcherTests, RoundTrip)
+{
+    // Arrange
+    const std::vector<std::byte> sourceBytes { CreateFunctionWithShortJump() };
+
+    // Act
+    const MethodPatcher patcher { sourceBytes };
+
+    // Assert
+    EXPECT_EQ(sourceBytes.size(), patcher.ComputePatchedSize());
+    EXPECT_EQ(sourceBytes, patcher.Patch());
+}
+
+// Checks a short jump over the inserted instructions gets
+// the long form, if the jump becomes too far, and the result
+// is the same as MethodBody gives for the same insertion.
+TEST(MethodPatcherTests, InsertMakesJumpLong)
+{
+    // Arrange
+    const std::vector<std::byte> sourceBytes { CreateFunctionWithShortJump() };
+    constexpr size_t nopsCount { 200 };
+    MethodBody method(sourceBytes);
+    method.BeginEdit();
+    for (size_t i = 0; i != nopsCount; ++i)
+    {
+        method.Insert(method.begin() + 1, OpCode::CEE_NOP{});
+    }
+
+    method.CommitEdit();
+    const std::vector<std::byte> expectedBytes { method.Compile() };
+    const std::vector<std::byte> nops(nopsCount, std::byte { 0x00 });
+
+    // Act
+    MethodPatcher patcher { sourceBytes };
+    patcher.Insert(2, nops);
+    const std::vector<std::byte> actualBytes { patcher.Patch() };
+
+    // Assert
+    EXPECT_EQ(expectedBytes, actualBytes);
+    ASSERT_EQ(12 + 5 + nopsCount + 2, actualBytes.size());
+    EXPECT_EQ(std::byte { 0x38 }, actualBytes[12]); // br
+    EXPECT_EQ(std::byte { nopsCount + 1 }, actualBytes[13]);
+}
+
+// Checks instructions inserted at the same offset
+// keep the order of the calls.
+TEST(MethodPatcherTests, InsertKeepsOrder)
+{
+    // Arrange
+    const std::vector<std::byte> sourceBytes { CreateFunctionWithShortJump() };
+    const std::vector<std::byte> first { std::byte { 0x16 } }; // ldc.i4.0
+    const std::vector<std::byte> second { std::byte { 0x26 } }; // pop
+
+    // Act
+    MethodPatcher patcher { sourceBytes };
+    patcher.Insert(3, first);
+    patcher.Insert(3, second);
+    const std::vector<std::byte> actualBytes { patcher.Patch() };
+
+    // Assert
+    ASSERT_EQ(sourceBytes.size() + 2, actualBytes.size());
+    EXPECT_EQ(std::byte { 0x06 }, actualBytes[4]); // code size
+    EXPECT_EQ(std::byte { 0x01 }, actualBytes[13]); // the jump reaches the inserted code
+    EXPECT_EQ(std::byte { 0x16 }, actualBytes[15]);
+    EXPECT_EQ(std::byte { 0x26 }, actualBytes[16]);
+    EXPECT_EQ(std::byte { 0x2A }, actualBytes[17]);
+}
+
+// Checks std::logic_error is thrown if an insertion
+// point is in the middle of an instruction.
+TEST(MethodPatcherTests, InsertThrowsInsideInstruction)
+{
+    // Arrange
+    const std::vector<std::byte> sourceBytes { CreateFunctionWithShortJump() };
+    const std::vector<std::byte> nop { std::byte { 0x00 } };
+    MethodPatcher patcher { sourceBytes };
+
+    // Assert
+    EXPECT_THROW(patcher.Insert(1, nop), std::logic_error);
+}
+
+// Checks a tiny header is promoted to a fat one,
+// if the code grows too big for it.
+TEST(MethodPatcherTests, PatchPromotesTinyHeader)
+{
+    // Arrange
+    const std::vector<std::byte> sourceBytes {
+        std::byte { 0x06 }, // tiny header, 1 byte of code
+        std::byte { 0x2A }  // ret
+    };
+
+    const std::vector<std::byte> nops(63, std::byte { 0x00 });
+    MethodPatcher patcher { sourceBytes };
+    patcher.Insert(0, nops);
+
+    // Act
+    const std::vector<std::byte> patched { patcher.Patch() };
+
+    // Assert
+    ASSERT_EQ(12 + 64, patched.size());
+    EXPECT_EQ(patched.size(), patcher.ComputePatchedSize());
+    const MethodHeader header { patched };
+    EXPECT_FALSE(header.IsTiny());
+    EXPECT_EQ(64, header.CodeSize());
+    EXPECT_EQ(8, header.MaxStack());
+    EXPECT_EQ(std::byte { 0x2A }, patched.back());
+}
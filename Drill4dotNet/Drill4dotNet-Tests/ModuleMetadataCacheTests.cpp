@@ -0,0 +1,232 @@
+#include "pch.h"
+
+#include "Benchmark.h"
+#include "ModuleMetadataCache.h"
+
+#include <atomic>
+#include <future>
+#include <random>
+#include <thread>
+
+using namespace Drill4dotNet;
+using namespace testing;
+
+// Stands for the metadata import object of a module.
+// Can be neither copied nor moved, as the real ones.
+class MetadataStub
+{
+public:
+    const ModuleID Module;
+
+    explicit MetadataStub(const ModuleID module)
+        : Module { module }
+    {
+    }
+
+    MetadataStub(const MetadataStub&) = delete;
+    MetadataStub& operator=(const MetadataStub&) = delete;
+};
+
+// Checks the metadata of each module are opened once,
+// however many times they are asked for.
+TEST(ModuleMetadataCacheTests, OpensOncePerModule)
+{
+    // Arrange
+    ModuleMetadataCache<MetadataStub> cache {};
+    MockFunction<void(ModuleID)> opened {};
+    EXPECT_CALL(opened, Call(0x100)).Times(1);
+    EXPECT_CALL(opened, Call(0x200)).Times(1);
+    const auto open { [&opened](const ModuleID module)
+    {
+        opened.Call(module);
+        return MetadataStub { module };
+    } };
+
+    // Act
+    const std::shared_ptr<const MetadataStub> first { cache.Get(0x100, open) };
+    const std::shared_ptr<const MetadataStub> second { cache.Get(0x200, open) };
+    const std::shared_ptr<const MetadataStub> again { cache.Get(0x100, open) };
+
+    // Assert
+    EXPECT_EQ(0x100, first->Module);
+    EXPECT_EQ(0x200, second->Module);
+    EXPECT_EQ(first, again);
+    EXPECT_EQ(2, cache.Size());
+}
+
+// Checks the metadata are opened once, when many threads ask for them at once.
+TEST(ModuleMetadataCacheTests, OpensOnceForConcurrentCallers)
+{
+    // Arrange
+    ModuleMetadataCache<MetadataStub> cache {};
+    std::atomic<int> opens { 0 };
+    const auto open { [&opens](const ModuleID module)
+    {
+        opens.fetch_add(1);
+        return MetadataStub { module };
+    } };
+
+    // Act
+    std::vector<std::thread> threads {};
+    for (int i = 0; i != 8; ++i)
+    {
+        threads.emplace_back([&cache, &open]()
+        {
+            for (ModuleID module = 0x100; module != 0x140; ++module)
+            {
+                cache.Get(module, open);
+            }
+        });
+    }
+
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    // Assert
+    EXPECT_EQ(0x40, opens.load());
+    EXPECT_EQ(0x40, cache.Size());
+}
+
+// Checks the metadata of an unloaded module are released, stay alive
+// for the callers still using them, and are opened again if asked for.
+TEST(ModuleMetadataCacheTests, ReleasesUnloadedModule)
+{
+    // Arrange
+    ModuleMetadataCache<MetadataStub> cache {};
+    int opens { 0 };
+    const auto open { [&opens](const ModuleID module)
+    {
+        ++opens;
+        return MetadataStub { module };
+    } };
+
+    const std::shared_ptr<const MetadataStub> inUse { cache.Get(0x100, open) };
+
+    // Act
+    cache.Release(0x100);
+    const size_t sizeAfterRelease { cache.Size() };
+    const std::shared_ptr<const MetadataStub> reopened { cache.Get(0x100, open) };
+
+    // Assert
+    EXPECT_EQ(0, sizeAfterRelease);
+    EXPECT_EQ(0x100, inUse->Module);
+    EXPECT_NE(inUse, reopened);
+    EXPECT_EQ(2, opens);
+}
+
+// Checks an error opening the metadata is passed to
+// the caller, and the metadata are not remembered.
+TEST(ModuleMetadataCacheTests, PassesOpenErrors)
+{
+    // Arrange
+    ModuleMetadataCache<MetadataStub> cache {};
+    const auto failingOpen { [](const ModuleID) -> MetadataStub
+    {
+        throw std::runtime_error("Cannot open the metadata");
+    } };
+
+    // Act & Assert
+    EXPECT_THROW(cache.Get(0x100, failingOpen), std::runtime_error);
+    EXPECT_EQ(0, cache.Size());
+    EXPECT_EQ(0x100, cache.Get(0x100, [](const ModuleID module) { return MetadataStub { module }; })->Module);
+}
+
+// Checks the metadata of a module can be got, while
+// the metadata of another one are being opened.
+TEST(ModuleMetadataCacheTests, OpensWithoutBlockingOtherModules)
+{
+    // Arrange
+    ModuleMetadataCache<MetadataStub> cache {};
+    std::promise<void> slowOpenStarted {};
+    std::promise<void> otherModuleGot {};
+    std::future<void> otherModuleGotFuture { otherModuleGot.get_future() };
+    bool waitedForOtherModule { false };
+    std::thread slowOpener { [&]()
+    {
+        cache.Get(0x100, [&](const ModuleID module)
+        {
+            slowOpenStarted.set_value();
+            waitedForOtherModule = otherModuleGotFuture.wait_for(std::chrono::seconds(5)) == std::future_status::ready;
+            return MetadataStub { module };
+        });
+    } };
+
+    // Act
+    slowOpenStarted.get_future().wait();
+    const std::shared_ptr<const MetadataStub> other { cache.Get(0x200, [](const ModuleID module)
+    {
+        return MetadataStub { module };
+    }) };
+
+    otherModuleGot.set_value();
+    slowOpener.join();
+
+    // Assert
+    EXPECT_EQ(0x200, other->Module);
+    EXPECT_TRUE(waitedForOtherModule);
+    EXPECT_EQ(2, cache.Size());
+}
+
+// Measures a storm of JIT compilation callbacks, each needing the
+// metadata of the module of the method, from several threads at once:
+// with the metadata opened on each callback, and taken from the cache.
+// The opening counts the opens, and allocates the object, as the
+// real one does; the cost of the COM calls is not included.
+TEST(ModuleMetadataCacheTests, DISABLED_BenchmarkJitStorm)
+{
+    constexpr ModuleID modulesCount { 50 };
+    constexpr size_t callbacksPerThread { 1'000'000 };
+    std::minstd_rand random { 42 };
+    std::vector<ModuleID> callbacks(callbacksPerThread);
+    for (ModuleID& module : callbacks)
+    {
+        module = 0x100 + random() % modulesCount;
+    }
+
+    std::atomic<size_t> opens { 0 };
+    const auto open { [&opens](const ModuleID module)
+    {
+        opens.fetch_add(1, std::memory_order_relaxed);
+        return MetadataStub { module };
+    } };
+
+    for (const size_t threadsCount : { 1, 4 })
+    {
+        opens = 0;
+        const double uncachedDuration { MeasureThreadsNanoseconds(threadsCount, [&callbacks, &opens](size_t)
+        {
+            size_t sum { 0 };
+            for (const ModuleID module : callbacks)
+            {
+                opens.fetch_add(1, std::memory_order_relaxed);
+                const std::shared_ptr<const MetadataStub> metadata { std::make_shared<const MetadataStub>(module) };
+                sum += metadata->Module;
+            }
+
+            KeepResult(sum);
+        }) };
+
+        const size_t uncachedOpens { opens.exchange(0) };
+        ModuleMetadataCache<MetadataStub> cache {};
+        const double cachedDuration { MeasureThreadsNanoseconds(threadsCount, [&callbacks, &cache, &open](size_t)
+        {
+            size_t sum { 0 };
+            for (const ModuleID module : callbacks)
+            {
+                sum += cache.Get(module, open)->Module;
+            }
+
+            KeepResult(sum);
+        }) };
+
+        EXPECT_EQ(modulesCount, opens.load());
+        const std::string threads { std::to_string(threadsCount) + (threadsCount == 1 ? " thread" : " threads") };
+        const double callbacksCount { static_cast<double>(callbacksPerThread * threadsCount) };
+        ReportBenchmark("opens, opened per callback, " + threads, static_cast<double>(uncachedOpens), "");
+        ReportBenchmark("opens, cached, " + threads, static_cast<double>(opens.load()), "");
+        ReportBenchmark("opened per callback, " + threads, uncachedDuration / callbacksCount, "ns per callback");
+        ReportBenchmark("cached, " + threads, cachedDuration / callbacksCount, "ns per callback");
+    }
+}
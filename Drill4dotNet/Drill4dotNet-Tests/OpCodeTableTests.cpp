@@ -0,0 +1,114 @@
+#include "pch.h"
+
+#include "Benchmark.h"
+#include "MethodBody.h"
+#include "OpCodeTable.h"
+
+using namespace Drill4dotNet;
+
+// Checks every instruction generated from opcode.def
+// can be found in the table by its code, and the
+// table describes it the same way as its OpCode::CEE_* class.
+TEST(OpCodeTableTests, AllInstructionsDescribed)
+{
+    // Arrange
+    size_t describedCount { 0 };
+    for (const auto& codes : OpCodeInfos)
+    {
+        for (const OpCodeInfo& info : codes)
+        {
+            if (info.IsDefined)
+            {
+                ++describedCount;
+            }
+        }
+    }
+
+    size_t expectedCount { 0 };
+
+    // Act
+#define OPDEF_REAL_INSTRUCTION( \
+    canonicalName, \
+    stringName, \
+    stackPop, \
+    stackPush, \
+    inlineArgumentType, \
+    operationKind, \
+    codeLength, \
+    byte1, \
+    byte2, \
+    controlBehavior) \
+    { \
+        ++expectedCount; \
+        const OpCodeInfo& info { codeLength == 1 \
+            ? FindOneByteOpCode(std::byte { byte2 }) \
+            : FindTwoByteOpCode(std::byte { byte2 }) }; \
+        EXPECT_TRUE(info.IsDefined); \
+        EXPECT_EQ(OpCodeArgumentKind :: ## inlineArgumentType, info.ArgumentKind); \
+        EXPECT_EQ(OpCode :: ## canonicalName ::FlowBehavior, info.FlowBehavior); \
+    }
+
+#include "DefineOpCodesGeneratorSpecializations.h"
+#include <opcode.def>
+#include "UnDefineOpCodesGeneratorSpecializations.h"
+#undef OPDEF_REAL_INSTRUCTION
+
+    // Assert
+    EXPECT_EQ(expectedCount, describedCount);
+}
+
+// Checks the aspects describing inline arguments, control flow
+// and stack behavior are properly put to the table.
+
+static_assert(FindOneByteOpCode(std::byte { 0x58 }).IsDefined); // add
+static_assert(FindOneByteOpCode(std::byte { 0x58 }).ArgumentKind == OpCodeArgumentKind::InlineNone);
+static_assert(FindOneByteOpCode(std::byte { 0x58 }).ArgumentSize == 0);
+static_assert(FindOneByteOpCode(std::byte { 0x58 }).FlowBehavior == OpCodeFlowBehavior::Next);
+static_assert(FindOneByteOpCode(std::byte { 0x58 }).ItemsPoppedFromStack == 2);
+static_assert(FindOneByteOpCode(std::byte { 0x58 }).ItemsPushedToStack == 1);
+
+static_assert(FindOneByteOpCode(std::byte { 0x2C }).ArgumentKind == OpCodeArgumentKind::ShortInlineBrTarget); // brfalse.s
+static_assert(FindOneByteOpCode(std::byte { 0x2C }).ArgumentSize == 1);
+static_assert(FindOneByteOpCode(std::byte { 0x2C }).FlowBehavior == OpCodeFlowBehavior::ConditionalBranch);
+
+static_assert(FindOneByteOpCode(std::byte { 0x45 }).ArgumentKind == OpCodeArgumentKind::InlineSwitch); // switch
+static_assert(FindOneByteOpCode(std::byte { 0x45 }).ArgumentSize == 4);
+
+static_assert(FindOneByteOpCode(std::byte { 0x28 }).ArgumentKind == OpCodeArgumentKind::InlineMethod); // call
+static_assert(FindOneByteOpCode(std::byte { 0x28 }).FlowBehavior == OpCodeFlowBehavior::Call);
+static_assert(!FindOneByteOpCode(std::byte { 0x28 }).ItemsPoppedFromStack.has_value());
+static_assert(!FindOneByteOpCode(std::byte { 0x28 }).ItemsPushedToStack.has_value());
+
+static_assert(FindTwoByteOpCode(std::byte { 0x01 }).IsDefined); // ceq
+static_assert(FindTwoByteOpCode(std::byte { 0x01 }).ItemsPoppedFromStack == 2);
+static_assert(FindTwoByteOpCode(std::byte { 0x0C }).ArgumentKind == OpCodeArgumentKind::InlineVar); // ldloc
+static_assert(FindTwoByteOpCode(std::byte { 0x0C }).ArgumentSize == 2);
+
+static_assert(!FindTwoByteOpCode(std::byte { 0xF0 }).IsDefined);
+
+// Measures the instructions per second decoded
+// by MethodBody from the corpus methods.
+TEST(OpCodeTableTests, DISABLED_BenchmarkDecodeThroughput)
+{
+    const std::vector<std::vector<std::byte>> corpus { MakeMethodCorpus() };
+    size_t instructionsCount { 0 };
+    for (const std::vector<std::byte>& bytes : corpus)
+    {
+        const MethodBody method(bytes);
+        for (const StreamElement& element : method.Stream())
+        {
+            instructionsCount += std::holds_alternative<OpCodeVariant>(element);
+        }
+    }
+
+    const double duration { MeasureNanoseconds([&corpus]()
+    {
+        for (const std::vector<std::byte>& bytes : corpus)
+        {
+            const MethodBody method(bytes);
+            KeepResult(method.Stream().size());
+        }
+    }) };
+
+    ReportBenchmark("MethodBody decoding", instructionsCount / duration * 1e3, "million instructions per second");
+}
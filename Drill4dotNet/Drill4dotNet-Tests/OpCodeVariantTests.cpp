@@ -1,5 +1,6 @@
 #include "pch.h"
 
+#include "InstructionStream.h"
 #include "OpCodes.h"
 
 using namespace Drill4dotNet;
@@ -72,6 +73,35 @@ TEST(OpCodeVariantTests, CreateWithArgument)
     EXPECT_EQ(expectedConstant, variant.GetIf<OpCode::CEE_LDC_I4>()->Argument());
 }
 
+// Checks a copy of OpCodeVariant holding an instruction with
+// out-of-line argument gets its own copy of the argument.
+TEST(OpCodeVariantTests, CopySwitch)
+{
+    // Arrange
+    LabelCreator labelCreator{};
+    const Label firstLabel{ labelCreator.CreateLabel() };
+    const Label secondLabel{ labelCreator.CreateLabel() };
+    OpCodeVariant source { OpCode::CEE_SWITCH{{ firstLabel, secondLabel }} };
+
+    // Act
+    const OpCodeVariant copy { source };
+    source = OpCode::CEE_NOP{};
+
+    // Assert
+    AssertVariantHolds<OpCode::CEE_SWITCH>(copy);
+    EXPECT_EQ(1 + 4 + 2 * 4, copy.SizeWithArgument());
+    ASSERT_TRUE(copy.GetIf<OpCode::CEE_SWITCH>().has_value());
+    EXPECT_EQ(
+        OpCodeVariant(OpCode::CEE_SWITCH{{ firstLabel, secondLabel }}),
+        copy);
+    EXPECT_NE(source, copy);
+}
+
+// Checks OpCodeVariant keeps instructions compactly:
+// the instruction code, the argument kind, and an inline
+// argument of up to 8 bytes or a pointer to a bigger one.
+static_assert(sizeof(OpCodeVariant) <= 2 * sizeof(uint64_t));
+
 // Checks the aspects describing control flow and stack
 // behavior are properly added to OpCode::CEE_* classes.
 
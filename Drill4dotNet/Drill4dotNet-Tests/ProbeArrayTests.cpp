@@ -0,0 +1,191 @@
+#include "pch.h"
+
+#include "Benchmark.h"
+#include "ProbeArray.h"
+#include "MethodBody.h"
+
+using namespace Drill4dotNet;
+
+// Inserts the given probe into the method
+// consisting of the single ret instruction.
+// @returns the compiled method body.
+template <size_t Size>
+static std::vector<std::byte> CompileWithProbe(const std::array<OpCodeVariant, Size>& probe)
+{
+    MethodBody method({
+        std::byte { 0x06 }, // tiny header, 1 byte of code
+        std::byte { 0x2A }  // ret
+    });
+
+    method.BeginEdit();
+    for (const OpCodeVariant& instruction : probe)
+    {
+        method.Insert(method.begin(), instruction);
+    }
+
+    method.CommitEdit();
+    return method.Compile();
+}
+
+// Checks a new array has no probes hit, and the
+// probes are hit by writing to their addresses.
+TEST(ProbeArrayTests, WriteToAddressHitsProbe)
+{
+    // Arrange
+    ProbeArray probes { 3 };
+    const std::vector<bool> initialHits { probes.Hits() };
+
+    // Act
+    *reinterpret_cast<std::byte*>(probes.Address(2)) = std::byte { 1 };
+
+    // Assert
+    EXPECT_EQ((std::vector<bool> { false, false, false }), initialHits);
+    EXPECT_EQ((std::vector<bool> { false, false, true }), probes.Hits());
+    EXPECT_EQ(probes.Address(0) + 2, probes.Address(2));
+    EXPECT_TRUE(probes.IsHit(2));
+}
+
+// Checks Reset() marks all probes as not hit.
+TEST(ProbeArrayTests, ResetClearsHits)
+{
+    // Arrange
+    ProbeArray probes { 2 };
+    *reinterpret_cast<std::byte*>(probes.Address(0)) = std::byte { 1 };
+
+    // Act
+    probes.Reset();
+
+    // Assert
+    EXPECT_EQ((std::vector<bool> { false, false }), probes.Hits());
+}
+
+// Checks std::logic_error is thrown for a probe out of the array.
+TEST(ProbeArrayTests, AddressThrowsOutOfRange)
+{
+    // Arrange
+    const ProbeArray probes { 2 };
+
+    // Assert
+    EXPECT_THROW(probes.Address(2), std::logic_error);
+    EXPECT_THROW(probes.IsHit(2), std::logic_error);
+}
+
+// Checks the probe for a 64-bit target loads the address with ldc.i8.
+TEST(ProbeArrayTests, NativeProbe64Bit)
+{
+    // Arrange
+    const std::vector<std::byte> expectedBytes {
+        std::byte { 0x36 }, // tiny header, 13 bytes of code
+        std::byte { 0x21 }, // ldc.i8 0x0000123456789ABC
+        std::byte { 0xBC }, std::byte { 0x9A }, std::byte { 0x78 }, std::byte { 0x56 },
+        std::byte { 0x34 }, std::byte { 0x12 }, std::byte { 0x00 }, std::byte { 0x00 },
+        std::byte { 0xE0 }, // conv.u
+        std::byte { 0x17 }, // ldc.i4.1
+        std::byte { 0x52 }, // stind.i1
+        std::byte { 0x2A }  // ret
+    };
+
+    // Act
+    const std::vector<std::byte> compiled { CompileWithProbe(MakeNativeProbe(0x123456789ABC, 8)) };
+
+    // Assert
+    EXPECT_EQ(expectedBytes, compiled);
+}
+
+// Checks the probe for a 32-bit target loads the address with ldc.i4,
+// and the addresses with the highest bit set are kept.
+TEST(ProbeArrayTests, NativeProbe32Bit)
+{
+    // Arrange
+    const std::vector<std::byte> expectedBytes {
+        std::byte { 0x26 }, // tiny header, 9 bytes of code
+        std::byte { 0x20 }, // ldc.i4 0x89ABCDEF
+        std::byte { 0xEF }, std::byte { 0xCD }, std::byte { 0xAB }, std::byte { 0x89 },
+        std::byte { 0xE0 }, // conv.u
+        std::byte { 0x17 }, // ldc.i4.1
+        std::byte { 0x52 }, // stind.i1
+        std::byte { 0x2A }  // ret
+    };
+
+    // Act
+    const std::vector<std::byte> compiled { CompileWithProbe(MakeNativeProbe(0x89ABCDEF, 4)) };
+
+    // Assert
+    EXPECT_EQ(expectedBytes, compiled);
+}
+
+// Checks std::logic_error is thrown if the address does
+// not fit the pointer, or the pointer size is unknown.
+TEST(ProbeArrayTests, NativeProbeThrowsOnWrongTarget)
+{
+    // Assert
+    EXPECT_THROW(MakeNativeProbe(0x100000000, 4), std::logic_error);
+    EXPECT_THROW(MakeNativeProbe(0x1000, 2), std::logic_error);
+}
+
+// Checks the counter for a 64-bit target loads the address
+// with ldc.i8, and adds 1 to the 64-bit value at it.
+TEST(ProbeArrayTests, NativeCounter64Bit)
+{
+    // Arrange
+    const std::vector<std::byte> expectedBytes {
+        std::byte { 0x46 }, // tiny header, 17 bytes of code
+        std::byte { 0x21 }, // ldc.i8 0x0000123456789ABC
+        std::byte { 0xBC }, std::byte { 0x9A }, std::byte { 0x78 }, std::byte { 0x56 },
+        std::byte { 0x34 }, std::byte { 0x12 }, std::byte { 0x00 }, std::byte { 0x00 },
+        std::byte { 0xE0 }, // conv.u
+        std::byte { 0x25 }, // dup
+        std::byte { 0x4C }, // ldind.i8
+        std::byte { 0x17 }, // ldc.i4.1
+        std::byte { 0x6A }, // conv.i8
+        std::byte { 0x58 }, // add
+        std::byte { 0x55 }, // stind.i8
+        std::byte { 0x2A }  // ret
+    };
+
+    // Act
+    const std::vector<std::byte> compiled { CompileWithProbe(MakeNativeCounter(0x123456789ABC, 8)) };
+
+    // Assert
+    EXPECT_EQ(expectedBytes, compiled);
+    EXPECT_THROW(MakeNativeCounter(0x100000000, 4), std::logic_error);
+}
+
+// Marks the given probe as hit, as the method called by a call-based
+// probe would. Called through a pointer, so it is not inlined.
+static void (* volatile s_recordHit)(std::byte*, size_t) { [](std::byte* const bytes, const size_t probe)
+{
+    bytes[probe] = std::byte { 1 };
+} };
+
+// Measures the time per hit of the code the native probe compiles to,
+// a store of one byte, compared with a call recording the hit, which
+// is the least a call-based probe costs. The runtime is not available
+// to the tests, so the instructions are not compiled by the JIT.
+TEST(ProbeArrayTests, DISABLED_BenchmarkProbeCost)
+{
+    constexpr size_t probesCount { 1024 };
+    constexpr size_t hitsCount { 1000000 };
+    ProbeArray probes { probesCount };
+    const auto bytes { reinterpret_cast<std::byte*>(probes.Address(0)) };
+
+    const double store { MeasureNanoseconds([bytes]()
+    {
+        for (size_t i = 0; i != hitsCount; ++i)
+        {
+            *static_cast<volatile std::byte*>(bytes + i % probesCount) = std::byte { 1 };
+        }
+    }) };
+
+    const double call { MeasureNanoseconds([bytes]()
+    {
+        for (size_t i = 0; i != hitsCount; ++i)
+        {
+            s_recordHit(bytes, i % probesCount);
+        }
+    }) };
+
+    EXPECT_EQ(std::vector<bool>(probesCount, true), probes.Hits());
+    ReportBenchmark("native probe", store / hitsCount, "ns per hit");
+    ReportBenchmark("call-based probe", call / hitsCount, "ns per hit");
+}
@@ -0,0 +1,310 @@
+#include "pch.h"
+
+#include "Benchmark.h"
+#include "StackDepth.h"
+
+using namespace Drill4dotNet;
+
+// Parses the given method signature blob.
+static MethodSignature ParseSignature(const std::vector<std::byte>& signatureBytes)
+{
+    return MethodSignature::Parse(signatureBytes.cbegin(), signatureBytes.cend()).ParsedValue;
+}
+
+// Fails the test, if the analysis asks for a signature.
+static MethodSignature NoCallsExpected(const mdToken)
+{
+    throw std::logic_error("No calls expected");
+}
+
+// Computes the maximal stack depth of the given method.
+// @param method : the method to inspect.
+// @param getCallSignature : gets the signatures of the called methods.
+static uint16_t ComputeMaxStackOf(
+    const MethodBody& method,
+    const CallSignatureProvider& getCallSignature = NoCallsExpected)
+{
+    const ControlFlowGraph graph { method };
+    return ComputeMaxStack(method, graph, getCallSignature);
+}
+
+// Checks the depth of a method without jumps
+// is the maximum of its running stack size.
+TEST(StackDepthTests, StraightLine)
+{
+    // Arrange
+    const std::vector<std::byte> bodyBytes {
+        std::byte { 0x16 }, // tiny header, 5 bytes of code
+        std::byte { 0x17 }, // ldc.i4.1
+        std::byte { 0x18 }, // ldc.i4.2
+        std::byte { 0x58 }, // add
+        std::byte { 0x16 }, // ldc.i4.0
+        std::byte { 0x2A }  // ret
+    };
+
+    const MethodBody method(bodyBytes);
+
+    // Act
+    const uint16_t maxStack { ComputeMaxStackOf(method) };
+
+    // Assert
+    EXPECT_EQ(2, maxStack);
+}
+
+// Checks the depth follows both arms of if-else.
+TEST(StackDepthTests, IfElse)
+{
+    // Arrange
+    const std::vector<std::byte> bodyBytes {
+        std::byte { 0x22 }, // tiny header, 8 bytes of code
+        std::byte { 0x02 }, // ldarg.0
+        std::byte { 0x2C }, // brfalse.s ELSE
+        std::byte { 0x03 },
+        std::byte { 0x17 }, // ldc.i4.1
+        std::byte { 0x2B }, // br.s END
+        std::byte { 0x01 },
+        std::byte { 0x16 }, // ELSE: ldc.i4.0
+        std::byte { 0x2A }  // END: ret
+    };
+
+    const MethodBody method(bodyBytes);
+
+    // Act
+    const uint16_t maxStack { ComputeMaxStackOf(method) };
+
+    // Assert
+    EXPECT_EQ(1, maxStack);
+}
+
+// Checks call and callvirt pop the parameters
+// and "this", and push the returned value.
+TEST(StackDepthTests, CallsUseSignatures)
+{
+    // Arrange
+    const std::vector<std::byte> bodyBytes {
+        std::byte { 0x3A }, // tiny header, 14 bytes of code
+        std::byte { 0x02 }, // ldarg.0
+        std::byte { 0x17 }, // ldc.i4.1
+        std::byte { 0x18 }, // ldc.i4.2
+        std::byte { 0x6F }, // callvirt instance void (int32, int32)
+        std::byte { 0x01 }, std::byte { 0x00 }, std::byte { 0x00 }, std::byte { 0x0A },
+        std::byte { 0x28 }, // call int32 ()
+        std::byte { 0x02 }, std::byte { 0x00 }, std::byte { 0x00 }, std::byte { 0x06 },
+        std::byte { 0x2A }  // ret
+    };
+
+    const MethodBody method(bodyBytes);
+    std::vector<mdToken> requestedTokens {};
+    const auto getCallSignature = [&requestedTokens](const mdToken token)
+    {
+        requestedTokens.push_back(token);
+        return token == 0x0A000001
+            ? ParseSignature({ std::byte { 0x20 }, std::byte { 0x02 }, std::byte { 0x01 }, std::byte { 0x08 }, std::byte { 0x08 } })
+            : ParseSignature({ std::byte { 0x00 }, std::byte { 0x00 }, std::byte { 0x08 } });
+    };
+
+    // Act
+    const uint16_t maxStack { ComputeMaxStackOf(method, getCallSignature) };
+
+    // Assert
+    EXPECT_EQ(3, maxStack);
+    EXPECT_EQ((std::vector<mdToken> { 0x0A000001, 0x06000002 }), requestedTokens);
+}
+
+// Checks newobj pushes the new object instead of popping "this",
+// and calli pops the function pointer after the parameters.
+TEST(StackDepthTests, NewObjectAndIndirectCall)
+{
+    // Arrange
+    const std::vector<std::byte> bodyBytes {
+        std::byte { 0x3E }, // tiny header, 15 bytes of code
+        std::byte { 0x17 }, // ldc.i4.1
+        std::byte { 0x73 }, // newobj instance void (int32)
+        std::byte { 0x01 }, std::byte { 0x00 }, std::byte { 0x00 }, std::byte { 0x06 },
+        std::byte { 0x18 }, // ldc.i4.2
+        std::byte { 0x14 }, // ldnull
+        std::byte { 0x29 }, // calli int32 (object, int32)
+        std::byte { 0x01 }, std::byte { 0x00 }, std::byte { 0x00 }, std::byte { 0x11 },
+        std::byte { 0x26 }, // pop
+        std::byte { 0x2A }  // ret
+    };
+
+    const MethodBody method(bodyBytes);
+    const auto getCallSignature = [](const mdToken token)
+    {
+        return token == 0x06000001
+            ? ParseSignature({ std::byte { 0x20 }, std::byte { 0x01 }, std::byte { 0x01 }, std::byte { 0x08 } })
+            : ParseSignature({ std::byte { 0x00 }, std::byte { 0x02 }, std::byte { 0x08 }, std::byte { 0x1C }, std::byte { 0x08 } });
+    };
+
+    // Act
+    const uint16_t maxStack { ComputeMaxStackOf(method, getCallSignature) };
+
+    // Assert
+    EXPECT_EQ(3, maxStack);
+}
+
+// Checks the catch handler starts with the exception
+// object on the stack, and leave empties the stack.
+TEST(StackDepthTests, CatchHandlerAndLeave)
+{
+    // Arrange
+    const std::vector<std::byte> bodyBytes {
+        std::byte { 0x1B }, std::byte { 0x30 }, // fat header flags and size
+        std::byte { 0x02 }, std::byte { 0x00 }, // max stack
+        std::byte { 0x09 }, std::byte { 0x00 }, std::byte { 0x00 }, std::byte { 0x00 }, // code size
+        std::byte { 0x00 }, std::byte { 0x00 }, std::byte { 0x00 }, std::byte { 0x00 }, // local variables
+        std::byte { 0x00 }, // nop
+        std::byte { 0x02 }, // TRY: ldarg.0
+        std::byte { 0x02 }, // ldarg.0
+        std::byte { 0xDE }, // leave.s END
+        std::byte { 0x03 },
+        std::byte { 0x26 }, // CATCH: pop
+        std::byte { 0xDE }, // leave.s END
+        std::byte { 0x00 },
+        std::byte { 0x2A }, // END: ret
+        std::byte { 0x00 }, std::byte { 0x00 }, std::byte { 0x00 }, // alignment
+        std::byte { 0x01 }, std::byte { 0x10 }, std::byte { 0x00 }, std::byte { 0x00 }, // small section header
+        std::byte { 0x00 }, std::byte { 0x00 }, // catch
+        std::byte { 0x01 }, std::byte { 0x00 }, std::byte { 0x04 }, // try offset and length
+        std::byte { 0x05 }, std::byte { 0x00 }, std::byte { 0x03 }, // handler offset and length
+        std::byte { 0x01 }, std::byte { 0x00 }, std::byte { 0x00 }, std::byte { 0x01 } // exception type
+    };
+
+    const MethodBody method(bodyBytes);
+
+    // Act
+    const uint16_t maxStack { ComputeMaxStackOf(method) };
+
+    // Assert
+    EXPECT_EQ(2, maxStack);
+}
+
+// Checks std::runtime_error is thrown if an instruction
+// pops more items than the stack has.
+TEST(StackDepthTests, ThrowsOnUnderflow)
+{
+    // Arrange
+    const std::vector<std::byte> bodyBytes {
+        std::byte { 0x0A }, // tiny header, 2 bytes of code
+        std::byte { 0x26 }, // pop
+        std::byte { 0x2A }  // ret
+    };
+
+    const MethodBody method(bodyBytes);
+
+    // Assert
+    EXPECT_THROW(ComputeMaxStackOf(method), std::runtime_error);
+}
+
+// Checks std::runtime_error is thrown if the stack has
+// different depths on different paths to an instruction.
+TEST(StackDepthTests, ThrowsOnInconsistentDepth)
+{
+    // Arrange
+    const std::vector<std::byte> bodyBytes {
+        std::byte { 0x16 }, // tiny header, 5 bytes of code
+        std::byte { 0x02 }, // ldarg.0
+        std::byte { 0x2C }, // brfalse.s END
+        std::byte { 0x01 },
+        std::byte { 0x17 }, // ldc.i4.1
+        std::byte { 0x2A }  // END: ret
+    };
+
+    const MethodBody method(bodyBytes);
+
+    // Assert
+    EXPECT_THROW(ComputeMaxStackOf(method), std::runtime_error);
+}
+
+// Checks the computed depth, which does not fit the
+// tiny header, turns it into a fat one.
+TEST(StackDepthTests, DeepStackPromotesHeader)
+{
+    // Arrange
+    std::vector<std::byte> bodyBytes { std::byte { 0x4A } }; // tiny header, 18 bytes of code
+    bodyBytes.insert(bodyBytes.end(), 9, std::byte { 0x16 }); // ldc.i4.0
+    bodyBytes.insert(bodyBytes.end(), 8, std::byte { 0x58 }); // add
+    bodyBytes.push_back(std::byte { 0x2A }); // ret
+
+    MethodBody method(bodyBytes);
+
+    // Act
+    method.SetMaxStack(ComputeMaxStackOf(method));
+    const std::vector<std::byte> compiled { method.Compile() };
+
+    // Assert
+    EXPECT_EQ(9, method.MaxStack());
+    ASSERT_EQ(12 + 18, compiled.size());
+    EXPECT_EQ(std::byte { 0x03 }, compiled[0]);
+    EXPECT_EQ(std::byte { 0x09 }, compiled[2]);
+    EXPECT_TRUE(std::equal(bodyBytes.cbegin() + 1, bodyBytes.cend(), compiled.cbegin() + 12));
+}
+
+// Checks std::runtime_error is thrown if a handler
+// is not in the given graph.
+TEST(StackDepthTests, ThrowsOnHandlerOutsideGraph)
+{
+    // Arrange
+    const std::vector<std::byte> bodyBytes {
+        std::byte { 0x1B }, std::byte { 0x30 }, // fat header flags and size
+        std::byte { 0x02 }, std::byte { 0x00 }, // max stack
+        std::byte { 0x06 }, std::byte { 0x00 }, std::byte { 0x00 }, std::byte { 0x00 }, // code size
+        std::byte { 0x00 }, std::byte { 0x00 }, std::byte { 0x00 }, std::byte { 0x00 }, // local variables
+        std::byte { 0xDE }, // TRY: leave.s END
+        std::byte { 0x03 },
+        std::byte { 0x26 }, // CATCH: pop
+        std::byte { 0xDE }, // leave.s END
+        std::byte { 0x00 },
+        std::byte { 0x2A }, // END: ret
+        std::byte { 0x00 }, std::byte { 0x00 }, // alignment
+        std::byte { 0x01 }, std::byte { 0x10 }, std::byte { 0x00 }, std::byte { 0x00 }, // small section header
+        std::byte { 0x00 }, std::byte { 0x00 }, // catch
+        std::byte { 0x00 }, std::byte { 0x00 }, std::byte { 0x02 }, // try offset and length
+        std::byte { 0x02 }, std::byte { 0x00 }, std::byte { 0x03 }, // handler offset and length
+        std::byte { 0x01 }, std::byte { 0x00 }, std::byte { 0x00 }, std::byte { 0x01 } // exception type
+    };
+
+    const MethodBody method(bodyBytes);
+
+    // The graph of another method, which has no labels.
+    const MethodBody otherMethod(std::vector<std::byte> {
+        std::byte { 0x06 }, // tiny header, 1 byte of code
+        std::byte { 0x2A }  // ret
+    });
+
+    const ControlFlowGraph otherGraph { otherMethod };
+
+    // Act & Assert
+    EXPECT_THROW(ComputeMaxStack(method, otherGraph, NoCallsExpected), std::runtime_error);
+}
+
+// Measures the time per instruction ComputeMaxStack takes
+// for the corpus methods, with their graphs built beforehand.
+TEST(StackDepthTests, DISABLED_BenchmarkComputeMaxStack)
+{
+    std::vector<MethodBody> methods {};
+    size_t instructionsCount { 0 };
+    for (const std::vector<std::byte>& bytes : MakeMethodCorpus())
+    {
+        const MethodBody& method { methods.emplace_back(bytes) };
+        instructionsCount += method.Stream().InstructionsBefore(method.end());
+    }
+
+    std::vector<ControlFlowGraph> graphs {};
+    for (const MethodBody& method : methods)
+    {
+        graphs.emplace_back(method);
+    }
+
+    const CallSignatureProvider getCallSignature { CorpusCallSignature };
+    const double duration { MeasureNanoseconds([&methods, &graphs, &getCallSignature]()
+    {
+        for (size_t i = 0; i != methods.size(); ++i)
+        {
+            KeepResult(ComputeMaxStack(methods[i], graphs[i], getCallSignature));
+        }
+    }) };
+
+    ReportBenchmark("ComputeMaxStack", duration / instructionsCount, "ns per instruction");
+}
@@ -0,0 +1,66 @@
+#include "pch.h"
+#include "BlockCoverage.h"
+
+#include <algorithm>
+
+namespace Drill4dotNet
+{
+    BlockCoveragePlan::BlockCoveragePlan(const ControlFlowGraph& graph)
+        : m_parents(graph.Blocks().size(), NoBlock),
+        m_probedBlocks {}
+    {
+        const DominatorTree& dominators { graph.Dominators() };
+        for (BlockIndex block = 0; block != m_parents.size(); ++block)
+        {
+            if (!dominators.Contains(block))
+            {
+                continue;
+            }
+
+            m_parents[block] = dominators.Parent(block);
+            const auto successors { graph.Successors(block) };
+            const bool needsProbe { successors.empty()
+                || std::any_of(
+                    successors.begin(),
+                    successors.end(),
+                    [&dominators, block](const ControlFlowEdge& edge)
+                    {
+                        return !dominators.Dominates(block, edge.Block);
+                    }) };
+
+            if (needsProbe)
+            {
+                m_probedBlocks.push_back(block);
+            }
+        }
+    }
+
+    std::vector<bool> BlockCoveragePlan::ReconstructCoverage(const std::vector<bool>& probeHits) const
+    {
+        if (probeHits.size() != m_probedBlocks.size())
+        {
+            throw std::logic_error("The count of probe hits does not match the count of probes.");
+        }
+
+        // Each block is marked once, and the walk up
+        // stops at the first block already marked,
+        // so it takes linear time in total.
+        std::vector<bool> result(m_parents.size(), false);
+        for (size_t probe = 0; probe != probeHits.size(); ++probe)
+        {
+            if (!probeHits[probe])
+            {
+                continue;
+            }
+
+            for (BlockIndex block = m_probedBlocks[probe];
+                block != NoBlock && !result[block];
+                block = m_parents[block])
+            {
+                result[block] = true;
+            }
+        }
+
+        return result;
+    }
+}
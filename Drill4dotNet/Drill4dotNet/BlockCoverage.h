@@ -0,0 +1,104 @@
+#pragma once
+
+#include "ControlFlowGraph.h"
+
+#include <vector>
+
+namespace Drill4dotNet
+{
+    // Decides which basic blocks of a method get coverage probes,
+    // and restores the coverage of all blocks from the probes hit.
+    // A probe at the beginning of a block proves that every block
+    // dominating it has been executed as well. So a block does not
+    // need a probe, if every execution leaving it reaches a probed
+    // block it dominates: it is not an exit, and all its successors
+    // are dominated by it. Only the remaining blocks are probed,
+    // which is the smallest set allowing to restore the coverage
+    // this way: a block with a successor it does not dominate may
+    // be the last executed one, and no probe but its own proves it.
+    // Blocks not reachable from the entry are never executed, and
+    // do not get probes. The coverage is exact for executions,
+    // which have returned or have thrown from an exit. A block,
+    // which is being executed or has thrown an exception out of the
+    // method, may be reported as not covered, but a block is never
+    // reported as covered before it is executed.
+    // The plan does not refer to the graph, so it can be kept
+    // to restore the coverage after the method is compiled.
+    class BlockCoveragePlan
+    {
+    private:
+        // For each block, its immediate dominator, or NoBlock.
+        std::vector<BlockIndex> m_parents;
+
+        // The blocks getting probes, in ascending order.
+        // Probe i is put to block m_probedBlocks[i].
+        std::vector<BlockIndex> m_probedBlocks;
+
+    public:
+        // Chooses the probes for the blocks of the given graph.
+        // Takes the time linear in the count of blocks and edges.
+        // @param graph : the control flow graph of the method.
+        explicit BlockCoveragePlan(const ControlFlowGraph& graph);
+
+        // Gets the count of blocks of the method.
+        size_t BlocksCount() const noexcept
+        {
+            return m_parents.size();
+        }
+
+        // Gets the blocks getting probes, in ascending order.
+        // Probe i is put to block ProbedBlocks()[i].
+        const std::vector<BlockIndex>& ProbedBlocks() const noexcept
+        {
+            return m_probedBlocks;
+        }
+
+        // Queues the instructions of each probe for insertion before the
+        // first instruction of its block, after the labels, so jumps to
+        // the block execute the probe. Starts and commits an edit, if an
+        // edit is not in progress. The method must not be changed after
+        // the graph given to the plan has been built, except by queueing
+        // changes since BeginEdit().
+        // TMakeProbe : callable accepting the probe index and returning
+        //     a container of OpCodeVariant. The instructions must keep the
+        //     evaluation stack as is and must not jump out of the probe.
+        // @param method : the method to instrument.
+        // @param graph : the control flow graph the plan has been made for.
+        // @param makeProbe : creates the instructions of a probe.
+        template <typename TMakeProbe>
+        void InsertProbes(
+            MethodBody& method,
+            const ControlFlowGraph& graph,
+            TMakeProbe&& makeProbe) const
+        {
+            const bool ownEdit { !method.IsEditInProgress() };
+            if (ownEdit)
+            {
+                method.BeginEdit();
+            }
+
+            for (size_t probe = 0; probe != m_probedBlocks.size(); ++probe)
+            {
+                const ConstStreamPosition position { SkipLabels(
+                    method.begin() + graph.Blocks()[m_probedBlocks[probe]].Begin,
+                    method.end()) };
+
+                for (const OpCodeVariant& instruction : makeProbe(probe))
+                {
+                    method.Insert(position, instruction);
+                }
+            }
+
+            if (ownEdit)
+            {
+                method.CommitEdit();
+            }
+        }
+
+        // Restores the coverage of all blocks from the probes hit.
+        // The result suits ExecClassData::probes, one element per block.
+        // Throws std::logic_error if the count of probes is wrong.
+        // @param probeHits : for each probe, whether it has been hit.
+        std::vector<bool> ReconstructCoverage(const std::vector<bool>& probeHits) const;
+    };
+}
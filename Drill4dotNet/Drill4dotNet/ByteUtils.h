@@ -1,9 +1,273 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <bit>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
 
 namespace Drill4dotNet
 {
+    // Calculates how many bytes must follow the given
+    // amount of bytes to achieve the given byte alignment.
+    // alignment : the alignment in bytes
+    // @param size : the amount of bytes to align.
+    template <size_t alignment>
+    constexpr size_t PaddingToBoundary(const size_t size) noexcept
+    {
+        return (alignment - size % alignment) % alignment;
+    }
+
+    // Order of bytes in binary representation of multi-byte values.
+    enum class ByteOrder
+    {
+        // The least significant byte goes first. Used by
+        // method headers, instructions and exception sections.
+        LittleEndian,
+
+        // The most significant byte goes first. Used by
+        // compressed integers in signature blobs.
+        BigEndian
+    };
+
+    // Determines whether the given type is a number, which
+    // ByteWriter and ByteReader can convert to the given byte order.
+    template <typename T>
+    concept IsOrderedNumber = std::is_arithmetic_v<T> || std::is_enum_v<T>;
+
+    // Reverses the given bytes of a number, if the
+    // given byte order differs from the native one.
+    // order : the byte order to convert from or to.
+    // size : the size of the number, in bytes.
+    // @param bytes : the bytes of the number.
+    template <ByteOrder order, size_t size>
+    void ConvertNativeByteOrder(std::byte* const bytes) noexcept
+    {
+        constexpr ByteOrder nativeOrder { std::endian::native == std::endian::little
+            ? ByteOrder::LittleEndian
+            : ByteOrder::BigEndian };
+
+        if constexpr (order != nativeOrder && size != 1)
+        {
+            std::reverse(bytes, bytes + size);
+        }
+    }
+
+    // Writes binary representations of values either to the end
+    // of a bytes vector, growing it, or to a fixed-size buffer,
+    // checking its bounds. Copies each value with one memcpy.
+    class ByteWriter
+    {
+    private:
+        // The vector to append to, or nullptr if writing
+        // to a fixed-size buffer.
+        std::vector<std::byte>* m_vector;
+
+        // The fixed-size buffer to write to.
+        std::span<std::byte> m_buffer;
+
+        // The amount of bytes written.
+        size_t m_written { 0 };
+
+        // Provides room for the given amount of bytes.
+        // Returns the pointer to write the bytes to.
+        // Throws std::overflow_error if the fixed-size buffer is too small.
+        // @param count : the amount of bytes.
+        std::byte* Allocate(const size_t count)
+        {
+            std::byte* result;
+            if (m_vector != nullptr)
+            {
+                const size_t start { m_vector->size() };
+                m_vector->resize(start + count);
+                result = m_vector->data() + start;
+            }
+            else
+            {
+                if (m_buffer.size() - m_written < count)
+                {
+                    throw std::overflow_error("There is no room in the target buffer to write the value");
+                }
+
+                result = m_buffer.data() + m_written;
+            }
+
+            m_written += count;
+            return result;
+        }
+
+    public:
+        // Creates a writer appending to the given vector.
+        // @param target : the vector to append to.
+        explicit ByteWriter(std::vector<std::byte>& target) noexcept
+            : m_vector { &target }
+        {
+        }
+
+        // Creates a writer filling the given buffer from its beginning.
+        // @param target : the buffer to write to.
+        explicit ByteWriter(const std::span<std::byte> target) noexcept
+            : m_vector { nullptr },
+            m_buffer { target }
+        {
+        }
+
+        // Prepares to write the given amount of bytes, so
+        // writing them to a vector does not reallocate it.
+        // @param count : the amount of bytes to be written.
+        void Reserve(const size_t count)
+        {
+            if (m_vector != nullptr)
+            {
+                m_vector->reserve(m_vector->size() + count);
+            }
+        }
+
+        // Gets the amount of bytes written by this writer.
+        size_t Written() const noexcept
+        {
+            return m_written;
+        }
+
+        // Writes the given number with the given byte order.
+        // order : the byte order to use.
+        // @param value : the number to write.
+        template <ByteOrder order = ByteOrder::LittleEndian, IsOrderedNumber T>
+        void Write(const T value)
+        {
+            std::byte* const target { Allocate(sizeof(T)) };
+            std::memcpy(target, &value, sizeof(T));
+            ConvertNativeByteOrder<order, sizeof(T)>(target);
+        }
+
+        // Writes the in-memory representation of the given
+        // structure, as the runtime structures expect.
+        // @param value : the structure to write.
+        template <typename T>
+        void WriteRaw(const T& value)
+        {
+            static_assert(std::is_trivially_copyable_v<T>);
+            std::memcpy(Allocate(sizeof(T)), &value, sizeof(T));
+        }
+
+        // Writes the given bytes as is.
+        // @param bytes : the bytes to write.
+        void WriteBytes(const std::span<const std::byte> bytes)
+        {
+            if (!bytes.empty())
+            {
+                std::memcpy(Allocate(bytes.size()), bytes.data(), bytes.size());
+            }
+        }
+
+        // Writes zero bytes until Written() is a multiple of the given alignment.
+        // alignment : the alignment in bytes.
+        template <size_t alignment>
+        void AlignTo()
+        {
+            const size_t padding { PaddingToBoundary<alignment>(m_written) };
+            if (padding != 0)
+            {
+                std::memset(Allocate(padding), 0, padding);
+            }
+        }
+    };
+
+    // Reads values from a bytes buffer, checking its bounds.
+    class ByteReader
+    {
+    private:
+        // The buffer to read from.
+        std::span<const std::byte> m_source;
+
+        // The amount of bytes read.
+        size_t m_position { 0 };
+
+        // Moves past the given amount of bytes.
+        // Returns the pointer to the first of them.
+        // Throws std::runtime_error if the buffer ends earlier.
+        // @param count : the amount of bytes.
+        const std::byte* Take(const size_t count)
+        {
+            if (Remaining() < count)
+            {
+                throw std::runtime_error("Unexpected end of the input");
+            }
+
+            const std::byte* const result { m_source.data() + m_position };
+            m_position += count;
+            return result;
+        }
+
+    public:
+        // Creates a reader of the given buffer, starting from its beginning.
+        // @param source : the buffer to read.
+        explicit ByteReader(const std::span<const std::byte> source) noexcept
+            : m_source { source }
+        {
+        }
+
+        // Gets the amount of bytes read.
+        size_t Position() const noexcept
+        {
+            return m_position;
+        }
+
+        // Gets the amount of bytes left to read.
+        size_t Remaining() const noexcept
+        {
+            return m_source.size() - m_position;
+        }
+
+        // Gets the next byte without moving past it.
+        // Throws std::runtime_error if there are no bytes left.
+        std::byte Peek() const
+        {
+            if (Remaining() == 0)
+            {
+                throw std::runtime_error("Unexpected end of the input");
+            }
+
+            return m_source[m_position];
+        }
+
+        // Reads a number stored with the given byte order.
+        // Throws std::runtime_error if the buffer ends earlier.
+        // order : the byte order of the stored number.
+        template <IsOrderedNumber T, ByteOrder order = ByteOrder::LittleEndian>
+        T Read()
+        {
+            std::array<std::byte, sizeof(T)> bytes;
+            std::memcpy(bytes.data(), Take(sizeof(T)), sizeof(T));
+            ConvertNativeByteOrder<order, sizeof(T)>(bytes.data());
+            T result;
+            std::memcpy(&result, bytes.data(), sizeof(T));
+            return result;
+        }
+
+        // Reads the in-memory representation of the given structure.
+        // Throws std::runtime_error if the buffer ends earlier.
+        template <typename T>
+        T ReadRaw()
+        {
+            static_assert(std::is_trivially_copyable_v<T>);
+            T result;
+            std::memcpy(&result, Take(sizeof(T)), sizeof(T));
+            return result;
+        }
+
+        // Reads the given amount of bytes as is.
+        // Throws std::runtime_error if the buffer ends earlier.
+        // @param count : the amount of bytes.
+        std::span<const std::byte> ReadBytes(const size_t count)
+        {
+            return { Take(count), count };
+        }
+    };
+
     // Appends the binary representation of the
     // given object to the bytes vector.
     // @param target : the vector to append bytes to.
@@ -11,10 +275,7 @@ namespace Drill4dotNet
     template <typename T>
     void AppendAsBytes(std::vector<std::byte>& target, const T& value)
     {
-        for (const auto b : (std::array<std::byte, sizeof(T)>&)value)
-        {
-            target.push_back(b);
-        }
+        ByteWriter(target).WriteRaw(value);
     }
 
     // Calculates how far the given iterator must be advanced
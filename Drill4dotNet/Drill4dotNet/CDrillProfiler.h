@@ -9,7 +9,11 @@
 
 namespace Drill4dotNet
 {
-    using TConnector = Connector<std::function<std::vector<AstEntity>()>, std::function<void(const PackagesPrefixes&)>>;
+    using TConnector = Connector<
+        std::function<std::vector<AstEntity>()>,
+        std::function<void(const PackagesPrefixes&)>,
+        std::function<void(const SessionChange&)>,
+        std::function<std::vector<ExecClassData>()>>;
     using TLogger = LogToProClient<TConnector>;
     class ATL_NO_VTABLE CDrillProfiler
         : public ATL::CComObjectRootEx<ATL::CComSingleThreadModel>
@@ -30,6 +34,8 @@ namespace Drill4dotNet
         BEGIN_COM_MAP(CDrillProfiler)
             COM_INTERFACE_ENTRY(ICorProfilerCallback)
             COM_INTERFACE_ENTRY(ICorProfilerCallback2)
+            COM_INTERFACE_ENTRY(ICorProfilerCallback3)
+            COM_INTERFACE_ENTRY(ICorProfilerCallback4)
         END_COM_MAP()
         DECLARE_PROTECT_FINAL_CONSTRUCT()
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <optional>
 #include <filesystem>
 #include <type_traits>
@@ -8,11 +9,18 @@
 #include <chrono>
 #include <condition_variable>
 #include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
 
 #include "LogBuffer.h"
 #include "ICorProfilerInfo.h"
 #include "CProfilerCallbackBase.h"
 #include "ComWrapperBase.h"
+#include "BlockCoverage.h"
+#include "CoverageRegistry.h"
+#include "InstrumentationRules.h"
+#include "ModuleMetadataCache.h"
+#include "MethodArena.h"
 #include "MethodBody.h"
 #include "IMetadataImport.h"
 #include "IMetaDataAssemblyImport.h"
@@ -20,6 +28,7 @@
 #include "Connector.h"
 #include "ProClient.h"
 #include "Signature.h"
+#include "StackDepth.h"
 
 namespace Drill4dotNet
 {
@@ -73,6 +82,51 @@ namespace Drill4dotNet
         return std::nullopt;
     }
 
+    // Gets the names of the given methods of one module, reading the name
+    // of each class once for all its methods.
+    // @param metadataImport : the metadata of the module, or nullptr if not obtained.
+    // @param tokens : the methods to get the names of.
+    // @returns the names by the positions of the tokens, std::nullopt for
+    //     the methods the names of which cannot be obtained.
+    template <IMetadataImport TMetadataImport>
+    std::vector<std::optional<FunctionName>> TryGetFunctionNames(
+        const std::shared_ptr<const TMetadataImport>& metadataImport,
+        const std::vector<mdMethodDef>& tokens)
+    {
+        std::vector<std::optional<FunctionName>> result(tokens.size());
+        if (metadataImport == nullptr)
+        {
+            return result;
+        }
+
+        std::unordered_map<mdTypeDef, std::optional<std::wstring>> classNames {};
+        for (size_t i = 0; i != tokens.size(); ++i)
+        {
+            std::optional<MethodProps> methodProps { metadataImport->TryGetMethodProps(tokens[i]) };
+            if (!methodProps.has_value())
+            {
+                continue;
+            }
+
+            auto [className, isNew] { classNames.try_emplace(methodProps->EnclosingClass) };
+            if (isNew)
+            {
+                if (std::optional<TypeDefProps> classProps { metadataImport->TryGetTypeDefProps(methodProps->EnclosingClass) }
+                    ; classProps.has_value())
+                {
+                    className->second = std::move(classProps->Name);
+                }
+            }
+
+            if (className->second.has_value())
+            {
+                result[i] = FunctionName { std::move(methodProps->Name), *className->second };
+            }
+        }
+
+        return result;
+    }
+
     // Adds the class name to the given class info.
     // @param classInfo : the object carrying tokens of the class.
     // @returns the class name and the tokens from classInfo, if obtained, std::nullopt otherwise.
@@ -117,6 +171,37 @@ namespace Drill4dotNet
         return result;
     }
 
+    // Gets the signature of the method called by call, callvirt,
+    // newobj, or calli instruction, suitable for CallSignatureProvider.
+    // Throws _com_error in case of an error, std::runtime_error
+    // if the token cannot refer to a called method.
+    // @param token : the inline argument of the instruction.
+    template <IMetadataImport TMetadataImport>
+    MethodSignature GetCallSignature(
+        const TMetadataImport& metadataImport,
+        const mdToken token)
+    {
+        std::vector<std::byte> signatureBytes {};
+        switch (TypeFromToken(token))
+        {
+        case mdtMethodDef:
+            signatureBytes = metadataImport.GetMethodProps(token).SignatureBlob;
+            break;
+        case mdtMemberRef:
+            signatureBytes = metadataImport.GetMemberReferenceProps(token).SignatureBlob;
+            break;
+        case mdtMethodSpec:
+            return GetCallSignature(metadataImport, metadataImport.GetMethodSpecificationParent(token));
+        case mdtSignature:
+            signatureBytes = metadataImport.GetSignatureBlob(token);
+            break;
+        default:
+            throw std::runtime_error("The token does not refer to a method or a signature.");
+        }
+
+        return MethodSignature::Parse(signatureBytes.cbegin(), signatureBytes.cend()).ParsedValue;
+    }
+
     // Wraps ProClient to make its logging interface
     // compatible with CorProfilerInfo.
     template <IsConnector TConnector>
@@ -143,6 +228,109 @@ namespace Drill4dotNet
         }
     };
 
+    // Requests the ReJIT of the given methods. Does nothing if there are
+    // no methods. Throws _com_error in case of an error.
+    // @param corProfilerInfo : the tool to request the ReJIT.
+    // @param methods : the methods to compile again.
+    template <TCorProfilerInfo CorProfilerInfo>
+    void RequestReJITOf(
+        const CorProfilerInfo& corProfilerInfo,
+        const std::vector<MethodKey>& methods)
+    {
+        if (methods.empty())
+        {
+            return;
+        }
+
+        std::vector<ModuleID> moduleIds {};
+        std::vector<mdMethodDef> methodIds {};
+        moduleIds.reserve(methods.size());
+        methodIds.reserve(methods.size());
+        for (const MethodKey& key : methods)
+        {
+            moduleIds.push_back(key.Module);
+            methodIds.push_back(key.Method);
+        }
+
+        corProfilerInfo.RequestReJIT(moduleIds, methodIds);
+    }
+
+    // Requests the ReJIT of the methods, all block coverage probes
+    // of which have been hit, so they are compiled again with their
+    // original bodies, and run without the probes. Their coverage is kept.
+    // Returns the methods the ReJIT has been requested for.
+    // Throws _com_error in case of an error.
+    // @param corProfilerInfo : the tool to request the ReJIT.
+    // @param coverage : the instrumented methods.
+    template <TCorProfilerInfo CorProfilerInfo>
+    std::vector<MethodKey> RetireFullyCoveredMethods(
+        const CorProfilerInfo& corProfilerInfo,
+        CoverageRegistry& coverage)
+    {
+        const std::vector<MethodKey> retired { coverage.RetireFullyCovered() };
+        RequestReJITOf(corProfilerInfo, retired);
+        return retired;
+    }
+
+    // Starts or stops a test session, and requests the ReJIT of the
+    // instrumented methods, so they run with the probes only while
+    // the session is active. Returns the methods the ReJIT has been
+    // requested for. Throws _com_error in case of an error.
+    // @param corProfilerInfo : the tool to request the ReJIT.
+    // @param coverage : the instrumented methods.
+    // @param isActive : whether the session starts.
+    template <TCorProfilerInfo CorProfilerInfo>
+    std::vector<MethodKey> SwitchCoverageSession(
+        const CorProfilerInfo& corProfilerInfo,
+        CoverageRegistry& coverage,
+        const bool isActive)
+    {
+        const std::vector<MethodKey> methods { isActive
+            ? coverage.StartSession()
+            : coverage.StopSession() };
+        RequestReJITOf(corProfilerInfo, methods);
+        return methods;
+    }
+
+    // Makes the coverage to send to the admin when a test session stops:
+    // an ExecClassData for each method, which has got the probes, with the
+    // coverage of its basic blocks, see CoverageRegistry::Coverage. The
+    // class name is the module file name without the extension, which is
+    // the assembly name, and the name of the class of the method.
+    // Throws _com_error in case of an error.
+    // @param corProfilerInfo : the tool to get the module names.
+    // @param coverage : the instrumented methods.
+    // @param getModuleMetadata : callable accepting ModuleID, which gets
+    //     a pointer to the metadata of the module.
+    template <TCorProfilerInfo CorProfilerInfo, typename TGetModuleMetadata>
+    std::vector<ExecClassData> MakeSessionCoverage(
+        const CorProfilerInfo& corProfilerInfo,
+        const CoverageRegistry& coverage,
+        TGetModuleMetadata&& getModuleMetadata)
+    {
+        std::vector<ExecClassData> result {};
+        for (const MethodKey key : coverage.MethodsWithProbes())
+        {
+            std::optional<std::vector<bool>> probes { coverage.Coverage(key) };
+            if (!probes.has_value())
+            {
+                // The module has been unloaded meanwhile.
+                continue;
+            }
+
+            const auto metadata { getModuleMetadata(key.Module) };
+            const MethodProps methodProps { metadata->GetMethodProps(key.Method) };
+            const std::filesystem::path modulePath { corProfilerInfo.GetModuleInfo(key.Module).name };
+            result.push_back(ExecClassData {
+                .className = modulePath.stem().native()
+                    + L"/"
+                    + metadata->GetTypeDefProps(methodProps.EnclosingClass).Name,
+                .probes = std::move(*probes) });
+        }
+
+        return result;
+    }
+
     template <
         IsConnector TConnector,
         TCorProfilerInfo CorProfilerInfo,
@@ -154,106 +342,430 @@ namespace Drill4dotNet
         public CProfilerCallbackBase
     {
     private:
+        // There are no Enter and Leave hooks: the calls are counted by the
+        // instrumented bodies, which test sessions swap in and out by ReJIT,
+        // see CoverageRegistry. Outside sessions the methods run their
+        // original code, without any call into the profiler.
         inline static constexpr DWORD EVENTS_WE_MONITOR =
             COR_PRF_MONITOR_CLASS_LOADS |
             COR_PRF_MONITOR_MODULE_LOADS |
             COR_PRF_MONITOR_ASSEMBLY_LOADS |
             COR_PRF_MONITOR_APPDOMAIN_LOADS |
             COR_PRF_MONITOR_JIT_COMPILATION |
-            COR_PRF_MONITOR_ENTERLEAVE;
+            COR_PRF_ENABLE_REJIT;
 
         ProClient<TConnector>& m_pImplClient;
         std::optional<CorProfilerInfo> m_corProfilerInfo;
         std::optional<std::vector<std::wstring>> m_packagesPrefixes;
         std::optional<std::thread> m_adminInteractionThread;
+        std::atomic<bool> m_stopAdminInteraction { false };
+        CoverageRegistry m_coverage {};
+
+        // The method the example injection is done into, see JITCompilationStarted.
+        inline static const InstrumentationRule s_injectionTargetRule {
+            .Include = true,
+            .ModulePrefix = L"HelloWorld",
+            .ClassPattern = L"HelloWorld.Program",
+            .MethodPattern = L"MyInjectionTarget" };
+
+        // Guards m_instrumentationRules, m_moduleRules and m_classScopes.
+        mutable std::shared_mutex m_rulesMutex {};
+
+        // Chooses the methods to instrument, made from the packages prefixes.
+        InstrumentationRules m_instrumentationRules { { s_injectionTargetRule } };
+
+        // The rules applying to the loaded modules, so the module file
+        // name is looked at once for each module, not for each method.
+        std::unordered_map<ModuleID, ModuleRules> m_moduleRules {};
+
+        // Which methods of the classes of the loaded modules are instrumented,
+        // by the module and the class token, see ModuleRules::ForClass.
+        std::unordered_map<ModuleID, std::unordered_map<mdTypeDef, ModuleRules::Scope>> m_classScopes {};
+
+        // The metadata of the loaded modules, opened once for each module.
+        ModuleMetadataCache<MetaDataImport> m_moduleMetadata {};
+
+        // Decides whether the given function is instrumented: only the
+        // functions matching the instrumentation rules are. Returns the
+        // function with its name, or std::nullopt if the function is not
+        // instrumented. The decisions are cached for each module and class,
+        // so the functions of the modules not instrumented are rejected
+        // without reading the metadata, and the rules are matched against
+        // the name of each class once.
+        // Throws _com_error in case of an error.
+        // @param functionId : the function to decide about.
+        std::optional<FunctionInfo> FindInstrumentedFunction(const FunctionID functionId)
+        {
+            const FunctionInfoWithoutName functionInfoWithoutName {
+                m_corProfilerInfo->GetFunctionInfo(functionId) };
 
-        inline static CProfilerCallback* g_cb = nullptr;
+            const ModuleID moduleId { functionInfoWithoutName.moduleId };
+            const ModuleRules::Scope moduleScope { VisitModuleRules(
+                moduleId,
+                [](const ModuleRules& rules) { return rules.GetScope(); }) };
 
-        static void __stdcall fn_functionEnter(
-            FunctionID funcId,
-            UINT_PTR clientData,
-            COR_PRF_FRAME_INFO func,
-            COR_PRF_FUNCTION_ARGUMENT_INFO* argumentInfo
-        )
-        {
-            if (!g_cb) return;
+            if (moduleScope == ModuleRules::Scope::None)
+            {
+                return std::nullopt;
+            }
 
-            if (std::optional<FunctionInfo> functionInfo = g_cb->GetInfoHandler().TryGetFunctionInfo(funcId);
-                functionInfo.has_value())
+            const std::shared_ptr<const MetaDataImport> moduleMetaData { GetModuleMetadata(moduleId) };
+            const MethodProps methodProps { moduleMetaData->GetMethodProps(functionInfoWithoutName.token) };
+            std::optional<ModuleRules::Scope> classScope {};
+            if (moduleScope == ModuleRules::Scope::All)
             {
-                g_cb->GetClient().Log() << L"Enter function: " << functionInfo->fullName();
+                classScope = ModuleRules::Scope::All;
             }
             else
             {
-                g_cb->GetClient().Log() << L"Enter function: " << funcId;
+                std::shared_lock lock { m_rulesMutex };
+                if (const auto module { m_classScopes.find(moduleId) }
+                    ; module != m_classScopes.cend())
+                {
+                    if (const auto found { module->second.find(methodProps.EnclosingClass) }
+                        ; found != module->second.cend())
+                    {
+                        classScope = found->second;
+                    }
+                }
+            }
+
+            if (classScope == ModuleRules::Scope::None)
+            {
+                return std::nullopt;
+            }
+
+            FunctionInfo functionInfo {};
+            functionInfo.moduleId = moduleId;
+            functionInfo.classId = functionInfoWithoutName.classId;
+            functionInfo.token = functionInfoWithoutName.token;
+            functionInfo.name = FunctionName {
+                methodProps.Name,
+                moduleMetaData->GetTypeDefProps(methodProps.EnclosingClass).Name };
+
+            if (!classScope.has_value())
+            {
+                classScope = VisitModuleRules(
+                    moduleId,
+                    [&functionInfo](const ModuleRules& rules)
+                    {
+                        return rules.ForClass(functionInfo.name.className);
+                    });
+
+                std::unique_lock lock { m_rulesMutex };
+                m_classScopes[moduleId].try_emplace(methodProps.EnclosingClass, *classScope);
+            }
+
+            if (classScope == ModuleRules::Scope::None
+                || (classScope == ModuleRules::Scope::ByName
+                    && !VisitModuleRules(
+                        moduleId,
+                        [&functionInfo](const ModuleRules& rules)
+                        {
+                            return rules.Matches(functionInfo.name.className, functionInfo.name.ownName);
+                        })))
+            {
+                return std::nullopt;
+            }
+
+            return functionInfo;
+        }
+
+        // Resolves the names of the functions called, for the statistics.
+        // @param moduleId : the module to resolve the names of the functions
+        //     of, or std::nullopt to resolve the names in all modules.
+        void ResolveCalledFunctionNames(const std::optional<ModuleID> moduleId)
+        {
+            if (!m_corProfilerInfo.has_value())
+            {
+                return;
             }
-            g_cb->GetInfoHandler().FunctionCalled(funcId);
+
+            GetInfoHandler().ResolveCalledFunctionNames(
+                [this, moduleId](const ModuleID functionsModuleId, const std::vector<mdToken>& tokens)
+                {
+                    if (moduleId.has_value() && *moduleId != functionsModuleId)
+                    {
+                        return std::vector<std::optional<FunctionName>>(tokens.size());
+                    }
+
+                    return TryGetFunctionNames(TryGetModuleMetadata(functionsModuleId), tokens);
+                });
         }
 
-        static void __stdcall fn_functionLeave(
-            FunctionID funcId,
-            UINT_PTR clientData,
-            COR_PRF_FRAME_INFO func,
-            COR_PRF_FUNCTION_ARGUMENT_RANGE* retvalRange
-        )
+        // Gets the metadata of the module, opened when the module was
+        // loaded, or now if the module was loaded before the profiler.
+        // Throws _com_error in case of an error.
+        // @param moduleId : the module to get the metadata of.
+        std::shared_ptr<const MetaDataImport> GetModuleMetadata(const ModuleID moduleId)
         {
-            if (!g_cb) return;
+            return m_moduleMetadata.Get(
+                moduleId,
+                [this](const ModuleID id)
+                {
+                    return m_corProfilerInfo->GetModuleMetadata(id, TLogger(m_pImplClient));
+                });
+        }
 
-            if (std::optional<FunctionInfo> functionInfo = g_cb->GetInfoHandler().TryGetFunctionInfo(funcId);
-                functionInfo.has_value())
+        // Gets the metadata of the module, opened when the module was
+        // loaded, or now if the module was loaded before the profiler.
+        // Returns nullptr in case of an error, which is logged.
+        // @param moduleId : the module to get the metadata of.
+        std::shared_ptr<const MetaDataImport> TryGetModuleMetadata(const ModuleID moduleId)
+        {
+            try
             {
-                g_cb->GetClient().Log() << L"Leave function: " << functionInfo->fullName();
+                return GetModuleMetadata(moduleId);
             }
-            else
+            catch (const _com_error& exception)
             {
-                g_cb->GetClient().Log() << L"Leave function: " << funcId;
+                m_pImplClient.Log()
+                    << L"Cannot get the metadata of module "
+                    << moduleId
+                    << L", COM error: "
+                    << HexOutput(exception.Error())
+                    << " "
+                    << exception.ErrorMessage();
             }
+
+            return nullptr;
         }
 
-        static void __stdcall fn_functionTailcall(
-            FunctionID funcId,
-            UINT_PTR clientData,
-            COR_PRF_FRAME_INFO func
-        )
+        // Logs how many block coverage probes the given method has,
+        // compared to a probe in each basic block.
+        // @param key : the instrumented method.
+        void LogBlockCoverageProbes(const MethodKey key)
         {
-            if (!g_cb) return;
+            if (const std::optional<ProbesCount> count { m_coverage.CountProbes(key) }
+                ; count.has_value())
+            {
+                GetClient().Log()
+                    << L"Block coverage needs "
+                    << count->Probes
+                    << L" probes for "
+                    << count->Blocks
+                    << L" blocks";
+            }
+        }
+
+        // Checks whether the given module file name starts
+        // with one of the packages prefixes. Returns false
+        // if the prefixes have not been set.
+        // @param fileName : the file name of the module, without the directory.
+        bool MatchesPackagesPrefixes(const std::wstring& fileName) const
+        {
+            return m_packagesPrefixes.has_value()
+                && std::find_if(
+                    m_packagesPrefixes->cbegin(),
+                    m_packagesPrefixes->cend(),
+                    [&fileName](const std::wstring& prefix)
+                    {
+                        return StartsWithIgnoreCase(fileName, prefix);
+                    }) != m_packagesPrefixes->cend();
+        }
 
-            if (std::optional<FunctionInfo> functionInfo = g_cb->GetInfoHandler().TryGetFunctionInfo(funcId);
-                functionInfo.has_value())
+        // Gets the instrumentation rules applying to the given module,
+        // and calls the visitor with them. The rules are computed once
+        // for each module, the later calls take them from the cache.
+        // Throws _com_error in case of an error.
+        // TVisitor : callable accepting const ModuleRules&.
+        // @param moduleId : the module to get the rules of.
+        // @param visitor : is called with the rules found.
+        template <typename TVisitor>
+        auto VisitModuleRules(const ModuleID moduleId, TVisitor&& visitor)
+        {
             {
-                g_cb->GetClient().Log() << L"Tailcall at function: " << functionInfo->fullName();
+                std::shared_lock lock { m_rulesMutex };
+                if (const auto found { m_moduleRules.find(moduleId) }
+                    ; found != m_moduleRules.cend())
+                {
+                    return visitor(found->second);
+                }
             }
-            else
+
+            const std::filesystem::path modulePath { m_corProfilerInfo->GetModuleInfo(moduleId).name };
+            std::unique_lock lock { m_rulesMutex };
+            const auto [inserted, _] { m_moduleRules.try_emplace(
+                moduleId,
+                m_instrumentationRules.ForModule(modulePath.filename().native())) };
+
+            return visitor(inserted->second);
+        }
+
+        // Replaces the instrumentation rules with the ones
+        // made from the given packages prefixes.
+        // @param packagesPrefixes : the prefixes of the modules to instrument.
+        void SetInstrumentationRules(const std::vector<std::wstring>& packagesPrefixes)
+        {
+            std::vector<InstrumentationRule> rules { RulesFromPackagesPrefixes(packagesPrefixes) };
+            rules.push_back(s_injectionTargetRule);
+            InstrumentationRules compiled { std::move(rules) };
+
+            std::unique_lock lock { m_rulesMutex };
+            m_instrumentationRules = std::move(compiled);
+            m_moduleRules.clear();
+            m_classScopes.clear();
+        }
+
+        // Instruments the given method with block coverage probes, and
+        // with the counter of its calls for the statistics.
+        // The caller checks the method matches the instrumentation rules.
+        // The probes and the counter run only while a test session is
+        // active, and the method is not retired.
+        // The method is compiled as is, if the instrumentation fails.
+        // Throws _com_error in case of an error.
+        // @param functionId : the method being compiled.
+        // @param functionInfo : the method being compiled, with its name.
+        // @param functionBytes : the method body bytes.
+        // @param moduleMetaData : the metadata of the module of the method.
+        template <IMetadataImport TMetadataImport>
+        void InstrumentBlockCoverage(
+            const FunctionID functionId,
+            const FunctionInfo& functionInfo,
+            const std::vector<std::byte>& functionBytes,
+            const TMetadataImport& moduleMetaData)
+        {
+            const MethodKey key { functionInfo.moduleId, functionInfo.token };
+            std::optional<uintptr_t> callCounter {};
+            if (const std::optional<uint32_t> index { GetInfoHandler().MapFunctionInfo(functionId, functionInfo) }
+                ; index.has_value())
+            {
+                callCounter = GetInfoHandler().CallCountAddress(*index);
+            }
+
+            std::vector<std::byte> coveredBytes {};
+            try
+            {
+                coveredBytes = m_coverage.Instrument(
+                    key,
+                    functionBytes,
+                    [&moduleMetaData](const mdToken token)
+                    {
+                        return GetCallSignature(moduleMetaData, token);
+                    },
+                    callCounter);
+            }
+            catch (const std::exception& exception)
+            {
+                GetClient().Log() << L"Block coverage probes are not inserted: " << exception.what();
+                return;
+            }
+
+            LogBlockCoverageProbes(key);
+
+            if (coveredBytes != functionBytes)
             {
-                g_cb->GetClient().Log() << L"Tailcall at function: " << funcId;
+                m_corProfilerInfo->SetILFunctionBody(functionInfo, coveredBytes);
+                GetClient().Log() << L"Block coverage probes are inserted.";
             }
         }
 
-        static UINT_PTR __stdcall fn_FunctionIDMapper(
-            FunctionID funcId,
-            BOOL* pbHookFunction)
+        // Requests the ReJIT of the methods, all block
+        // coverage probes of which have been hit.
+        void RetireCoveredMethods()
         {
-            if (!g_cb) return funcId;
+            if (!m_corProfilerInfo.has_value())
+            {
+                return;
+            }
 
-            if (const std::optional<FunctionInfoWithoutName> functionInfoWithoutName{
-                    g_cb->GetCorProfilerInfo()->TryGetFunctionInfo(funcId) }
-                ; functionInfoWithoutName.has_value())
+            try
             {
-                if (const std::optional<FunctionInfo> functionInfo { TryGetFunctionInfo(
-                    g_cb->GetCorProfilerInfo()->TryGetModuleMetadata(functionInfoWithoutName->moduleId, LogToProClient(g_cb->m_pImplClient)),
-                    functionInfoWithoutName) }
-                    ; functionInfo.has_value())
+                if (const std::vector<MethodKey> retired { RetireFullyCoveredMethods(*m_corProfilerInfo, m_coverage) }
+                    ; !retired.empty())
                 {
-                    g_cb->GetClient().Log() << "Mapping   function[" << funcId << "] to " << functionInfo->fullName();
-                    g_cb->GetInfoHandler().MapFunctionInfo(funcId, functionInfo.value());
+                    GetClient().Log()
+                        << L"Requested ReJIT of "
+                        << retired.size()
+                        << L" fully covered methods";
                 }
             }
+            catch (const _com_error& exception)
+            {
+                m_pImplClient.Log()
+                    << L"COM error: "
+                    << HexOutput(exception.Error())
+                    << " "
+                    << exception.ErrorMessage();
+            }
+            catch (const std::exception& exception)
+            {
+                m_pImplClient.Log() << L"Std exception: " << exception.what();
+            }
+        }
+
+        // Starts or stops instrumenting the methods for a test session.
+        // @param change : the session started or stopped.
+        void OnSessionChange(const SessionChange& change)
+        {
+            if (!m_corProfilerInfo.has_value())
+            {
+                return;
+            }
 
-            if (pbHookFunction)
+            try
             {
-                *pbHookFunction = TRUE; // to receive FunctionEnter2, FunctionLeave2, and FunctionTailcall2 callbacks
+                const std::vector<MethodKey> methods { SwitchCoverageSession(
+                    *m_corProfilerInfo,
+                    m_coverage,
+                    change.isActive) };
+
+                GetClient().Log()
+                    << L"Session "
+                    << change.sessionId
+                    << (change.isActive ? L" started" : L" stopped")
+                    << L", requested ReJIT of "
+                    << methods.size()
+                    << L" methods";
+            }
+            catch (const _com_error& exception)
+            {
+                m_pImplClient.Log()
+                    << L"COM error: "
+                    << HexOutput(exception.Error())
+                    << " "
+                    << exception.ErrorMessage();
+            }
+            catch (const std::exception& exception)
+            {
+                m_pImplClient.Log() << L"Std exception: " << exception.what();
             }
-            return funcId;
+        }
+
+        // Gets the coverage of the instrumented methods to send to the
+        // admin when a test session stops. Returns nothing in case
+        // of an error, which is logged.
+        std::vector<ExecClassData> SessionCoverage()
+        {
+            if (!m_corProfilerInfo.has_value())
+            {
+                return {};
+            }
+
+            try
+            {
+                return MakeSessionCoverage(
+                    *m_corProfilerInfo,
+                    m_coverage,
+                    [this](const ModuleID moduleId)
+                    {
+                        return GetModuleMetadata(moduleId);
+                    });
+            }
+            catch (const _com_error& exception)
+            {
+                m_pImplClient.Log()
+                    << L"COM error: "
+                    << HexOutput(exception.Error())
+                    << " "
+                    << exception.ErrorMessage();
+            }
+            catch (const std::exception& exception)
+            {
+                m_pImplClient.Log() << L"Std exception: " << exception.what();
+            }
+
+            return {};
         }
 
     public:
@@ -293,13 +805,7 @@ namespace Drill4dotNet
                         if (file.path().extension() == L".dll"
                             && (
                                 !m_packagesPrefixes.has_value()
-                                || std::find_if(
-                                    m_packagesPrefixes->cbegin(),
-                                    m_packagesPrefixes->cend(),
-                                    [file](const std::wstring& prefix)
-                                    {
-                                        return StartsWithIgnoreCase(std::wstring{ file.path().filename() }, prefix);
-                                    }) != m_packagesPrefixes->cend()))
+                                || MatchesPackagesPrefixes(file.path().filename())))
                         {
                             std::wcout << L"File found: " << file.path() << std::endl;
 
@@ -363,6 +869,7 @@ namespace Drill4dotNet
                         }
                     }
 
+                    SetInstrumentationRules(packagesPrefixes);
                     if (packagesPrefixes.empty())
                     {
                         m_packagesPrefixes.reset();
@@ -373,18 +880,30 @@ namespace Drill4dotNet
                     }
                 } };
 
+                GetClient().GetConnector().SessionHandler() = std::function { [this](const SessionChange& change)
+                {
+                    OnSessionChange(change);
+                } };
+
+                GetClient().GetConnector().CoverageProvider() = std::function { [this]()
+                {
+                    return SessionCoverage();
+                } };
+
+                m_corProfilerInfo.emplace(pICorProfilerInfoUnk, TLogger(m_pImplClient));
+
+                // Started once the profiler info is set, as the threads use it.
                 m_adminInteractionThread.emplace([this]()
                 {
                     GetClient().GetConnector().InitializeAgent();
 
-                    while (true)
+                    while (!m_stopAdminInteraction)
                     {
                         std::this_thread::sleep_for(std::chrono::seconds(1));
+                        RetireCoveredMethods();
                     }
                 });
 
-                m_corProfilerInfo.emplace(pICorProfilerInfoUnk, TLogger(m_pImplClient));
-
                 InjectionMetaData injection;
                 MetaDataDispenser metaDataDispenser { TLogger(m_pImplClient) };
                 const std::filesystem::path pathInjection = Drill4dotNet::s_Drill4dotNetLibFilePath.parent_path() / L"Injection.dll";
@@ -466,15 +985,6 @@ namespace Drill4dotNet
                 }
 
                 m_corProfilerInfo->SetEventMask(EVENTS_WE_MONITOR);
-
-                // set the enter, leave and tailcall hooks
-                g_cb = this;
-                m_corProfilerInfo->SetEnterLeaveFunctionHooks(
-                    fn_functionEnter,
-                    fn_functionLeave,
-                    fn_functionTailcall
-                );
-                m_corProfilerInfo->SetFunctionIDMapper(fn_FunctionIDMapper);
             }
             catch (const _com_error& exception)
             {
@@ -494,14 +1004,17 @@ namespace Drill4dotNet
             m_pImplClient.Log() << L"CProfilerCallback::Shutdown";
             try
             {
-                g_cb = nullptr;
+                ResolveCalledFunctionNames(std::nullopt);
                 GetInfoHandler().OutputStatistics();
-                m_corProfilerInfo.reset();
+                m_stopAdminInteraction = true;
                 if (m_adminInteractionThread.has_value())
                 {
                     m_adminInteractionThread->join();
                     m_adminInteractionThread.reset();
                 }
+
+                m_moduleMetadata.Clear();
+                m_corProfilerInfo.reset();
             }
             catch (const _com_error& exception)
             {
@@ -652,6 +1165,15 @@ namespace Drill4dotNet
                     GetInfoHandler().MapModuleInfo(moduleId, info.value());
                     GetInfoHandler().OutputModuleInfo(moduleId);
                 }
+
+                // Opened once, and used by all later callbacks of the module.
+                // The modules not instrumented need no metadata; they are
+                // opened on demand, if the rules change.
+                if (VisitModuleRules(moduleId, [](const ModuleRules& rules) { return rules.GetScope(); })
+                    != ModuleRules::Scope::None)
+                {
+                    TryGetModuleMetadata(moduleId);
+                }
             }
             catch (const _com_error& exception)
             {
@@ -671,6 +1193,15 @@ namespace Drill4dotNet
             try
             {
                 GetInfoHandler().OutputModuleInfo(moduleId);
+
+                // The metadata of the module are not available after the unload.
+                ResolveCalledFunctionNames(moduleId);
+                m_moduleMetadata.Release(moduleId);
+                m_coverage.ForgetModule(moduleId);
+
+                std::unique_lock lock { m_rulesMutex };
+                m_moduleRules.erase(moduleId);
+                m_classScopes.erase(moduleId);
             }
             catch (const std::exception& exception)
             {
@@ -705,20 +1236,12 @@ namespace Drill4dotNet
             try
             {
                 // valid when the Finished event is called
+                // Only the tokens are kept, the name is not read.
                 if (const std::optional<ClassInfoWithoutName> classInfoWithoutName { m_corProfilerInfo->TryGetClassInfo(classId) }
                     ; classInfoWithoutName.has_value())
                 {
-
-                    if (const std::optional<ClassInfo> info { TryGetClassInfo(
-                            m_corProfilerInfo->TryGetModuleMetadata(
-                                classInfoWithoutName->moduleId,
-                                TLogger(m_pImplClient)),
-                            classInfoWithoutName) }
-                    ; info.has_value())
-                    {
-                        GetInfoHandler().MapClassInfo(classId, info.value());
-                        GetInfoHandler().OutputClassInfo(classId);
-                    }
+                    GetInfoHandler().MapClassInfo(classId, classInfoWithoutName.value());
+                    GetInfoHandler().OutputClassInfo(classId);
                 }
             }
             catch (const _com_error& exception)
@@ -763,23 +1286,29 @@ namespace Drill4dotNet
 
         virtual HRESULT __stdcall JITCompilationStarted(FunctionID functionId, BOOL fIsSafeToBlock) override
         {
-            GetClient().Log() << L"CProfilerCallback::JITCompilationStarted";
             try
             {
+                // Most methods are from the modules not to be instrumented.
+                // They are rejected by the rules cached for the module, before
+                // any name, signature, or body of the method is read.
+                const std::optional<FunctionInfo> instrumentedFunction { FindInstrumentedFunction(functionId) };
+                if (!instrumentedFunction.has_value())
+                {
+                    return S_OK;
+                }
+
+                const FunctionInfo& functionInfo { *instrumentedFunction };
+                GetClient().Log() << L"CProfilerCallback::JITCompilationStarted";
+
                 // This example injection will insert artificial calls to Console.WriteLine
                 // into the HelloWorld.Program.MyInjectionTarget function, at the place of
                 // the second Console.WriteLine call, and in the finally clause. Also some
                 // NOPs will be added to show ability to turn short branching instructions
                 // into long ones.
 
-                const FunctionInfoWithoutName functionInfoWithoutName {
-                    m_corProfilerInfo->GetFunctionInfo(functionId) };
-
-                const auto moduleMetaData { m_corProfilerInfo->GetModuleMetadata(
-                    functionInfoWithoutName.moduleId,
-                    LogToProClient(m_pImplClient)) };
-
-                const FunctionInfo functionInfo { GetFunctionInfo(moduleMetaData, functionInfoWithoutName) };
+                const std::shared_ptr<const MetaDataImport> cachedMetaData {
+                    GetModuleMetadata(functionInfo.moduleId) };
+                const MetaDataImport& moduleMetaData { *cachedMetaData };
 
                 const std::vector<std::byte> signatureBytes { moduleMetaData
                     .GetMethodProps(functionInfo.token)
@@ -808,10 +1337,14 @@ namespace Drill4dotNet
 
                 if (functionInfo.fullName() != L"HelloWorld.Program.MyInjectionTarget")
                 {
+                    InstrumentBlockCoverage(functionId, functionInfo, functionBytes, moduleMetaData);
                     return S_OK;
                 }
 
-                auto functionBody = MethodBody(functionBytes);
+                // Resets the per-thread memory of the method body after the
+                // body is destroyed, so it is declared before the body.
+                MethodArenaScope arena {};
+                MethodBody functionBody(functionBytes, arena.Resource());
 
                 GetClient().Log()
                     << L"Initially decompiled raw bytes:"
@@ -833,51 +1366,49 @@ namespace Drill4dotNet
                     return S_OK;
                 }
 
-                const auto findSecondCall = [this, &body{ std::as_const(functionBody) }]()
+                const auto secondCall = FindInstruction<OpCode::CEE_CALL>(
+                    FindNextInstruction(
+                        FindInstruction<OpCode::CEE_CALL>(
+                            functionBody.begin(),
+                            functionBody.end()),
+                        functionBody.end()),
+                    functionBody.end());
+                if (secondCall == functionBody.end())
                 {
-                    const auto result = FindInstruction<OpCode::CEE_CALL>(
-                        FindNextInstruction(
-                            FindInstruction<OpCode::CEE_CALL>(
-                                body.begin(),
-                                body.end()),
-                            body.end()),
-                        body.end());
-                    if (result == body.end())
-                    {
-                        throw std::logic_error("Error: position for injection was not found. "
-                            "Need to update the example or the injection.");
-                    }
+                    throw std::logic_error("Error: position for injection was not found. "
+                        "Need to update the example or the injection.");
+                }
 
-                    return result;
-                };
+                // All positions below refer to the instructions
+                // as they were before the edit started.
+                functionBody.BeginEdit();
 
                 functionBody.Insert(
-                    findSecondCall() + 1,
+                    secondCall + 1,
                     OpCode::CEE_LDLOC_0{});
 
                 functionBody.Insert(
-                    findSecondCall() + 2,
+                    secondCall + 1,
                     OpCode::CEE_LDC_I4_1{});
 
                 Label label = functionBody.CreateLabel();
 
                 functionBody.Insert(
-                    findSecondCall() + 3,
+                    secondCall + 1,
                     OpCode::CEE_BLT_S{ ShortJump { label } });
 
                 functionBody.Insert(
-                    findSecondCall() + 4,
+                    secondCall + 1,
                     OpCode::CEE_LDC_I4{ 42 });
 
-                const auto callPosition = findSecondCall();
                 functionBody.Insert(
-                    callPosition + 5,
-                    std::get<OpCodeVariant>(*callPosition));
+                    secondCall + 1,
+                    std::get<OpCodeVariant>(*secondCall));
 
                 for (int i = 0; i != 128; ++i)
                 {
                     functionBody.Insert(
-                        findSecondCall() + 6,
+                        secondCall + 1,
                         OpCode::CEE_NOP{});
                 }
 
@@ -940,19 +1471,35 @@ namespace Drill4dotNet
                     FindInstruction<OpCode::CEE_RET>(functionBody.begin(), functionBody.end()),
                     label);
 
-                const std::vector<std::byte> afterInjection = functionBody.Compile();
+                functionBody.CommitEdit();
+
+                const AbsoluteOffset savedBytes { functionBody.MinimizeSize() };
+                GetClient().Log()
+                    << L"Shortest instruction forms saved "
+                    << savedBytes
+                    << L" bytes";
+
+                const ControlFlowGraph graph { functionBody, arena.Resource() };
+                functionBody.SetMaxStack(ComputeMaxStack(
+                    functionBody,
+                    graph,
+                    [&moduleMetaData](const mdToken token)
+                    {
+                        return GetCallSignature(moduleMetaData, token);
+                    }));
+
+                GetClient().Log()
+                    << L"Max stack after injection: "
+                    << functionBody.MaxStack();
+
                 GetClient().Log()
                     << L"After injection: IL Body size "
-                    << afterInjection.size()
-                    << L", raw bytes:"
-                    << std::endl
-                    << afterInjection
-                    << std::endl
-                    << L"instructions:"
+                    << functionBody.ComputeCompiledSize()
+                    << L", instructions:"
                     << std::endl
                     << functionBody;
 
-                m_corProfilerInfo->SetILFunctionBody(functionInfo, afterInjection);
+                m_corProfilerInfo->SetILFunctionBody(functionInfo, functionBody);
                 GetClient().Log() << L"Injected successfully.";
 
                 return S_OK;
@@ -973,5 +1520,76 @@ namespace Drill4dotNet
             }
             return S_OK;
         }
+
+        // Inherited via ICorProfilerCallback4
+        virtual HRESULT __stdcall GetReJITParameters(
+            ModuleID moduleId,
+            mdMethodDef methodId,
+            ICorProfilerFunctionControl* pFunctionControl) override
+        {
+            m_pImplClient.Log()
+                << L"CProfilerCallback::GetReJITParameters("
+                << moduleId
+                << L", "
+                << HexOutput(methodId)
+                << L")";
+            try
+            {
+                // The metadata are needed only if the probes are made now.
+                std::shared_ptr<const MetaDataImport> moduleMetaData {};
+                const auto getCallSignature { [this, moduleId, &moduleMetaData](const mdToken token)
+                {
+                    if (moduleMetaData == nullptr)
+                    {
+                        moduleMetaData = GetModuleMetadata(moduleId);
+                    }
+
+                    return GetCallSignature(*moduleMetaData, token);
+                } };
+
+                // The runtime copies the body, so it
+                // can be released after the call.
+                if (const std::optional<std::vector<std::byte>> body { m_coverage.CurrentBody(
+                        MethodKey { moduleId, methodId },
+                        getCallSignature) }
+                    ; body.has_value())
+                {
+                    return pFunctionControl->SetILFunctionBody(
+                        static_cast<ULONG>(body->size()),
+                        reinterpret_cast<LPCBYTE>(body->data()));
+                }
+            }
+            catch (const _com_error& exception)
+            {
+                m_pImplClient.Log()
+                    << L"COM error: "
+                    << HexOutput(exception.Error())
+                    << " "
+                    << exception.ErrorMessage();
+            }
+            catch (const std::exception& exception)
+            {
+                m_pImplClient.Log() << L"Std exception: " << exception.what();
+            }
+            return S_OK;
+        }
+
+        virtual HRESULT __stdcall ReJITError(
+            ModuleID moduleId,
+            mdMethodDef methodId,
+            FunctionID functionId,
+            HRESULT hrStatus) override
+        {
+            m_pImplClient.Log()
+                << L"CProfilerCallback::ReJITError("
+                << moduleId
+                << L", "
+                << HexOutput(methodId)
+                << L", "
+                << functionId
+                << L"): "
+                << HexOutput(hrStatus);
+            return S_OK;
+        }
     };
 }
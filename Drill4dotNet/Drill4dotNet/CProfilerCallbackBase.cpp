@@ -11,9 +11,11 @@ namespace Drill4dotNet
     {
         if (riid == IID_IUnknown ||
             riid == IID_ICorProfilerCallback ||
-            riid == IID_ICorProfilerCallback2)
+            riid == IID_ICorProfilerCallback2 ||
+            riid == IID_ICorProfilerCallback3 ||
+            riid == IID_ICorProfilerCallback4)
         {
-            *ppvObject = (ICorProfilerCallback2*)this;
+            *ppvObject = (ICorProfilerCallback4*)this;
         }
         else
         {
@@ -430,4 +432,49 @@ namespace Drill4dotNet
     {
         return E_NOTIMPL;
     }
+
+    HRESULT __stdcall CProfilerCallbackBase::InitializeForAttach(IUnknown* pCorProfilerInfoUnk, void* pvClientData, UINT cbClientData)
+    {
+        return E_NOTIMPL;
+    }
+
+    HRESULT __stdcall CProfilerCallbackBase::ProfilerAttachComplete(void)
+    {
+        return E_NOTIMPL;
+    }
+
+    HRESULT __stdcall CProfilerCallbackBase::ProfilerDetachSucceeded(void)
+    {
+        return E_NOTIMPL;
+    }
+
+    HRESULT __stdcall CProfilerCallbackBase::ReJITCompilationStarted(FunctionID functionId, ReJITID rejitId, BOOL fIsSafeToBlock)
+    {
+        return E_NOTIMPL;
+    }
+
+    HRESULT __stdcall CProfilerCallbackBase::GetReJITParameters(ModuleID moduleId, mdMethodDef methodId, ICorProfilerFunctionControl* pFunctionControl)
+    {
+        return E_NOTIMPL;
+    }
+
+    HRESULT __stdcall CProfilerCallbackBase::ReJITCompilationFinished(FunctionID functionId, ReJITID rejitId, HRESULT hrStatus, BOOL fIsSafeToBlock)
+    {
+        return E_NOTIMPL;
+    }
+
+    HRESULT __stdcall CProfilerCallbackBase::ReJITError(ModuleID moduleId, mdMethodDef methodId, FunctionID functionId, HRESULT hrStatus)
+    {
+        return E_NOTIMPL;
+    }
+
+    HRESULT __stdcall CProfilerCallbackBase::MovedReferences2(ULONG cMovedObjectIDRanges, ObjectID oldObjectIDRangeStart[], ObjectID newObjectIDRangeStart[], SIZE_T cObjectIDRangeLength[])
+    {
+        return E_NOTIMPL;
+    }
+
+    HRESULT __stdcall CProfilerCallbackBase::SurvivingReferences2(ULONG cSurvivingObjectIDRanges, ObjectID objectIDRangeStart[], SIZE_T cObjectIDRangeLength[])
+    {
+        return E_NOTIMPL;
+    }
 }
@@ -4,7 +4,7 @@
 
 namespace Drill4dotNet
 {
-    class CProfilerCallbackBase : public ICorProfilerCallback2
+    class CProfilerCallbackBase : public ICorProfilerCallback4
     {
     private:
         volatile ULONG m_lRef = 0;
@@ -99,5 +99,18 @@ namespace Drill4dotNet
         virtual HRESULT __stdcall RootReferences2(ULONG cRootRefs, ObjectID rootRefIds[], COR_PRF_GC_ROOT_KIND rootKinds[], COR_PRF_GC_ROOT_FLAGS rootFlags[], UINT_PTR rootIds[]) override;
         virtual HRESULT __stdcall HandleCreated(GCHandleID handleId, ObjectID initialObjectId) override;
         virtual HRESULT __stdcall HandleDestroyed(GCHandleID handleId) override;
+
+        // Inherited via ICorProfilerCallback3
+        virtual HRESULT __stdcall InitializeForAttach(IUnknown* pCorProfilerInfoUnk, void* pvClientData, UINT cbClientData) override;
+        virtual HRESULT __stdcall ProfilerAttachComplete(void) override;
+        virtual HRESULT __stdcall ProfilerDetachSucceeded(void) override;
+
+        // Inherited via ICorProfilerCallback4
+        virtual HRESULT __stdcall ReJITCompilationStarted(FunctionID functionId, ReJITID rejitId, BOOL fIsSafeToBlock) override;
+        virtual HRESULT __stdcall GetReJITParameters(ModuleID moduleId, mdMethodDef methodId, ICorProfilerFunctionControl* pFunctionControl) override;
+        virtual HRESULT __stdcall ReJITCompilationFinished(FunctionID functionId, ReJITID rejitId, HRESULT hrStatus, BOOL fIsSafeToBlock) override;
+        virtual HRESULT __stdcall ReJITError(ModuleID moduleId, mdMethodDef methodId, FunctionID functionId, HRESULT hrStatus) override;
+        virtual HRESULT __stdcall MovedReferences2(ULONG cMovedObjectIDRanges, ObjectID oldObjectIDRangeStart[], ObjectID newObjectIDRangeStart[], SIZE_T cObjectIDRangeLength[]) override;
+        virtual HRESULT __stdcall SurvivingReferences2(ULONG cSurvivingObjectIDRanges, ObjectID objectIDRangeStart[], SIZE_T cObjectIDRangeLength[]) override;
     };
 }
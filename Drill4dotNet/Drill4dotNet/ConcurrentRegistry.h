@@ -0,0 +1,210 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace Drill4dotNet
+{
+    // Maps the keys to the values for many concurrent readers and rare
+    // writers, like the runtime ids of the functions to their data.
+    // The lookups take no lock, and end in a bounded number of steps,
+    // whatever the other threads do. The insertions are serialized by a
+    // mutex. Nothing is removed, and the entries are never moved or freed
+    // while the registry lives: a replaced value, or an outgrown table, is
+    // kept till the destruction, so a reader can use what it has found
+    // without synchronization. The runtime ids are mapped once, and the
+    // table doubles when it grows, so the tables kept take at most twice
+    // the memory of the current one.
+    // TKey : the key, compared with ==.
+    // TValue : the value, need not be copyable or movable.
+    // THash : the hash of the keys.
+    template <typename TKey, typename TValue, typename THash = std::hash<TKey>>
+    class ConcurrentRegistry
+    {
+    private:
+        // A key with its value.
+        struct Entry
+        {
+            const TKey Key;
+            TValue Value;
+        };
+
+        // An open addressing table with linear probing. It is filled
+        // at most by half, so each lookup ends at an empty slot soon.
+        struct Table
+        {
+            // The entries, or nullptr in the empty slots.
+            // The count of slots is a power of 2.
+            std::vector<std::atomic<Entry*>> Slots;
+
+            explicit Table(const size_t capacity)
+                : Slots(capacity)
+            {
+            }
+        };
+
+        // The count of slots of the first table.
+        inline static constexpr size_t InitialCapacity { 64 };
+
+        // Computes the hash of the keys.
+        THash m_hash {};
+
+        // The current table, read without the lock.
+        std::atomic<Table*> m_table { nullptr };
+
+        // Guards the members below.
+        mutable std::mutex m_mutex {};
+
+        // All tables, the current one is the last.
+        std::vector<std::unique_ptr<Table>> m_tables {};
+
+        // All entries, including the replaced ones.
+        std::vector<std::unique_ptr<Entry>> m_entries {};
+
+        // The count of keys.
+        size_t m_size { 0 };
+
+        // Gets the first slot to look for the key at. The hash is
+        // mixed, since the runtime ids are aligned pointers, which
+        // would otherwise gather in few slots.
+        // @param key : the key to look for.
+        // @param table : the table to look in.
+        size_t HomeSlot(const TKey& key, const Table& table) const noexcept
+        {
+            uint64_t hash { static_cast<uint64_t>(m_hash(key)) };
+            hash ^= hash >> 33;
+            hash *= 0xFF51AFD7ED558CCDull;
+            hash ^= hash >> 33;
+            return static_cast<size_t>(hash) & (table.Slots.size() - 1);
+        }
+
+        // Finds the slot having the key, or the empty slot the key would
+        // be put into. Returns the slot, and the entry read from it, or
+        // nullptr if the slot is empty. The readers use the entry read,
+        // as the slot may be filled by the writer right after the read.
+        // @param key : the key to look for.
+        // @param table : the table to look in.
+        std::pair<std::atomic<Entry*>*, Entry*> FindSlot(const TKey& key, Table& table) const noexcept
+        {
+            const size_t mask { table.Slots.size() - 1 };
+            for (size_t i { HomeSlot(key, table) }; ; i = (i + 1) & mask)
+            {
+                Entry* const entry { table.Slots[i].load(std::memory_order_acquire) };
+                if (entry == nullptr || entry->Key == key)
+                {
+                    return { &table.Slots[i], entry };
+                }
+            }
+        }
+
+        // Makes a table twice as large as the current one, with the same
+        // entries, and makes it current. m_mutex must be locked.
+        Table& Grow()
+        {
+            const Table& current { *m_tables.back() };
+            auto grown { std::make_unique<Table>(current.Slots.size() * 2) };
+            for (const std::atomic<Entry*>& slot : current.Slots)
+            {
+                if (Entry* const entry { slot.load(std::memory_order_relaxed) }
+                    ; entry != nullptr)
+                {
+                    FindSlot(entry->Key, *grown).first->store(entry, std::memory_order_relaxed);
+                }
+            }
+
+            m_tables.push_back(std::move(grown));
+            m_table.store(m_tables.back().get(), std::memory_order_release);
+            return *m_tables.back();
+        }
+
+    public:
+        // Creates an empty registry.
+        ConcurrentRegistry()
+        {
+            m_tables.push_back(std::make_unique<Table>(InitialCapacity));
+            m_table.store(m_tables.back().get(), std::memory_order_release);
+        }
+
+        ConcurrentRegistry(const ConcurrentRegistry&) = delete;
+        ConcurrentRegistry& operator=(const ConcurrentRegistry&) = delete;
+
+        // Maps the key to a new value, constructed from the given arguments.
+        // The value the key had before, if any, is kept in memory, but is
+        // not found anymore. Returns the new value, which stays at the same
+        // address while the registry lives.
+        // @param key : the key to map.
+        // @param arguments : the arguments of the constructor of the value.
+        template <typename... TArguments>
+        TValue& Emplace(const TKey& key, TArguments&&... arguments)
+        {
+            std::scoped_lock lock { m_mutex };
+            std::unique_ptr<Entry> entry { new Entry { key, TValue(std::forward<TArguments>(arguments)...) } };
+            m_entries.push_back(std::move(entry));
+            Entry& added { *m_entries.back() };
+
+            Table* table { m_tables.back().get() };
+            auto [slot, existing] { FindSlot(key, *table) };
+            if (existing == nullptr && (m_size + 1) * 2 > table->Slots.size())
+            {
+                table = &Grow();
+                slot = FindSlot(key, *table).first;
+            }
+
+            if (existing == nullptr)
+            {
+                ++m_size;
+            }
+
+            slot->store(&added, std::memory_order_release);
+            return added.Value;
+        }
+
+        // Gets the value of the key, or nullptr if the key is
+        // not mapped. Takes no lock, and does not allocate memory.
+        // @param key : the key to look for.
+        TValue* Find(const TKey& key) noexcept
+        {
+            Entry* const entry { FindSlot(key, *m_table.load(std::memory_order_acquire)).second };
+            return entry != nullptr ? &entry->Value : nullptr;
+        }
+
+        // Gets the value of the key, or nullptr if the key is
+        // not mapped. Takes no lock, and does not allocate memory.
+        // @param key : the key to look for.
+        const TValue* Find(const TKey& key) const noexcept
+        {
+            const Entry* const entry { FindSlot(key, *m_table.load(std::memory_order_acquire)).second };
+            return entry != nullptr ? &entry->Value : nullptr;
+        }
+
+        // Calls the visitor with each key and its value. Takes no lock;
+        // the keys mapped during the call may be visited, or not.
+        // TVisitor : callable accepting const TKey& and const TValue&.
+        // @param visitor : is called with the keys and values.
+        template <typename TVisitor>
+        void ForEach(TVisitor&& visitor) const
+        {
+            const Table& table { *m_table.load(std::memory_order_acquire) };
+            for (const std::atomic<Entry*>& slot : table.Slots)
+            {
+                if (const Entry* const entry { slot.load(std::memory_order_acquire) }
+                    ; entry != nullptr)
+                {
+                    visitor(entry->Key, entry->Value);
+                }
+            }
+        }
+
+        // Gets the count of the keys mapped.
+        size_t Size() const
+        {
+            std::scoped_lock lock { m_mutex };
+            return m_size;
+        }
+    };
+}
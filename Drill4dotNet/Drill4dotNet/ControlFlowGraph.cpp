@@ -0,0 +1,592 @@
+#include "pch.h"
+#include "ControlFlowGraph.h"
+
+#include <algorithm>
+
+namespace Drill4dotNet
+{
+    // A control transfer found while building ControlFlowGraph,
+    // before the transfers are grouped by their sources and targets.
+    struct ControlTransfer
+    {
+        // The block the control is transferred from.
+        BlockIndex Source;
+
+        // The block the control is transferred to.
+        BlockIndex Target;
+
+        // How the control is transferred.
+        EdgeKind Kind;
+    };
+
+    // Calls the given callback with each jump target of the instruction
+    // at the given position. Returns how the instruction affects control
+    // flow. Reads the arrays of the stream, so the instruction is not
+    // made, and the jump table of a switch is not copied.
+    // TCallback : callable accepting Label and EdgeKind.
+    // @param instruction : the position of the instruction to inspect.
+    // @param callback : the callback to call.
+    template <typename TCallback>
+    static OpCodeFlowBehavior VisitJumpTargets(const ConstStreamPosition instruction, TCallback&& callback)
+    {
+        const OpCodeInfo& info { instruction.Info() };
+        switch (info.ArgumentKind)
+        {
+        case OpCodeArgumentKind::InlineSwitch:
+            for (const LongJump jump : instruction.Argument<OpCodeArgumentType::InlineSwitch>())
+            {
+                callback(jump.Label(), EdgeKind::Switch);
+            }
+
+            break;
+        case OpCodeArgumentKind::InlineBrTarget:
+            callback(instruction.Argument<OpCodeArgumentType::InlineBrTarget>().Label(), EdgeKind::Branch);
+            break;
+        case OpCodeArgumentKind::ShortInlineBrTarget:
+            callback(instruction.Argument<OpCodeArgumentType::ShortInlineBrTarget>().Label(), EdgeKind::Branch);
+            break;
+        default:
+            break;
+        }
+
+        // opcode.def describes jmp as a call, but
+        // it never returns to the current method.
+        return instruction.Holds<OpCode::CEE_JMP>()
+            ? OpCodeFlowBehavior::Return
+            : info.FlowBehavior;
+    }
+
+    // Gets the value indicating whether an instruction
+    // with the given behavior ends a basic block.
+    // @param flow : how the instruction affects control flow.
+    static constexpr bool EndsBlock(const OpCodeFlowBehavior flow) noexcept
+    {
+        switch (flow)
+        {
+        case OpCodeFlowBehavior::Branch:
+        case OpCodeFlowBehavior::ConditionalBranch:
+        case OpCodeFlowBehavior::Return:
+        case OpCodeFlowBehavior::Throw:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    // Gets the value indicating whether an instruction with the given
+    // behavior may continue to the instruction following it.
+    // @param flow : how the instruction affects control flow.
+    static constexpr bool FallsThrough(const OpCodeFlowBehavior flow) noexcept
+    {
+        switch (flow)
+        {
+        case OpCodeFlowBehavior::Branch:
+        case OpCodeFlowBehavior::Return:
+        case OpCodeFlowBehavior::Throw:
+            return false;
+        default:
+            return true;
+        }
+    }
+
+    // Calls the given callback with each label,
+    // which marks a boundary of the given clause.
+    // TCallback : callable accepting Label.
+    // @param clause : the exception handling clause.
+    // @param callback : the callback to call.
+    template <typename TCallback>
+    static void VisitClauseBoundaries(const ExceptionClause& clause, TCallback&& callback)
+    {
+        callback(clause.TryOffset());
+        callback(clause.TryEndOffset());
+        callback(clause.HandlerOffset());
+        callback(clause.HandlerEndOffset());
+        const std::variant<mdTypeDef, Label> handler { clause.Handler() };
+        if (const Label* filter = std::get_if<Label>(&handler)
+            ; filter != nullptr)
+        {
+            callback(*filter);
+        }
+    }
+
+    // Groups the given transfers by one of their ends into compressed
+    // adjacency lists. Keeps the order of transfers with the same end.
+    // Takes the time linear in the count of blocks and transfers.
+    // @param transfers : the transfers to group.
+    // @param blocksCount : the count of blocks.
+    // @param groupBy : the end of transfers to group by.
+    // @param otherEnd : the end of transfers to store in the edges.
+    // @param offsets : receives the index of the first edge of each block,
+    //     followed by the total count of edges.
+    // @param edges : receives the edges.
+    static void GroupTransfers(
+        const std::pmr::vector<ControlTransfer>& transfers,
+        const size_t blocksCount,
+        BlockIndex ControlTransfer::* const groupBy,
+        BlockIndex ControlTransfer::* const otherEnd,
+        std::pmr::vector<uint32_t>& offsets,
+        std::pmr::vector<ControlFlowEdge>& edges)
+    {
+        offsets.assign(blocksCount + 1, 0);
+        for (const ControlTransfer& transfer : transfers)
+        {
+            ++offsets[transfer.*groupBy + 1];
+        }
+
+        for (size_t i = 1; i != offsets.size(); ++i)
+        {
+            offsets[i] += offsets[i - 1];
+        }
+
+        edges.resize(transfers.size());
+        std::pmr::vector<uint32_t> positions(offsets.cbegin(), offsets.cend() - 1, offsets.get_allocator());
+        for (const ControlTransfer& transfer : transfers)
+        {
+            edges[positions[transfer.*groupBy]++] = ControlFlowEdge { transfer.*otherEnd, transfer.Kind };
+        }
+    }
+
+    DominatorTree::DominatorTree(std::pmr::memory_resource* const resource)
+        : m_parents(resource),
+        m_childOffsets(1, 0, resource),
+        m_children(resource),
+        m_enter(resource),
+        m_exit(resource)
+    {
+    }
+
+    DominatorTree::DominatorTree(
+        std::span<const BlockIndex> immediateDominators,
+        const size_t blocksCount,
+        std::pmr::memory_resource* const resource)
+        : m_parents(blocksCount, NoBlock, resource),
+        m_childOffsets(blocksCount + 1, 0, resource),
+        m_children(resource),
+        m_enter(blocksCount, NoBlock, resource),
+        m_exit(blocksCount, NoBlock, resource)
+    {
+        for (BlockIndex block = 0; block != blocksCount; ++block)
+        {
+            const BlockIndex parent { immediateDominators[block] };
+            if (parent != NoBlock && parent != block && parent < blocksCount)
+            {
+                m_parents[block] = parent;
+                ++m_childOffsets[parent + 1];
+            }
+        }
+
+        for (size_t i = 1; i != m_childOffsets.size(); ++i)
+        {
+            m_childOffsets[i] += m_childOffsets[i - 1];
+        }
+
+        m_children.resize(m_childOffsets.back());
+        std::pmr::vector<BlockIndex> positions(m_childOffsets.cbegin(), m_childOffsets.cend() - 1, resource);
+        for (BlockIndex block = 0; block != blocksCount; ++block)
+        {
+            if (m_parents[block] != NoBlock)
+            {
+                m_children[positions[m_parents[block]]++] = block;
+            }
+        }
+
+        // Numbers the blocks in preorder, so the subtree of
+        // a block gets the numbers m_enter[block] ... m_exit[block].
+        BlockIndex counter { 0 };
+        std::pmr::vector<std::pair<BlockIndex, BlockIndex>> stack(resource);
+        for (BlockIndex root = 0; root != blocksCount; ++root)
+        {
+            if (m_parents[root] != NoBlock || immediateDominators[root] == NoBlock)
+            {
+                continue;
+            }
+
+            m_enter[root] = counter++;
+            stack.emplace_back(root, m_childOffsets[root]);
+            while (!stack.empty())
+            {
+                auto& [block, nextChild] { stack.back() };
+                if (nextChild == m_childOffsets[block + 1])
+                {
+                    m_exit[block] = counter - 1;
+                    stack.pop_back();
+                    continue;
+                }
+
+                const BlockIndex child { m_children[nextChild++] };
+                m_enter[child] = counter++;
+                stack.emplace_back(child, m_childOffsets[child]);
+            }
+        }
+    }
+
+    ControlFlowGraph::ControlFlowGraph(
+        const MethodBody& method,
+        std::pmr::memory_resource* const resource)
+        : m_blocks(resource),
+        m_labelBlocks(resource),
+        m_successorOffsets(resource),
+        m_successors(resource),
+        m_predecessorOffsets(resource),
+        m_predecessors(resource),
+        m_dominators(resource),
+        m_postDominators(resource)
+    {
+        BuildBlocks(method.Stream(), method.ExceptionSections());
+        BuildEdges(method.Stream(), method.ExceptionSections());
+        m_dominators = DominatorTree(ComputeImmediateDominators(false), m_blocks.size(), resource);
+        m_postDominators = DominatorTree(ComputeImmediateDominators(true), m_blocks.size(), resource);
+    }
+
+    BlockIndex ControlFlowGraph::LabelBlock(const Label label) const
+    {
+        if (label.GetId() >= m_labelBlocks.size() || m_labelBlocks[label.GetId()] == NoBlock)
+        {
+            throw std::logic_error("Control flow graph: unresolved label.");
+        }
+
+        return m_labelBlocks[label.GetId()];
+    }
+
+    BlockIndex ControlFlowGraph::TargetBlock(const Label label) const
+    {
+        const BlockIndex result { LabelBlock(label) };
+        if (result == m_blocks.size())
+        {
+            throw std::runtime_error("Control flow graph: the control is transferred past the end of the code.");
+        }
+
+        return result;
+    }
+
+    void ControlFlowGraph::BuildBlocks(
+        const InstructionStream& stream,
+        const std::pmr::vector<ExceptionsSection>& sections)
+    {
+        // For each label id, indicates whether the label is a jump target
+        // or a boundary of a try block or a handler, so it starts a block.
+        std::pmr::vector<bool> leaders(m_blocks.get_allocator());
+        const auto markLeader = [&leaders](const Label label, const auto ...)
+        {
+            if (label.GetId() >= leaders.size())
+            {
+                leaders.resize(label.GetId() + 1, false);
+            }
+
+            leaders[label.GetId()] = true;
+        };
+
+        for (ConstStreamPosition current { stream.cbegin() }; current != stream.cend(); ++current)
+        {
+            if (!current.IsLabel())
+            {
+                VisitJumpTargets(current, markLeader);
+            }
+        }
+
+        for (const ExceptionsSection& section : sections)
+        {
+            for (const ExceptionClause& clause : section.Clauses())
+            {
+                VisitClauseBoundaries(clause, markLeader);
+            }
+        }
+
+        // Indicates whether the last block of m_blocks
+        // can get more elements, and whether it has instructions.
+        bool isBlockOpen { false };
+        bool hasInstructions { false };
+        uint32_t i { 0 };
+        for (ConstStreamPosition current { stream.cbegin() }; current != stream.cend(); ++current, ++i)
+        {
+            if (current.IsLabel())
+            {
+                const Label label { current.GetLabel() };
+                const bool isLeader { label.GetId() < leaders.size() && leaders[label.GetId()] };
+                if (isBlockOpen && hasInstructions && isLeader)
+                {
+                    m_blocks.back().End = i;
+                    isBlockOpen = false;
+                }
+
+                if (!isBlockOpen)
+                {
+                    m_blocks.push_back(BasicBlock { i, i, i });
+                    isBlockOpen = true;
+                    hasInstructions = false;
+                }
+
+                if (label.GetId() >= m_labelBlocks.size())
+                {
+                    m_labelBlocks.resize(label.GetId() + 1, NoBlock);
+                }
+
+                m_labelBlocks[label.GetId()] = static_cast<BlockIndex>(m_blocks.size() - 1);
+                continue;
+            }
+
+            if (!isBlockOpen)
+            {
+                m_blocks.push_back(BasicBlock { i, i, i });
+                isBlockOpen = true;
+            }
+
+            m_blocks.back().Last = i;
+            hasInstructions = true;
+            const OpCodeFlowBehavior flow { VisitJumpTargets(current, [](const auto ...) {}) };
+            if (EndsBlock(flow))
+            {
+                m_blocks.back().End = i + 1;
+                isBlockOpen = false;
+            }
+        }
+
+        if (isBlockOpen)
+        {
+            if (hasInstructions)
+            {
+                m_blocks.back().End = static_cast<uint32_t>(stream.size());
+            }
+            else
+            {
+                // Only labels follow the last instruction. They keep
+                // the index of the removed block, m_blocks.size().
+                m_blocks.pop_back();
+            }
+        }
+    }
+
+    void ControlFlowGraph::BuildEdges(
+        const InstructionStream& stream,
+        const std::pmr::vector<ExceptionsSection>& sections)
+    {
+        std::pmr::vector<ControlTransfer> transfers(m_blocks.get_allocator());
+        transfers.reserve(m_blocks.size() * 2);
+        for (BlockIndex block = 0; block != m_blocks.size(); ++block)
+        {
+            const OpCodeFlowBehavior flow { VisitJumpTargets(
+                stream.cbegin() + m_blocks[block].Last,
+                [this, block, &transfers](const Label target, const EdgeKind kind)
+                {
+                    transfers.push_back(ControlTransfer { block, TargetBlock(target), kind });
+                }) };
+
+            if (FallsThrough(flow))
+            {
+                if (block + 1 == m_blocks.size())
+                {
+                    throw std::runtime_error("Control flow graph: the control is transferred past the end of the code.");
+                }
+
+                transfers.push_back(ControlTransfer { block, block + 1, EdgeKind::FallThrough });
+            }
+        }
+
+        // Any instruction of a try block may throw, so each
+        // block of the try block leads to the handler, and to the
+        // filter, if any. Boundaries of try blocks start blocks,
+        // so the try block is exactly a range of blocks.
+        for (const ExceptionsSection& section : sections)
+        {
+            for (const ExceptionClause& clause : section.Clauses())
+            {
+                const BlockIndex tryBegin { TargetBlock(clause.TryOffset()) };
+                const BlockIndex tryEnd { LabelBlock(clause.TryEndOffset()) };
+                const BlockIndex handler { TargetBlock(clause.HandlerOffset()) };
+                const std::variant<mdTypeDef, Label> handlerOrFilter { clause.Handler() };
+                const Label* const filterLabel { std::get_if<Label>(&handlerOrFilter) };
+                const BlockIndex filter { filterLabel != nullptr ? TargetBlock(*filterLabel) : NoBlock };
+                for (BlockIndex block = tryBegin; block < tryEnd; ++block)
+                {
+                    if (filter != NoBlock)
+                    {
+                        transfers.push_back(ControlTransfer { block, filter, EdgeKind::Exception });
+                    }
+
+                    transfers.push_back(ControlTransfer { block, handler, EdgeKind::Exception });
+                }
+            }
+        }
+
+        GroupTransfers(
+            transfers,
+            m_blocks.size(),
+            &ControlTransfer::Source,
+            &ControlTransfer::Target,
+            m_successorOffsets,
+            m_successors);
+
+        GroupTransfers(
+            transfers,
+            m_blocks.size(),
+            &ControlTransfer::Target,
+            &ControlTransfer::Source,
+            m_predecessorOffsets,
+            m_predecessors);
+    }
+
+    std::pmr::vector<BlockIndex> ControlFlowGraph::ComputeImmediateDominators(const bool postDominators) const
+    {
+        // Uses the iterative algorithm from K. D. Cooper, T. J. Harvey,
+        // K. Kennedy, "A Simple, Fast Dominance Algorithm". On graphs
+        // of structured code, it converges after two passes over the
+        // blocks in reverse postorder, so takes almost linear time.
+        const auto allocator { m_blocks.get_allocator() };
+        const size_t blocksCount { m_blocks.size() };
+        const size_t nodesCount { postDominators ? blocksCount + 1 : blocksCount };
+        std::pmr::vector<BlockIndex> result(nodesCount, NoBlock, allocator);
+        if (blocksCount == 0)
+        {
+            return result;
+        }
+
+        // For post-dominators, the edges are reversed, and
+        // the virtual root node leads to every exit.
+        const BlockIndex root { static_cast<BlockIndex>(postDominators ? blocksCount : 0) };
+        std::pmr::vector<ControlFlowEdge> exitEdges(allocator);
+        if (postDominators)
+        {
+            for (BlockIndex block = 0; block != blocksCount; ++block)
+            {
+                if (Successors(block).empty())
+                {
+                    exitEdges.push_back(ControlFlowEdge { block, EdgeKind::FallThrough });
+                }
+            }
+        }
+
+        const auto forward = [this, postDominators, root, &exitEdges](const BlockIndex node)
+        {
+            if (!postDominators)
+            {
+                return Successors(node);
+            }
+
+            return node == root
+                ? std::span<const ControlFlowEdge>(exitEdges)
+                : Predecessors(node);
+        };
+
+        // Numbers the nodes reachable from the root in postorder.
+        std::pmr::vector<BlockIndex> postorder(allocator);
+        std::pmr::vector<BlockIndex> postorderNumbers(nodesCount, NoBlock, allocator);
+        std::pmr::vector<bool> visited(nodesCount, false, allocator);
+        std::pmr::vector<std::pair<BlockIndex, uint32_t>> stack(allocator);
+        visited[root] = true;
+        stack.emplace_back(root, 0);
+        while (!stack.empty())
+        {
+            auto& [node, nextEdge] { stack.back() };
+            const std::span<const ControlFlowEdge> edges { forward(node) };
+            if (nextEdge == edges.size())
+            {
+                postorderNumbers[node] = static_cast<BlockIndex>(postorder.size());
+                postorder.push_back(node);
+                stack.pop_back();
+                continue;
+            }
+
+            const BlockIndex next { edges[nextEdge++].Block };
+            if (!visited[next])
+            {
+                visited[next] = true;
+                stack.emplace_back(next, 0);
+            }
+        }
+
+        const auto intersect = [&result, &postorderNumbers](BlockIndex left, BlockIndex right)
+        {
+            while (left != right)
+            {
+                while (postorderNumbers[left] < postorderNumbers[right])
+                {
+                    left = result[left];
+                }
+
+                while (postorderNumbers[right] < postorderNumbers[left])
+                {
+                    right = result[right];
+                }
+            }
+
+            return left;
+        };
+
+        result[root] = root;
+        bool changed { true };
+        while (changed)
+        {
+            changed = false;
+            for (auto node = postorder.crbegin(); node != postorder.crend(); ++node)
+            {
+                if (*node == root)
+                {
+                    continue;
+                }
+
+                BlockIndex newDominator { NoBlock };
+                const auto meet = [&newDominator, &result, &intersect](const BlockIndex predecessor)
+                {
+                    if (result[predecessor] != NoBlock)
+                    {
+                        newDominator = newDominator == NoBlock
+                            ? predecessor
+                            : intersect(predecessor, newDominator);
+                    }
+                };
+
+                // The predecessors in the graph being walked: for
+                // post-dominators, the successors and the virtual root.
+                const std::span<const ControlFlowEdge> backward { postDominators
+                    ? Successors(*node)
+                    : Predecessors(*node) };
+                for (const ControlFlowEdge& edge : backward)
+                {
+                    meet(edge.Block);
+                }
+
+                if (postDominators && backward.empty())
+                {
+                    meet(root);
+                }
+
+                if (result[*node] != newDominator)
+                {
+                    result[*node] = newDominator;
+                    changed = true;
+                }
+            }
+        }
+
+        return result;
+    }
+
+    BlockIndex ControlFlowGraph::BlockOf(const size_t elementIndex) const noexcept
+    {
+        const auto next { std::upper_bound(
+            m_blocks.cbegin(),
+            m_blocks.cend(),
+            elementIndex,
+            [](const size_t index, const BasicBlock& block)
+            {
+                return index < block.Begin;
+            }) };
+
+        if (next == m_blocks.cbegin() || elementIndex >= std::prev(next)->End)
+        {
+            return NoBlock;
+        }
+
+        return static_cast<BlockIndex>(std::prev(next) - m_blocks.cbegin());
+    }
+
+    BlockIndex ControlFlowGraph::BlockOf(const Label label) const noexcept
+    {
+        if (label.GetId() >= m_labelBlocks.size() || m_labelBlocks[label.GetId()] == m_blocks.size())
+        {
+            return NoBlock;
+        }
+
+        return m_labelBlocks[label.GetId()];
+    }
+}
@@ -0,0 +1,288 @@
+#pragma once
+
+#include "MethodBody.h"
+
+#include <limits>
+#include <memory_resource>
+#include <span>
+
+namespace Drill4dotNet
+{
+    // Index of a basic block in ControlFlowGraph.
+    using BlockIndex = uint32_t;
+
+    // Marks the absence of a basic block.
+    inline constexpr BlockIndex NoBlock { std::numeric_limits<BlockIndex>::max() };
+
+    // How the control is transferred along an edge of ControlFlowGraph.
+    enum class EdgeKind : uint8_t
+    {
+        // The last instruction of the source block
+        // continues to the first instruction of the next block.
+        FallThrough,
+
+        // The last instruction of the source block is a branching
+        // instruction, and the target block is its jump target.
+        Branch,
+
+        // The last instruction of the source block is a switch,
+        // and the target block is one of its jump targets.
+        Switch,
+
+        // The source block is protected by a try block, and
+        // the target block is the beginning of its handler or filter.
+        Exception
+    };
+
+    // An edge of ControlFlowGraph.
+    struct ControlFlowEdge
+    {
+        // The block on the other end of the edge: the target
+        // block for successors, the source block for predecessors.
+        BlockIndex Block;
+
+        // How the control is transferred.
+        EdgeKind Kind;
+    };
+
+    // A sequence of instructions, which are always executed one
+    // after another: only the first instruction is a jump target
+    // or a beginning of a try block or of a handler, and only
+    // the last instruction transfers the control elsewhere.
+    struct BasicBlock
+    {
+        // The index of the first element of the block in the
+        // instructions stream. Can be a label.
+        uint32_t Begin;
+
+        // The index of the last instruction of the block in the instructions stream.
+        uint32_t Last;
+
+        // The index of the element following the block in the instructions stream.
+        uint32_t End;
+    };
+
+    // Dominator or post-dominator tree of the blocks of ControlFlowGraph.
+    // Block A dominates block B if every path from the entry to B goes
+    // through A. Block A post-dominates block B if every path from B to
+    // an exit goes through A. Blocks not reachable from the entry (or,
+    // for post-dominators, not reaching any exit) are not in the tree.
+    // Every block dominates itself.
+    class DominatorTree
+    {
+    private:
+        // For each block, its immediate dominator, or NoBlock
+        // for the roots of the tree and for the unreachable blocks.
+        std::pmr::vector<BlockIndex> m_parents;
+
+        // For each block, the index of its first child in m_children.
+        // Has one more element, so that the children of block i are
+        // m_children[m_childOffsets[i], m_childOffsets[i + 1]).
+        std::pmr::vector<BlockIndex> m_childOffsets;
+
+        // The children of all blocks, grouped by parent.
+        std::pmr::vector<BlockIndex> m_children;
+
+        // For each block, its number in the preorder walk of the tree,
+        // or NoBlock if the block is unreachable.
+        std::pmr::vector<BlockIndex> m_enter;
+
+        // For each block, the largest preorder number in its subtree.
+        std::pmr::vector<BlockIndex> m_exit;
+
+    public:
+        // Creates an empty tree.
+        // @param resource : the memory resource, must outlive the tree.
+        explicit DominatorTree(std::pmr::memory_resource* const resource);
+
+        // Creates the tree from the given immediate dominators.
+        // @param immediateDominators : for each node, its immediate dominator.
+        //     The root refers to itself, unreachable nodes have NoBlock.
+        //     Nodes with indices blocksCount and higher are virtual: they
+        //     are dropped, and the blocks they dominate become roots.
+        // @param blocksCount : the count of real blocks.
+        // @param resource : the memory resource, must outlive the tree.
+        DominatorTree(
+            std::span<const BlockIndex> immediateDominators,
+            const size_t blocksCount,
+            std::pmr::memory_resource* const resource);
+
+        // Gets the immediate dominator of the given block,
+        // NoBlock for a root or an unreachable block.
+        // @param block : the index of the block.
+        BlockIndex Parent(const BlockIndex block) const noexcept
+        {
+            return m_parents[block];
+        }
+
+        // Gets the blocks immediately dominated by the given block.
+        // @param block : the index of the block.
+        std::span<const BlockIndex> Children(const BlockIndex block) const noexcept
+        {
+            return std::span<const BlockIndex>(m_children)
+                .subspan(m_childOffsets[block], m_childOffsets[block + 1] - m_childOffsets[block]);
+        }
+
+        // Gets the value indicating whether the given block is in the tree.
+        // @param block : the index of the block.
+        bool Contains(const BlockIndex block) const noexcept
+        {
+            return m_enter[block] != NoBlock;
+        }
+
+        // Gets the value indicating whether the first block
+        // dominates the second one. Takes constant time.
+        // @param dominator : the index of the possibly dominating block.
+        // @param block : the index of the possibly dominated block.
+        bool Dominates(const BlockIndex dominator, const BlockIndex block) const noexcept
+        {
+            return Contains(dominator)
+                && Contains(block)
+                && m_enter[dominator] <= m_enter[block]
+                && m_enter[block] <= m_exit[dominator];
+        }
+    };
+
+    // Basic blocks of a method and the control transfers between them.
+    // Blocks are numbered in the order of the instructions, the entry
+    // block has index 0. Instructions returning from the method or
+    // throwing an exception end blocks without successors, the exits.
+    // The graph refers to the instructions by their indices in the
+    // stream, so it becomes outdated after the method is edited.
+    // Reference: ECMA-335, Common Language Infrastructure,
+    // part I.12.4.2 Exception handling
+    // https://www.ecma-international.org/publications/files/ECMA-ST/ECMA-335.pdf
+    class ControlFlowGraph
+    {
+    private:
+        // The blocks, in the order of the instructions.
+        std::pmr::vector<BasicBlock> m_blocks;
+
+        // For each label id, the index of the block the label belongs to,
+        // m_blocks.size() if the label follows the last instruction,
+        // or NoBlock if the label is not in the stream.
+        std::pmr::vector<BlockIndex> m_labelBlocks;
+
+        // For each block, the index of its first outgoing edge in m_successors.
+        // Has one more element, so that the outgoing edges of block i are
+        // m_successors[m_successorOffsets[i], m_successorOffsets[i + 1]).
+        std::pmr::vector<uint32_t> m_successorOffsets;
+
+        // The outgoing edges of all blocks, grouped by source.
+        std::pmr::vector<ControlFlowEdge> m_successors;
+
+        // For each block, the index of its first incoming edge in
+        // m_predecessors, organized like m_successorOffsets.
+        std::pmr::vector<uint32_t> m_predecessorOffsets;
+
+        // The incoming edges of all blocks, grouped by target.
+        std::pmr::vector<ControlFlowEdge> m_predecessors;
+
+        // The dominator tree, rooted at the entry block.
+        DominatorTree m_dominators;
+
+        // The post-dominator tree, each exit is a root.
+        DominatorTree m_postDominators;
+
+        // Gets the block of the given label, m_blocks.size()
+        // if the label follows the last instruction.
+        // Throws std::logic_error if the label is not in the stream.
+        // @param label : the label to look for.
+        BlockIndex LabelBlock(const Label label) const;
+
+        // Gets the block of the given label.
+        // Throws std::logic_error if the label is not in the stream.
+        // Throws std::runtime_error if the label follows the last instruction.
+        // @param label : the label to look for.
+        BlockIndex TargetBlock(const Label label) const;
+
+        // Splits the instructions of the given stream to blocks.
+        // Fills m_blocks and m_labelBlocks.
+        // @param stream : the instructions and labels.
+        // @param sections : the exception handling clauses.
+        void BuildBlocks(
+            const InstructionStream& stream,
+            const std::pmr::vector<ExceptionsSection>& sections);
+
+        // Finds the edges between the blocks. Fills
+        // m_successors, m_predecessors and their offsets.
+        // @param stream : the instructions and labels.
+        // @param sections : the exception handling clauses.
+        void BuildEdges(
+            const InstructionStream& stream,
+            const std::pmr::vector<ExceptionsSection>& sections);
+
+        // Computes the immediate dominators of the blocks.
+        // @param postDominators : true to compute the post-dominators,
+        //     on the reversed graph with a virtual node following all exits.
+        std::pmr::vector<BlockIndex> ComputeImmediateDominators(const bool postDominators) const;
+
+    public:
+        // Builds the graph of the given method in the time
+        // linear in the size of the method and the count of edges.
+        // Throws std::logic_error if a jump refers to a label,
+        // which is not in the instructions stream.
+        // Throws std::runtime_error if a jump or the last
+        // instruction transfers the control past the code end.
+        // @param method : the method to build the graph of.
+        // @param resource : the memory resource to store the graph,
+        //     must outlive the graph, for example, MethodArena::Resource().
+        explicit ControlFlowGraph(
+            const MethodBody& method,
+            std::pmr::memory_resource* const resource = std::pmr::get_default_resource());
+
+        // Gets the blocks, in the order of the instructions.
+        const std::pmr::vector<BasicBlock>& Blocks() const noexcept
+        {
+            return m_blocks;
+        }
+
+        // Gets the edges leaving the given block.
+        // The same target may appear more than once, for example,
+        // a conditional jump to the next instruction.
+        // @param block : the index of the block.
+        std::span<const ControlFlowEdge> Successors(const BlockIndex block) const noexcept
+        {
+            return std::span<const ControlFlowEdge>(m_successors)
+                .subspan(m_successorOffsets[block], m_successorOffsets[block + 1] - m_successorOffsets[block]);
+        }
+
+        // Gets the edges entering the given block.
+        // @param block : the index of the block.
+        std::span<const ControlFlowEdge> Predecessors(const BlockIndex block) const noexcept
+        {
+            return std::span<const ControlFlowEdge>(m_predecessors)
+                .subspan(m_predecessorOffsets[block], m_predecessorOffsets[block + 1] - m_predecessorOffsets[block]);
+        }
+
+        // Gets the count of edges.
+        size_t EdgesCount() const noexcept
+        {
+            return m_successors.size();
+        }
+
+        // Gets the block containing the element of the
+        // instructions stream with the given index.
+        // Returns NoBlock for labels following the last instruction.
+        // @param elementIndex : the index of the element in the stream.
+        BlockIndex BlockOf(const size_t elementIndex) const noexcept;
+
+        // Gets the block the given label belongs to.
+        // Returns NoBlock, if the label is not in the stream,
+        // or follows the last instruction.
+        // @param label : the label to look for.
+        BlockIndex BlockOf(const Label label) const noexcept;
+
+        // Gets the dominator tree, rooted at the entry block.
+        const DominatorTree& Dominators() const noexcept
+        {
+            return m_dominators;
+        }
+
+        // Gets the post-dominator tree, each exit is a root.
+        const DominatorTree& PostDominators() const noexcept
+        {
+            return m_postDominators;
+        }
+    };
+}
@@ -9,6 +9,7 @@
 #include "ComWrapperBase.h"
 #include "MetaDataImport.h"
 #include "MethodMalloc.h"
+#include "MethodBody.h"
 
 namespace Drill4dotNet
 {
@@ -61,15 +62,15 @@ namespace Drill4dotNet
             };
         }
 
-        // Wraps ICorProfilerInfo3::SetEnterLeaveFunctionHooks2.
+        // Wraps ICorProfilerInfo3::SetEnterLeaveFunctionHooks3.
         auto SetEnterLeaveFunctionHooksCallable(
-            FunctionEnter2* pFuncEnter,
-            FunctionLeave2* pFuncLeave,
-            FunctionTailcall2* pFuncTailcall) const
+            FunctionEnter3* pFuncEnter,
+            FunctionLeave3* pFuncLeave,
+            FunctionTailcall3* pFuncTailcall) const
         {
             return [this, pFuncEnter, pFuncLeave, pFuncTailcall]()
             {
-                return m_corProfilerInfo->SetEnterLeaveFunctionHooks2(
+                return m_corProfilerInfo->SetEnterLeaveFunctionHooks3(
                     pFuncEnter,
                     pFuncLeave,
                     pFuncTailcall);
@@ -156,6 +157,33 @@ namespace Drill4dotNet
             };
         }
 
+        // Wraps ICorProfilerInfo4::RequestReJIT.
+        // Fails with E_NOINTERFACE if the runtime does not support ReJIT,
+        // and with E_INVALIDARG if the counts of modules and methods differ.
+        auto RequestReJITCallable(
+            const std::vector<ModuleID>& moduleIds,
+            const std::vector<mdMethodDef>& methodIds) const
+        {
+            return [this, &moduleIds, &methodIds]()
+            {
+                const ATL::CComQIPtr<ICorProfilerInfo4> info { m_corProfilerInfo };
+                if (!info)
+                {
+                    return E_NOINTERFACE;
+                }
+
+                if (moduleIds.size() != methodIds.size())
+                {
+                    return E_INVALIDARG;
+                }
+
+                return info->RequestReJIT(
+                    static_cast<ULONG>(moduleIds.size()),
+                    const_cast<ModuleID*>(moduleIds.data()),
+                    const_cast<mdMethodDef*>(methodIds.data()));
+            };
+        }
+
         // Copies the method body given by pointer and length, to a separate vector.
         static std::vector<std::byte> CopyBody(const LPCBYTE methodHeader, const ULONG methodSize)
         {
@@ -309,12 +337,12 @@ namespace Drill4dotNet
             return this->TryCallCom(SetEventMaskCallable(eventMask) , L"Failed to call CorProfilerInfo::TrySetEventMask.");
         }
 
-        // Calls ICorProfilerInfo3::SetEnterLeaveFunctionHooks2 with the given parameters.
+        // Calls ICorProfilerInfo3::SetEnterLeaveFunctionHooks3 with the given parameters.
         // Throws _com_error in case of an error.
         void SetEnterLeaveFunctionHooks(
-            FunctionEnter2* pFuncEnter,
-            FunctionLeave2* pFuncLeave,
-            FunctionTailcall2* pFuncTailcall) const
+            FunctionEnter3* pFuncEnter,
+            FunctionLeave3* pFuncLeave,
+            FunctionTailcall3* pFuncTailcall) const
         {
             this->CallComOrThrow(
                 SetEnterLeaveFunctionHooksCallable(
@@ -324,12 +352,12 @@ namespace Drill4dotNet
                 L"Failed to call CorProfilerInfo::SetEnterLeaveFunctionHooks.");
         }
 
-        // Calls ICorProfilerInfo3::SetEnterLeaveFunctionHooks2 with the given parameters.
+        // Calls ICorProfilerInfo3::SetEnterLeaveFunctionHooks3 with the given parameters.
         // Returns false in case of an error.
         bool TrySetEnterLeaveFunctionHooks(
-            FunctionEnter2* pFuncEnter,
-            FunctionLeave2* pFuncLeave,
-            FunctionTailcall2* pFuncTailcall) const
+            FunctionEnter3* pFuncEnter,
+            FunctionLeave3* pFuncLeave,
+            FunctionTailcall3* pFuncTailcall) const
         {
             return this->TryCallCom(
                 SetEnterLeaveFunctionHooksCallable(
@@ -782,6 +810,38 @@ namespace Drill4dotNet
             );
         }
 
+        // Compiles the given .net method body directly into memory
+        // allocated with IMethodMalloc, and sets it as an implementation
+        // for the given method. Avoids an intermediate copy of the bytes.
+        // Calls ICorProfilerInfo3::SetILFunctionBody.
+        // Throws _com_error in case of an error.
+        // @param target : the target method
+        // @param newILMethodBody : the new method body
+        void SetILFunctionBody(
+            const FunctionInfo& target,
+            const MethodBody& newILMethodBody) const
+        {
+            MethodMalloc allocator = GetILFunctionBodyAllocator(
+                target.moduleId,
+                m_logger);
+
+            const size_t size { newILMethodBody.ComputeCompiledSize() };
+            BYTE* buffer = static_cast<BYTE*>(
+                allocator.Alloc(
+                static_cast<uint32_t>(size)));
+
+            newILMethodBody.CompileInto(std::span<std::byte>(
+                reinterpret_cast<std::byte*>(buffer),
+                size));
+
+            CallComOrThrow(
+                SetILFunctionBodyCallable(
+                    target,
+                    buffer),
+                L"Failed to call CorProfilerInfo::SetILFunctionBody"
+            );
+        }
+
         // Sets the given byte representation of a .net method body as
         // an implementation for the given method.
         // Calls ICorProfilerInfo3::SetILFunctionBody.
@@ -812,5 +872,35 @@ namespace Drill4dotNet
                 L"Failed to call CorProfilerInfo::TrySetILFunctionBody"
             );
         }
+
+        // Requests the given methods to be compiled again. The runtime
+        // gets their new bodies from ICorProfilerCallback4::GetReJITParameters.
+        // Calls ICorProfilerInfo4::RequestReJIT.
+        // Throws _com_error in case of an error.
+        // @param moduleIds : the modules of the methods.
+        // @param methodIds : the methods, methodIds[i] is from moduleIds[i].
+        void RequestReJIT(
+            const std::vector<ModuleID>& moduleIds,
+            const std::vector<mdMethodDef>& methodIds) const
+        {
+            this->CallComOrThrow(
+                RequestReJITCallable(moduleIds, methodIds),
+                L"Failed to call CorProfilerInfo::RequestReJIT.");
+        }
+
+        // Requests the given methods to be compiled again. The runtime
+        // gets their new bodies from ICorProfilerCallback4::GetReJITParameters.
+        // Calls ICorProfilerInfo4::RequestReJIT.
+        // Returns false in case of an error.
+        // @param moduleIds : the modules of the methods.
+        // @param methodIds : the methods, methodIds[i] is from moduleIds[i].
+        bool TryRequestReJIT(
+            const std::vector<ModuleID>& moduleIds,
+            const std::vector<mdMethodDef>& methodIds) const
+        {
+            return this->TryCallCom(
+                RequestReJITCallable(moduleIds, methodIds),
+                L"Failed to call CorProfilerInfo::TryRequestReJIT.");
+        }
     };
 }
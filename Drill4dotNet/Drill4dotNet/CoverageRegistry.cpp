@@ -0,0 +1,281 @@
+#include "pch.h"
+#include "CoverageRegistry.h"
+
+#include "MethodArena.h"
+
+#include <algorithm>
+
+namespace Drill4dotNet
+{
+    CoverageRegistry::Instrumentation CoverageRegistry::MakeInstrumentation(
+        const std::vector<std::byte>& originalBody,
+        const std::optional<uintptr_t> callCounter,
+        const CallSignatureProvider& getCallSignature)
+    {
+        MethodArenaScope arena {};
+        MethodBody method(originalBody, arena.Resource());
+        const ControlFlowGraph graph { method, arena.Resource() };
+        BlockCoveragePlan plan { graph };
+        ProbeArray probes { plan.ProbedBlocks().size() };
+        method.BeginEdit();
+
+        // Before the labels of the first instruction,
+        // so the jumps back to it are not counted as calls.
+        if (callCounter.has_value())
+        {
+            for (const OpCodeVariant& instruction : MakeNativeCounter(*callCounter))
+            {
+                method.Insert(method.begin(), instruction);
+            }
+        }
+
+        plan.InsertProbes(
+            method,
+            graph,
+            [&probes](const size_t probe)
+            {
+                return MakeNativeProbe(probes.Address(probe));
+            });
+
+        method.CommitEdit();
+        const ControlFlowGraph instrumentedGraph { method, arena.Resource() };
+        method.SetMaxStack(ComputeMaxStack(method, instrumentedGraph, getCallSignature));
+        return Instrumentation {
+            .Body { method.Compile() },
+            .Plan { std::move(plan) },
+            .Probes { std::move(probes) } };
+    }
+
+    bool CoverageRegistry::NeedsInstrumentation(const Record& record) const noexcept
+    {
+        return m_isSessionActive && !record.IsRetired && !record.Instrumented.has_value();
+    }
+
+    const std::vector<std::byte>& CoverageRegistry::BodyToCompile(const Record& record) const noexcept
+    {
+        return m_isSessionActive && !record.IsRetired && record.Instrumented.has_value()
+            ? record.Instrumented->Body
+            : record.OriginalBody;
+    }
+
+    std::vector<std::byte> CoverageRegistry::Instrument(
+        const MethodKey key,
+        const std::vector<std::byte>& originalBody,
+        const CallSignatureProvider& getCallSignature,
+        const std::optional<uintptr_t> callCounter)
+    {
+        {
+            const std::lock_guard lock { m_mutex };
+            const auto [record, _] { m_records.try_emplace(
+                key,
+                Record {
+                    .OriginalBody { originalBody },
+                    .CallCounter { callCounter },
+                    .Instrumented { std::nullopt },
+                    .IsRetired { false } }) };
+
+            if (!NeedsInstrumentation(record->second))
+            {
+                return BodyToCompile(record->second);
+            }
+        }
+
+        // Forgotten meanwhile only if the module is unloading.
+        return CurrentBody(key, getCallSignature).value_or(originalBody);
+    }
+
+    std::optional<std::vector<std::byte>> CoverageRegistry::CurrentBody(
+        const MethodKey key,
+        const CallSignatureProvider& getCallSignature)
+    {
+        std::vector<std::byte> originalBody {};
+        std::optional<uintptr_t> callCounter {};
+        {
+            const std::lock_guard lock { m_mutex };
+            const auto record { m_records.find(key) };
+            if (record == m_records.cend())
+            {
+                return std::nullopt;
+            }
+
+            if (!NeedsInstrumentation(record->second))
+            {
+                return BodyToCompile(record->second);
+            }
+
+            originalBody = record->second.OriginalBody;
+            callCounter = record->second.CallCounter;
+        }
+
+        // The method is instrumented without the lock,
+        // so the methods compiled by other threads wait
+        // only for the lookups.
+        std::optional<Instrumentation> instrumentation {};
+        try
+        {
+            instrumentation.emplace(MakeInstrumentation(originalBody, callCounter, getCallSignature));
+        }
+        catch (...)
+        {
+            // Compiled with the original body, and not tried again.
+            const std::lock_guard lock { m_mutex };
+            m_records.erase(key);
+            throw;
+        }
+
+        const std::lock_guard lock { m_mutex };
+        const auto record { m_records.find(key) };
+        if (record == m_records.cend())
+        {
+            return std::nullopt;
+        }
+
+        // Another thread may have instrumented the method
+        // meanwhile, its probes are used then.
+        if (!record->second.Instrumented.has_value())
+        {
+            record->second.Instrumented = std::move(instrumentation);
+        }
+
+        return BodyToCompile(record->second);
+    }
+
+    void CoverageRegistry::ForgetModule(const ModuleID moduleId)
+    {
+        const std::lock_guard lock { m_mutex };
+        auto record { m_records.lower_bound(MethodKey { moduleId, 0 }) };
+        while (record != m_records.end() && record->first.Module == moduleId)
+        {
+            record = m_records.erase(record);
+        }
+    }
+
+    std::vector<MethodKey> CoverageRegistry::RetireFullyCovered()
+    {
+        std::vector<MethodKey> result {};
+        const std::lock_guard lock { m_mutex };
+        if (!m_isSessionActive)
+        {
+            return result;
+        }
+
+        for (auto& [key, record] : m_records)
+        {
+            if (record.IsRetired || !record.Instrumented.has_value())
+            {
+                continue;
+            }
+
+            const std::vector<bool> hits { record.Instrumented->Probes.Hits() };
+            if (std::all_of(hits.cbegin(), hits.cend(), [](const bool hit) { return hit; }))
+            {
+                record.IsRetired = true;
+                result.push_back(key);
+            }
+        }
+
+        return result;
+    }
+
+    std::vector<MethodKey> CoverageRegistry::StartSession()
+    {
+        std::vector<MethodKey> result {};
+        const std::lock_guard lock { m_mutex };
+        if (m_isSessionActive)
+        {
+            return result;
+        }
+
+        m_isSessionActive = true;
+        result.reserve(m_records.size());
+        for (auto& [key, record] : m_records)
+        {
+            if (record.Instrumented.has_value())
+            {
+                record.Instrumented->Probes.Reset();
+            }
+
+            record.IsRetired = false;
+            result.push_back(key);
+        }
+
+        return result;
+    }
+
+    std::vector<MethodKey> CoverageRegistry::StopSession()
+    {
+        std::vector<MethodKey> result {};
+        const std::lock_guard lock { m_mutex };
+        if (!m_isSessionActive)
+        {
+            return result;
+        }
+
+        m_isSessionActive = false;
+        for (const auto& [key, record] : m_records)
+        {
+            // The retired methods, and the methods not compiled
+            // with the probes, run the original body already.
+            if (!record.IsRetired && record.Instrumented.has_value())
+            {
+                result.push_back(key);
+            }
+        }
+
+        return result;
+    }
+
+    bool CoverageRegistry::IsSessionActive() const
+    {
+        const std::lock_guard lock { m_mutex };
+        return m_isSessionActive;
+    }
+
+    bool CoverageRegistry::IsRetired(const MethodKey key) const
+    {
+        const std::lock_guard lock { m_mutex };
+        const auto record { m_records.find(key) };
+        return record != m_records.cend() && record->second.IsRetired;
+    }
+
+    std::optional<ProbesCount> CoverageRegistry::CountProbes(const MethodKey key) const
+    {
+        const std::lock_guard lock { m_mutex };
+        if (const auto record { m_records.find(key) }
+            ; record != m_records.cend() && record->second.Instrumented.has_value())
+        {
+            const BlockCoveragePlan& plan { record->second.Instrumented->Plan };
+            return ProbesCount { plan.ProbedBlocks().size(), plan.BlocksCount() };
+        }
+
+        return std::nullopt;
+    }
+
+    std::optional<std::vector<bool>> CoverageRegistry::Coverage(const MethodKey key) const
+    {
+        const std::lock_guard lock { m_mutex };
+        if (const auto record { m_records.find(key) }
+            ; record != m_records.cend() && record->second.Instrumented.has_value())
+        {
+            const Instrumentation& instrumented { *record->second.Instrumented };
+            return instrumented.Plan.ReconstructCoverage(instrumented.Probes.Hits());
+        }
+
+        return std::nullopt;
+    }
+
+    std::vector<MethodKey> CoverageRegistry::MethodsWithProbes() const
+    {
+        std::vector<MethodKey> result {};
+        const std::lock_guard lock { m_mutex };
+        for (const auto& [key, record] : m_records)
+        {
+            if (record.Instrumented.has_value())
+            {
+                result.push_back(key);
+            }
+        }
+
+        return result;
+    }
+}
@@ -0,0 +1,197 @@
+#pragma once
+
+#include "BlockCoverage.h"
+#include "ProbeArray.h"
+#include "StackDepth.h"
+
+#include <compare>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace Drill4dotNet
+{
+    // Identifies a method for ReJIT: the module and the method token.
+    struct MethodKey
+    {
+        ModuleID Module;
+        mdMethodDef Method;
+
+        auto operator<=>(const MethodKey&) const = default;
+    };
+
+    // How many block coverage probes an instrumented method has.
+    struct ProbesCount
+    {
+        // The count of the probes inserted.
+        size_t Probes;
+
+        // The count of the basic blocks, which a probe
+        // in each block would need as many probes as.
+        size_t Blocks;
+    };
+
+    // Keeps the block coverage probes of the instrumented methods.
+    // The methods run with the probes only while a test session is
+    // active; outside sessions they are compiled with their original
+    // bodies, and run without overhead. Starting and stopping a session
+    // gives the methods to be compiled again (ReJIT) with the new bodies.
+    // The probes of a method are made when a session first needs them,
+    // so the methods compiled outside sessions cost only a copy of the
+    // original body.
+    // Once all probes of a method have been hit, the instrumentation
+    // gives nothing more in the session, so the method is retired: it
+    // is compiled again with its original body till the next session.
+    // The probes of a retired method are kept, so its coverage is still
+    // reported, and the code compiled before the ReJIT, which may still
+    // be running, has its probes to write to.
+    // Can be used from several threads at once.
+    class CoverageRegistry
+    {
+    private:
+        // The probes of a method.
+        struct Instrumentation
+        {
+            // The body of the method with the probes.
+            std::vector<std::byte> Body;
+
+            // The blocks getting the probes.
+            BlockCoveragePlan Plan;
+
+            // The memory the probes write to.
+            ProbeArray Probes;
+        };
+
+        // The state of an instrumented method.
+        struct Record
+        {
+            // The body of the method before the instrumentation.
+            std::vector<std::byte> OriginalBody;
+
+            // The native address of the count of the calls of the
+            // method, which the instrumented body adds its calls to.
+            std::optional<uintptr_t> CallCounter;
+
+            // The probes, made when a session first needs them.
+            std::optional<Instrumentation> Instrumented;
+
+            // Whether the method has been retired.
+            bool IsRetired;
+        };
+
+        // Guards m_records and m_isSessionActive.
+        mutable std::mutex m_mutex {};
+
+        // Whether a test session is active.
+        bool m_isSessionActive { false };
+
+        // The instrumented methods.
+        std::map<MethodKey, Record> m_records {};
+
+        // Makes the probes of the method with the given body.
+        // Throws std::runtime_error if the body is malformed,
+        // or the max stack cannot be computed.
+        // @param originalBody : the body of the method from the metadata.
+        // @param callCounter : the counter to add the calls of the method
+        //     to, see MakeNativeCounter, or std::nullopt to not count them.
+        // @param getCallSignature : gets the signatures of the called methods.
+        static Instrumentation MakeInstrumentation(
+            const std::vector<std::byte>& originalBody,
+            const std::optional<uintptr_t> callCounter,
+            const CallSignatureProvider& getCallSignature);
+
+        // Gets whether the given method has to get the probes
+        // before it is compiled. m_mutex must be locked.
+        // @param record : the method to compile.
+        bool NeedsInstrumentation(const Record& record) const noexcept;
+
+        // Gets the body the given method is to be compiled with.
+        // m_mutex must be locked.
+        // @param record : the method to compile.
+        const std::vector<std::byte>& BodyToCompile(const Record& record) const noexcept;
+
+    public:
+        // Remembers the given method to be instrumented with block
+        // coverage probes. Returns the body the method is to be
+        // compiled with, see CurrentBody(). A method remembered
+        // before keeps its original body, its counter and its probes.
+        // The instrumented body also adds each call of the method
+        // to the given counter on entry, so the calls are counted
+        // only while the method runs with the probes.
+        // Throws std::runtime_error if a session needs the probes, and
+        // the body is malformed, or the max stack cannot be computed;
+        // the method is not remembered then.
+        // @param key : the method to instrument.
+        // @param originalBody : the body of the method from the metadata.
+        // @param getCallSignature : gets the signatures of the called methods.
+        // @param callCounter : the native address of the 64-bit count of
+        //     the calls of the method, which must outlive the code of the
+        //     method, or std::nullopt to not count the calls.
+        std::vector<std::byte> Instrument(
+            const MethodKey key,
+            const std::vector<std::byte>& originalBody,
+            const CallSignatureProvider& getCallSignature,
+            const std::optional<uintptr_t> callCounter = std::nullopt);
+
+        // Gets the body the given method is to be compiled with
+        // during a ReJIT: the instrumented body while a session is
+        // active, or the original body if there is no active session,
+        // or the method is retired. Makes the probes of the method,
+        // if a session needs them for the first time. Returns
+        // std::nullopt if the method is not remembered.
+        // Throws std::runtime_error if the body is malformed, or the
+        // max stack cannot be computed; the method is forgotten then.
+        // @param key : the method to compile.
+        // @param getCallSignature : gets the signatures of the called methods.
+        std::optional<std::vector<std::byte>> CurrentBody(
+            const MethodKey key,
+            const CallSignatureProvider& getCallSignature);
+
+        // Forgets the methods of the unloading module, so a module
+        // loaded later with the same id does not get their bodies.
+        // @param moduleId : the module unloading.
+        void ForgetModule(const ModuleID moduleId);
+
+        // Marks the methods, all probes of which have been hit,
+        // as retired. Returns the methods retired by this call,
+        // which are to be compiled again with the original body.
+        // Returns nothing if there is no active session.
+        std::vector<MethodKey> RetireFullyCovered();
+
+        // Starts a test session: clears the probes and the retired marks
+        // of all methods. Returns the methods to be compiled again with
+        // the probes, see CurrentBody(). Returns nothing if a session
+        // is already active.
+        std::vector<MethodKey> StartSession();
+
+        // Stops the test session. The probes are kept, so the coverage
+        // of the session is still available. Returns the methods to be
+        // compiled again with the original body. Returns nothing if
+        // there is no active session.
+        std::vector<MethodKey> StopSession();
+
+        // Gets whether a test session is active.
+        bool IsSessionActive() const;
+
+        // Gets whether the given method has been retired.
+        // @param key : the method to check.
+        bool IsRetired(const MethodKey key) const;
+
+        // Gets how many probes the given method has, taken from the
+        // plan made with the probes. Returns std::nullopt if the method
+        // has not got the probes.
+        // @param key : the method to get the count of.
+        std::optional<ProbesCount> CountProbes(const MethodKey key) const;
+
+        // Gets the coverage of the basic blocks of the given method,
+        // see BlockCoveragePlan::ReconstructCoverage. Returns
+        // std::nullopt if the method has not got the probes.
+        // @param key : the method to get the coverage of.
+        std::optional<std::vector<bool>> Coverage(const MethodKey key) const;
+
+        // Gets the methods, which have got the probes,
+        // so their coverage is available, see Coverage().
+        std::vector<MethodKey> MethodsWithProbes() const;
+    };
+}
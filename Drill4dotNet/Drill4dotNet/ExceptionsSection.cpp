@@ -11,7 +11,7 @@ namespace Drill4dotNet
         const std::vector<std::byte>::const_iterator sourceEnd,
         InstructionStream& target,
         LabelCreator& labelCreator,
-        std::vector<ExceptionClause>& clauses)
+        std::pmr::vector<ExceptionClause>& clauses)
     {
         constexpr size_t clauseSize = sizeof(TClause);
 
@@ -23,7 +23,8 @@ namespace Drill4dotNet
             throw std::runtime_error("Unexpected end of the input in the middle of exception section header");
         }
 
-        const TSection& sectionHeader = *(reinterpret_cast<const TSection*>(&*source));
+        ByteReader reader { std::span<const std::byte> { &*source, static_cast<size_t>(sourceEnd - source) } };
+        const TSection sectionHeader { reader.ReadRaw<TSection>() };
 
         const size_t clausesCount = (sectionHeader.DataSize - headerSize) / clauseSize;
         if (clausesCount * clauseSize + headerSize != sectionHeader.DataSize)
@@ -37,23 +38,27 @@ namespace Drill4dotNet
         }
 
         clauses.reserve(clausesCount);
-        source += headerSize;
+        // skip the padding of SMALL header
+        reader.ReadBytes(headerSize - sizeof(TSection));
         for (size_t i = 0; i != clausesCount; ++i)
         {
-            const TClause& clause = *(reinterpret_cast<const TClause*>(&*source));
-            source += clauseSize;
+            const TClause clause { reader.ReadRaw<TClause>() };
             clauses.emplace_back(
                 clause,
                 target,
                 labelCreator);
         }
+
+        source += reader.Position();
     }
 
     ExceptionsSection::ExceptionsSection(
         std::vector<std::byte>::const_iterator& source,
         const std::vector<std::byte>::const_iterator sourceEnd,
         InstructionStream& target,
-        LabelCreator& labelCreator)
+        LabelCreator& labelCreator,
+        std::pmr::memory_resource* const resource)
+        : m_clauses(resource)
     {
         if (source == sourceEnd)
         {
@@ -95,13 +100,34 @@ namespace Drill4dotNet
         }
     }
 
-    void ExceptionsSection::AppendToBytes(std::vector<std::byte>& target) const
+    bool ExceptionsSection::ShouldBeFat() const
     {
-        CorILMethodSect flags{ CorILMethodSect::CorILMethod_Sect_EHTable };
-        bool shouldBeFat = m_fat || std::any_of(
+        return m_fat || std::any_of(
             m_clauses.cbegin(),
             m_clauses.cend(),
             [](const ExceptionClause& c) { return !c.CanPutToSmallHeader(); });
+    }
+
+    size_t ExceptionsSection::Size() const
+    {
+        // same for SMALL and FAT, SMALL has padding for equal header sizes
+        constexpr size_t headerSize = sizeof(IMAGE_COR_ILMETHOD_SECT_FAT);
+        return headerSize + m_clauses.size() * (ShouldBeFat()
+            ? sizeof(IMAGE_COR_ILMETHOD_SECT_EH_CLAUSE_FAT)
+            : sizeof(IMAGE_COR_ILMETHOD_SECT_EH_CLAUSE_SMALL));
+    }
+
+    void ExceptionsSection::AppendToBytes(std::vector<std::byte>& target) const
+    {
+        ByteWriter writer { target };
+        writer.Reserve(Size());
+        WriteToBytes(writer);
+    }
+
+    void ExceptionsSection::WriteToBytes(ByteWriter& target) const
+    {
+        CorILMethodSect flags{ CorILMethodSect::CorILMethod_Sect_EHTable };
+        const bool shouldBeFat { ShouldBeFat() };
 
         if (shouldBeFat)
         {
@@ -127,11 +153,11 @@ namespace Drill4dotNet
                 throw std::runtime_error("IMAGE_COR_ILMETHOD_SECT_FAT::DataSize overflows.");
             }
             header.DataSize = static_cast<unsigned>(dataSize);
-            AppendAsBytes(target, header);
+            target.WriteRaw(header);
             for (size_t i = 0; i != m_clauses.size(); ++i)
             {
                 IMAGE_COR_ILMETHOD_SECT_EH_CLAUSE_FAT clause = m_clauses[i].FillFatHeader();
-                AppendAsBytes(target, clause);
+                target.WriteRaw(clause);
             }
         }
         else
@@ -146,12 +172,12 @@ namespace Drill4dotNet
                 throw std::runtime_error("IMAGE_COR_ILMETHOD_SECT_SMALL::DataSize overflows.");
             }
             header.DataSize = static_cast<BYTE>(dataSize);
-            AppendAsBytes(target, header);
-            AppendAsBytes(target, decltype(std::declval<IMAGE_COR_ILMETHOD_SECT_EH_SMALL>().Reserved) { 0 });
+            target.WriteRaw(header);
+            target.Write(decltype(std::declval<IMAGE_COR_ILMETHOD_SECT_EH_SMALL>().Reserved) { 0 });
             for (size_t i = 0; i != m_clauses.size(); ++i)
             {
                 IMAGE_COR_ILMETHOD_SECT_EH_CLAUSE_SMALL clause = m_clauses[i].FillSmallHeader();
-                AppendAsBytes(target, clause);
+                target.WriteRaw(clause);
             }
         }
     }
@@ -2,6 +2,8 @@
 
 #include "ExceptionClause.h"
 
+#include <memory_resource>
+
 namespace Drill4dotNet
 {
     // Represents one section with definitions of several
@@ -23,7 +25,11 @@ namespace Drill4dotNet
         bool m_fat;
 
         // Try-catch and try-finally clauses stored in this section.
-        std::vector<ExceptionClause> m_clauses;
+        std::pmr::vector<ExceptionClause> m_clauses;
+
+        // Gets the value indicating whether this section must
+        // be serialized with the fat header.
+        bool ShouldBeFat() const;
     public:
 
         // Fills a new instance from method bytes representation.
@@ -32,17 +38,26 @@ namespace Drill4dotNet
         // @param sourceEnd : the end of the method bytes.
         // @param target : the instructions stream to add new labels to.
         // @param labelCreator : the tool to emit new labels.
+        // @param resource : the memory resource to store the clauses.
         ExceptionsSection(
             std::vector<std::byte>::const_iterator& source,
             const std::vector<std::byte>::const_iterator sourceEnd,
             InstructionStream& target,
-            LabelCreator& labelCreator);
+            LabelCreator& labelCreator,
+            std::pmr::memory_resource* const resource = std::pmr::get_default_resource());
 
         // Serializes this instance as bytes and adds them to the
         // given vector.
         // @param target : will append serialized bytes there.
         void AppendToBytes(std::vector<std::byte>& target) const;
 
+        // Serializes this instance as bytes with the given writer.
+        // @param target : the writer to save serialized bytes with.
+        void WriteToBytes(ByteWriter& target) const;
+
+        // Gets the size of the serialized section, in bytes.
+        size_t Size() const;
+
         // Value indicating whether more sections present in method
         // after this section.
         constexpr bool HasMoreSections() const noexcept
@@ -51,7 +66,7 @@ namespace Drill4dotNet
         }
 
         // Try-catch and try-finally clauses stored in this section.
-        constexpr const std::vector<ExceptionClause>& Clauses() const noexcept
+        const std::pmr::vector<ExceptionClause>& Clauses() const noexcept
         {
             return m_clauses;
         }
@@ -0,0 +1,96 @@
+#include "pch.h"
+#include "FunctionTable.h"
+
+namespace Drill4dotNet
+{
+    uint32_t StringPool::Intern(const std::wstring_view value)
+    {
+        if (const auto found { m_indices.find(value) }
+            ; found != m_indices.cend())
+        {
+            return found->second;
+        }
+
+        const uint32_t index { m_strings.Add([value](std::wstring& added)
+        {
+            added = value;
+        }) };
+
+        m_indices.emplace(m_strings[index], index);
+        return index;
+    }
+
+    uint32_t FunctionTable::Add(const FunctionID id, const FunctionInfoWithoutName& info)
+    {
+        std::scoped_lock lock { m_mutex };
+        const uint32_t index { m_runtimeInfos.Add() };
+        m_modules.Add([&info](ModuleID& moduleId) { moduleId = info.moduleId; });
+        m_classes.Add([&info](ClassID& classId) { classId = info.classId; });
+        m_tokens.Add([&info](mdToken& token) { token = info.token; });
+        m_classNames.Add([](std::atomic<uint32_t>& name) { name.store(NoName, std::memory_order_relaxed); });
+        m_ownNames.Add([](std::atomic<uint32_t>& name) { name.store(NoName, std::memory_order_relaxed); });
+
+        m_count.store(index + 1, std::memory_order_release);
+        m_indices.Emplace(id, index);
+        return index;
+    }
+
+    void FunctionTable::SetName(const uint32_t index, const FunctionName& name)
+    {
+        std::scoped_lock lock { m_mutex };
+        if (m_ownNames[index].load(std::memory_order_relaxed) != NoName)
+        {
+            return;
+        }
+
+        m_classNames[index].store(m_names.Intern(name.className), std::memory_order_relaxed);
+        m_ownNames[index].store(m_names.Intern(name.ownName), std::memory_order_release);
+    }
+
+    std::optional<uint32_t> FunctionTable::IndexOf(const FunctionID id) const noexcept
+    {
+        if (const uint32_t* const index { m_indices.Find(id) }
+            ; index != nullptr)
+        {
+            return *index;
+        }
+
+        return std::nullopt;
+    }
+
+    FunctionInfoWithoutName FunctionTable::Info(const uint32_t index) const noexcept
+    {
+        FunctionInfoWithoutName result {};
+        result.moduleId = m_modules[index];
+        result.classId = m_classes[index];
+        result.token = m_tokens[index];
+        return result;
+    }
+
+    std::optional<FunctionName> FunctionTable::TryGetName(const uint32_t index) const
+    {
+        const uint32_t ownName { m_ownNames[index].load(std::memory_order_acquire) };
+        if (ownName == NoName)
+        {
+            return std::nullopt;
+        }
+
+        return FunctionName {
+            m_names[ownName],
+            m_names[m_classNames[index].load(std::memory_order_relaxed)] };
+    }
+
+    uint32_t FunctionTable::CountCalled() const noexcept
+    {
+        uint32_t result { 0 };
+        m_runtimeInfos.ForEach([&result](const FunctionRuntimeInfo& runtimeInfo)
+        {
+            if (runtimeInfo.callCount.load(std::memory_order_relaxed) > 0)
+            {
+                ++result;
+            }
+        });
+
+        return result;
+    }
+}
@@ -0,0 +1,192 @@
+#pragma once
+
+#include "framework.h"
+#include "CorDataStructures.h"
+#include "ConcurrentRegistry.h"
+#include "SegmentedArray.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <limits>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace Drill4dotNet
+{
+    // The runtime data of a function: the count of the calls, which
+    // the instrumented code of the function adds to by its native
+    // address, see MakeNativeCounter. So it must be lock free.
+    struct FunctionRuntimeInfo
+    {
+        std::atomic<uint64_t> callCount { 0 };
+    };
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free);
+    static_assert(alignof(std::atomic<uint64_t>) == sizeof(uint64_t));
+
+    // Keeps each distinct string once, and identifies it by a dense index.
+    // One thread at a time may add strings, while other threads read
+    // the strings added before.
+    class StringPool
+    {
+    private:
+        // The strings, by their indices.
+        SegmentedArray<std::wstring> m_strings {};
+
+        // The indices of the strings, used only by the adding thread.
+        // The keys refer to m_strings, the elements of which never move.
+        std::unordered_map<std::wstring_view, uint32_t> m_indices {};
+
+    public:
+        // Gets the index of the string, adding the string if it is new.
+        // @param value : the string to find or to add.
+        uint32_t Intern(const std::wstring_view value);
+
+        // Gets the count of distinct strings.
+        uint32_t Size() const noexcept
+        {
+            return m_strings.Size();
+        }
+
+        // Gets the string by its index, given by Intern().
+        // @param index : the index of the string.
+        const std::wstring& operator[](const uint32_t index) const noexcept
+        {
+            return m_strings[index];
+        }
+    };
+
+    // The functions mapped by the profiler. Each function gets a dense
+    // 32-bit index, and its data are kept in columns indexed by it: the
+    // reports scan the few contiguous blocks of a column instead of
+    // walking hash maps, and the instrumented code touches only the counters.
+    // The functions are added with their tokens only, since most names
+    // are never read: the names are resolved later, by ResolveNames(),
+    // for the functions a report needs, and are kept once resolved. The
+    // names are interned, as the functions of a class share the class
+    // name. The functions are added under a lock, and are read from many
+    // threads without it.
+    class FunctionTable
+    {
+    private:
+        // Marks the functions, the names of which are not resolved yet.
+        inline static constexpr uint32_t NoName { std::numeric_limits<uint32_t>::max() };
+
+        // Serializes the additions of the functions and the names.
+        std::mutex m_mutex {};
+
+        // The indices of the functions by their runtime ids.
+        ConcurrentRegistry<FunctionID, uint32_t> m_indices {};
+
+        // The totals of the calls.
+        SegmentedArray<FunctionRuntimeInfo> m_runtimeInfos {};
+
+        SegmentedArray<ModuleID> m_modules {};
+        SegmentedArray<ClassID> m_classes {};
+        SegmentedArray<mdToken> m_tokens {};
+
+        // The indices of the names in m_names, or NoName. The own name
+        // is written last, so a function having it has the class name.
+        SegmentedArray<std::atomic<uint32_t>> m_classNames {};
+        SegmentedArray<std::atomic<uint32_t>> m_ownNames {};
+
+        // The names of the classes and the functions.
+        StringPool m_names {};
+
+        // The count of functions, all columns of which have been written.
+        std::atomic<uint32_t> m_count { 0 };
+
+    public:
+        // Adds the function without its name, and returns its index.
+        // A function added again gets a new index, which its id refers
+        // to from now on; the data at the old index are kept.
+        // Throws std::length_error if there are too many functions.
+        // @param id : the runtime id of the function.
+        // @param info : the data of the function.
+        uint32_t Add(const FunctionID id, const FunctionInfoWithoutName& info);
+
+        // Sets the name of the function, if it has none yet.
+        // @param index : the index of the function, less than Count().
+        // @param name : the name of the function.
+        void SetName(const uint32_t index, const FunctionName& name);
+
+        // Gets the index of the function, or std::nullopt
+        // if it has not been added. Takes no lock.
+        // @param id : the runtime id of the function.
+        std::optional<uint32_t> IndexOf(const FunctionID id) const noexcept;
+
+        // Gets the count of the indices given.
+        uint32_t Count() const noexcept
+        {
+            return m_count.load(std::memory_order_acquire);
+        }
+
+        // Gets the data of the function.
+        // @param index : the index of the function, less than Count().
+        FunctionInfoWithoutName Info(const uint32_t index) const noexcept;
+
+        // Gets the name of the function, or std::nullopt
+        // if it has not been resolved yet.
+        // @param index : the index of the function, less than Count().
+        std::optional<FunctionName> TryGetName(const uint32_t index) const;
+
+        // Gets the runtime data of the function.
+        // @param index : the index of the function, less than Count().
+        FunctionRuntimeInfo& RuntimeInfo(const uint32_t index) noexcept
+        {
+            return m_runtimeInfos[index];
+        }
+
+        // Gets the count of the functions called at least once,
+        // by a scan over the call counters.
+        uint32_t CountCalled() const noexcept;
+
+        // Resolves the names of the chosen functions, which have no names
+        // yet. The functions are resolved in batches, one for each module,
+        // so the metadata of a module are opened once for all of them.
+        // The names which cannot be resolved are left unresolved.
+        // TChoose : callable accepting uint32_t index, returning bool.
+        // TResolveModule : callable accepting ModuleID and
+        //     const std::vector<mdToken>&, returning the names by the
+        //     positions of the tokens, as std::vector<std::optional<FunctionName>>.
+        // @param choose : tells whether the name of the function is needed.
+        // @param resolveModule : resolves the names of the given methods of the module.
+        template <typename TChoose, typename TResolveModule>
+        void ResolveNames(TChoose&& choose, TResolveModule&& resolveModule)
+        {
+            std::map<ModuleID, std::vector<uint32_t>> unresolved {};
+            const uint32_t count { Count() };
+            for (uint32_t index = 0; index != count; ++index)
+            {
+                if (m_ownNames[index].load(std::memory_order_acquire) == NoName && choose(index))
+                {
+                    unresolved[m_modules[index]].push_back(index);
+                }
+            }
+
+            for (const auto& [moduleId, indices] : unresolved)
+            {
+                std::vector<mdToken> tokens {};
+                tokens.reserve(indices.size());
+                for (const uint32_t index : indices)
+                {
+                    tokens.push_back(m_tokens[index]);
+                }
+
+                const std::vector<std::optional<FunctionName>> names { resolveModule(moduleId, tokens) };
+                for (size_t i = 0; i != indices.size() && i != names.size(); ++i)
+                {
+                    if (names[i].has_value())
+                    {
+                        SetName(indices[i], *names[i]);
+                    }
+                }
+            }
+        }
+    };
+}
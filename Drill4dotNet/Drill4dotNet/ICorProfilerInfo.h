@@ -3,6 +3,7 @@
 #include "CorDataStructures.h"
 #include "IMetadataImport.h"
 #include "ComWrapperBase.h"
+#include "MethodBody.h"
 #include <optional>
 #include <vector>
 #include <concepts>
@@ -32,17 +33,17 @@ namespace Drill4dotNet
         // Sets the Function Mapper callback. Returns false on errors.
         { x.TrySetFunctionIDMapper(std::declval<const FunctionIDMapper* const>()) } -> std::same_as<bool>;
 
-        // Sets Enter/Leave function callbacks (version 2). Throws on errors.
+        // Sets Enter/Leave function callbacks (version 3). Throws on errors.
         { x.SetEnterLeaveFunctionHooks(
-            std::declval<const FunctionEnter2* const>(),
-            std::declval<const FunctionLeave2* const>(),
-            std::declval<const FunctionTailcall2* const>())} -> std::same_as<void>;
+            std::declval<const FunctionEnter3* const>(),
+            std::declval<const FunctionLeave3* const>(),
+            std::declval<const FunctionTailcall3* const>())} -> std::same_as<void>;
 
-        // Sets Enter/Leave function callbacks (version 2). Returns false on errors.
+        // Sets Enter/Leave function callbacks (version 3). Returns false on errors.
         { x.TrySetEnterLeaveFunctionHooks(
-            std::declval<const FunctionEnter2* const>(),
-            std::declval<const FunctionLeave2* const>(),
-            std::declval<const FunctionTailcall2* const>())} -> std::same_as<bool>;
+            std::declval<const FunctionEnter3* const>(),
+            std::declval<const FunctionLeave3* const>(),
+            std::declval<const FunctionTailcall3* const>())} -> std::same_as<bool>;
 
         // Gets information about Application Domain by id. Throws on errors.
         { x.GetAppDomainInfo(std::declval<const AppDomainID>()) } -> std::same_as<AppDomainInfo>;
@@ -102,9 +103,29 @@ namespace Drill4dotNet
             std::declval<const FunctionInfo&>(),
             std::declval<const std::vector<std::byte>&>()) } -> std::same_as<void>;
 
+        // Compiles the given method body directly into memory allocated by the runtime,
+        // and sets it to the Function body. Throws on errors.
+        { x.SetILFunctionBody(
+            std::declval<const FunctionInfo&>(),
+            std::declval<const MethodBody&>()) } -> std::same_as<void>;
+
         // Sets the given the Intermediate Language representation to the Function body. Returns false on errors.
         { x.TrySetILFunctionBody(
             std::declval<const FunctionInfo&>(),
             std::declval<const std::vector<std::byte>&>()) } -> std::same_as<bool>;
+
+        // Requests the given methods to be compiled again, methodIds[i]
+        // from moduleIds[i]. The runtime asks the new bodies with
+        // ICorProfilerCallback4::GetReJITParameters. Throws on errors.
+        { x.RequestReJIT(
+            std::declval<const std::vector<ModuleID>&>(),
+            std::declval<const std::vector<mdMethodDef>&>()) } -> std::same_as<void>;
+
+        // Requests the given methods to be compiled again, methodIds[i]
+        // from moduleIds[i]. The runtime asks the new bodies with
+        // ICorProfilerCallback4::GetReJITParameters. Returns false on errors.
+        { x.TryRequestReJIT(
+            std::declval<const std::vector<ModuleID>&>(),
+            std::declval<const std::vector<mdMethodDef>&>()) } -> std::same_as<bool>;
     };
 }
@@ -74,6 +74,16 @@ namespace Drill4dotNet
         // Returns std::nullopt in case of errors.
         { x.TryGetSignatureBlob(std::declval<const mdSignature>()) } -> std::same_as<std::optional<std::vector<std::byte>>>;
 
+        // Gets the mdMethodDef or mdMemberRef token of the generic method,
+        // which the given method specification instantiates.
+        // Throws _com_error on errors.
+        { x.GetMethodSpecificationParent(std::declval<const mdMethodSpec>()) } -> std::same_as<mdToken>;
+
+        // Gets the mdMethodDef or mdMemberRef token of the generic method,
+        // which the given method specification instantiates.
+        // Returns std::nullopt in case of errors.
+        { x.TryGetMethodSpecificationParent(std::declval<const mdMethodSpec>()) } -> std::same_as<std::optional<mdToken>>;
+
         // Gets the tokens of the types in the module. Throws in case of an error.
         { x.EnumTypeDefinitions() } -> std::same_as<std::vector<mdTypeDef>>;
 
@@ -19,81 +19,99 @@ namespace Drill4dotNet
         return LogBuffer<std::wostream>(m_ostream);
     }
 
-    void InfoHandler::MapFunctionInfo(const FunctionID id, const FunctionInfo& info) noexcept
+    std::optional<uint32_t> InfoHandler::MapFunctionInfo(const FunctionID id, const FunctionInfoWithoutName& info) noexcept
     {
         try
         {
-            m_functionInfos[id] = info;
-            m_functionCounts[id] = { 0 };
+            return m_functions.Add(id, info);
         }
         catch (const std::exception & ex)
         {
             Log() << "InfoHandler::MapFunctionInfo: exception while inserting function info by id [" << id << "]. " << ex.what();
         }
+        return std::nullopt;
     }
 
-    std::optional<FunctionInfo> InfoHandler::TryGetFunctionInfo(const FunctionID id) const noexcept
+    std::optional<uint32_t> InfoHandler::MapFunctionInfo(const FunctionID id, const FunctionInfo& info) noexcept
     {
         try
         {
-            if (const auto it = m_functionInfos.find(id);
-                m_functionInfos.end() != it)
-            {
-                return it->second;
-            }
-            else
-            {
-                Log() << "InfoHandler::TryGetFunctionInfo: cannot find function by id [" << id << "].";
-            }
+            const uint32_t index { m_functions.Add(id, info) };
+            m_functions.SetName(index, info.name);
+            return index;
         }
         catch (const std::exception & ex)
         {
-            Log() << "InfoHandler::TryGetFunctionInfo: exception while accessing function info by id [" << id << "]. " << ex.what();
+            Log() << "InfoHandler::MapFunctionInfo: exception while inserting function info by id [" << id << "]. " << ex.what();
         }
         return std::nullopt;
     }
 
-    void InfoHandler::FunctionCalled(const FunctionID id) noexcept
+    std::optional<FunctionInfo> InfoHandler::TryGetFunctionInfo(const FunctionID id) const noexcept
     {
         try
         {
-            if (auto it = m_functionCounts.find(id);
-                m_functionCounts.end() != it)
+            if (const auto index = m_functions.IndexOf(id);
+                index.has_value())
             {
-                it->second.callCount += 1;
+                FunctionInfo result {};
+                static_cast<FunctionInfoWithoutName&>(result) = m_functions.Info(*index);
+                if (std::optional<FunctionName> name { m_functions.TryGetName(*index) }
+                    ; name.has_value())
+                {
+                    result.name = std::move(*name);
+                }
+
+                return result;
             }
             else
             {
-                Log() << "InfoHandler::FunctionCalled: cannot find function by id [" << id << "].";
+                Log() << "InfoHandler::TryGetFunctionInfo: cannot find function by id [" << id << "].";
             }
         }
         catch (const std::exception & ex)
         {
-            Log() << "InfoHandler::FunctionCalled: exception while accessing function info by id [" << id << "]. " << ex.what();
+            Log() << "InfoHandler::TryGetFunctionInfo: exception while accessing function info by id [" << id << "]. " << ex.what();
         }
+        return std::nullopt;
     }
-    
+
     void InfoHandler::OutputStatistics() const
     {
         Log() << L"Statistics:";
-        Log() << L"Total number of functions mapped: " << m_functionInfos.size();
+        Log() << L"Total number of functions mapped: " << m_functions.Count();
+        Log() << L"Total number of functions called: " << m_functions.CountCalled();
+
+        const uint32_t count { m_functions.Count() };
+        for (uint32_t index = 0; index != count; ++index)
+        {
+            const uint64_t calls { m_functions.RuntimeInfo(index).callCount.load(std::memory_order_relaxed) };
+            if (calls == 0)
+            {
+                continue;
+            }
 
-        size_t countFunctionsCalled = std::count_if(
-            m_functionCounts.cbegin(),
-            m_functionCounts.cend(),
-            [](const auto& info) -> bool
+            if (const std::optional<FunctionName> name { m_functions.TryGetName(index) }
+                ; name.has_value())
+            {
+                Log() << name->className << L"." << name->ownName << L" called " << calls << L" times";
+            }
+            else
             {
-                return info.second.callCount > 0;
+                const FunctionInfoWithoutName info { m_functions.Info(index) };
+                Log()
+                    << L"Function " << HexOutput(info.token)
+                    << L" of module " << info.moduleId
+                    << L" called " << calls << L" times";
             }
-        );
-        Log() << L"Total number of functions called: " << countFunctionsCalled;
+        }
     }
 
     void InfoHandler::MapAppDomainInfo(const AppDomainID id, const AppDomainInfo& info) noexcept
     {
         try
         {
-            m_appDomainInfos[id] = info;
+            m_appDomainInfos.Emplace(id, info);
         }
         catch (const std::exception & ex)
         {
@@ -105,10 +123,10 @@ namespace Drill4dotNet
     {
         try
         {
-            if (const auto it = m_appDomainInfos.find(id);
-                m_appDomainInfos.end() != it)
+            if (const auto found = m_appDomainInfos.Find(id);
+                found != nullptr)
             {
-                return it->second;
+                return *found;
             }
             else
             {
@@ -124,10 +142,10 @@ namespace Drill4dotNet
 
     void InfoHandler::OutputAppDomainInfo(const AppDomainID id) const
     {
-        if (const auto it = m_appDomainInfos.find(id);
-            m_appDomainInfos.end() != it)
+        if (const auto it = m_appDomainInfos.Find(id);
+            nullptr != it)
         {
-            Log() << L"Domain name: " << it->second.name << L", process id: " << it->second.processId;
+            Log() << L"Domain name: " << it->name << L", process id: " << it->processId;
         }
     }
 
@@ -135,7 +153,7 @@ namespace Drill4dotNet
     {
         try
         {
-            m_assemblyInfos[id] = info;
+            m_assemblyInfos.Emplace(id, info);
         }
         catch (const std::exception & ex)
         {
@@ -147,10 +165,10 @@ namespace Drill4dotNet
     {
         try
         {
-            if (const auto it = m_assemblyInfos.find(id);
-                m_assemblyInfos.end() != it)
+            if (const auto found = m_assemblyInfos.Find(id);
+                found != nullptr)
             {
-                return it->second;
+                return *found;
             }
             else
             {
@@ -166,17 +184,17 @@ namespace Drill4dotNet
 
     void InfoHandler::OutputAssemblyInfo(const AssemblyID id) const
     {
-        if (const auto _assembly = m_assemblyInfos.find(id);
-            m_assemblyInfos.end() != _assembly)
+        if (const auto _assembly = m_assemblyInfos.Find(id);
+            nullptr != _assembly)
         {
-            const auto _domain = m_appDomainInfos.find(_assembly->second.appDomainId);
-            const auto _module = m_moduleInfos.find(_assembly->second.moduleId);
+            const auto _domain = m_appDomainInfos.Find(_assembly->appDomainId);
+            const auto _module = m_moduleInfos.Find(_assembly->moduleId);
             Log()
-                << L"Assembly name: " << _assembly->second.name
-                << L", its app domain: " << _assembly->second.appDomainId
-                << L" (" << (m_appDomainInfos.end() != _domain ? _domain->second.name : L"<unknown>") << L")"
-                << L", its module: " << _assembly->second.moduleId
-                << L" (" << (m_moduleInfos.end() != _module ? _module->second.name : L"<unknown>") << L")"
+                << L"Assembly name: " << _assembly->name
+                << L", its app domain: " << _assembly->appDomainId
+                << L" (" << (nullptr != _domain ? _domain->name : L"<unknown>") << L")"
+                << L", its module: " << _assembly->moduleId
+                << L" (" << (nullptr != _module ? _module->name : L"<unknown>") << L")"
                 ;
         }
     }
@@ -185,7 +203,7 @@ namespace Drill4dotNet
     {
         try
         {
-            m_moduleInfos[id] = info;
+            m_moduleInfos.Emplace(id, info);
         }
         catch (const std::exception & ex)
         {
@@ -197,10 +215,10 @@ namespace Drill4dotNet
     {
         try
         {
-            if (const auto it = m_moduleInfos.find(id);
-                m_moduleInfos.end() != it)
+            if (const auto found = m_moduleInfos.Find(id);
+                found != nullptr)
             {
-                return it->second;
+                return *found;
             }
             else
             {
@@ -216,24 +234,24 @@ namespace Drill4dotNet
 
     void InfoHandler::OutputModuleInfo(const ModuleID id) const
     {
-        if (const auto _module = m_moduleInfos.find(id);
-            m_moduleInfos.end() != _module)
+        if (const auto _module = m_moduleInfos.Find(id);
+            nullptr != _module)
         {
-            const auto _assembly = m_assemblyInfos.find(_module->second.assemblyId);
+            const auto _assembly = m_assemblyInfos.Find(_module->assemblyId);
             Log()
-                << L"Module name: " << _module->second.name
-                << L", loaded by address: " << HexOutput(_module->second.baseLoadAddress)
-                << L", its assembly: " << _module->second.assemblyId
-                << L" (" << (m_assemblyInfos.end() != _assembly ? _assembly->second.name : L"<unknown>") << L")"
+                << L"Module name: " << _module->name
+                << L", loaded by address: " << HexOutput(_module->baseLoadAddress)
+                << L", its assembly: " << _module->assemblyId
+                << L" (" << (nullptr != _assembly ? _assembly->name : L"<unknown>") << L")"
                 ;
         }
     }
 
-    void InfoHandler::MapClassInfo(const ClassID id, const ClassInfo& info) noexcept
+    void InfoHandler::MapClassInfo(const ClassID id, const ClassInfoWithoutName& info) noexcept
     {
         try
         {
-            m_classInfos[id] = info;
+            m_classInfos.Emplace(id, info);
         }
         catch (const std::exception & ex)
         {
@@ -241,14 +259,14 @@ namespace Drill4dotNet
         }
     }
 
-    std::optional<ClassInfo> InfoHandler::TryGetClassInfo(const ClassID id) const noexcept
+    std::optional<ClassInfoWithoutName> InfoHandler::TryGetClassInfo(const ClassID id) const noexcept
     {
         try
         {
-            if (const auto it = m_classInfos.find(id);
-                m_classInfos.end() != it)
+            if (const auto found = m_classInfos.Find(id);
+                found != nullptr)
             {
-                return it->second;
+                return *found;
             }
             else
             {
@@ -264,14 +282,14 @@ namespace Drill4dotNet
 
     void InfoHandler::OutputClassInfo(const ClassID id) const
     {
-        if (const auto _class = m_classInfos.find(id);
-            m_classInfos.end() != _class)
+        if (const auto _class = m_classInfos.Find(id);
+            nullptr != _class)
         {
-            const auto _module = m_moduleInfos.find(_class->second.moduleId);
+            const auto _module = m_moduleInfos.Find(_class->moduleId);
             Log()
-                << L"Class/Type name: " << _class->second.name
-                << L", its module: " << _class->second.moduleId
-                << L" (" << (m_moduleInfos.end() != _module ? _module->second.name : L"<unknown>") << L")"
+                << L"Class/Type token: " << HexOutput(_class->typeDefToken)
+                << L", its module: " << _class->moduleId
+                << L" (" << (nullptr != _module ? _module->name : L"<unknown>") << L")"
                 ;
         }
     }
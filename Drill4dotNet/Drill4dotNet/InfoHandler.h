@@ -3,20 +3,17 @@
 #include "framework.h"
 #include <string>
 #include <optional>
-#include <unordered_map>
+#include <mutex>
 #include "LogBuffer.h"
 #include "CorDataStructures.h"
+#include "ConcurrentRegistry.h"
+#include "FunctionTable.h"
 #include <filesystem>
 
 namespace Drill4dotNet
 {
     extern std::filesystem::path s_Drill4dotNetLibFilePath;
 
-    struct FunctionRuntimeInfo
-    {
-        unsigned long callCount = 0UL;
-    };
-
     struct InjectionMetaData
     {
         mdAssembly  Assembly = 0;
@@ -24,22 +21,62 @@ namespace Drill4dotNet
         mdMethodDef Function = 0;
     };
 
-    using TAppDomainInfoMap = std::unordered_map<AppDomainID, AppDomainInfo>;
-    using TAssemblyInfoMap = std::unordered_map<AssemblyID, AssemblyInfo>;
-    using TModuleInfoMap = std::unordered_map<ModuleID, ModuleInfo>;
-    using TClassInfoMap = std::unordered_map<ClassID, ClassInfo>;
-    using TFunctionInfoMap = std::unordered_map<FunctionID, FunctionInfo>;
-    using TFunctionRuntimeInfoMap = std::unordered_map<FunctionID, FunctionRuntimeInfo>;
+    // The maps are written by the runtime callbacks, and read by
+    // the other callbacks, from many threads at once.
+    using TAppDomainInfoMap = ConcurrentRegistry<AppDomainID, AppDomainInfo>;
+    using TAssemblyInfoMap = ConcurrentRegistry<AssemblyID, AssemblyInfo>;
+    using TModuleInfoMap = ConcurrentRegistry<ModuleID, ModuleInfo>;
+    using TClassInfoMap = ConcurrentRegistry<ClassID, ClassInfoWithoutName>;
 
     class InfoHandler
     {
     public:
         explicit InfoHandler(std::wostream& log);
 
+        // Logs the counts of the functions, and the calls of the functions
+        // called. The names of the functions are logged, if resolved,
+        // see ResolveCalledFunctionNames(), the tokens otherwise.
         void OutputStatistics() const;
-        void MapFunctionInfo(const FunctionID id, const FunctionInfo& info) noexcept;
+
+        // Remembers the function without its name, and returns its index
+        // for CallCountAddress(), or std::nullopt if the function cannot be
+        // remembered.
+        std::optional<uint32_t> MapFunctionInfo(const FunctionID id, const FunctionInfoWithoutName& info) noexcept;
+
+        // Remembers the function with its name, already known by the
+        // caller, and returns its index for CallCountAddress(), or
+        // std::nullopt if the function cannot be remembered.
+        std::optional<uint32_t> MapFunctionInfo(const FunctionID id, const FunctionInfo& info) noexcept;
+
+        // Gets the data of the function. The names are empty,
+        // if not resolved yet.
         std::optional<FunctionInfo> TryGetFunctionInfo(const FunctionID id) const noexcept;
-        void FunctionCalled(const FunctionID id) noexcept;
+
+        // Resolves the names of the functions called, not resolved yet,
+        // for the statistics, in batches for each module.
+        // TResolveModule : see FunctionTable::ResolveNames.
+        // @param resolveModule : resolves the names of the given methods of the module.
+        template <typename TResolveModule>
+        void ResolveCalledFunctionNames(TResolveModule&& resolveModule)
+        {
+            m_functions.ResolveNames(
+                [this](const uint32_t index)
+                {
+                    return m_functions.RuntimeInfo(index).callCount.load(std::memory_order_relaxed) > 0;
+                },
+                std::forward<TResolveModule>(resolveModule));
+        }
+
+        // Gets the native address of the count of the calls of the function,
+        // which the instrumented code of the function adds its calls to, see
+        // MakeNativeCounter. The address does not change while the handler
+        // lives.
+        // @param index : the index given by MapFunctionInfo().
+        uintptr_t CallCountAddress(const uint32_t index) noexcept
+        {
+            return reinterpret_cast<uintptr_t>(&m_functions.RuntimeInfo(index).callCount);
+        }
+
         void MapAppDomainInfo(const AppDomainID id, const AppDomainInfo& info) noexcept;
         std::optional<AppDomainInfo> TryGetAppDomainInfo(const AppDomainID id) const noexcept;
         void OutputAppDomainInfo(const AppDomainID id) const;
@@ -49,8 +86,8 @@ namespace Drill4dotNet
         void MapModuleInfo(const ModuleID id, const ModuleInfo& info) noexcept;
         std::optional<ModuleInfo> TryGetModuleInfo(const ModuleID id) const noexcept;
         void OutputModuleInfo(const ModuleID id) const;
-        void MapClassInfo(const ClassID id, const ClassInfo& info) noexcept;
-        std::optional<ClassInfo> TryGetClassInfo(const ClassID id) const noexcept;
+        void MapClassInfo(const ClassID id, const ClassInfoWithoutName& info) noexcept;
+        std::optional<ClassInfoWithoutName> TryGetClassInfo(const ClassID id) const noexcept;
         void OutputClassInfo(const ClassID id) const;
         InjectionMetaData GetInjectionMetaData() const noexcept;
         void SetInjectionMetaData(const InjectionMetaData& injection) noexcept;
@@ -58,8 +95,7 @@ namespace Drill4dotNet
         using Logger = LogBuffer<std::wostream>;
         Logger Log() const;
         std::wostream& m_ostream;
-        TFunctionInfoMap m_functionInfos;
-        TFunctionRuntimeInfoMap m_functionCounts;
+        FunctionTable m_functions;
         TAppDomainInfoMap m_appDomainInfos;
         TAssemblyInfoMap m_assemblyInfos;
         TModuleInfoMap m_moduleInfos;
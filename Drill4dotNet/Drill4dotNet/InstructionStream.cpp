@@ -1,84 +1,563 @@
 #include "pch.h"
 #include "InstructionStream.h"
 
+#include <algorithm>
+#include <bit>
 #include <cassert>
-#include <numeric>
+#include <limits>
 
 namespace Drill4dotNet
 {
-    // If the given stream element is an instruction, returns
-    // its size with argument, in bytes. Returns 0 for label.
-    // @param position : instruction or label.
-    AbsoluteOffset InstructionSize(const StreamElement& position) noexcept
+    // For each value of OpCodeArgumentKind, the size of the
+    // binary representation of the argument, in bytes. For switch
+    // and phi, the size of the count before the items.
+    static constexpr std::array<uint8_t, OpCodeArgumentKindsCount> s_argumentSizes
     {
-        return std::visit(
-            [](const auto& instruction)
+        0, // InlineNone
+        sizeof(OpCodeArgumentType::InlineVar),
+        sizeof(OpCodeArgumentType::InlineI),
+        sizeof(OpCodeArgumentType::InlineR),
+        sizeof(LongJump::Offset), // InlineBrTarget
+        sizeof(OpCodeArgumentType::InlineI8),
+        sizeof(OpCodeArgumentType::InlineMethod),
+        sizeof(OpCodeArgumentType::InlineField),
+        sizeof(OpCodeArgumentType::InlineType),
+        sizeof(OpCodeArgumentType::InlineString),
+        sizeof(OpCodeArgumentType::InlineSig),
+        sizeof(OpCodeArgumentType::InlineRVA),
+        sizeof(OpCodeArgumentType::InlineTok),
+        sizeof(uint32_t), // InlineSwitch
+        sizeof(uint8_t), // InlinePhi
+        sizeof(OpCodeArgumentType::ShortInlineVar),
+        sizeof(OpCodeArgumentType::ShortInlineI),
+        sizeof(OpCodeArgumentType::ShortInlineR),
+        sizeof(ShortJump::Offset) // ShortInlineBrTarget
+    };
+
+    InstructionStream::InstructionStream(std::pmr::memory_resource* const resource)
+        : m_codes(resource),
+        m_kinds(resource),
+        m_operands(resource),
+        m_switchTargets(resource),
+        m_phiVariables(resource),
+        m_labels(resource),
+        m_index(resource),
+        m_labelPositions(resource)
+    {
+    }
+
+    InstructionStream::InstructionStream(std::initializer_list<StreamElement> elements)
+    {
+        for (const StreamElement& element : elements)
+        {
+            push_back(element);
+        }
+    }
+
+    InstructionStream::InstructionStream(const size_t count, const StreamElement& element)
+    {
+        insert(cend(), count, element);
+    }
+
+    AbsoluteOffset InstructionStream::SizeOf(const size_t instruction) const noexcept
+    {
+        const OpCodeArgumentKind kind { m_kinds[instruction] };
+        AbsoluteOffset result { m_codes[instruction].Size() + s_argumentSizes[static_cast<size_t>(kind)] };
+        if (kind == OpCodeArgumentKind::InlineSwitch)
+        {
+            result += std::bit_cast<PoolRange>(m_operands[instruction]).Count * sizeof(LongJump::Offset);
+        }
+        else if (kind == OpCodeArgumentKind::InlinePhi)
+        {
+            result += std::bit_cast<PoolRange>(m_operands[instruction]).Count * sizeof(OpCodeArgumentType::InlineVar);
+        }
+
+        return result;
+    }
+
+    OpCodeVariant InstructionStream::PooledInstructionAt(const size_t instruction) const
+    {
+        OpCodeVariant result { m_codes[instruction] };
+        const PoolRange range { std::bit_cast<PoolRange>(m_operands[instruction]) };
+        if (m_kinds[instruction] == OpCodeArgumentKind::InlineSwitch)
+        {
+            const auto first { m_switchTargets.cbegin() + range.First };
+            result.SetArgument(OpCodeArgumentType::InlineSwitch(first, first + range.Count));
+        }
+        else
+        {
+            const auto first { m_phiVariables.cbegin() + range.First };
+            result.SetArgument(OpCodeArgumentType::InlinePhi(first, first + range.Count));
+        }
+
+        result.m_kind = m_kinds[instruction];
+        return result;
+    }
+
+    void InstructionStream::AppendInstruction(
+        const InstructionCode code,
+        const OpCodeArgumentKind kind,
+        const Operand& operand)
+    {
+        m_codes.push_back(code);
+        m_kinds.push_back(kind);
+        m_operands.push_back(operand);
+        m_indexValid = false;
+    }
+
+    void InstructionStream::Store(const size_t instruction, const OpCodeVariant& value)
+    {
+        m_codes[instruction] = value.m_code;
+        m_kinds[instruction] = value.m_kind;
+        if (value.m_kind == OpCodeArgumentKind::InlineSwitch)
+        {
+            m_operands[instruction] = AppendToPool<LongJump>(m_switchTargets, *value.m_operand.Switch);
+        }
+        else if (value.m_kind == OpCodeArgumentKind::InlinePhi)
+        {
+            m_operands[instruction] = AppendToPool<OpCodeArgumentType::InlineVar>(m_phiVariables, *value.m_operand.Phi);
+        }
+        else
+        {
+            m_operands[instruction] = value.m_operand.Bytes;
+        }
+    }
+
+    bool InstructionStream::SameArgument(
+        const size_t instruction,
+        const InstructionStream& other,
+        const size_t otherInstruction) const noexcept
+    {
+        const auto equalItems = [](const auto& pool, const PoolRange range, const auto& otherPool, const PoolRange otherRange)
+        {
+            return std::equal(
+                pool.cbegin() + range.First,
+                pool.cbegin() + range.First + range.Count,
+                otherPool.cbegin() + otherRange.First,
+                otherPool.cbegin() + otherRange.First + otherRange.Count);
+        };
+
+        switch (m_kinds[instruction])
+        {
+        case OpCodeArgumentKind::InlineSwitch:
+            return equalItems(
+                m_switchTargets,
+                std::bit_cast<PoolRange>(m_operands[instruction]),
+                other.m_switchTargets,
+                std::bit_cast<PoolRange>(other.m_operands[otherInstruction]));
+        case OpCodeArgumentKind::InlinePhi:
+            return equalItems(
+                m_phiVariables,
+                std::bit_cast<PoolRange>(m_operands[instruction]),
+                other.m_phiVariables,
+                std::bit_cast<PoolRange>(other.m_operands[otherInstruction]));
+        default:
+            // The unused bytes are zero, see OpCodeVariant::SetArgument.
+            return m_operands[instruction] == other.m_operands[otherInstruction];
+        }
+    }
+
+    void InstructionStream::EnsureIndex() const
+    {
+        if (m_indexValid)
+        {
+            return;
+        }
+
+        // Linear time construction: each node passes
+        // its sum to the parent node.
+        m_index.assign(m_codes.size() + 1, AbsoluteOffset { 0 });
+        for (size_t i { 1 }; i < m_index.size(); ++i)
+        {
+            m_index[i] += SizeOf(i - 1);
+            const size_t parent { i + (i & (~i + 1)) };
+            if (parent < m_index.size())
+            {
+                m_index[parent] += m_index[i];
+            }
+        }
+
+        m_indexValid = true;
+    }
+
+    void InstructionStream::EnsureLabelPositions() const
+    {
+        if (m_labelPositionsValid)
+        {
+            return;
+        }
+
+        m_labelPositions.assign(m_labelPositions.size(), s_noLabel);
+        for (size_t i { 0 }; i != m_labels.size(); ++i)
+        {
+            const Label::Id id { m_labels[i].Value.GetId() };
+            if (id >= m_labelPositions.size())
             {
-                if constexpr (std::is_same_v<std::decay_t<decltype(instruction)>, OpCodeVariant>)
-                {
-                    return instruction.SizeWithArgument();
-                }
-
-                return AbsoluteOffset { 0 };
-            },
-            position);
-    }
-
-    // Walks the given part of instructions stream,
-    // until exactly the given amount of bytes is passed.
-    // Returns the reached position.
-    // @param start : the position where to start walk from
-    // @param end : points immediately after the last element to walk.
-    //     Returned if the position is not found.
-    // @param target : the offset to reach.
-    ConstStreamPosition ReachPositiveOffset(
-        const ConstStreamPosition start,
-        const ConstStreamPosition end,
-        const AbsoluteOffset target)
-    {
-        AbsoluteOffset distance { 0 };
-        return std::find_if(
-            start,
-            end,
-            [&distance, target](const StreamElement& instruction)
+                m_labelPositions.resize(size_t { id } + 1, s_noLabel);
+            }
+
+            // Keep the first occurrence, as the linear search would.
+            if (m_labelPositions[id] == s_noLabel)
             {
-                if (distance == target)
-                {
-                    return true;
-                }
+                m_labelPositions[id] = static_cast<uint32_t>(i);
+            }
+        }
 
-                distance += InstructionSize(instruction);
-                return false;
-            });
-    }
-
-    // Walks the given part of instructions stream, in reverse
-    // order, until exactly the given amount of bytes is passed.
-    // Returns the reached position.
-    // @param start : the position where to start walk from
-    // @param begin : points at the last element to walk.
-    // @param end : points immediately after the last element of
-    //     the instruction stream. Returned if the position is not found.
-    // @param target : the offset to reach. Must be negative.
-    ConstStreamPosition ReachNegativeOffset(
-        const ConstStreamPosition start,
-        const ConstStreamPosition begin,
-        const ConstStreamPosition end,
-        const LongJump::Offset target)
-    {
-        AbsoluteOffset distance { 0 };
-        ConstStreamPosition current { start };
-        while (current != begin)
-        {
-            --current;
-            distance -= InstructionSize(*current);
-            if (distance == target)
+        m_labelPositionsValid = true;
+    }
+
+    void InstructionStream::UpdateIndex(const size_t instruction, const AbsoluteOffset delta)
+    {
+        if (!m_indexValid)
+        {
+            return;
+        }
+
+        for (size_t i { instruction + 1 }; i < m_index.size(); i += i & (~i + 1))
+        {
+            m_index[i] += delta;
+        }
+    }
+
+    AbsoluteOffset InstructionStream::PrefixSum(size_t count) const
+    {
+        EnsureIndex();
+        AbsoluteOffset result { 0 };
+        for (; count != 0; count &= count - 1)
+        {
+            result += m_index[count];
+        }
+
+        return result;
+    }
+
+    size_t InstructionStream::CountInstructionsBelow(const AbsoluteOffset value) const
+    {
+        EnsureIndex();
+        size_t result { 0 };
+        AbsoluteOffset sum { 0 };
+        size_t step { 1 };
+        while (step * 2 < m_index.size())
+        {
+            step *= 2;
+        }
+
+        for (; step != 0; step /= 2)
+        {
+            const size_t next { result + step };
+            if (next < m_index.size() && sum + m_index[next] < value)
             {
-                return current;
+                result = next;
+                sum += m_index[next];
             }
         }
 
-        return end;
+        return result;
+    }
+
+    size_t InstructionStream::LabelsUpTo(const size_t instruction, const size_t knownLabels) const noexcept
+    {
+        return std::upper_bound(
+            m_labels.cbegin() + knownLabels,
+            m_labels.cend(),
+            instruction,
+            [](const size_t value, const LabelEntry& label)
+            {
+                return value < label.Instruction;
+            }) - m_labels.cbegin();
+    }
+
+    ConstStreamPosition InstructionStream::AtIndex(const size_t index) const noexcept
+    {
+        // The label i has index m_labels[i].Instruction + i,
+        // so the indices of the labels grow with i.
+        size_t low { 0 };
+        size_t high { m_labels.size() };
+        while (low != high)
+        {
+            const size_t middle { low + (high - low) / 2 };
+            if (m_labels[middle].Instruction + middle < index)
+            {
+                low = middle + 1;
+            }
+            else
+            {
+                high = middle;
+            }
+        }
+
+        return const_iterator { this, index - low, low };
+    }
+
+    void InstructionStream::reserve(const size_t capacity)
+    {
+        m_codes.reserve(capacity);
+        m_kinds.reserve(capacity);
+        m_operands.reserve(capacity);
+    }
+
+    void InstructionStream::InsertInstructions(
+        const size_t instruction,
+        const size_t label,
+        const size_t count,
+        const OpCodeVariant& value)
+    {
+        m_codes.insert(m_codes.cbegin() + instruction, count, InstructionCode {});
+        m_kinds.insert(m_kinds.cbegin() + instruction, count, OpCodeArgumentKind::InlineNone);
+        m_operands.insert(m_operands.cbegin() + instruction, count, Operand {});
+        for (size_t i { instruction }; i != instruction + count; ++i)
+        {
+            Store(i, value);
+        }
+
+        // The labels after the position now precede the
+        // instructions, which moved by count.
+        for (auto current { m_labels.begin() + label }; current != m_labels.end(); ++current)
+        {
+            current->Instruction += static_cast<uint32_t>(count);
+        }
+
+        m_indexValid = false;
+    }
+
+    void InstructionStream::Erase(const size_t instruction, const size_t label)
+    {
+        if (const_iterator { this, instruction, label }.IsLabel())
+        {
+            m_labels.erase(m_labels.cbegin() + label);
+            m_labelPositionsValid = false;
+            return;
+        }
+
+        m_codes.erase(m_codes.cbegin() + instruction);
+        m_kinds.erase(m_kinds.cbegin() + instruction);
+        m_operands.erase(m_operands.cbegin() + instruction);
+        for (auto current { m_labels.begin() + label }; current != m_labels.end(); ++current)
+        {
+            --current->Instruction;
+        }
+
+        m_indexValid = false;
+    }
+
+    ConstStreamPosition InstructionStream::insert(const const_iterator position, const StreamElement& element)
+    {
+        return insert(position, 1, element);
+    }
+
+    ConstStreamPosition InstructionStream::insert(
+        const const_iterator position,
+        const size_t count,
+        const StreamElement& element)
+    {
+        if (const Label* const label { std::get_if<Label>(&element) }
+            ; label != nullptr)
+        {
+            m_labels.insert(
+                m_labels.cbegin() + position.m_label,
+                count,
+                LabelEntry { static_cast<uint32_t>(position.m_instruction), *label });
+            m_labelPositionsValid = false;
+        }
+        else
+        {
+            InsertInstructions(position.m_instruction, position.m_label, count, std::get<OpCodeVariant>(element));
+        }
+
+        return const_iterator { this, position.m_instruction, position.m_label };
+    }
+
+    ConstStreamPosition InstructionStream::insert(
+        const const_iterator position,
+        std::initializer_list<StreamElement> elements)
+    {
+        const_iterator current { position };
+        for (const StreamElement& element : elements)
+        {
+            current = insert(current, element) + 1;
+        }
+
+        return const_iterator { this, position.m_instruction, position.m_label };
+    }
+
+    void InstructionStream::push_back(const StreamElement& element)
+    {
+        if (const Label* const label { std::get_if<Label>(&element) }
+            ; label != nullptr)
+        {
+            m_labels.push_back(LabelEntry { static_cast<uint32_t>(m_codes.size()), *label });
+            m_labelPositionsValid = false;
+            return;
+        }
+
+        m_codes.emplace_back();
+        m_kinds.emplace_back();
+        m_operands.emplace_back();
+        Store(m_codes.size() - 1, std::get<OpCodeVariant>(element));
+        m_indexValid = false;
+    }
+
+    void InstructionStream::AppendFrom(const const_iterator source)
+    {
+        assert(source.m_stream != this);
+        if (source.IsLabel())
+        {
+            m_labels.push_back(LabelEntry { static_cast<uint32_t>(m_codes.size()), source.GetLabel() });
+            m_labelPositionsValid = false;
+            return;
+        }
+
+        const InstructionStream& stream { *source.m_stream };
+        const size_t instruction { source.m_instruction };
+        switch (const OpCodeArgumentKind kind { stream.m_kinds[instruction] }; kind)
+        {
+        case OpCodeArgumentKind::InlineSwitch:
+            AppendSwitch(stream.m_codes[instruction], stream.ArgumentAt<OpCodeArgumentType::InlineSwitch>(instruction));
+            break;
+        case OpCodeArgumentKind::InlinePhi:
+            AppendPhi(stream.m_codes[instruction], stream.ArgumentAt<OpCodeArgumentType::InlinePhi>(instruction));
+            break;
+        default:
+            AppendInstruction(stream.m_codes[instruction], kind, stream.m_operands[instruction]);
+            break;
+        }
+    }
+
+    void InstructionStream::AppendSwitch(const InstructionCode code, const std::span<const LongJump> targets)
+    {
+        AppendInstruction(
+            code,
+            OpCodeArgumentKind::InlineSwitch,
+            AppendToPool(m_switchTargets, targets));
+    }
+
+    void InstructionStream::AppendPhi(const InstructionCode code, const std::span<const OpCodeArgumentType::InlineVar> variables)
+    {
+        AppendInstruction(
+            code,
+            OpCodeArgumentKind::InlinePhi,
+            AppendToPool(m_phiVariables, variables));
+    }
+
+    void InstructionStream::Replace(const const_iterator position, const StreamElement& element)
+    {
+        const bool isLabel { position.IsLabel() };
+        if (isLabel != std::holds_alternative<Label>(element))
+        {
+            Erase(position.m_instruction, position.m_label);
+            insert(const_iterator { this, position.m_instruction, position.m_label }, element);
+        }
+        else if (isLabel)
+        {
+            m_labels[position.m_label].Value = std::get<Label>(element);
+            m_labelPositionsValid = false;
+        }
+        else
+        {
+            const AbsoluteOffset oldSize { SizeOf(position.m_instruction) };
+            Store(position.m_instruction, std::get<OpCodeVariant>(element));
+            UpdateIndex(position.m_instruction, SizeOf(position.m_instruction) - oldSize);
+        }
+    }
+
+    AbsoluteOffset InstructionStream::OffsetOf(const const_iterator position) const
+    {
+        return PrefixSum(position.m_instruction);
+    }
+
+    AbsoluteOffset InstructionStream::OffsetAfter(const const_iterator position) const
+    {
+        return PrefixSum(std::min(position.m_instruction + 1, m_codes.size()));
+    }
+
+    ConstStreamPosition InstructionStream::FindOffset(const int64_t offset) const
+    {
+        if (offset < 0 || offset > std::numeric_limits<AbsoluteOffset>::max())
+        {
+            return cend();
+        }
+
+        const AbsoluteOffset target { static_cast<AbsoluteOffset>(offset) };
+        const size_t instruction { target == 0
+            ? 0
+            : CountInstructionsBelow(target) + 1 };
+
+        if (instruction > m_codes.size() || PrefixSum(instruction) != target)
+        {
+            return cend();
+        }
+
+        // The labels of the instruction are at the same offset, and go first.
+        const size_t label = std::lower_bound(
+            m_labels.cbegin(),
+            m_labels.cend(),
+            instruction,
+            [](const LabelEntry& label, const size_t value)
+            {
+                return label.Instruction < value;
+            }) - m_labels.cbegin();
+
+        return const_iterator { this, instruction, label };
+    }
+
+    ConstStreamPosition InstructionStream::FindLabel(const Label label) const
+    {
+        EnsureLabelPositions();
+        const Label::Id id { label.GetId() };
+        if (id >= m_labelPositions.size() || m_labelPositions[id] == s_noLabel)
+        {
+            return cend();
+        }
+
+        const size_t index { m_labelPositions[id] };
+        return const_iterator { this, m_labels[index].Instruction, index };
+    }
+
+    ConstStreamPosition InstructionStream::FindInstructionNumber(const size_t number) const noexcept
+    {
+        if (number >= m_codes.size())
+        {
+            return cend();
+        }
+
+        return const_iterator { this, number, LabelsUpTo(number) };
+    }
+
+    ConstStreamPosition InstructionStream::FindCode(
+        const const_iterator start,
+        const const_iterator end,
+        const InstructionCode code) const noexcept
+    {
+        const auto found { std::find(
+            m_codes.cbegin() + start.m_instruction,
+            m_codes.cbegin() + end.m_instruction,
+            code) };
+
+        if (found == m_codes.cbegin() + end.m_instruction)
+        {
+            return end;
+        }
+
+        const size_t instruction = found - m_codes.cbegin();
+        return const_iterator { this, instruction, LabelsUpTo(instruction, start.m_label) };
+    }
+
+    bool InstructionStream::operator==(const InstructionStream& other) const noexcept
+    {
+        if (m_codes != other.m_codes || m_kinds != other.m_kinds || m_labels != other.m_labels)
+        {
+            return false;
+        }
+
+        for (size_t i { 0 }; i != m_codes.size(); ++i)
+        {
+            if (!SameArgument(i, other, i))
+            {
+                return false;
+            }
+        }
+
+        return true;
     }
 
     ConstStreamPosition ResolveJumpOffset(
@@ -98,43 +577,28 @@ namespace Drill4dotNet
             return origin;
         }
 
-        ConstStreamPosition target;
-        const bool forward = offset > 0;
-        if (forward)
-        {
-            if (origin == stream.cend())
-            {
-                return stream.cend();
-            }
-
-            target = ReachPositiveOffset(
-                origin,
-                stream.cend(),
-                offset);
-        }
-        else
+        if (offset > 0 && origin == stream.cend())
         {
-            target = ReachNegativeOffset(
-                origin,
-                stream.cbegin(),
-                stream.cend(),
-                offset);
+            return stream.cend();
         }
 
-        return SkipLabels(target, stream.end());
+        const ConstStreamPosition target { stream.FindOffset(
+            int64_t { stream.OffsetOf(origin) } + offset) };
+
+        return SkipLabels(target, stream.cend());
     }
 
     ConstStreamPosition SkipLabels(
         const ConstStreamPosition startPoint,
         const ConstStreamPosition end)
     {
-        return std::find_if(
-            startPoint,
-            end,
-            [](const StreamElement& instructionOrLabel)
-            {
-                return std::holds_alternative<OpCodeVariant>(instructionOrLabel);
-            });
+        ConstStreamPosition result { startPoint };
+        while (result != end && result.IsLabel())
+        {
+            ++result;
+        }
+
+        return result;
     }
 
     ConstStreamPosition FindNextInstruction(
@@ -160,32 +624,12 @@ namespace Drill4dotNet
         const InstructionStream& stream,
         const AbsoluteOffset offset)
     {
-        return SkipLabels(
-            ReachPositiveOffset(
-                stream.cbegin(),
-                stream.cend(),
-                offset),
-            stream.cend());
+        return SkipLabels(stream.FindOffset(offset), stream.cend());
     }
 
     ConstStreamPosition GetNthInstruction(const InstructionStream& stream, const size_t number)
     {
-        ptrdiff_t instructions{ 0 };
-        return SkipLabels(
-            std::find_if(
-                stream.cbegin(),
-                stream.cend(),
-                [&instructions, number](const StreamElement& variant)
-                {
-                    const bool targetReached = instructions == number;
-                    if (!targetReached && std::holds_alternative<OpCodeVariant>(variant))
-                    {
-                        ++instructions;
-                    }
-
-                    return targetReached;
-                }),
-            stream.cend());
+        return stream.FindInstructionNumber(number);
     }
 
     // Calculates the distance, in bytes,
@@ -195,19 +639,12 @@ namespace Drill4dotNet
     // @param to : the first instruction not to count.
     //     Must be after from.
     AbsoluteOffset CalculateDistance(
+        const InstructionStream& stream,
         const ConstStreamPosition from,
         const ConstStreamPosition to)
     {
         assert(from <= to);
-
-        return std::accumulate(
-            from,
-            to,
-            AbsoluteOffset { 0 },
-            [](const AbsoluteOffset sum, const StreamElement& variant) noexcept
-            {
-                return sum + InstructionSize(variant);
-            });
+        return stream.OffsetOf(to) - stream.OffsetOf(from);
     }
 
     LongJump::Offset CalculateJumpOffset(
@@ -215,10 +652,7 @@ namespace Drill4dotNet
         const ConstStreamPosition from,
         const ConstStreamPosition to)
     {
-        const ConstStreamPosition origin = FindNextInstruction(from, stream.cend());
-        const int64_t result = origin > to
-            ? int64_t { -1 } * CalculateDistance(to, origin)
-            : CalculateDistance(origin, to);
+        const int64_t result { int64_t { stream.OffsetOf(to) } - int64_t { stream.OffsetAfter(from) } };
 
         if (!LongJump::CanSafelyStoreOffset(result))
         {
@@ -232,26 +666,14 @@ namespace Drill4dotNet
         const InstructionStream& instructionStream,
         const ConstStreamPosition to)
     {
-        return CalculateDistance(instructionStream.cbegin(), to);
+        return instructionStream.OffsetOf(to);
     }
 
     ConstStreamPosition FindLabel(
         const InstructionStream& stream,
         const Label label)
     {
-        return std::find_if(
-            stream.cbegin(),
-            stream.cend(),
-            [label](const auto& maybeLabel)
-            {
-                if (const Label* const candidate = std::get_if<Label>(&maybeLabel)
-                    ; candidate != nullptr)
-                {
-                    return *candidate == label;
-                }
-
-                return false;
-            });
+        return stream.FindLabel(label);
     }
 
     Label LabelCreator::CreateLabel() noexcept
@@ -1,6 +1,14 @@
 #pragma once
 
 #include "OpCodes.h"
+#include "OpCodeTable.h"
+
+#include <array>
+#include <compare>
+#include <iterator>
+#include <limits>
+#include <memory_resource>
+#include <span>
 
 namespace Drill4dotNet
 {
@@ -10,14 +18,735 @@ namespace Drill4dotNet
 
     // Instructions stream - sequence of opcodes, with added
     // labels before some of the opcodes.
-    using InstructionStream = std::vector<StreamElement>;
+    // Behaves like a read-only std::vector, which allows
+    // insertion of new elements and replacement of existing ones.
+    // The instructions are kept in parallel dense arrays of codes,
+    // argument kinds and 8-byte inline arguments. The jump tables of
+    // switch and the variables of phi are kept in shared pools, and
+    // the labels in a side table ordered by the instructions they
+    // precede. So scanning the codes touches 2 bytes per instruction,
+    // and the elements are made only when the iterator is dereferenced.
+    // Maintains an index of byte offsets, so positional queries take
+    // logarithmic time instead of walking the whole stream.
+    // All the memory is taken from the memory resource given at
+    // construction, which allows to keep a method being edited
+    // in an arena, see MethodArena.
+    class InstructionStream
+    {
+    public:
+        class const_iterator;
+
+    private:
+        using InstructionCode = OpCodeVariant::InstructionCode;
+
+        // The binary representation of an inline argument of up to 8 bytes,
+        // or the PoolRange of the argument of a switch or a phi.
+        using Operand = std::array<std::byte, sizeof(uint64_t)>;
+
+        // The place of the argument of a switch or a phi in its pool.
+        struct PoolRange
+        {
+            // The index of the first item in the pool.
+            uint32_t First;
+
+            // The count of the items.
+            uint32_t Count;
+        };
+
+        // A label, with the count of the instructions before it.
+        struct LabelEntry
+        {
+            // The index of the instruction the label precedes,
+            // the count of the instructions if the label is at the end.
+            uint32_t Instruction;
+
+            // The label.
+            Label Value;
+
+            // Compares with another entry.
+            // @param other : the entry to compare with.
+            bool operator==(const LabelEntry& other) const noexcept
+            {
+                return Instruction == other.Instruction && Value == other.Value;
+            }
+        };
+
+        // Marks a label id, which is not present in the stream.
+        inline static constexpr uint32_t s_noLabel { std::numeric_limits<uint32_t>::max() };
+
+        // The codes of the instructions.
+        std::pmr::vector<InstructionCode> m_codes;
+
+        // For each instruction, the kind of its inline argument.
+        std::pmr::vector<OpCodeArgumentKind> m_kinds;
+
+        // For each instruction, its inline argument.
+        std::pmr::vector<Operand> m_operands;
+
+        // The jump tables of the switch instructions. The tables of
+        // the replaced instructions stay until the stream is rebuilt.
+        std::pmr::vector<LongJump> m_switchTargets;
+
+        // The variables of the phi instructions. The variables of
+        // the replaced instructions stay until the stream is rebuilt.
+        std::pmr::vector<OpCodeArgumentType::InlineVar> m_phiVariables;
+
+        // The labels, ordered by the instructions they precede.
+        // The labels before the same instruction are in the stream order.
+        std::pmr::vector<LabelEntry> m_labels;
+
+        // Binary indexed (Fenwick) tree over the sizes of the
+        // instructions. The instruction i is stored at index i + 1.
+        // Rebuilt lazily after the set of instructions changes,
+        // so mutable to allow rebuilding from const queries.
+        mutable std::pmr::vector<AbsoluteOffset> m_index;
+
+        // For each label id, the index of the label in m_labels,
+        // or s_noLabel. Label ids are issued sequentially by
+        // LabelCreator, so a plain vector serves as the lookup table.
+        // Rebuilt lazily after the set of labels changes.
+        mutable std::pmr::vector<uint32_t> m_labelPositions;
+
+        // Indicates whether m_index corresponds to the instructions.
+        mutable bool m_indexValid { false };
+
+        // Indicates whether m_labelPositions corresponds to m_labels.
+        mutable bool m_labelPositionsValid { false };
+
+        // Gets the size of the instruction with the given index, in bytes.
+        // @param instruction : the index of the instruction.
+        AbsoluteOffset SizeOf(const size_t instruction) const noexcept;
+
+        // Makes the instruction with the given index.
+        // @param instruction : the index of the instruction.
+        OpCodeVariant InstructionAt(const size_t instruction) const
+        {
+            const OpCodeArgumentKind kind { m_kinds[instruction] };
+            if (kind == OpCodeArgumentKind::InlineSwitch || kind == OpCodeArgumentKind::InlinePhi)
+            {
+                return PooledInstructionAt(instruction);
+            }
+
+            OpCodeVariant result { m_codes[instruction] };
+            result.m_operand.Bytes = m_operands[instruction];
+            result.m_kind = kind;
+            return result;
+        }
+
+        // Gets the description of the instruction with the given index.
+        // @param instruction : the index of the instruction.
+        const OpCodeInfo& InfoAt(const size_t instruction) const noexcept
+        {
+            const InstructionCode code { m_codes[instruction] };
+            return code.IsOneByte()
+                ? FindOneByteOpCode(code.SecondByte)
+                : FindTwoByteOpCode(code.SecondByte);
+        }
+
+        // Gets the value indicating whether the instruction
+        // with the given index is of the given type.
+        // TOpCode : the opcode type to check for.
+        // @param instruction : the index of the instruction.
+        template <IsOpCode TOpCode>
+        bool HoldsAt(const size_t instruction) const noexcept
+        {
+            return m_codes[instruction] == OpCodeVariant::OpCodeInstruction<TOpCode>::Code;
+        }
+
+        // Gets the inline argument of the instruction with the given index.
+        // The argument of a switch or a phi is viewed in its pool.
+        // TArgument : the inline argument type, see OpCodeArgumentType.
+        // @param instruction : the index of the instruction.
+        template <typename TArgument>
+        auto ArgumentAt(const size_t instruction) const noexcept
+        {
+            if constexpr (std::is_same_v<TArgument, OpCodeArgumentType::InlineSwitch>)
+            {
+                const PoolRange range { std::bit_cast<PoolRange>(m_operands[instruction]) };
+                return std::span<const LongJump>(m_switchTargets.data() + range.First, range.Count);
+            }
+            else if constexpr (std::is_same_v<TArgument, OpCodeArgumentType::InlinePhi>)
+            {
+                const PoolRange range { std::bit_cast<PoolRange>(m_operands[instruction]) };
+                return std::span<const OpCodeArgumentType::InlineVar>(m_phiVariables.data() + range.First, range.Count);
+            }
+            else
+            {
+                std::array<std::byte, sizeof(TArgument)> bytes;
+                std::memcpy(bytes.data(), m_operands[instruction].data(), sizeof(TArgument));
+                return std::bit_cast<TArgument>(bytes);
+            }
+        }
+
+        // Calls the given visitor with the inline argument of the
+        // instruction with the given index, see ArgumentAt, or with
+        // std::monostate if the instruction has no argument.
+        // Returns the result of the visitor.
+        // @param instruction : the index of the instruction.
+        // @param visitor : the visitor to call.
+        template <typename TVisitor>
+        auto VisitArgumentAt(const size_t instruction, TVisitor&& visitor) const
+        {
+            switch (m_kinds[instruction])
+            {
+            case OpCodeArgumentKind::InlineVar:
+                return visitor(ArgumentAt<OpCodeArgumentType::InlineVar>(instruction));
+            case OpCodeArgumentKind::InlineI:
+                return visitor(ArgumentAt<OpCodeArgumentType::InlineI>(instruction));
+            case OpCodeArgumentKind::InlineR:
+                return visitor(ArgumentAt<OpCodeArgumentType::InlineR>(instruction));
+            case OpCodeArgumentKind::InlineBrTarget:
+                return visitor(ArgumentAt<OpCodeArgumentType::InlineBrTarget>(instruction));
+            case OpCodeArgumentKind::InlineI8:
+                return visitor(ArgumentAt<OpCodeArgumentType::InlineI8>(instruction));
+            case OpCodeArgumentKind::InlineMethod:
+                return visitor(ArgumentAt<OpCodeArgumentType::InlineMethod>(instruction));
+            case OpCodeArgumentKind::InlineField:
+                return visitor(ArgumentAt<OpCodeArgumentType::InlineField>(instruction));
+            case OpCodeArgumentKind::InlineType:
+                return visitor(ArgumentAt<OpCodeArgumentType::InlineType>(instruction));
+            case OpCodeArgumentKind::InlineString:
+                return visitor(ArgumentAt<OpCodeArgumentType::InlineString>(instruction));
+            case OpCodeArgumentKind::InlineSig:
+                return visitor(ArgumentAt<OpCodeArgumentType::InlineSig>(instruction));
+            case OpCodeArgumentKind::InlineRVA:
+                return visitor(ArgumentAt<OpCodeArgumentType::InlineRVA>(instruction));
+            case OpCodeArgumentKind::InlineTok:
+                return visitor(ArgumentAt<OpCodeArgumentType::InlineTok>(instruction));
+            case OpCodeArgumentKind::InlineSwitch:
+                return visitor(ArgumentAt<OpCodeArgumentType::InlineSwitch>(instruction));
+            case OpCodeArgumentKind::InlinePhi:
+                return visitor(ArgumentAt<OpCodeArgumentType::InlinePhi>(instruction));
+            case OpCodeArgumentKind::ShortInlineVar:
+                return visitor(ArgumentAt<OpCodeArgumentType::ShortInlineVar>(instruction));
+            case OpCodeArgumentKind::ShortInlineI:
+                return visitor(ArgumentAt<OpCodeArgumentType::ShortInlineI>(instruction));
+            case OpCodeArgumentKind::ShortInlineR:
+                return visitor(ArgumentAt<OpCodeArgumentType::ShortInlineR>(instruction));
+            case OpCodeArgumentKind::ShortInlineBrTarget:
+                return visitor(ArgumentAt<OpCodeArgumentType::ShortInlineBrTarget>(instruction));
+            default:
+                return visitor(std::monostate {});
+            }
+        }
+
+        // Makes the switch or phi instruction with the given index,
+        // copying its argument from the pool.
+        // @param instruction : the index of the instruction.
+        OpCodeVariant PooledInstructionAt(const size_t instruction) const;
+
+        // Appends the given items to the given pool.
+        // Returns the operand referring to the appended items.
+        // TItem : the type of the pool items.
+        // @param pool : the pool to append to.
+        // @param items : the items to append, must not be in the pool.
+        template <typename TItem>
+        static Operand AppendToPool(std::pmr::vector<TItem>& pool, const std::span<const TItem> items)
+        {
+            const PoolRange range { static_cast<uint32_t>(pool.size()), static_cast<uint32_t>(items.size()) };
+            pool.insert(pool.cend(), items.begin(), items.end());
+            return std::bit_cast<Operand>(range);
+        }
+
+        // Appends an instruction to the instruction arrays.
+        // @param code : the code of the instruction.
+        // @param kind : the kind of the inline argument.
+        // @param operand : the inline argument, or the range in the pool.
+        void AppendInstruction(
+            const InstructionCode code,
+            const OpCodeArgumentKind kind,
+            const Operand& operand);
+
+        // Stores the given instruction to the given index of
+        // the instruction arrays, which must already exist.
+        // @param instruction : the index of the instruction.
+        // @param value : the instruction to store.
+        void Store(const size_t instruction, const OpCodeVariant& value);
+
+        // Compares the arguments of the given instructions of this
+        // and the other stream, which have the same argument kind.
+        // @param instruction : the index of the instruction in this stream.
+        // @param other : the other stream.
+        // @param otherInstruction : the index of the instruction in the other stream.
+        bool SameArgument(
+            const size_t instruction,
+            const InstructionStream& other,
+            const size_t otherInstruction) const noexcept;
 
-    // Position in the instructions stream,
-    // which content can be modified.
-    using StreamPosition = InstructionStream::iterator;
+        // Builds m_index from scratch, if it is not valid.
+        void EnsureIndex() const;
 
-    // Position in the instructions stream,
-    // which content cannot be modified.
+        // Builds m_labelPositions from scratch, if it is not valid.
+        void EnsureLabelPositions() const;
+
+        // Adds the given value to the size of the given instruction.
+        // @param instruction : the index of the instruction.
+        // @param delta : the value to add. Uses unsigned wrap-around
+        //     to allow negative changes.
+        void UpdateIndex(const size_t instruction, const AbsoluteOffset delta);
+
+        // Gets the sum of the sizes of the first count instructions.
+        // @param count : the amount of instructions to sum.
+        AbsoluteOffset PrefixSum(size_t count) const;
+
+        // Gets the largest count of first instructions,
+        // which sum of sizes is less than the given value.
+        // @param value : the value to compare to.
+        size_t CountInstructionsBelow(const AbsoluteOffset value) const;
+
+        // Gets the count of the labels before the instruction
+        // with the given index, including the labels preceding it.
+        // @param instruction : the index of the instruction.
+        // @param knownLabels : the count of the labels known to
+        //     precede the instruction, to search after them.
+        size_t LabelsUpTo(const size_t instruction, const size_t knownLabels = 0) const noexcept;
+
+        // Inserts copies of the given instruction before
+        // the given position.
+        // @param instruction : the index of the instruction to insert before.
+        // @param label : the count of the labels before the position.
+        // @param count : the amount of copies.
+        // @param value : the instruction to copy.
+        void InsertInstructions(
+            const size_t instruction,
+            const size_t label,
+            const size_t count,
+            const OpCodeVariant& value);
+
+        // Removes the element at the given position.
+        // @param instruction : the count of the instructions before the element.
+        // @param label : the count of the labels before the element.
+        void Erase(const size_t instruction, const size_t label);
+
+        // Gets the first instruction with the given code
+        // in the given range, or end if there is no such.
+        // @param start : the first element of the range.
+        // @param end : the element after the range.
+        // @param code : the code to search for.
+        const_iterator FindCode(
+            const const_iterator start,
+            const const_iterator end,
+            const InstructionCode code) const noexcept;
+
+    public:
+        // Position in the stream. Refers to the stream and
+        // counts the instructions and the labels before the element,
+        // so the elements are made on each dereference.
+        class const_iterator
+        {
+        private:
+            // The stream, or nullptr for a default-constructed iterator.
+            const InstructionStream* m_stream { nullptr };
+
+            // The count of the instructions before the element.
+            size_t m_instruction { 0 };
+
+            // The count of the labels before the element.
+            size_t m_label { 0 };
+
+            // Creates the position with the given counts.
+            // @param stream : the stream of the position.
+            // @param instruction : the count of the instructions before.
+            // @param label : the count of the labels before.
+            const_iterator(
+                const InstructionStream* const stream,
+                const size_t instruction,
+                const size_t label) noexcept
+                : m_stream { stream },
+                m_instruction { instruction },
+                m_label { label }
+            {
+            }
+
+            // Gets the index of the element in the stream.
+            size_t Index() const noexcept
+            {
+                return m_instruction + m_label;
+            }
+
+            friend class InstructionStream;
+
+        public:
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type = StreamElement;
+            using difference_type = std::ptrdiff_t;
+            using reference = StreamElement;
+            using pointer = void;
+
+            const_iterator() noexcept = default;
+
+            // Gets the value indicating whether the position has a label.
+            // Cheaper than checking the element, which is made on each call.
+            bool IsLabel() const noexcept
+            {
+                return m_label < m_stream->m_labels.size()
+                    && m_stream->m_labels[m_label].Instruction == m_instruction;
+            }
+
+            // Gets the label at the position, which must have a label.
+            Label GetLabel() const noexcept
+            {
+                return m_stream->m_labels[m_label].Value;
+            }
+
+            // Gets the code of the instruction at the position,
+            // which must not have a label.
+            InstructionCode Code() const noexcept
+            {
+                return m_stream->m_codes[m_instruction];
+            }
+
+            // Gets the description of the instruction at the position,
+            // which must not have a label. Reads the code only.
+            const OpCodeInfo& Info() const noexcept
+            {
+                return m_stream->InfoAt(m_instruction);
+            }
+
+            // Gets the value indicating whether the instruction at
+            // the position, which must not have a label, is of the given type.
+            // TOpCode : the opcode type to check for.
+            template <IsOpCode TOpCode>
+            bool Holds() const noexcept
+            {
+                return m_stream->HoldsAt<TOpCode>(m_instruction);
+            }
+
+            // Gets the inline argument of the instruction at the position,
+            // which must have an argument of the given type. Unlike the
+            // element, the jump table of a switch and the variables of
+            // a phi are returned as a std::span viewing the pool of the
+            // stream, valid until the stream is changed.
+            // TArgument : the inline argument type, see OpCodeArgumentType.
+            template <typename TArgument>
+            auto Argument() const noexcept
+            {
+                return m_stream->ArgumentAt<TArgument>(m_instruction);
+            }
+
+            // Calls the given visitor with the inline argument of the
+            // instruction at the position, which must not have a label,
+            // or with std::monostate if the instruction has no argument.
+            // The arguments are passed as Argument returns them.
+            // Returns the result of the visitor.
+            // @param visitor : the visitor to call.
+            template <typename TVisitor>
+            auto VisitArgument(TVisitor&& visitor) const
+            {
+                return m_stream->VisitArgumentAt(m_instruction, std::forward<TVisitor>(visitor));
+            }
+
+            // Makes the element at the position.
+            StreamElement operator*() const
+            {
+                if (IsLabel())
+                {
+                    return m_stream->m_labels[m_label].Value;
+                }
+
+                return m_stream->InstructionAt(m_instruction);
+            }
+
+            // Makes the element at the given distance from the position.
+            // @param offset : the distance in elements.
+            StreamElement operator[](const difference_type offset) const
+            {
+                return *(*this + offset);
+            }
+
+            const_iterator& operator++() noexcept
+            {
+                if (IsLabel())
+                {
+                    ++m_label;
+                }
+                else
+                {
+                    ++m_instruction;
+                }
+
+                return *this;
+            }
+
+            const_iterator operator++(int) noexcept
+            {
+                const const_iterator result { *this };
+                ++*this;
+                return result;
+            }
+
+            const_iterator& operator--() noexcept
+            {
+                // The labels of an instruction precede it.
+                if (m_label != 0 && m_stream->m_labels[m_label - 1].Instruction == m_instruction)
+                {
+                    --m_label;
+                }
+                else
+                {
+                    --m_instruction;
+                }
+
+                return *this;
+            }
+
+            const_iterator operator--(int) noexcept
+            {
+                const const_iterator result { *this };
+                --*this;
+                return result;
+            }
+
+            const_iterator& operator+=(const difference_type offset) noexcept
+            {
+                // The usual step to the next element needs no search.
+                if (offset == 1)
+                {
+                    return ++*this;
+                }
+
+                return *this = m_stream->AtIndex(Index() + offset);
+            }
+
+            const_iterator& operator-=(const difference_type offset) noexcept
+            {
+                return *this += -offset;
+            }
+
+            const_iterator operator+(const difference_type offset) const noexcept
+            {
+                return const_iterator { *this } += offset;
+            }
+
+            friend const_iterator operator+(const difference_type offset, const const_iterator position) noexcept
+            {
+                return position + offset;
+            }
+
+            const_iterator operator-(const difference_type offset) const noexcept
+            {
+                return const_iterator { *this } -= offset;
+            }
+
+            difference_type operator-(const const_iterator other) const noexcept
+            {
+                return static_cast<difference_type>(Index()) - static_cast<difference_type>(other.Index());
+            }
+
+            bool operator==(const const_iterator other) const noexcept
+            {
+                return Index() == other.Index();
+            }
+
+            std::strong_ordering operator<=>(const const_iterator other) const noexcept
+            {
+                return Index() <=> other.Index();
+            }
+        };
+
+        using value_type = StreamElement;
+        using size_type = size_t;
+        using difference_type = std::ptrdiff_t;
+        using reference = StreamElement;
+        using const_reference = StreamElement;
+        using iterator = const_iterator;
+
+        // Creates an empty stream.
+        InstructionStream() = default;
+
+        // Creates an empty stream, which takes memory from the given resource.
+        // @param resource : the memory resource, must outlive the stream.
+        explicit InstructionStream(std::pmr::memory_resource* const resource);
+
+        // Creates a stream with the given elements.
+        // @param elements : the elements to store.
+        InstructionStream(std::initializer_list<StreamElement> elements);
+
+        // Creates a stream with the given amount of copies of an element.
+        // @param count : the amount of copies.
+        // @param element : the element to copy.
+        InstructionStream(const size_t count, const StreamElement& element);
+
+        // Gets the beginning of the stream.
+        const_iterator begin() const noexcept
+        {
+            return const_iterator { this, 0, 0 };
+        }
+
+        // Gets the ending of the stream.
+        const_iterator end() const noexcept
+        {
+            return const_iterator { this, m_codes.size(), m_labels.size() };
+        }
+
+        // Gets the beginning of the stream.
+        const_iterator cbegin() const noexcept
+        {
+            return begin();
+        }
+
+        // Gets the ending of the stream.
+        const_iterator cend() const noexcept
+        {
+            return end();
+        }
+
+        // Gets the count of instructions and labels.
+        size_t size() const noexcept
+        {
+            return m_codes.size() + m_labels.size();
+        }
+
+        // Gets the value indicating whether the stream has no elements.
+        bool empty() const noexcept
+        {
+            return size() == 0;
+        }
+
+        // Makes the element with the given index.
+        // @param index : the index of the element.
+        StreamElement operator[](const size_t index) const
+        {
+            return *AtIndex(index);
+        }
+
+        // Gets the position of the element with the given index.
+        // @param index : the index of the element, up to size().
+        const_iterator AtIndex(const size_t index) const noexcept;
+
+        // Gets the memory resource the stream takes memory from.
+        std::pmr::memory_resource* Resource() const noexcept
+        {
+            return m_codes.get_allocator().resource();
+        }
+
+        // Reserves memory for the given amount of instructions.
+        // @param capacity : the amount of instructions.
+        void reserve(const size_t capacity);
+
+        // Inserts the given element before the given position.
+        // Returns the position of the inserted element.
+        // @param position : the point at which to insert.
+        // @param element : the element to insert.
+        const_iterator insert(const const_iterator position, const StreamElement& element);
+
+        // Inserts the given amount of copies of an element before the given position.
+        // Returns the position of the first inserted element.
+        // @param position : the point at which to insert.
+        // @param count : the amount of copies.
+        // @param element : the element to copy.
+        const_iterator insert(
+            const const_iterator position,
+            const size_t count,
+            const StreamElement& element);
+
+        // Inserts the given elements before the given position.
+        // Returns the position of the first inserted element.
+        // @param position : the point at which to insert.
+        // @param elements : the elements to insert.
+        const_iterator insert(
+            const const_iterator position,
+            std::initializer_list<StreamElement> elements);
+
+        // Appends the given element to the end of the stream.
+        // @param element : the element to append.
+        void push_back(const StreamElement& element);
+
+        // Constructs a new element at the end of the stream.
+        // @param arguments : the arguments to construct the element from.
+        template <typename ... TArguments>
+        void emplace_back(TArguments&& ... arguments)
+        {
+            push_back(StreamElement(std::forward<TArguments>(arguments) ...));
+        }
+
+        // Appends a copy of the element at the given position
+        // of another stream, without making the element.
+        // @param source : the position of the element to copy.
+        void AppendFrom(const const_iterator source);
+
+        // Appends a switch instruction with the given jump table.
+        // @param code : the code of the instruction.
+        // @param targets : the jump table.
+        void AppendSwitch(const InstructionCode code, const std::span<const LongJump> targets);
+
+        // Appends a phi instruction with the given variables.
+        // @param code : the code of the instruction.
+        // @param variables : the variables.
+        void AppendPhi(const InstructionCode code, const std::span<const OpCodeArgumentType::InlineVar> variables);
+
+        // Replaces the element at the given position.
+        // Keeps the index up to date without rebuilding it,
+        // if an instruction is replaced with an instruction.
+        // @param position : the element to replace.
+        // @param element : the new value.
+        void Replace(const const_iterator position, const StreamElement& element);
+
+        // Gets the distance, in bytes, from the beginning
+        // of the stream to the given position.
+        // @param position : the position to calculate the distance to.
+        AbsoluteOffset OffsetOf(const const_iterator position) const;
+
+        // Gets the distance, in bytes, from the beginning of the stream
+        // to the end of the first instruction at or after the given
+        // position, which is where the jumps of the instruction count from.
+        // @param position : the position of the instruction or of its labels.
+        AbsoluteOffset OffsetAfter(const const_iterator position) const;
+
+        // Gets the count of instructions located before the given position.
+        // @param position : the position to count instructions before.
+        size_t InstructionsBefore(const const_iterator position) const noexcept
+        {
+            return position.m_instruction;
+        }
+
+        // Gets the first element, which is located exactly
+        // at the given distance from the beginning of the stream.
+        // The element can be a label.
+        // Returns cend(), if there is no such element.
+        // @param offset : the distance in bytes.
+        const_iterator FindOffset(const int64_t offset) const;
+
+        // Gets the position of the instruction with the given number.
+        // Returns cend(), if there is no such instruction.
+        // @param number : 0-based number of the instruction, labels are not counted.
+        const_iterator FindInstructionNumber(const size_t number) const noexcept;
+
+        // Returns the position of the given label.
+        // Returns cend(), if the label is not in the stream.
+        // @param label : the label to search for.
+        const_iterator FindLabel(const Label label) const;
+
+        // Searches for a specific instruction in the given range
+        // of the stream. Compares only the instruction codes.
+        // Returns end, if there is no such instruction.
+        // TOpCode : type of instruction to search for.
+        // @param start : the first element of the search range.
+        // @param end : the element after the search range.
+        template <IsOpCode TOpCode>
+        static const_iterator FindInstruction(const const_iterator start, const const_iterator end) noexcept
+        {
+            if (start == end)
+            {
+                return end;
+            }
+
+            return start.m_stream->FindCode(start, end, OpCodeVariant::OpCodeInstruction<TOpCode>::Code);
+        }
+
+        // Compares the elements of two streams.
+        // @param other : the stream to compare with.
+        bool operator==(const InstructionStream& other) const noexcept;
+
+        // Compares the elements of two streams.
+        // @param other : the stream to compare with.
+        bool operator!=(const InstructionStream& other) const noexcept
+        {
+            return !(*this == other);
+        }
+    };
+
+    // Position in the instructions stream.
     using ConstStreamPosition = InstructionStream::const_iterator;
 
     // Searches for a specific instruction in the
@@ -32,19 +761,7 @@ namespace Drill4dotNet
         const ConstStreamPosition start,
         const ConstStreamPosition end)
     {
-        return std::find_if(
-            start,
-            end,
-            [](const StreamElement& current)
-            {
-                if (const OpCodeVariant* instruction = std::get_if<OpCodeVariant>(&current)
-                    ; instruction != nullptr)
-                {
-                    return instruction->HoldsAlternative<TOpCode>();
-                }
-
-                return false;
-            });
+        return InstructionStream::FindInstruction<TOpCode>(start, end);
     }
 
     // Searches for an instruction in the given
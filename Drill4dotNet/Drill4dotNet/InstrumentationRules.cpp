@@ -0,0 +1,266 @@
+#include "pch.h"
+#include "InstrumentationRules.h"
+
+#include <algorithm>
+#include <cwctype>
+
+namespace Drill4dotNet
+{
+    // Checks whether the rule does not look at the names of the methods.
+    static bool IsNameIndependent(const InstrumentationRule& rule) noexcept
+    {
+        return rule.NamespacePrefix.empty()
+            && rule.ClassPattern.empty()
+            && rule.MethodPattern.empty();
+    }
+
+    // Decides which methods of a module or a class are instrumented,
+    // from the rules applying to some of the methods, see Add().
+    class ScopeDecision
+    {
+    private:
+        bool m_anyIncluded { false };
+        bool m_allIncluded { false };
+        bool m_anyExcluded { false };
+        bool m_allExcluded { false };
+
+    public:
+        // Takes the rule into account.
+        // @param rule : the rule applying to some of the methods.
+        // @param appliesToAll : whether the rule applies to all the methods.
+        void Add(const InstrumentationRule& rule, const bool appliesToAll) noexcept
+        {
+            if (rule.Include)
+            {
+                m_anyIncluded = true;
+                m_allIncluded = m_allIncluded || appliesToAll;
+            }
+            else
+            {
+                m_anyExcluded = true;
+                m_allExcluded = m_allExcluded || appliesToAll;
+            }
+        }
+
+        // Gets which methods are instrumented.
+        ModuleRules::Scope Scope() const noexcept
+        {
+            if (!m_anyIncluded || m_allExcluded)
+            {
+                return ModuleRules::Scope::None;
+            }
+
+            return m_allIncluded && !m_anyExcluded
+                ? ModuleRules::Scope::All
+                : ModuleRules::Scope::ByName;
+        }
+    };
+
+    std::vector<InstrumentationRule> RulesFromPackagesPrefixes(const std::vector<std::wstring>& packagesPrefixes)
+    {
+        std::vector<InstrumentationRule> result {};
+        result.reserve(packagesPrefixes.size());
+        for (const std::wstring& prefix : packagesPrefixes)
+        {
+            result.push_back(InstrumentationRule {
+                .Include = true,
+                .ModulePrefix = prefix });
+        }
+
+        return result;
+    }
+
+    bool MatchesPattern(const std::wstring_view text, const std::wstring_view pattern) noexcept
+    {
+        // On a mismatch, the last '*' takes one more character,
+        // and the matching restarts after it. The earlier '*'s
+        // need not be revisited, the last one can take more instead.
+        size_t textPosition { 0 };
+        size_t patternPosition { 0 };
+        size_t starPosition { std::wstring_view::npos };
+        size_t starTextPosition { 0 };
+        while (textPosition != text.size())
+        {
+            if (patternPosition != pattern.size() && pattern[patternPosition] == L'*')
+            {
+                starPosition = patternPosition++;
+                starTextPosition = textPosition;
+            }
+            else if (patternPosition != pattern.size()
+                && (pattern[patternPosition] == L'?' || pattern[patternPosition] == text[textPosition]))
+            {
+                ++textPosition;
+                ++patternPosition;
+            }
+            else if (starPosition != std::wstring_view::npos)
+            {
+                patternPosition = starPosition + 1;
+                textPosition = ++starTextPosition;
+            }
+            else
+            {
+                return false;
+            }
+        }
+
+        while (patternPosition != pattern.size() && pattern[patternPosition] == L'*')
+        {
+            ++patternPosition;
+        }
+
+        return patternPosition == pattern.size();
+    }
+
+    PrefixTrie::PrefixTrie(const bool ignoreCase)
+        : m_nodes(1),
+        m_ignoreCase { ignoreCase }
+    {
+    }
+
+    wchar_t PrefixTrie::Normalize(const wchar_t character) const noexcept
+    {
+        return m_ignoreCase
+            ? static_cast<wchar_t>(std::towlower(character))
+            : character;
+    }
+
+    uint32_t PrefixTrie::FindChild(const uint32_t node, const wchar_t character) const noexcept
+    {
+        const auto& children { m_nodes[node].Children };
+        const wchar_t key { Normalize(character) };
+        const auto child { std::lower_bound(
+            children.cbegin(),
+            children.cend(),
+            key,
+            [](const std::pair<wchar_t, uint32_t>& item, const wchar_t value)
+            {
+                return item.first < value;
+            }) };
+
+        return child != children.cend() && child->first == key
+            ? child->second
+            : 0;
+    }
+
+    void PrefixTrie::Insert(const std::wstring_view prefix, const size_t value)
+    {
+        uint32_t node { 0 };
+        for (const wchar_t character : prefix)
+        {
+            uint32_t child { FindChild(node, character) };
+            if (child == 0)
+            {
+                child = static_cast<uint32_t>(m_nodes.size());
+                m_nodes.emplace_back();
+                auto& children { m_nodes[node].Children };
+                const std::pair<wchar_t, uint32_t> item { Normalize(character), child };
+                children.insert(
+                    std::upper_bound(
+                        children.cbegin(),
+                        children.cend(),
+                        item,
+                        [](const std::pair<wchar_t, uint32_t>& left, const std::pair<wchar_t, uint32_t>& right)
+                        {
+                            return left.first < right.first;
+                        }),
+                    item);
+            }
+
+            node = child;
+        }
+
+        m_nodes[node].Values.push_back(value);
+    }
+
+    ModuleRules::ModuleRules(const Scope scope, std::vector<InstrumentationRule> rules)
+        : m_scope { scope },
+        m_rules { std::move(rules) },
+        m_namespaces { false }
+    {
+        for (size_t i = 0; i != m_rules.size(); ++i)
+        {
+            m_namespaces.Insert(m_rules[i].NamespacePrefix, i);
+        }
+    }
+
+    ModuleRules::Scope ModuleRules::ForClass(const std::wstring_view className) const
+    {
+        if (m_scope != Scope::ByName)
+        {
+            return m_scope;
+        }
+
+        ScopeDecision decision {};
+        m_namespaces.ForEachPrefixOf(
+            className,
+            [this, className, &decision](const size_t index)
+            {
+                const InstrumentationRule& rule { m_rules[index] };
+                if (rule.ClassPattern.empty() || MatchesPattern(className, rule.ClassPattern))
+                {
+                    decision.Add(rule, rule.MethodPattern.empty());
+                }
+            });
+
+        return decision.Scope();
+    }
+
+    bool ModuleRules::Matches(const std::wstring_view className, const std::wstring_view methodName) const
+    {
+        switch (m_scope)
+        {
+        case Scope::None:
+            return false;
+        case Scope::All:
+            return true;
+        default:
+            break;
+        }
+
+        bool included { false };
+        bool excluded { false };
+        m_namespaces.ForEachPrefixOf(
+            className,
+            [this, className, methodName, &included, &excluded](const size_t index)
+            {
+                const InstrumentationRule& rule { m_rules[index] };
+                bool& matched { rule.Include ? included : excluded };
+                matched = matched
+                    || ((rule.ClassPattern.empty() || MatchesPattern(className, rule.ClassPattern))
+                        && (rule.MethodPattern.empty() || MatchesPattern(methodName, rule.MethodPattern)));
+            });
+
+        return included && !excluded;
+    }
+
+    InstrumentationRules::InstrumentationRules(std::vector<InstrumentationRule> rules)
+        : m_rules { std::move(rules) },
+        m_modules { true }
+    {
+        for (size_t i = 0; i != m_rules.size(); ++i)
+        {
+            m_modules.Insert(m_rules[i].ModulePrefix, i);
+        }
+    }
+
+    ModuleRules InstrumentationRules::ForModule(const std::wstring_view moduleFileName) const
+    {
+        std::vector<InstrumentationRule> applying {};
+        ScopeDecision decision {};
+        m_modules.ForEachPrefixOf(
+            moduleFileName,
+            [this, &applying, &decision](const size_t index)
+            {
+                applying.push_back(m_rules[index]);
+                decision.Add(m_rules[index], IsNameIndependent(m_rules[index]));
+            });
+
+        const ModuleRules::Scope scope { decision.Scope() };
+        if (scope != ModuleRules::Scope::ByName)
+        {
+            applying.clear();
+        }
+
+        return ModuleRules { scope, std::move(applying) };
+    }
+}
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace Drill4dotNet
+{
+    // Chooses the methods to instrument, or to exclude from the
+    // instrumentation. A method matches the rule, if all parts of
+    // the rule match it. An empty part matches everything.
+    struct InstrumentationRule
+    {
+        // Whether the matching methods are instrumented, or excluded.
+        bool Include;
+
+        // The beginning of the module file name, case-insensitive.
+        std::wstring ModulePrefix;
+
+        // The beginning of the full class name, for example, "MyCompany.MyProduct.".
+        std::wstring NamespacePrefix;
+
+        // The pattern of the full class name: '*' matches
+        // any sequence of characters, '?' matches any character.
+        std::wstring ClassPattern;
+
+        // The pattern of the method name, see ClassPattern.
+        std::wstring MethodPattern;
+    };
+
+    // Creates the rules instrumenting all methods of the modules,
+    // the file names of which start with the given prefixes.
+    // @param packagesPrefixes : the prefixes from PackagesPrefixes.
+    std::vector<InstrumentationRule> RulesFromPackagesPrefixes(const std::vector<std::wstring>& packagesPrefixes);
+
+    // Checks whether the text matches the pattern:
+    // '*' matches any sequence of characters, '?' matches
+    // any character, other characters match themselves.
+    // Does not allocate memory. Takes the time proportional
+    // to the product of the lengths in the worst case.
+    // @param text : the text to check.
+    // @param pattern : the pattern to match.
+    bool MatchesPattern(const std::wstring_view text, const std::wstring_view pattern) noexcept;
+
+    // Keeps a set of strings, each with a value, to find all strings being
+    // the prefixes of a given text in the time linear in the length of the text.
+    class PrefixTrie
+    {
+    private:
+        // A node of the trie, represents the string spelled
+        // by the characters on the way from the root.
+        struct Node
+        {
+            // The characters leading to the children, and the
+            // indices of the children in m_nodes, sorted by the character.
+            std::vector<std::pair<wchar_t, uint32_t>> Children;
+
+            // The values of the strings ending at this node.
+            std::vector<size_t> Values;
+        };
+
+        // The nodes, the root is the first one.
+        std::vector<Node> m_nodes;
+
+        // Whether the characters are compared ignoring the case.
+        bool m_ignoreCase;
+
+        // Converts the character for comparison.
+        wchar_t Normalize(const wchar_t character) const noexcept;
+
+        // Gets the child of the given node by the character,
+        // or 0 if there is no such child.
+        uint32_t FindChild(const uint32_t node, const wchar_t character) const noexcept;
+
+    public:
+        // Creates an empty trie.
+        // @param ignoreCase : whether the characters are compared ignoring the case.
+        explicit PrefixTrie(const bool ignoreCase);
+
+        // Adds the string with the given value. The same
+        // string can be added several times with different values.
+        // @param prefix : the string to add.
+        // @param value : the value to find by the string.
+        void Insert(const std::wstring_view prefix, const size_t value);
+
+        // Calls the visitor with the value of each string being
+        // a prefix of the given text, including the empty string,
+        // in the order of the lengths of the strings.
+        // TVisitor : callable accepting size_t.
+        // @param text : the text to find the prefixes of.
+        // @param visitor : is called with the values found.
+        template <typename TVisitor>
+        void ForEachPrefixOf(const std::wstring_view text, TVisitor&& visitor) const
+        {
+            uint32_t node { 0 };
+            for (size_t i = 0; ; ++i)
+            {
+                for (const size_t value : m_nodes[node].Values)
+                {
+                    visitor(value);
+                }
+
+                if (i == text.size())
+                {
+                    return;
+                }
+
+                node = FindChild(node, text[i]);
+                if (node == 0)
+                {
+                    return;
+                }
+            }
+        }
+    };
+
+    // The instrumentation rules applying to the methods of one module,
+    // see InstrumentationRules::ForModule(). Most modules need no names
+    // of the methods to decide: either no method or every method of the
+    // module is instrumented.
+    class ModuleRules
+    {
+    public:
+        // Tells which methods of a module are instrumented.
+        enum class Scope
+        {
+            // No method of the module is instrumented.
+            None,
+
+            // All methods of the module are instrumented.
+            All,
+
+            // The methods are chosen by the class and method names.
+            ByName
+        };
+
+    private:
+        // Which methods are instrumented.
+        Scope m_scope;
+
+        // The rules checking the names, if the scope is ByName.
+        std::vector<InstrumentationRule> m_rules;
+
+        // The indices of m_rules by the namespace prefix.
+        PrefixTrie m_namespaces;
+
+    public:
+        // Creates the rules for a module.
+        // @param scope : which methods are instrumented.
+        // @param rules : the rules checking the names, if the scope is ByName.
+        ModuleRules(const Scope scope, std::vector<InstrumentationRule> rules);
+
+        // Gets which methods of the module are instrumented.
+        Scope GetScope() const noexcept
+        {
+            return m_scope;
+        }
+
+        // Gets which methods of the given class are instrumented.
+        // Is the same as the scope of the module, unless it is ByName.
+        // @param className : the full name of the class.
+        Scope ForClass(const std::wstring_view className) const;
+
+        // Checks whether the method with the given names is instrumented:
+        // matches an including rule, and matches no excluding rule.
+        // @param className : the full name of the class of the method.
+        // @param methodName : the name of the method.
+        bool Matches(const std::wstring_view className, const std::wstring_view methodName) const;
+    };
+
+    // The compiled instrumentation rules. Finds the rules applying
+    // to a module by a trie of the module prefixes, so the rules are
+    // checked once for each module, and the methods are checked by
+    // names only in the modules with the rules about the names.
+    // An excluding rule wins over an including one.
+    class InstrumentationRules
+    {
+    private:
+        // The rules.
+        std::vector<InstrumentationRule> m_rules;
+
+        // The indices of m_rules by the module prefix.
+        PrefixTrie m_modules;
+
+    public:
+        // Compiles the given rules.
+        // @param rules : the rules to compile.
+        explicit InstrumentationRules(std::vector<InstrumentationRule> rules);
+
+        // Gets the rules applying to the methods of the module.
+        // @param moduleFileName : the file name of the module, without the directory.
+        ModuleRules ForModule(const std::wstring_view moduleFileName) const;
+    };
+}
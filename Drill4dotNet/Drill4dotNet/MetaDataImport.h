@@ -235,6 +235,26 @@ namespace Drill4dotNet
             };
         }
 
+        // Gets the call to IMetaDataImport2::GetMethodSpecProps,
+        // which gets the generic method the specification instantiates.
+        // @param methodSpecificationToken : the token of the
+        //     instantiation of a generic method.
+        // @param parent : will be set to the mdMethodDef or
+        //     mdMemberRef token of the generic method.
+        auto GetMethodSpecificationParentCallable(
+            const mdMethodSpec methodSpecificationToken,
+            mdToken& parent) const
+        {
+            return [this, methodSpecificationToken, &parent]()
+            {
+                return m_metaDataImport->GetMethodSpecProps(
+                    methodSpecificationToken,
+                    &parent,
+                    nullptr,
+                    nullptr);
+            };
+        }
+
         // Returns copy of a function's signature.
         // @param signatureBytes : must point to the
         //     function's signature.
@@ -732,6 +752,43 @@ namespace Drill4dotNet
             return CopySignature(signatureBytes, signatureSize);
         }
 
+        // Gets the generic method, which the given method
+        // specification instantiates.
+        // Throws _com_error in case of errors.
+        // @param methodSpecificationToken : the token of the
+        //     instantiation of a generic method.
+        // @returns the mdMethodDef or mdMemberRef token of the generic method.
+        mdToken GetMethodSpecificationParent(const mdMethodSpec methodSpecificationToken) const
+        {
+            mdToken parent { mdTokenNil };
+            CallComOrThrow(
+                GetMethodSpecificationParentCallable(
+                    methodSpecificationToken,
+                    parent),
+                L"MetadataImport::GetMethodSpecificationParent: call to IMetadataImport2::GetMethodSpecProps failed.");
+            return parent;
+        }
+
+        // Gets the generic method, which the given method
+        // specification instantiates.
+        // Returns std::nullopt in case of errors.
+        // @param methodSpecificationToken : the token of the
+        //     instantiation of a generic method.
+        // @returns the mdMethodDef or mdMemberRef token of the generic method.
+        std::optional<mdToken> TryGetMethodSpecificationParent(const mdMethodSpec methodSpecificationToken) const
+        {
+            mdToken parent { mdTokenNil };
+            if (!this->TryCallCom(GetMethodSpecificationParentCallable(
+                    methodSpecificationToken,
+                    parent),
+                L"MetadataImport::TryGetMethodSpecificationParent: call to IMetadataImport2::GetMethodSpecProps failed."))
+            {
+                return std::nullopt;
+            }
+
+            return parent;
+        }
+
         // Gets the tokens of the types in the module.
         // Throws _com_error in case of an error.
         std::vector<mdTypeDef> EnumTypeDefinitions() const
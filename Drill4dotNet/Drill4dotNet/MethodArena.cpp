@@ -0,0 +1,50 @@
+#include "pch.h"
+#include "MethodArena.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace Drill4dotNet
+{
+    void* MethodArena::HeapResource::do_allocate(const size_t bytes, const size_t alignment)
+    {
+        void* const result { std::pmr::new_delete_resource()->allocate(bytes, alignment) };
+        ++m_allocationsCount;
+        m_allocatedBytes += bytes;
+        return result;
+    }
+
+    void MethodArena::HeapResource::do_deallocate(void* const pointer, const size_t bytes, const size_t alignment)
+    {
+        std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+    }
+
+    MethodArena::MethodArena(const size_t bufferSize)
+        : m_bufferSize { bufferSize },
+        m_buffer { std::make_unique<std::byte[]>(bufferSize) }
+    {
+        m_resource.emplace(m_buffer.get(), m_bufferSize, &m_heap);
+    }
+
+    MethodArena& MethodArena::ForCurrentThread()
+    {
+        thread_local MethodArena arena {};
+        return arena;
+    }
+
+    void MethodArena::Reset()
+    {
+        m_resource->release();
+        const size_t overflow { m_heap.AllocatedBytes() };
+        m_heap.ResetCounters();
+        if (overflow == 0 || m_bufferSize >= s_maxBufferSize)
+        {
+            return;
+        }
+
+        m_bufferSize = std::min(std::bit_ceil(m_bufferSize + overflow), s_maxBufferSize);
+        m_resource.reset();
+        m_buffer = std::make_unique<std::byte[]>(m_bufferSize);
+        m_resource.emplace(m_buffer.get(), m_bufferSize, &m_heap);
+    }
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+namespace Drill4dotNet
+{
+    // Memory for decoding, editing and compiling one method at a time.
+    // Allocations are taken sequentially from a single buffer and are
+    // only freed all together by Reset(), so processing a method does
+    // not go to the process heap, which is shared with the application.
+    // If a method does not fit, the rest is taken from the heap, and
+    // the buffer grows on the next Reset() to fit such methods.
+    // Not thread-safe: use ForCurrentThread() to get the instance
+    // of the calling thread.
+    class MethodArena
+    {
+    private:
+        // Allocates from the heap, counting the allocations
+        // done since the last reset of the counters.
+        class HeapResource final : public std::pmr::memory_resource
+        {
+        private:
+            // The amount of allocations since the last ResetCounters().
+            size_t m_allocationsCount { 0 };
+
+            // The amount of bytes allocated since the last ResetCounters().
+            size_t m_allocatedBytes { 0 };
+
+            void* do_allocate(const size_t bytes, const size_t alignment) override;
+
+            void do_deallocate(void* const pointer, const size_t bytes, const size_t alignment) override;
+
+            bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+            {
+                return this == &other;
+            }
+
+        public:
+            // Gets the amount of allocations since the last ResetCounters().
+            size_t AllocationsCount() const noexcept
+            {
+                return m_allocationsCount;
+            }
+
+            // Gets the amount of bytes allocated since the last ResetCounters().
+            size_t AllocatedBytes() const noexcept
+            {
+                return m_allocatedBytes;
+            }
+
+            // Sets the counters to zero.
+            void ResetCounters() noexcept
+            {
+                m_allocationsCount = 0;
+                m_allocatedBytes = 0;
+            }
+        };
+
+        // The buffer will not grow beyond this size, so a single
+        // huge method does not hold much memory for the thread lifetime.
+        inline static constexpr size_t s_maxBufferSize { 4 * 1024 * 1024 };
+
+        // The size of the buffer.
+        size_t m_bufferSize;
+
+        // The memory to take allocations from.
+        std::unique_ptr<std::byte[]> m_buffer;
+
+        // Provides memory, when the buffer is exhausted.
+        HeapResource m_heap {};
+
+        // Takes allocations from m_buffer.
+        // Recreated when the buffer grows.
+        std::optional<std::pmr::monotonic_buffer_resource> m_resource {};
+
+    public:
+        // The initial size of the buffer, enough
+        // for the most of methods.
+        inline static constexpr size_t DefaultBufferSize { 64 * 1024 };
+
+        // Creates a new arena.
+        // @param bufferSize : the initial size of the buffer, in bytes.
+        explicit MethodArena(const size_t bufferSize = DefaultBufferSize);
+
+        // The resource holds pointers to the buffer and to m_heap.
+        MethodArena(const MethodArena&) = delete;
+        MethodArena& operator=(const MethodArena&) = delete;
+
+        // Gets the arena of the calling thread.
+        static MethodArena& ForCurrentThread();
+
+        // Gets the resource to allocate memory from this arena.
+        // All objects using it must be destroyed before Reset().
+        std::pmr::memory_resource* Resource() noexcept
+        {
+            return &*m_resource;
+        }
+
+        // Frees all allocations at once. If the buffer was
+        // exhausted since the previous Reset(), grows it.
+        void Reset();
+
+        // Gets the size of the buffer, in bytes.
+        size_t BufferSize() const noexcept
+        {
+            return m_bufferSize;
+        }
+
+        // Gets the amount of allocations, which did not fit
+        // into the buffer since the last Reset(), and were taken
+        // from the heap.
+        size_t HeapAllocationsCount() const noexcept
+        {
+            return m_heap.AllocationsCount();
+        }
+    };
+
+    // Resets the arena of the calling thread when goes out of scope.
+    // Create it before the objects, which use the arena, so they are
+    // destroyed before the reset.
+    class MethodArenaScope
+    {
+    private:
+        // The arena to reset.
+        MethodArena& m_arena;
+
+    public:
+        // Starts using the arena of the calling thread.
+        MethodArenaScope()
+            : m_arena { MethodArena::ForCurrentThread() }
+        {
+        }
+
+        ~MethodArenaScope()
+        {
+            m_arena.Reset();
+        }
+
+        MethodArenaScope(const MethodArenaScope&) = delete;
+        MethodArenaScope& operator=(const MethodArenaScope&) = delete;
+
+        // Gets the resource to allocate memory from the arena.
+        std::pmr::memory_resource* Resource() noexcept
+        {
+            return m_arena.Resource();
+        }
+    };
+}
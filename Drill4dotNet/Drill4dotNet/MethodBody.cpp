@@ -1,211 +1,218 @@
 #include "pch.h"
 #include "MethodBody.h"
+#include "OpCodeTable.h"
 
-// The TARGET_* defines are only needed for <opinfo.cpp>
-#ifdef _M_AMD64
-#define TARGET_AMD64
-#else
-#define TARGET_X86
-#endif
-
-#include <opinfo.cpp>
-
-#ifdef _M_AMD64
-#undef TARGET_AMD64
-#else
-#undef TARGET_X86
-#endif
-
-#if defined(_DEBUG)
-
-// The <opinfo.cpp> requires this function to be defined, have to add a stub.
-static void DbgAssertDialog(const char* szFile, int iLine, const char* szExpr)
-{
-}
-
-#endif
+#include <algorithm>
+#include <array>
+#include <numeric>
+#include <span>
 
 namespace Drill4dotNet
 {
-    // Helps to convert OpArgsVal into values for MethodBody.
-    // Provides method AppendStream, which can be called from
-    // a macro for different inline argument types in an uniform way.
-    template <>
-    class MethodBody::ArgumentConverter<OpArgsVal>
+    // Decodes instructions from the method code bytes into
+    // an instructions stream, using the table of instruction
+    // descriptions generated from opcode.def.
+    class MethodBody::ArgumentConverter
     {
     public:
-        // Jump extracted from the opcode argument.
-        struct Jump
-        {
-            // The label associated with the jump.
-            Label Label;
-
-            // The offset of the jump, in bytes,
-            // relative to the instruction immediately after
-            // the branching instruction.
-            LongJump::Offset Offset;
-        };
-
         // The instructions stream to store parsed instructions.
         InstructionStream& Target;
 
         // The tool to emit new labels.
         LabelCreator& LabelCreator;
 
-        // For each position in Target, has corresponding vector
-        // of jumps from that position.
-        std::vector<std::vector<Jump>> JumpOffsets;
+        // For each byte offset from the beginning of the code,
+        // has the label of jumps to that offset. All jumps to
+        // the same offset share one label.
+        std::pmr::vector<std::optional<Label>> LabelsAtOffsets;
+
+        // The count of labels in LabelsAtOffsets.
+        size_t LabelsCount { 0 };
+
+        // For each instruction in Target, has the
+        // offset of the instruction, in bytes.
+        std::pmr::vector<AbsoluteOffset> InstructionOffsets;
 
     private:
-        // Adds a new Jump with the given offset to JumpOffsets.
+        // Reads the code bytes. Its position is the offset
+        // from the beginning of the code.
+        ByteReader m_reader;
+
+        // Reads the inline argument of the instruction with the
+        // given code, and appends the instruction to Target.
+        using ArgumentReader = void (ArgumentConverter::*)(OpCodeVariant::InstructionCode, OpCodeArgumentKind);
+
+        // Gets the label for the given jump, creating the
+        // label if it is the first jump to the target.
+        // Must be called after the whole branching instruction is read.
         // Returns a Jump to store in a branching instruction argument.
         // TJump : ShortJump or LongJump
-        // @param jumpOffset : the offset in bytes.
+        // @param jumpOffset : the offset in bytes, relative
+        //     to the instruction after the branching instruction.
         template <typename TJump>
         TJump CreateJump(const LongJump::Offset jumpOffset)
         {
-            const Label label { LabelCreator.CreateLabel() };
-            JumpOffsets.back().push_back( Jump { label, jumpOffset } );
-            return TJump { label };
-        }
+            const int64_t target { static_cast<int64_t>(m_reader.Position()) + jumpOffset };
+            if (target < 0 || target >= static_cast<int64_t>(LabelsAtOffsets.size()))
+            {
+                throw std::runtime_error("Could not find an instruction by the given jump offset.");
+            }
 
-    public:
+            std::optional<Label>& label { LabelsAtOffsets[static_cast<size_t>(target)] };
+            if (!label.has_value())
+            {
+                label = LabelCreator.CreateLabel();
+                ++LabelsCount;
+            }
 
-        // Creates a new converter with the given values.
-        ArgumentConverter(
-            InstructionStream& target,
-            Drill4dotNet::LabelCreator& labelCreator) noexcept
-            : Target { target },
-            LabelCreator { labelCreator }
-        {
+            return TJump { *label };
         }
 
-        // Appends the next instruction to the stream.
+        // Reads the inline argument of the given type,
+        // and appends the instruction with it to Target.
         // TArgument : the instruction's inline argument type.
-        // @param firstByte : the first byte of the instruction's code.
-        // @param secondByte : the second byte of the instruction's code.
-        // @param rawArgument : the value to construct the instruction's
-        //     inline argument from.
+        // @param code : the instruction code.
+        // @param kind : the kind of the inline argument.
         template <typename TArgument>
-        void AppendStream(
-            const std::byte firstByte,
-            const std::byte secondByte,
-            const OpArgsVal& rawArgument)
-        {
-            OpCodeVariant::InstructionCode code{ firstByte, secondByte };
-            OpCodeVariant::VariantType argument{};
-            JumpOffsets.emplace_back();
+        void AppendInstruction(const OpCodeVariant::InstructionCode code, const OpCodeArgumentKind kind)
+        {
             if constexpr (std::is_same_v<TArgument, OpCodeArgumentType::InlineNone>)
             {
-                argument = std::monostate{};
+                Target.emplace_back(OpCodeVariant(code));
             }
-            else if constexpr (
-                std::is_same_v<TArgument, OpCodeArgumentType::ShortInlineR>
-                || std::is_same_v<TArgument, OpCodeArgumentType::InlineR>)
+            else if constexpr (std::is_same_v<TArgument, OpCodeArgumentType::InlineSwitch>)
             {
-                argument = static_cast<TArgument>(rawArgument.r);
-            }
-            else if constexpr (
-                std::is_same_v<TArgument, OpCodeArgumentType::InlineI8>)
-            {
-                argument = static_cast<TArgument>(rawArgument.i8);
-            }
-            else if constexpr (
-                std::is_same_v<TArgument, OpCodeArgumentType::InlineSwitch>)
-            {
-                auto begin = static_cast<LongJump::Offset*>(rawArgument.switch_.targets);
-                auto count = rawArgument.switch_.count;
-                auto end = begin + count;
+                const uint32_t count { m_reader.Read<uint32_t>() };
+                if (m_reader.Remaining() / sizeof(LongJump::Offset) < count)
+                {
+                    throw std::runtime_error("Unexpected end of the input");
+                }
 
-                std::vector<LongJump> jumpTable{};
+                ByteReader offsets { m_reader.ReadBytes(count * sizeof(LongJump::Offset)) };
+                std::pmr::vector<LongJump> jumpTable { Target.Resource() };
                 jumpTable.reserve(count);
-                std::for_each(begin, end, [this, &jumpTable](LongJump::Offset offset)
-                    {
-                        jumpTable.push_back(CreateJump<LongJump>(offset));
-                    });
+                for (uint32_t i = 0; i != count; ++i)
+                {
+                    jumpTable.push_back(CreateJump<LongJump>(offsets.Read<LongJump::Offset>()));
+                }
 
-                argument = jumpTable;
+                Target.AppendSwitch(code, jumpTable);
             }
-            else if constexpr (
-                std::is_same_v<TArgument, OpCodeArgumentType::InlinePhi>)
+            else if constexpr (std::is_same_v<TArgument, OpCodeArgumentType::InlinePhi>)
             {
-                auto begin = (uint16_t*)(rawArgument.phi.vars);
-                auto end = begin + rawArgument.phi.count;
-                argument = std::vector<uint16_t>(begin, end);
-            }
-            else if constexpr (
-                std::is_same_v<TArgument, OpCodeArgumentType::ShortInlineBrTarget>)
-            {
-                const LongJump::Offset offset { static_cast<ShortJump::Offset>(
-                    rawArgument.i) };
-                argument = CreateJump<TArgument>(offset);
+                const uint8_t count { m_reader.Read<uint8_t>() };
+                std::pmr::vector<OpCodeArgumentType::InlineVar> variables { Target.Resource() };
+                variables.reserve(count);
+                for (uint8_t i = 0; i != count; ++i)
+                {
+                    variables.push_back(m_reader.Read<uint16_t>());
+                }
+
+                Target.AppendPhi(code, variables);
             }
-            else if constexpr (
-                std::is_same_v<TArgument, OpCodeArgumentType::InlineBrTarget>)
+            else if constexpr (std::is_same_v<TArgument, OpCodeArgumentType::ShortInlineBrTarget>
+                || std::is_same_v<TArgument, OpCodeArgumentType::InlineBrTarget>)
             {
-                argument = CreateJump<TArgument>(rawArgument.i);
+                const auto offset { m_reader.Read<typename TArgument::Offset>() };
+                Target.emplace_back(OpCodeVariant(code, kind, CreateJump<TArgument>(offset)));
             }
             else
             {
-                argument = static_cast<TArgument>(rawArgument.i);
+                Target.emplace_back(OpCodeVariant(code, kind, m_reader.Read<TArgument>()));
             }
+        }
+
+        // For each value of OpCodeArgumentKind, has
+        // the function to read the argument of that kind.
+        inline static constexpr std::array<ArgumentReader, OpCodeArgumentKindsCount> s_argumentReaders
+        {
+            &ArgumentConverter::AppendInstruction<OpCodeArgumentType::InlineNone>,
+            &ArgumentConverter::AppendInstruction<OpCodeArgumentType::InlineVar>,
+            &ArgumentConverter::AppendInstruction<OpCodeArgumentType::InlineI>,
+            &ArgumentConverter::AppendInstruction<OpCodeArgumentType::InlineR>,
+            &ArgumentConverter::AppendInstruction<OpCodeArgumentType::InlineBrTarget>,
+            &ArgumentConverter::AppendInstruction<OpCodeArgumentType::InlineI8>,
+            &ArgumentConverter::AppendInstruction<OpCodeArgumentType::InlineMethod>,
+            &ArgumentConverter::AppendInstruction<OpCodeArgumentType::InlineField>,
+            &ArgumentConverter::AppendInstruction<OpCodeArgumentType::InlineType>,
+            &ArgumentConverter::AppendInstruction<OpCodeArgumentType::InlineString>,
+            &ArgumentConverter::AppendInstruction<OpCodeArgumentType::InlineSig>,
+            &ArgumentConverter::AppendInstruction<OpCodeArgumentType::InlineRVA>,
+            &ArgumentConverter::AppendInstruction<OpCodeArgumentType::InlineTok>,
+            &ArgumentConverter::AppendInstruction<OpCodeArgumentType::InlineSwitch>,
+            &ArgumentConverter::AppendInstruction<OpCodeArgumentType::InlinePhi>,
+            &ArgumentConverter::AppendInstruction<OpCodeArgumentType::ShortInlineVar>,
+            &ArgumentConverter::AppendInstruction<OpCodeArgumentType::ShortInlineI>,
+            &ArgumentConverter::AppendInstruction<OpCodeArgumentType::ShortInlineR>,
+            &ArgumentConverter::AppendInstruction<OpCodeArgumentType::ShortInlineBrTarget>
+        };
 
-            Target.emplace_back(OpCodeVariant(code, argument));
+    public:
+
+        // Creates a new converter with the given values.
+        // @param target : the stream to store parsed instructions.
+        // @param labelCreator : the tool to emit new labels.
+        // @param code : the method code bytes.
+        ArgumentConverter(
+            InstructionStream& target,
+            Drill4dotNet::LabelCreator& labelCreator,
+            const std::span<const std::byte> code)
+            : Target { target },
+            LabelCreator { labelCreator },
+            LabelsAtOffsets(code.size(), target.Resource()),
+            InstructionOffsets(target.Resource()),
+            m_reader { code }
+        {
+        }
+
+        // Decodes all instructions of the code and appends them to Target.
+        // Throws std::runtime_error if the code is malformed.
+        void AppendAll()
+        {
+            while (m_reader.Remaining() != 0)
+            {
+                InstructionOffsets.push_back(static_cast<AbsoluteOffset>(m_reader.Position()));
+                OpCodeVariant::InstructionCode code { OneByteOpCodeMarker, m_reader.Read<std::byte>() };
+                const OpCodeInfo* info;
+                if (code.SecondByte == TwoByteOpCodePrefix)
+                {
+                    code = { TwoByteOpCodePrefix, m_reader.Read<std::byte>() };
+                    info = &FindTwoByteOpCode(code.SecondByte);
+                }
+                else
+                {
+                    info = &FindOneByteOpCode(code.SecondByte);
+                }
+
+                if (!info->IsDefined)
+                {
+                    throw std::runtime_error("Unknown Intermediate Language instruction");
+                }
+
+                (this->*s_argumentReaders[static_cast<size_t>(info->ArgumentKind)])(code, info->ArgumentKind);
+            }
         }
     };
 
-    MethodBody::MethodBody(const std::vector<std::byte>& bodyBytes)
-        : m_header(bodyBytes)
+    MethodBody::MethodBody(
+        const std::vector<std::byte>& bodyBytes,
+        std::pmr::memory_resource* const resource)
+        : m_header(bodyBytes),
+        m_stream(resource),
+        m_exceptionSections(resource),
+        m_pendingInsertions(resource),
+        m_pendingLabels(resource)
     {
-        // Uses
-        // const BYTE* OpInfo::fetch(const BYTE * instrPtr, OpArgsVal * args)
         if (bodyBytes.size() < size_t { m_header.CodeSize() } + m_header.Size())
         {
             throw std::runtime_error("Unexpected end of method body bytes.");
         }
 
-        OpInfo parser{};
-        const auto begin = reinterpret_cast<const BYTE*>(bodyBytes.data() + m_header.Size());
-        const auto end = begin + m_header.CodeSize();
-        auto currentInstruction{ begin };
-        ArgumentConverter<OpArgsVal> converter { m_stream, m_labelCreator };
-        while (currentInstruction < end)
-        {
-            OpArgsVal inlineArguments;
-            currentInstruction = parser.fetch(
-                currentInstruction,
-                &inlineArguments);
-            switch (parser.getOpcode())
-            {
-#define OPDEF_REAL_INSTRUCTION( \
-    canonicalName, \
-    stringName, \
-    stackPop, \
-    stackPush, \
-    inlineArgumentType, \
-    operationKind, \
-    codeLength, \
-    byte1, \
-    byte2, \
-    controlBehavior) \
-            case opcode_t:: ## canonicalName : \
-            { \
-                converter.AppendStream<OpCodeArgumentType :: ## inlineArgumentType >( \
-                    std::byte { byte1 }, \
-                    std::byte { byte2 }, \
-                    inlineArguments); \
-            } \
-\
-            break;
-#include "DefineOpCodesGeneratorSpecializations.h"
-#include <opcode.def>
-#include "UnDefineOpCodesGeneratorSpecializations.h"
-#undef OPDEF_REAL_INSTRUCTION
-
-            default:
-                throw std::runtime_error("Unknown Intermediate Language instruction");
-            }
-        }
+        ArgumentConverter converter {
+            m_stream,
+            m_labelCreator,
+            std::span<const std::byte> { bodyBytes.data() + m_header.Size(), m_header.CodeSize() } };
+        converter.AppendAll();
 
         if (m_header.HasExceptionsSections())
         {
@@ -214,141 +221,154 @@ namespace Drill4dotNet
             bool moreSections;
             do
             {
-                ExceptionsSection section(
+                const ExceptionsSection& section { m_exceptionSections.emplace_back(
                     sectionBeginning,
                     bodyBytes.cend(),
                     m_stream,
-                    m_labelCreator);
-                m_exceptionSections.push_back(section);
+                    m_labelCreator,
+                    resource) };
                 moreSections = section.HasMoreSections();
             } while (moreSections);
         }
 
-        size_t instructionsCounter { 0 };
-        for (const auto& jumpTable : converter.JumpOffsets)
+        if (converter.LabelsCount == 0)
         {
-            for (const auto jump : jumpTable)
+            return;
+        }
+
+        // Put each jump label right before the instruction it points
+        // to, after the labels of the exception clauses. The labels are
+        // kept aside of the instructions, so the instructions stay in place.
+        size_t labelsPlaced { 0 };
+        for (size_t i = 0; i != converter.InstructionOffsets.size(); ++i)
+        {
+            if (const std::optional<Label>& label { converter.LabelsAtOffsets[converter.InstructionOffsets[i]] }
+                ; label.has_value())
             {
-                auto insertAt { ResolveJumpOffset(
-                    m_stream,
-                    GetNthInstruction(m_stream, instructionsCounter),
-                    jump.Offset) };
+                m_stream.insert(m_stream.FindInstructionNumber(i), *label);
+                ++labelsPlaced;
+            }
+        }
 
-                if (insertAt == m_stream.cend())
-                {
-                    throw std::runtime_error("Could not find an instruction by the given jump offset.");
-                }
+        if (labelsPlaced != converter.LabelsCount)
+        {
+            throw std::runtime_error("Could not find an instruction by the given jump offset.");
+        }
+    }
 
-                m_stream.insert(insertAt, jump.Label);
+    size_t MethodBody::ComputeCompiledSize() const
+    {
+        size_t result { m_header.Size() + size_t { m_stream.OffsetOf(m_stream.cend()) } };
+        if (m_header.HasExceptionsSections())
+        {
+            result += PaddingToBoundary<4>(result);
+            for (const auto& section : m_exceptionSections)
+            {
+                result += section.Size();
             }
-
-            ++instructionsCounter;
         }
+
+        return result;
     }
 
     std::vector<std::byte> MethodBody::Compile() const
     {
-        std::vector<std::byte> result{};
-        result.reserve(m_header.Size() + m_header.CodeSize());
+        std::vector<std::byte> result(ComputeCompiledSize());
+        CompileInto(result);
+        return result;
+    }
+
+    void MethodBody::CompileInto(std::span<std::byte> target) const
+    {
+        if (m_editInProgress)
+        {
+            throw std::logic_error("Cannot compile the method while an edit is in progress");
+        }
 
-        m_header.AppendToBytes(result);
+        ByteWriter writer { target };
+        m_header.WriteToBytes(writer);
 
         for (ConstStreamPosition current = m_stream.cbegin(); current != m_stream.cend(); ++current)
         {
-            const StreamElement& variant{ *current };
-            if (const OpCodeVariant* instruction = std::get_if<OpCodeVariant>(&variant)
-                ; instruction != nullptr)
+            if (current.IsLabel())
             {
-                instruction->m_code.AppendToVector(result);
-                std::visit(
-                    [this, current, &result](const auto argument)
+                continue;
+            }
+
+            current.Code().WriteToBytes(writer);
+            current.VisitArgument(
+                [this, current, &writer](const auto& argument)
+                {
+                    using T = std::decay_t<decltype(argument)>;
+                    if constexpr (std::is_same_v<T, std::monostate>)
                     {
-                        using T = std::remove_cv_t<decltype(argument)>;
-                        if constexpr (std::is_same_v<T, std::monostate>)
-                        {
-                            return;
-                        }
-                        else if constexpr (std::is_same_v<T, OpCodeArgumentType::InlineSwitch>)
-                        {
-                            AppendAsBytes(result, static_cast<AbsoluteOffset>(argument.size()));
-                            for (const auto jump : argument)
-                            {
-                                auto labelPosition = FindLabel(m_stream, jump.Label());
-                                if (labelPosition == m_stream.cend())
-                                {
-                                    throw std::logic_error("Compilation failed: unresolved label.");
-                                }
-
-                                AppendAsBytes(
-                                    result,
-                                    CalculateJumpOffset(m_stream, current, labelPosition));
-                            }
-                        }
-                        else if constexpr (std::is_same_v<T, OpCodeArgumentType::InlinePhi>)
-                        {
-                            AppendAsBytes(result, static_cast<uint8_t>(argument.size()));
-                            for (const auto var : argument)
-                            {
-                                AppendAsBytes(result, var);
-                            }
-                        }
-                        else if constexpr (std::is_same_v<T, OpCodeArgumentType::ShortInlineBrTarget>)
+                        return;
+                    }
+                    else if constexpr (std::is_same_v<T, std::span<const LongJump>>)
+                    {
+                        writer.Write(static_cast<AbsoluteOffset>(argument.size()));
+                        for (const auto jump : argument)
                         {
-                            auto labelPosition = FindLabel(m_stream, argument.Label());
+                            auto labelPosition = FindLabel(m_stream, jump.Label());
                             if (labelPosition == m_stream.cend())
                             {
                                 throw std::logic_error("Compilation failed: unresolved label.");
                             }
 
-                            const LongJump::Offset offset = CalculateJumpOffset(m_stream, current, labelPosition);
-                            AppendAsBytes(
-                                result,
-                                static_cast<const ShortJump::Offset>(offset));
+                            writer.Write(CalculateJumpOffset(m_stream, current, labelPosition));
                         }
-                        else if constexpr (std::is_same_v<T, OpCodeArgumentType::InlineBrTarget>)
+                    }
+                    else if constexpr (std::is_same_v<T, std::span<const OpCodeArgumentType::InlineVar>>)
+                    {
+                        writer.Write(static_cast<uint8_t>(argument.size()));
+                        for (const auto var : argument)
                         {
-                            auto labelPosition = FindLabel(m_stream, argument.Label());
-                            if (labelPosition == m_stream.cend())
-                            {
-                                throw std::logic_error("Compilation failed: unresolved label.");
-                            }
-
-                            const LongJump::Offset offset = CalculateJumpOffset(m_stream, current, labelPosition);
-                            AppendAsBytes(
-                                result,
-                                offset);
+                            writer.Write(var);
                         }
-                        else
+                    }
+                    else if constexpr (std::is_same_v<T, OpCodeArgumentType::ShortInlineBrTarget>)
+                    {
+                        auto labelPosition = FindLabel(m_stream, argument.Label());
+                        if (labelPosition == m_stream.cend())
                         {
-                            AppendAsBytes(result, argument);
+                            throw std::logic_error("Compilation failed: unresolved label.");
                         }
-                    },
-                    instruction->m_argument);
-            }
+
+                        const LongJump::Offset offset = CalculateJumpOffset(m_stream, current, labelPosition);
+                        writer.Write(static_cast<const ShortJump::Offset>(offset));
+                    }
+                    else if constexpr (std::is_same_v<T, OpCodeArgumentType::InlineBrTarget>)
+                    {
+                        auto labelPosition = FindLabel(m_stream, argument.Label());
+                        if (labelPosition == m_stream.cend())
+                        {
+                            throw std::logic_error("Compilation failed: unresolved label.");
+                        }
+
+                        const LongJump::Offset offset = CalculateJumpOffset(m_stream, current, labelPosition);
+                        writer.Write(offset);
+                    }
+                    else
+                    {
+                        writer.Write(argument);
+                    }
+                });
         }
 
         if (m_header.HasExceptionsSections())
         {
-            const ptrdiff_t padding { AdvanceToBoundary<4>(result.cend(), result) };
-            for (size_t i = 0; i != padding; ++i)
-            {
-                result.push_back(std::byte { 0 });
-            }
-
+            writer.AlignTo<4>();
             for (const auto& section : m_exceptionSections)
             {
-                section.AppendToBytes(result);
+                section.WriteToBytes(writer);
             }
         }
-
-        return result;
     }
 
     void MethodBody::Insert(
         const ConstStreamPosition position,
         const OpCodeVariant opcode)
     {
-        // Dangerous: maxstack
         const int64_t newCodeSize = int64_t { m_header.CodeSize() } + opcode.SizeWithArgument();
         if (!m_header.IsValidCodeSize(newCodeSize))
         {
@@ -356,10 +376,86 @@ namespace Drill4dotNet
         }
 
         m_header.SetCodeSize(static_cast<AbsoluteOffset>(newCodeSize));
+        if (m_editInProgress)
+        {
+            m_pendingInsertions.push_back(PendingInsertion {
+                static_cast<size_t>(position - m_stream.cbegin()),
+                opcode });
+
+            return;
+        }
+
         m_stream.insert(position, opcode);
         TurnJumpsToLongIfNeeded();
     }
 
+    void MethodBody::BeginEdit()
+    {
+        if (m_editInProgress)
+        {
+            throw std::logic_error("An edit is already in progress");
+        }
+
+        m_editInProgress = true;
+    }
+
+    void MethodBody::CommitEdit()
+    {
+        if (!m_editInProgress)
+        {
+            throw std::logic_error("There is no edit in progress");
+        }
+
+        m_editInProgress = false;
+        if (m_pendingInsertions.empty())
+        {
+            return;
+        }
+
+        // Order the insertions by position, keeping the order of the
+        // insertions at the same position. Sorts the indices with
+        // std::sort, because std::stable_sort takes its buffer from
+        // the global heap instead of the memory resource.
+        std::pmr::vector<size_t> order(m_pendingInsertions.size(), m_stream.Resource());
+        std::iota(order.begin(), order.end(), size_t { 0 });
+        std::sort(
+            order.begin(),
+            order.end(),
+            [this](const size_t left, const size_t right)
+            {
+                const size_t leftPosition { m_pendingInsertions[left].Position };
+                const size_t rightPosition { m_pendingInsertions[right].Position };
+                return leftPosition != rightPosition
+                    ? leftPosition < rightPosition
+                    : left < right;
+            });
+
+        InstructionStream stream { m_stream.Resource() };
+        stream.reserve(m_stream.size() + m_pendingInsertions.size());
+        auto pending { order.cbegin() };
+        size_t i { 0 };
+        for (ConstStreamPosition current = m_stream.cbegin(); current != m_stream.cend(); ++current)
+        {
+            for (; pending != order.cend() && m_pendingInsertions[*pending].Position == i; ++pending)
+            {
+                stream.push_back(m_pendingInsertions[*pending].Element);
+            }
+
+            stream.AppendFrom(current);
+            ++i;
+        }
+
+        for (; pending != order.cend(); ++pending)
+        {
+            stream.push_back(m_pendingInsertions[*pending].Element);
+        }
+
+        m_stream = std::move(stream);
+        m_pendingInsertions.clear();
+        m_pendingLabels.clear();
+        TurnJumpsToLongIfNeeded();
+    }
+
     // Indicates that the instruction is not a
     // short branching instruction.
     using InstructionCannotMadeLong = void;
@@ -377,7 +473,24 @@ namespace Drill4dotNet
         using LongInstruction = InstructionCannotMadeLong;
     };
 
-    // Declare specializations for all short branching instructions we know
+    // Indicates that the instruction is not a
+    // long branching instruction.
+    using InstructionCannotMadeShort = void;
+
+    // Gets the short branching instruction corresponding to the
+    // given long branching instruction.
+    // TOpCode : instruction type.
+    template <typename TOpCode>
+    class ToShortBranchInstruction
+    {
+    public:
+        // The short branching instruction, or
+        // InstructionCannotMadeShort if TOpCode is not a long
+        // branching instruction.
+        using ShortInstruction = InstructionCannotMadeShort;
+    };
+
+    // Declare specializations for all short and long branching instructions we know
 
 #define DECLARE_TO_LONG_BRANCH_INSTRUCTION_SPECIALIZATION(longName) \
     template <> \
@@ -393,6 +506,13 @@ namespace Drill4dotNet
  \
    public: \
         using LongInstruction = OpCode::CEE_ ## longName; \
+    }; \
+\
+    template <> \
+    class ToShortBranchInstruction< OpCode::CEE_ ## longName> \
+    { \
+   public: \
+        using ShortInstruction = OpCode::CEE_ ## longName ## _S; \
     };
 
     DECLARE_TO_LONG_BRANCH_INSTRUCTION_SPECIALIZATION(BR)
@@ -437,11 +557,12 @@ namespace Drill4dotNet
 #include "UnDefineOpCodesGeneratorSpecializations.h"
 #undef OPDEF_REAL_INSTRUCTION
 
-    bool MethodBody::ConvertJumpInstructionToLongIfNeeded(const StreamPosition instructionPosition)
+    bool MethodBody::ConvertJumpInstructionToLongIfNeeded(const ConstStreamPosition instructionPosition)
     {
         bool result{ false };
 
-        if (const OpCodeVariant* const instruction = std::get_if<OpCodeVariant>(&*instructionPosition)
+        const StreamElement element { *instructionPosition };
+        if (const OpCodeVariant* const instruction = std::get_if<OpCodeVariant>(&element)
             ; instruction != nullptr)
         {
             instruction->Visit(
@@ -478,7 +599,7 @@ namespace Drill4dotNet
                         }
 
                         m_header.SetCodeSize(static_cast<AbsoluteOffset>(newCodeSize));
-                        *instructionPosition = newInstruction;
+                        m_stream.Replace(instructionPosition, newInstruction);
 
                         result = true;
                     }
@@ -490,17 +611,221 @@ namespace Drill4dotNet
 
     void MethodBody::TurnJumpsToLongIfNeeded()
     {
+        std::pmr::vector<size_t> shortJumps { m_stream.Resource() };
+        size_t i { 0 };
+        for (ConstStreamPosition current = m_stream.cbegin(); current != m_stream.cend(); ++current)
+        {
+            if (!current.IsLabel() && current.Info().ArgumentKind == OpCodeArgumentKind::ShortInlineBrTarget)
+            {
+                shortJumps.push_back(i);
+            }
+
+            ++i;
+        }
+
         bool jumpsUpdated;
         do
         {
             jumpsUpdated = false;
 
-            for (auto current = m_stream.begin(); current != m_stream.end(); ++current)
+            // Replacing an instruction does not move the elements,
+            // so the indices of the remaining short jumps stay valid.
+            const auto remaining = std::remove_if(
+                shortJumps.begin(),
+                shortJumps.end(),
+                [this, &jumpsUpdated](const size_t index)
+                {
+                    const bool converted { ConvertJumpInstructionToLongIfNeeded(m_stream.cbegin() + index) };
+                    jumpsUpdated |= converted;
+                    return converted;
+                });
+
+            shortJumps.erase(remaining, shortJumps.end());
+        }
+        while (jumpsUpdated);
+    }
+
+    // Gets the shortest instruction, which pushes the given constant onto the stack.
+    // @param value : the constant to push.
+    static OpCodeVariant ShortestLoadConstant(const int32_t value)
+    {
+        switch (value)
+        {
+        case -1: return OpCode::CEE_LDC_I4_M1{};
+        case 0: return OpCode::CEE_LDC_I4_0{};
+        case 1: return OpCode::CEE_LDC_I4_1{};
+        case 2: return OpCode::CEE_LDC_I4_2{};
+        case 3: return OpCode::CEE_LDC_I4_3{};
+        case 4: return OpCode::CEE_LDC_I4_4{};
+        case 5: return OpCode::CEE_LDC_I4_5{};
+        case 6: return OpCode::CEE_LDC_I4_6{};
+        case 7: return OpCode::CEE_LDC_I4_7{};
+        case 8: return OpCode::CEE_LDC_I4_8{};
+        }
+
+        if (!Overflows<OpCodeArgumentType::ShortInlineI>(value))
+        {
+            return OpCode::CEE_LDC_I4_S{ static_cast<OpCodeArgumentType::ShortInlineI>(value) };
+        }
+
+        return OpCode::CEE_LDC_I4{ value };
+    }
+
+    // Gets the shortest instruction, which accesses the
+    // local variable or the argument with the given index.
+    // TShort : the instruction with 1-byte index.
+    // TLong : the instruction with 2-byte index.
+    // TNumbered : the instructions with the index built into
+    //     the instruction code, for indices 0, 1, 2...
+    // @param index : the index of the variable or the argument.
+    template <typename TShort, typename TLong, typename ... TNumbered>
+    static OpCodeVariant ShortestVariableAccess(const OpCodeArgumentType::InlineVar index)
+    {
+        if (index < sizeof...(TNumbered))
+        {
+            const std::array<OpCodeVariant, sizeof...(TNumbered)> numbered { TNumbered{} ... };
+            return numbered[index];
+        }
+
+        if (!Overflows<OpCodeArgumentType::ShortInlineVar>(index))
+        {
+            return TShort{ static_cast<OpCodeArgumentType::ShortInlineVar>(index) };
+        }
+
+        return TLong{ index };
+    }
+
+    // Gets the shortest instruction doing the same as the given one.
+    // Branching instructions are returned as is, because their size
+    // depends on the other instructions.
+    // @param instruction : the instruction to shorten.
+    static OpCodeVariant ShortestOperandForm(const OpCodeVariant& instruction)
+    {
+        std::optional<OpCodeVariant> result{};
+        instruction.Visit([&result](const auto& opcode)
+            {
+                using T = std::decay_t<decltype(opcode)>;
+                if constexpr (std::is_same_v<T, OpCode::CEE_LDC_I4> || std::is_same_v<T, OpCode::CEE_LDC_I4_S>)
+                {
+                    result = ShortestLoadConstant(opcode.Argument());
+                }
+                else if constexpr (std::is_same_v<T, OpCode::CEE_LDLOC> || std::is_same_v<T, OpCode::CEE_LDLOC_S>)
+                {
+                    result = ShortestVariableAccess<
+                        OpCode::CEE_LDLOC_S,
+                        OpCode::CEE_LDLOC,
+                        OpCode::CEE_LDLOC_0,
+                        OpCode::CEE_LDLOC_1,
+                        OpCode::CEE_LDLOC_2,
+                        OpCode::CEE_LDLOC_3>(opcode.Argument());
+                }
+                else if constexpr (std::is_same_v<T, OpCode::CEE_STLOC> || std::is_same_v<T, OpCode::CEE_STLOC_S>)
+                {
+                    result = ShortestVariableAccess<
+                        OpCode::CEE_STLOC_S,
+                        OpCode::CEE_STLOC,
+                        OpCode::CEE_STLOC_0,
+                        OpCode::CEE_STLOC_1,
+                        OpCode::CEE_STLOC_2,
+                        OpCode::CEE_STLOC_3>(opcode.Argument());
+                }
+                else if constexpr (std::is_same_v<T, OpCode::CEE_LDARG> || std::is_same_v<T, OpCode::CEE_LDARG_S>)
+                {
+                    result = ShortestVariableAccess<
+                        OpCode::CEE_LDARG_S,
+                        OpCode::CEE_LDARG,
+                        OpCode::CEE_LDARG_0,
+                        OpCode::CEE_LDARG_1,
+                        OpCode::CEE_LDARG_2,
+                        OpCode::CEE_LDARG_3>(opcode.Argument());
+                }
+                else if constexpr (std::is_same_v<T, OpCode::CEE_STARG>)
+                {
+                    result = ShortestVariableAccess<OpCode::CEE_STARG_S, OpCode::CEE_STARG>(opcode.Argument());
+                }
+                else if constexpr (std::is_same_v<T, OpCode::CEE_LDLOCA>)
+                {
+                    result = ShortestVariableAccess<OpCode::CEE_LDLOCA_S, OpCode::CEE_LDLOCA>(opcode.Argument());
+                }
+                else if constexpr (std::is_same_v<T, OpCode::CEE_LDARGA>)
+                {
+                    result = ShortestVariableAccess<OpCode::CEE_LDARGA_S, OpCode::CEE_LDARGA>(opcode.Argument());
+                }
+            });
+
+        return result.value_or(instruction);
+    }
+
+    // If the given instruction is a long branching instruction,
+    // gets the corresponding short branching instruction.
+    // Returns std::nullopt otherwise.
+    // @param instruction : the instruction to convert.
+    static std::optional<OpCodeVariant> ToShortBranch(const OpCodeVariant& instruction)
+    {
+        std::optional<OpCodeVariant> result{};
+        instruction.Visit([&result](const auto& opcode)
+            {
+                using TShort = typename ToShortBranchInstruction<std::decay_t<decltype(opcode)>>::ShortInstruction;
+                if constexpr (!std::is_same_v<TShort, InstructionCannotMadeShort>)
+                {
+                    result = TShort(ShortJump(opcode.Argument().Label()));
+                }
+            });
+
+        return result;
+    }
+
+    AbsoluteOffset MethodBody::MinimizeSize()
+    {
+        if (m_editInProgress)
+        {
+            throw std::logic_error("Cannot minimize the method while an edit is in progress");
+        }
+
+        const AbsoluteOffset initialCodeSize { m_header.CodeSize() };
+        AbsoluteOffset codeSize { initialCodeSize };
+
+        // Start with all branches in the short form and let
+        // TurnJumpsToLongIfNeeded grow only the ones which
+        // do not fit. This gives the smallest code, because
+        // making a branch long never makes another jump shorter.
+        for (auto current = m_stream.cbegin(); current != m_stream.cend(); ++current)
+        {
+            // Only the instructions with a single inline
+            // argument have shorter forms.
+            if (current.IsLabel())
             {
-                jumpsUpdated |= ConvertJumpInstructionToLongIfNeeded(current);
+                continue;
+            }
+
+            const OpCodeArgumentKind kind { current.Info().ArgumentKind };
+            if (kind == OpCodeArgumentKind::InlineNone
+                || kind == OpCodeArgumentKind::InlineSwitch
+                || kind == OpCodeArgumentKind::InlinePhi)
+            {
+                continue;
+            }
+
+            const OpCodeVariant instruction { std::get<OpCodeVariant>(*current) };
+            const OpCodeVariant shortest { ToShortBranch(instruction).value_or(ShortestOperandForm(instruction)) };
+            const AbsoluteOffset oldSize { instruction.SizeWithArgument() };
+            const AbsoluteOffset newSize { shortest.SizeWithArgument() };
+            if (newSize < oldSize)
+            {
+                codeSize -= oldSize - newSize;
+                m_stream.Replace(current, shortest);
             }
         }
-        while (jumpsUpdated);
+
+        m_header.SetCodeSize(codeSize);
+        TurnJumpsToLongIfNeeded();
+        return initialCodeSize - m_header.CodeSize();
+    }
+
+    bool MethodBody::IsLabelMarked(const Label label) const
+    {
+        return FindLabel(m_stream, label) != m_stream.cend()
+            || (label.GetId() < m_pendingLabels.size() && m_pendingLabels[label.GetId()]);
     }
 
     Label MethodBody::CreateLabel()
@@ -512,12 +837,26 @@ namespace Drill4dotNet
         const ConstStreamPosition target,
         const Label label)
     {
-        const ConstStreamPosition existingLabelPosition { FindLabel(m_stream, label) };
-        if (existingLabelPosition != m_stream.cend())
+        if (IsLabelMarked(label))
         {
             throw std::logic_error("This label has already been marked");
         }
 
+        if (m_editInProgress)
+        {
+            if (label.GetId() >= m_pendingLabels.size())
+            {
+                m_pendingLabels.resize(label.GetId() + 1, false);
+            }
+
+            m_pendingLabels[label.GetId()] = true;
+            m_pendingInsertions.push_back(PendingInsertion {
+                static_cast<size_t>(target - m_stream.cbegin()),
+                label });
+
+            return;
+        }
+
         m_stream.insert(target, label);
         TurnJumpsToLongIfNeeded();
     }
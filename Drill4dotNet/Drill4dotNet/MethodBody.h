@@ -5,6 +5,8 @@
 #include "ExceptionsSection.h"
 #include "MethodHeader.h"
 
+#include <memory_resource>
+
 namespace Drill4dotNet
 {
     // Object representation of method body bytes.
@@ -12,6 +14,8 @@ namespace Drill4dotNet
     // Reference: ECMA-335, Common Language Infrastructure,
     // part II.25.4 Common Intermediate Language physical layout
     // https://www.ecma-international.org/publications/files/ECMA-ST/ECMA-335.pdf
+    // All the memory kept, including the arguments of switch and phi
+    // instructions, is taken from the memory resource given at construction.
     class MethodBody
     {
     private:
@@ -25,34 +29,114 @@ namespace Drill4dotNet
         LabelCreator m_labelCreator;
 
         // Sections with descriptions of try-catch and try-finally clauses.
-        std::vector<ExceptionsSection> m_exceptionSections;
+        std::pmr::vector<ExceptionsSection> m_exceptionSections;
+
+        // An instruction or a label, queued by Insert()
+        // or MarkLabel() while an edit is in progress.
+        struct PendingInsertion
+        {
+            // The index of the element of m_stream,
+            // before which to insert.
+            size_t Position;
+
+            // The instruction or label to insert.
+            StreamElement Element;
+        };
+
+        // Insertions queued since BeginEdit(), in the order of calls.
+        std::pmr::vector<PendingInsertion> m_pendingInsertions;
+
+        // For each label id, indicates whether the label
+        // is queued in m_pendingInsertions.
+        std::pmr::vector<bool> m_pendingLabels;
+
+        // Indicates whether BeginEdit() has been called,
+        // and CommitEdit() has not been called yet.
+        bool m_editInProgress { false };
 
-        // Specialized for .net's OpArgsVal to allow
-        // getting instruction arguments from it.
-        template <typename TOpArgsVal>
+        // Decodes instructions and their inline
+        // arguments from the method code bytes.
         class ArgumentConverter;
 
         // Converts to the long form all short branching instructions,
         // which jumps are too far to be stored in these short instructions.
+        // Converting an instruction only moves other targets further,
+        // so only the remaining short instructions are checked again,
+        // until none of them changes.
         void TurnJumpsToLongIfNeeded();
 
+        // Returns true if the given label is present in the
+        // instructions stream or queued for insertion.
+        // @param label : the label to look for.
+        bool IsLabelMarked(const Label label) const;
+
         // Helper function for TurnJumpsToLongIfNeeded().
         // If the given instructions stream position contains an instruction,
         // and the instruction is a short branching instruction,
         // and the jump in the instruction is too far to be stored in the instruction,
         // replaces the instruction with the long jump alternative.
         // Returns true if the instruction has been replaced.
-        bool ConvertJumpInstructionToLongIfNeeded(const StreamPosition instructionPosition);
+        bool ConvertJumpInstructionToLongIfNeeded(const ConstStreamPosition instructionPosition);
 
     public:
         // Creates the object representation of the method body.
         // @param bodyBytes : the bytes of method body.
-        explicit MethodBody(const std::vector<std::byte>& bodyBytes);
+        // @param resource : the memory resource to store the instructions,
+        //     labels and exception clauses. Must outlive the method body,
+        //     for example, MethodArena::Resource().
+        explicit MethodBody(
+            const std::vector<std::byte>& bodyBytes,
+            std::pmr::memory_resource* const resource = std::pmr::get_default_resource());
 
         // Makes a binary representation of the method body.
+        // Throws std::logic_error if an edit is in progress.
         std::vector<std::byte> Compile() const;
 
+        // Gets the size of the binary representation
+        // of the method body, in bytes.
+        size_t ComputeCompiledSize() const;
+
+        // Writes the binary representation of the method body to
+        // the beginning of the given buffer, which must have at least
+        // ComputeCompiledSize() bytes. Allows to compile directly into
+        // memory allocated by the runtime.
+        // Throws std::overflow_error if the buffer is too small.
+        // Throws std::logic_error if an edit is in progress.
+        // @param target : the buffer to write to.
+        void CompileInto(std::span<std::byte> target) const;
+
+        // Replaces instructions with their shortest equivalents:
+        // branching instructions get the short form if the jump fits,
+        // constants loads and accesses to local variables and arguments
+        // get the forms with a shorter or built-in argument.
+        // Returns the amount of bytes the code became shorter.
+        // Throws std::logic_error if an edit is in progress.
+        AbsoluteOffset MinimizeSize();
+
+        // Starts a batch of edits. Until CommitEdit() is called,
+        // Insert() and MarkLabel() only queue the changes, and the
+        // positions given to them refer to the instructions list
+        // as it was before BeginEdit(). Elements queued for the
+        // same position are inserted in the order of the calls.
+        void BeginEdit();
+
+        // Applies all the changes queued since BeginEdit() in one
+        // pass over the instructions list, then converts the short
+        // branching instructions, which jumps became too far, once.
+        void CommitEdit();
+
+        // Gets the value indicating whether BeginEdit() has been
+        // called, and CommitEdit() has not been called yet.
+        bool IsEditInProgress() const noexcept
+        {
+            return m_editInProgress;
+        }
+
         // Inserts the given instruction into the instructions list.
+        // If an edit is in progress, queues the insertion until CommitEdit().
+        // The header becomes fat, if the code does not fit the tiny one.
+        // The maximal evaluation stack depth is kept as is, use
+        // ComputeMaxStack() and SetMaxStack() after the edit.
         // @param position : the point at which to insert,
         //    must be in range [begin(), end()]
         // @param opcode : the instruction to insert.
@@ -60,12 +144,44 @@ namespace Drill4dotNet
             const ConstStreamPosition position,
             const OpCodeVariant opcode);
 
+        // The maximal amount of items on the evaluation stack,
+        // as the method header declares it.
+        uint16_t MaxStack() const noexcept
+        {
+            return m_header.MaxStack();
+        }
+
+        // Sets the maximal amount of items on the evaluation stack.
+        // The header becomes fat, if the amount does not fit the tiny one.
+        // @param maxStack : the amount of items.
+        void SetMaxStack(const uint16_t maxStack) noexcept
+        {
+            m_header.SetMaxStack(maxStack);
+        }
+
+        // The token of the local variables signature,
+        // std::nullopt if the method has no local variables.
+        std::optional<mdSignature> LocalVariables() const noexcept
+        {
+            return m_header.LocalVariables();
+        }
+
+        // Sets the token of the local variables signature.
+        // The header becomes fat. The signature must describe
+        // the existing local variables in the same order.
+        // @param localVariables : the token of the signature.
+        void SetLocalVariables(const mdSignature localVariables) noexcept
+        {
+            m_header.SetLocalVariables(localVariables);
+        }
+
         // Declares a new Label.
         // For each created label MarkLabel must be called exactly
         // 1 time to define the location the label points to.
         Label CreateLabel();
 
         // Defines where the given label points to.
+        // If an edit is in progress, queues the label until CommitEdit().
         // @param target : the position to which the label targets.
         // @param label : the label which has not been yet defined.
         void MarkLabel(
@@ -97,13 +213,13 @@ namespace Drill4dotNet
         }
 
         // Gets the information about try-catch and try-finally clauses for reading.
-        const std::vector<ExceptionsSection>& ExceptionSections() const& noexcept
+        const std::pmr::vector<ExceptionsSection>& ExceptionSections() const& noexcept
         {
             return m_exceptionSections;
         }
 
         // Gets the information about try-catch and try-finally clauses.
-        std::vector<ExceptionsSection> ExceptionSections() && noexcept
+        std::pmr::vector<ExceptionsSection> ExceptionSections() && noexcept
         {
             return std::move(m_exceptionSections);
         }
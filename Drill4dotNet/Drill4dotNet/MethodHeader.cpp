@@ -32,8 +32,8 @@ namespace Drill4dotNet
                 throw std::runtime_error("Unexpected method header end");
             }
 
-            const IMAGE_COR_ILMETHOD_FAT& fatHeader
-                = *reinterpret_cast<const IMAGE_COR_ILMETHOD_FAT*>(methodBody.data());
+            ByteReader reader { methodBody };
+            const auto fatHeader { reader.ReadRaw<IMAGE_COR_ILMETHOD_FAT>() };
             m_flags = fatHeader.Flags;
             m_headerSize = static_cast<uint8_t>(sizeof(uint32_t) * fatHeader.Size);
             m_maxStack = static_cast<uint16_t>(fatHeader.MaxStack);
@@ -42,42 +42,89 @@ namespace Drill4dotNet
                 ? std::optional<uint32_t>(std::nullopt)
                 : fatHeader.LocalVarSigTok;
 
+            if (m_headerSize < sizeof(fatHeader))
+            {
+                throw std::runtime_error("Fat method header is too small");
+            }
+
             if (methodBody.size() < m_headerSize)
             {
                 throw std::runtime_error("Unexpected method header end");
             }
 
-            m_fatHeaderRemainder.assign(
-                methodBody.cbegin() + sizeof(fatHeader),
-                methodBody.cbegin() + m_headerSize);
+            const auto remainder { reader.ReadBytes(m_headerSize - sizeof(fatHeader)) };
+            m_fatHeaderRemainder.assign(remainder.begin(), remainder.end());
         }
     }
 
     void MethodHeader::AppendToBytes(std::vector<std::byte>& target) const
     {
-        if (m_headerSize == sizeof(std::byte)) // Dangerous, need to recalculate header type
+        ByteWriter writer { target };
+        writer.Reserve(m_headerSize);
+        WriteToBytes(writer);
+    }
+
+    void MethodHeader::WriteToBytes(ByteWriter& target) const
+    {
+        if (IsTiny())
         { // tiny header
-            target.push_back(std::byte{ m_flags | m_codeSize << 2 });
+            target.Write(std::byte{ m_flags | m_codeSize << 2 });
         }
         else
         { // fat header
             IMAGE_COR_ILMETHOD_FAT header;
             header.Flags = m_flags;
-            header.Size = m_headerSize / sizeof(uint32_t); // Dangerous, assert m_headerSize / sizeof(int32_t) == 0
-            header.MaxStack = m_maxStack.value(); // Dangerous, may be std::nullopt
+            header.Size = m_headerSize / sizeof(uint32_t); // A whole count of dwords: read from the Size field, or set by PromoteToFat
+            header.MaxStack = m_maxStack.value();
             header.LocalVarSigTok = m_localVariables.has_value() ? *m_localVariables : 0;
-            header.CodeSize = m_codeSize; // Dangerous, need to recalculate m_codeSize
+            header.CodeSize = m_codeSize; // Set by SetCodeSize, which promotes the header if needed
 
-            AppendAsBytes(target, header);
-            std::copy(
-                m_fatHeaderRemainder.cbegin(),
-                m_fatHeaderRemainder.cend(),
-                std::back_inserter(target));
+            target.WriteRaw(header);
+            target.WriteBytes(m_fatHeaderRemainder);
         }
     }
 
+    void MethodHeader::PromoteToFat() noexcept
+    {
+        // A tiny header has neither additional flags,
+        // nor local variables, nor exception sections.
+        m_flags = CorILMethod_FatFormat;
+        m_headerSize = sizeof(IMAGE_COR_ILMETHOD_FAT);
+        m_maxStack = s_TinyHeaderMaxStack;
+    }
+
     void MethodHeader::SetCodeSize(const AbsoluteOffset codeSize) noexcept
     {
+        if (IsTiny() && codeSize > s_TinyHeaderMaxCodeSize)
+        {
+            PromoteToFat();
+        }
+
         m_codeSize = codeSize;
     }
+
+    void MethodHeader::SetMaxStack(const uint16_t maxStack) noexcept
+    {
+        if (IsTiny())
+        {
+            if (maxStack <= s_TinyHeaderMaxStack)
+            {
+                return;
+            }
+
+            PromoteToFat();
+        }
+
+        m_maxStack = maxStack;
+    }
+
+    void MethodHeader::SetLocalVariables(const mdSignature localVariables) noexcept
+    {
+        if (IsTiny())
+        {
+            PromoteToFat();
+        }
+
+        m_localVariables = localVariables;
+    }
 }
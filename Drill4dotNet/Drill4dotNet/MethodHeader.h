@@ -48,6 +48,16 @@ namespace Drill4dotNet
         // Identifies whether the method has additional data sections.
         inline static const uint16_t s_SectionsFlag{ CorILMethod_MoreSects };
 
+        // The longest instructions stream a tiny header can describe, in bytes.
+        inline static constexpr AbsoluteOffset s_TinyHeaderMaxCodeSize{ 0b00111111 };
+
+        // The evaluation stack depth a tiny header implies.
+        inline static constexpr uint16_t s_TinyHeaderMaxStack{ 8 };
+
+        // Turns a tiny header into the fat header
+        // describing the same method.
+        void PromoteToFat() noexcept;
+
     public:
         // Parses a method header from the given body bytes.
         // @param methodBody : contains method header, instructions stream,
@@ -58,6 +68,10 @@ namespace Drill4dotNet
         // @param target : the bytes vector to save data to.
         void AppendToBytes(std::vector<std::byte>& target) const;
 
+        // Serializes data from this header with the given writer.
+        // @param target : the writer to save data with.
+        void WriteToBytes(ByteWriter& target) const;
+
         // Gets the value indicating whether
         // there are one or more additional data
         // sections after the instructions stream.
@@ -66,6 +80,15 @@ namespace Drill4dotNet
             return (m_flags & s_SectionsFlag) != 0;
         }
 
+        // Gets the value indicating whether this is a tiny header,
+        // which cannot describe local variables, exception sections,
+        // instructions streams longer than 63 bytes, and the
+        // evaluation stack deeper than 8 items.
+        constexpr bool IsTiny() const noexcept
+        {
+            return m_headerSize == sizeof(std::byte);
+        }
+
         // Size of this header, in bytes.
         constexpr uint8_t Size() const noexcept
         {
@@ -79,8 +102,35 @@ namespace Drill4dotNet
         }
 
         // Sets the size of the instructions stream, in bytes.
+        // Turns a tiny header into a fat one, if the size
+        // does not fit the tiny header.
         void SetCodeSize(const AbsoluteOffset codeSize) noexcept;
 
+        // The maximal amount of items on the evaluation stack.
+        // A tiny header implies 8 items.
+        constexpr uint16_t MaxStack() const noexcept
+        {
+            return m_maxStack.value_or(s_TinyHeaderMaxStack);
+        }
+
+        // Sets the maximal amount of items on the evaluation stack.
+        // Turns a tiny header into a fat one, if the amount
+        // does not fit the tiny header.
+        void SetMaxStack(const uint16_t maxStack) noexcept;
+
+        // The token of the local variables signature,
+        // std::nullopt if the method has no local variables.
+        constexpr std::optional<mdSignature> LocalVariables() const noexcept
+        {
+            return m_localVariables;
+        }
+
+        // Sets the token of the local variables signature.
+        // Turns a tiny header into a fat one.
+        // @param localVariables : the token of a signature
+        //     describing all local variables of the method.
+        void SetLocalVariables(const mdSignature localVariables) noexcept;
+
         // Gets the value indicating whether
         // this header can store the given length of an
         // instructions stream.
@@ -0,0 +1,613 @@
+#include "pch.h"
+#include "MethodPatcher.h"
+#include "OpCodeTable.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace Drill4dotNet
+{
+    // Maximum size of a protected code block, which can be represented by a small header.
+    constexpr AbsoluteOffset s_MaxSmallClauseLength { std::numeric_limits<uint8_t>::max() };
+
+    // Maximum offset of a protected code block, which can be represented by a small header.
+    constexpr AbsoluteOffset s_MaxSmallClauseOffset { std::numeric_limits<uint16_t>::max() };
+
+    // Gets the code of the long branching instruction corresponding
+    // to the given short one. In ECMA-335, part III, the short forms
+    // br.s ... blt.un.s directly precede their long forms br ... blt.un
+    // in the same order, and leave.s follows leave.
+    // @param shortCode : the code of a one-byte short branching instruction.
+    static constexpr std::byte LongBranchCode(const std::byte shortCode) noexcept
+    {
+        constexpr std::byte leaveShort { 0xDE };
+        constexpr std::byte leave { 0xDD };
+        constexpr uint8_t distanceToLongForm { 0x38 - 0x2B };
+        return shortCode == leaveShort
+            ? leave
+            : std::byte { static_cast<uint8_t>(static_cast<uint8_t>(shortCode) + distanceToLongForm) };
+    }
+
+    // Checks LongBranchCode() agrees with opcode.def for
+    // every short branching instruction.
+    static constexpr bool LongBranchCodesMatchOpCodeTable() noexcept
+    {
+        for (size_t code { 0 }; code != OpCodeInfos[0].size(); ++code)
+        {
+            const OpCodeInfo& shortForm { OpCodeInfos[0][code] };
+            if (!shortForm.IsDefined || shortForm.ArgumentKind != OpCodeArgumentKind::ShortInlineBrTarget)
+            {
+                continue;
+            }
+
+            const OpCodeInfo& longForm { FindOneByteOpCode(LongBranchCode(std::byte { static_cast<uint8_t>(code) })) };
+            if (!longForm.IsDefined
+                || longForm.ArgumentKind != OpCodeArgumentKind::InlineBrTarget
+                || longForm.FlowBehavior != shortForm.FlowBehavior
+                || longForm.ItemsPoppedFromStack != shortForm.ItemsPoppedFromStack)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    static_assert(LongBranchCodesMatchOpCodeTable());
+
+    // The amount of bytes a short branching instruction grows
+    // by, when it gets the long form.
+    constexpr AbsoluteOffset s_LongFormGrowth { sizeof(LongJump::Offset) - sizeof(ShortJump::Offset) };
+
+    MethodPatcher::MethodPatcher(const std::vector<std::byte>& bodyBytes)
+        : m_body { bodyBytes },
+        m_header { bodyBytes }
+    {
+        if (bodyBytes.size() < size_t { m_header.CodeSize() } + m_header.Size())
+        {
+            throw std::runtime_error("Unexpected end of method body bytes.");
+        }
+
+        ScanCode();
+        if (m_header.HasExceptionsSections())
+        {
+            ReadSections();
+        }
+
+        ValidateTargets();
+    }
+
+    void MethodPatcher::ScanCode()
+    {
+        ByteReader reader { Code() };
+        while (reader.Remaining() != 0)
+        {
+            const AbsoluteOffset offset { static_cast<AbsoluteOffset>(reader.Position()) };
+            m_instructionOffsets.push_back(offset);
+            std::byte code { reader.Read<std::byte>() };
+            const OpCodeInfo* info;
+            if (code == TwoByteOpCodePrefix)
+            {
+                code = reader.Read<std::byte>();
+                info = &FindTwoByteOpCode(code);
+            }
+            else
+            {
+                info = &FindOneByteOpCode(code);
+            }
+
+            if (!info->IsDefined)
+            {
+                throw std::runtime_error("Unknown Intermediate Language instruction");
+            }
+
+            const uint8_t codeSize { static_cast<uint8_t>(reader.Position() - offset) };
+            switch (info->ArgumentKind)
+            {
+            case OpCodeArgumentKind::InlineSwitch:
+                reader.ReadBytes(size_t { reader.Read<uint32_t>() } * sizeof(LongJump::Offset));
+                break;
+            case OpCodeArgumentKind::InlinePhi:
+                reader.ReadBytes(size_t { reader.Read<uint8_t>() } * sizeof(uint16_t));
+                break;
+            default:
+                reader.ReadBytes(info->ArgumentSize);
+                break;
+            }
+
+            if (info->ArgumentKind == OpCodeArgumentKind::ShortInlineBrTarget
+                || info->ArgumentKind == OpCodeArgumentKind::InlineBrTarget
+                || info->ArgumentKind == OpCodeArgumentKind::InlineSwitch)
+            {
+                m_branches.push_back(BranchSite {
+                    offset,
+                    static_cast<AbsoluteOffset>(reader.Position() - offset),
+                    codeSize,
+                    info->ArgumentKind });
+            }
+        }
+    }
+
+    // Reads the clauses of an exception handling section.
+    // TSection : IMAGE_COR_ILMETHOD_SECT_SMALL or IMAGE_COR_ILMETHOD_SECT_FAT.
+    // TClause : the type of clauses stored in the section.
+    // @param reader : the reader positioned at the section header.
+    // @param clauses : the vector to add the clauses to.
+    template <typename TSection, typename TClause>
+    static void ReadPatcherClauses(
+        ByteReader& reader,
+        std::vector<IMAGE_COR_ILMETHOD_SECT_EH_CLAUSE_FAT>& clauses)
+    {
+        // same for SMALL and FAT, SMALL has padding for equal header sizes
+        constexpr size_t headerSize = sizeof(IMAGE_COR_ILMETHOD_SECT_FAT);
+        const TSection sectionHeader { reader.ReadRaw<TSection>() };
+        if (sectionHeader.DataSize < headerSize
+            || (sectionHeader.DataSize - headerSize) % sizeof(TClause) != 0)
+        {
+            throw std::runtime_error("Unexpected size of exception section: it does not hold a whole number of exception clauses");
+        }
+
+        const size_t clausesCount { (sectionHeader.DataSize - headerSize) / sizeof(TClause) };
+        reader.ReadBytes(headerSize - sizeof(TSection));
+        clauses.reserve(clausesCount);
+        for (size_t i = 0; i != clausesCount; ++i)
+        {
+            const TClause clause { reader.ReadRaw<TClause>() };
+            IMAGE_COR_ILMETHOD_SECT_EH_CLAUSE_FAT fatClause {};
+            fatClause.Flags = static_cast<CorExceptionFlag>(clause.Flags);
+            fatClause.TryOffset = clause.TryOffset;
+            fatClause.TryLength = clause.TryLength;
+            fatClause.HandlerOffset = clause.HandlerOffset;
+            fatClause.HandlerLength = clause.HandlerLength;
+            fatClause.ClassToken = clause.ClassToken;
+            clauses.push_back(fatClause);
+        }
+    }
+
+    void MethodPatcher::ReadSections()
+    {
+        const size_t codeEnd { size_t { m_header.Size() } + m_header.CodeSize() };
+        const size_t sectionsBeginning { codeEnd + PaddingToBoundary<4>(codeEnd) };
+        if (sectionsBeginning > m_body.size())
+        {
+            throw std::runtime_error("Unexpected end of the input: no exception section header provided");
+        }
+
+        ByteReader reader { m_body.subspan(sectionsBeginning) };
+        bool moreSections;
+        do
+        {
+            const std::byte firstByte { reader.Peek() };
+            if ((firstByte & std::byte { CorILMethodSect::CorILMethod_Sect_EHTable }) == std::byte { 0 })
+            {
+                throw std::runtime_error("The data section is not an exception handling section");
+            }
+
+            Section& section { m_sections.emplace_back() };
+            section.Fat = (firstByte & std::byte { CorILMethodSect::CorILMethod_Sect_FatFormat }) != std::byte { 0 };
+            section.HasMoreSections = (firstByte & std::byte { CorILMethodSect::CorILMethod_Sect_MoreSects }) != std::byte { 0 };
+            if (section.Fat)
+            {
+                ReadPatcherClauses<IMAGE_COR_ILMETHOD_SECT_FAT, IMAGE_COR_ILMETHOD_SECT_EH_CLAUSE_FAT>(
+                    reader,
+                    section.Clauses);
+            }
+            else
+            {
+                ReadPatcherClauses<IMAGE_COR_ILMETHOD_SECT_SMALL, IMAGE_COR_ILMETHOD_SECT_EH_CLAUSE_SMALL>(
+                    reader,
+                    section.Clauses);
+            }
+
+            moreSections = section.HasMoreSections;
+        } while (moreSections);
+    }
+
+    bool MethodPatcher::IsInstructionBoundary(const AbsoluteOffset offset) const
+    {
+        return std::binary_search(m_instructionOffsets.cbegin(), m_instructionOffsets.cend(), offset);
+    }
+
+    void MethodPatcher::ValidateTargets() const
+    {
+        const std::span<const std::byte> code { Code() };
+        for (const BranchSite& site : m_branches)
+        {
+            ByteReader reader { code.subspan(site.Offset + site.CodeSize) };
+            const size_t targetsCount { site.ArgumentKind == OpCodeArgumentKind::InlineSwitch
+                ? reader.Read<uint32_t>()
+                : 1 };
+            for (size_t i = 0; i != targetsCount; ++i)
+            {
+                const int64_t jump { site.ArgumentKind == OpCodeArgumentKind::ShortInlineBrTarget
+                    ? reader.Read<ShortJump::Offset>()
+                    : reader.Read<LongJump::Offset>() };
+                const int64_t target { int64_t { site.Offset } + site.Size + jump };
+                if (target < 0
+                    || target > std::numeric_limits<AbsoluteOffset>::max()
+                    || !IsInstructionBoundary(static_cast<AbsoluteOffset>(target)))
+                {
+                    throw std::runtime_error("Could not find an instruction by the given jump offset.");
+                }
+            }
+        }
+
+        const auto isBoundaryOrEnd = [this](const int64_t offset)
+        {
+            return offset == m_header.CodeSize()
+                || (offset < m_header.CodeSize() && IsInstructionBoundary(static_cast<AbsoluteOffset>(offset)));
+        };
+
+        for (const Section& section : m_sections)
+        {
+            for (const IMAGE_COR_ILMETHOD_SECT_EH_CLAUSE_FAT& clause : section.Clauses)
+            {
+                if (!isBoundaryOrEnd(clause.TryOffset)
+                    || !isBoundaryOrEnd(int64_t { clause.TryOffset } + clause.TryLength)
+                    || !isBoundaryOrEnd(clause.HandlerOffset)
+                    || !isBoundaryOrEnd(int64_t { clause.HandlerOffset } + clause.HandlerLength)
+                    || ((clause.Flags & COR_ILEXCEPTION_CLAUSE_FILTER) != 0 && !isBoundaryOrEnd(clause.FilterOffset)))
+                {
+                    throw std::runtime_error("Could not find an instruction by the given absolute offset.");
+                }
+            }
+        }
+    }
+
+    void MethodPatcher::Insert(const AbsoluteOffset offset, const std::span<const std::byte> code)
+    {
+        if (offset != m_header.CodeSize() && !IsInstructionBoundary(offset))
+        {
+            throw std::logic_error("Can insert only at the beginning of an instruction or at the end of the code");
+        }
+
+        if (!MethodHeader::IsValidCodeSize(int64_t { m_header.CodeSize() } + m_insertedCode.size() + code.size()))
+        {
+            throw std::overflow_error("There is no room in the target method to insert the new instructions");
+        }
+
+        m_layoutValid = false;
+        const auto position { std::upper_bound(
+            m_insertions.cbegin(),
+            m_insertions.cend(),
+            offset,
+            [](const AbsoluteOffset value, const Insertion& insertion)
+            {
+                return value < insertion.Offset;
+            }) };
+
+        m_insertions.insert(position, Insertion {
+            offset,
+            m_insertedCode.size(),
+            static_cast<AbsoluteOffset>(code.size()) });
+        m_insertedCode.insert(m_insertedCode.cend(), code.begin(), code.end());
+    }
+
+    void MethodPatcher::EnsureLayout() const
+    {
+        if (m_layoutValid)
+        {
+            return;
+        }
+
+        m_insertedSizes.assign(1, 0);
+        for (const Insertion& insertion : m_insertions)
+        {
+            m_insertedSizes.push_back(m_insertedSizes.back() + insertion.Size);
+        }
+
+        // Making an instruction long only moves other targets further,
+        // so only the remaining short instructions are checked again,
+        // until none of them changes, as MethodBody does.
+        m_widened.assign(m_branches.size(), false);
+        m_widenedOffsets.clear();
+        const std::span<const std::byte> code { Code() };
+        bool widenedMore;
+        do
+        {
+            widenedMore = false;
+            for (size_t i = 0; i != m_branches.size(); ++i)
+            {
+                const BranchSite& site { m_branches[i] };
+                if (site.ArgumentKind != OpCodeArgumentKind::ShortInlineBrTarget || m_widened[i])
+                {
+                    continue;
+                }
+
+                const ShortJump::Offset jump { ByteReader { code.subspan(site.Offset + site.CodeSize) }
+                    .Read<ShortJump::Offset>() };
+                if (!ShortJump::CanSafelyStoreOffset(NewJumpOffset(i, jump)))
+                {
+                    m_widened[i] = true;
+                    widenedMore = true;
+                }
+            }
+
+            if (widenedMore)
+            {
+                m_widenedOffsets.clear();
+                for (size_t i = 0; i != m_branches.size(); ++i)
+                {
+                    if (m_widened[i])
+                    {
+                        m_widenedOffsets.push_back(m_branches[i].Offset);
+                    }
+                }
+            }
+        } while (widenedMore);
+
+        m_layoutValid = true;
+    }
+
+    AbsoluteOffset MethodPatcher::GrowthBefore(
+        const AbsoluteOffset offset,
+        const bool includeInsertionsAtOffset) const
+    {
+        const auto insertionsEnd { includeInsertionsAtOffset
+            ? std::upper_bound(
+                m_insertions.cbegin(),
+                m_insertions.cend(),
+                offset,
+                [](const AbsoluteOffset value, const Insertion& insertion)
+                {
+                    return value < insertion.Offset;
+                })
+            : std::lower_bound(
+                m_insertions.cbegin(),
+                m_insertions.cend(),
+                offset,
+                [](const Insertion& insertion, const AbsoluteOffset value)
+                {
+                    return insertion.Offset < value;
+                }) };
+
+        // An instruction grows after its beginning, so
+        // only the instructions before the offset count.
+        const size_t widenedCount { static_cast<size_t>(std::lower_bound(
+            m_widenedOffsets.cbegin(),
+            m_widenedOffsets.cend(),
+            offset) - m_widenedOffsets.cbegin()) };
+
+        return m_insertedSizes[insertionsEnd - m_insertions.cbegin()]
+            + static_cast<AbsoluteOffset>(widenedCount) * s_LongFormGrowth;
+    }
+
+    AbsoluteOffset MethodPatcher::NewInstructionOffset(const AbsoluteOffset offset) const
+    {
+        return offset + GrowthBefore(offset, true);
+    }
+
+    AbsoluteOffset MethodPatcher::NewTargetOffset(const AbsoluteOffset offset) const
+    {
+        return offset + GrowthBefore(offset, false);
+    }
+
+    AbsoluteOffset MethodPatcher::NewBranchSize(const size_t index) const
+    {
+        return m_branches[index].Size + (m_widened[index] ? s_LongFormGrowth : 0);
+    }
+
+    int64_t MethodPatcher::NewJumpOffset(const size_t index, const LongJump::Offset originalJump) const
+    {
+        const BranchSite& site { m_branches[index] };
+        const AbsoluteOffset originalTarget { static_cast<AbsoluteOffset>(int64_t { site.Offset } + site.Size + originalJump) };
+        return int64_t { NewTargetOffset(originalTarget) }
+            - (int64_t { NewInstructionOffset(site.Offset) } + NewBranchSize(index));
+    }
+
+    AbsoluteOffset MethodPatcher::NewCodeSize() const
+    {
+        EnsureLayout();
+        return NewInstructionOffset(m_header.CodeSize());
+    }
+
+    IMAGE_COR_ILMETHOD_SECT_EH_CLAUSE_FAT MethodPatcher::PatchClause(
+        const IMAGE_COR_ILMETHOD_SECT_EH_CLAUSE_FAT& clause) const
+    {
+        IMAGE_COR_ILMETHOD_SECT_EH_CLAUSE_FAT result { clause };
+        result.TryOffset = NewTargetOffset(clause.TryOffset);
+        result.TryLength = NewTargetOffset(clause.TryOffset + clause.TryLength) - result.TryOffset;
+        result.HandlerOffset = NewTargetOffset(clause.HandlerOffset);
+        result.HandlerLength = NewTargetOffset(clause.HandlerOffset + clause.HandlerLength) - result.HandlerOffset;
+        if ((clause.Flags & COR_ILEXCEPTION_CLAUSE_FILTER) != 0)
+        {
+            result.FilterOffset = NewTargetOffset(clause.FilterOffset);
+        }
+
+        return result;
+    }
+
+    bool MethodPatcher::ShouldBeFat(const Section& section) const
+    {
+        return section.Fat || std::any_of(
+            section.Clauses.cbegin(),
+            section.Clauses.cend(),
+            [this](const IMAGE_COR_ILMETHOD_SECT_EH_CLAUSE_FAT& clause)
+            {
+                const IMAGE_COR_ILMETHOD_SECT_EH_CLAUSE_FAT patched { PatchClause(clause) };
+                return patched.TryOffset > s_MaxSmallClauseOffset
+                    || patched.TryLength > s_MaxSmallClauseLength
+                    || patched.HandlerOffset > s_MaxSmallClauseOffset
+                    || patched.HandlerLength > s_MaxSmallClauseLength;
+            });
+    }
+
+    MethodHeader MethodPatcher::NewHeader() const
+    {
+        MethodHeader result { m_header };
+        result.SetCodeSize(NewCodeSize());
+        return result;
+    }
+
+    size_t MethodPatcher::ComputePatchedSize() const
+    {
+        const MethodHeader header { NewHeader() };
+        size_t result { header.Size() + size_t { header.CodeSize() } };
+        if (m_header.HasExceptionsSections())
+        {
+            result += PaddingToBoundary<4>(result);
+            for (const Section& section : m_sections)
+            {
+                // same for SMALL and FAT, SMALL has padding for equal header sizes
+                result += sizeof(IMAGE_COR_ILMETHOD_SECT_FAT) + section.Clauses.size() * (ShouldBeFat(section)
+                    ? sizeof(IMAGE_COR_ILMETHOD_SECT_EH_CLAUSE_FAT)
+                    : sizeof(IMAGE_COR_ILMETHOD_SECT_EH_CLAUSE_SMALL));
+            }
+        }
+
+        return result;
+    }
+
+    void MethodPatcher::WriteBranch(const size_t index, ByteWriter& target) const
+    {
+        const BranchSite& site { m_branches[index] };
+        ByteReader reader { Code().subspan(site.Offset, site.Size) };
+        const std::span<const std::byte> code { reader.ReadBytes(site.CodeSize) };
+        switch (site.ArgumentKind)
+        {
+        case OpCodeArgumentKind::ShortInlineBrTarget:
+        {
+            const int64_t jump { NewJumpOffset(index, reader.Read<ShortJump::Offset>()) };
+            if (m_widened[index])
+            {
+                target.Write(LongBranchCode(code.front()));
+                target.Write(static_cast<LongJump::Offset>(jump));
+            }
+            else
+            {
+                target.WriteBytes(code);
+                target.Write(static_cast<ShortJump::Offset>(jump));
+            }
+
+            break;
+        }
+        case OpCodeArgumentKind::InlineBrTarget:
+        case OpCodeArgumentKind::InlineSwitch:
+        {
+            target.WriteBytes(code);
+            const uint32_t jumpsCount { site.ArgumentKind == OpCodeArgumentKind::InlineSwitch
+                ? reader.Read<uint32_t>()
+                : 1 };
+            if (site.ArgumentKind == OpCodeArgumentKind::InlineSwitch)
+            {
+                target.Write(jumpsCount);
+            }
+
+            for (uint32_t i = 0; i != jumpsCount; ++i)
+            {
+                const int64_t jump { NewJumpOffset(index, reader.Read<LongJump::Offset>()) };
+                if (!LongJump::CanSafelyStoreOffset(jump))
+                {
+                    throw std::overflow_error("The relative jump is too far and cannot be represented as a long jump");
+                }
+
+                target.Write(static_cast<LongJump::Offset>(jump));
+            }
+
+            break;
+        }
+        default:
+            throw std::logic_error("The instruction is not a branching instruction");
+        }
+    }
+
+    void MethodPatcher::WriteSection(const Section& section, ByteWriter& target) const
+    {
+        CorILMethodSect flags { CorILMethodSect::CorILMethod_Sect_EHTable };
+        const bool shouldBeFat { ShouldBeFat(section) };
+        if (shouldBeFat)
+        {
+            flags = static_cast<CorILMethodSect>(flags | CorILMethodSect::CorILMethod_Sect_FatFormat);
+        }
+
+        if (section.HasMoreSections)
+        {
+            flags = static_cast<CorILMethodSect>(flags | CorILMethodSect::CorILMethod_Sect_MoreSects);
+        }
+
+        // same for SMALL and FAT, SMALL has padding for equal header sizes
+        constexpr size_t headerSize = sizeof(IMAGE_COR_ILMETHOD_SECT_FAT);
+        if (shouldBeFat)
+        {
+            IMAGE_COR_ILMETHOD_SECT_FAT header;
+            header.Kind = flags;
+            header.DataSize = static_cast<unsigned>(
+                headerSize + sizeof(IMAGE_COR_ILMETHOD_SECT_EH_CLAUSE_FAT) * section.Clauses.size());
+            target.WriteRaw(header);
+            for (const IMAGE_COR_ILMETHOD_SECT_EH_CLAUSE_FAT& clause : section.Clauses)
+            {
+                target.WriteRaw(PatchClause(clause));
+            }
+        }
+        else
+        {
+            IMAGE_COR_ILMETHOD_SECT_SMALL header;
+            header.Kind = flags;
+            header.DataSize = static_cast<BYTE>(
+                headerSize + sizeof(IMAGE_COR_ILMETHOD_SECT_EH_CLAUSE_SMALL) * section.Clauses.size());
+            target.WriteRaw(header);
+            target.Write(decltype(std::declval<IMAGE_COR_ILMETHOD_SECT_EH_SMALL>().Reserved) { 0 });
+            for (const IMAGE_COR_ILMETHOD_SECT_EH_CLAUSE_FAT& clause : section.Clauses)
+            {
+                const IMAGE_COR_ILMETHOD_SECT_EH_CLAUSE_FAT patched { PatchClause(clause) };
+                IMAGE_COR_ILMETHOD_SECT_EH_CLAUSE_SMALL smallClause {};
+                smallClause.Flags = patched.Flags;
+                smallClause.TryOffset = patched.TryOffset;
+                smallClause.TryLength = patched.TryLength;
+                smallClause.HandlerOffset = patched.HandlerOffset;
+                smallClause.HandlerLength = patched.HandlerLength;
+                smallClause.ClassToken = patched.ClassToken;
+                target.WriteRaw(smallClause);
+            }
+        }
+    }
+
+    void MethodPatcher::PatchInto(std::span<std::byte> target) const
+    {
+        ByteWriter writer { target };
+        NewHeader().WriteToBytes(writer);
+
+        // One forward pass: copy the original bytes up to the next
+        // insertion or branching instruction, then write it.
+        const std::span<const std::byte> code { Code() };
+        AbsoluteOffset copied { 0 };
+        auto insertion { m_insertions.cbegin() };
+        const auto copyUpTo = [&](const AbsoluteOffset end)
+        {
+            for (; insertion != m_insertions.cend() && insertion->Offset <= end; ++insertion)
+            {
+                writer.WriteBytes(code.subspan(copied, insertion->Offset - copied));
+                writer.WriteBytes(std::span<const std::byte> { m_insertedCode }.subspan(insertion->Begin, insertion->Size));
+                copied = insertion->Offset;
+            }
+
+            writer.WriteBytes(code.subspan(copied, end - copied));
+            copied = end;
+        };
+
+        for (size_t i = 0; i != m_branches.size(); ++i)
+        {
+            copyUpTo(m_branches[i].Offset);
+            WriteBranch(i, writer);
+            copied += m_branches[i].Size;
+        }
+
+        copyUpTo(m_header.CodeSize());
+
+        if (m_header.HasExceptionsSections())
+        {
+            writer.AlignTo<4>();
+            for (const Section& section : m_sections)
+            {
+                WriteSection(section, writer);
+            }
+        }
+    }
+
+    std::vector<std::byte> MethodPatcher::Patch() const
+    {
+        std::vector<std::byte> result(ComputePatchedSize());
+        PatchInto(result);
+        return result;
+    }
+}
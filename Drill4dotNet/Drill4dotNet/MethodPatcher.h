@@ -0,0 +1,231 @@
+#pragma once
+
+#include "ByteUtils.h"
+#include "MethodHeader.h"
+#include "OpCodes.h"
+
+#include <span>
+#include <vector>
+
+namespace Drill4dotNet
+{
+    // Inserts instructions into method body bytes without decoding
+    // the method into MethodBody. Only instruction boundaries, branching
+    // instructions and exception clauses are read from the original bytes.
+    // On patching, the bytes between insertion points are copied as is,
+    // and only the arguments of branching instructions and switches, and
+    // the exception clauses offsets are rewritten. Short branching
+    // instructions get the long form, if their jumps become too far.
+    // Suits adding a few instructions to a big method.
+    // Reference: ECMA-335, Common Language Infrastructure,
+    // part II.25.4 Common Intermediate Language physical layout
+    // https://www.ecma-international.org/publications/files/ECMA-ST/ECMA-335.pdf
+    class MethodPatcher
+    {
+    private:
+        // A branching instruction or a switch of the original code.
+        struct BranchSite
+        {
+            // The offset of the instruction from the beginning of the code.
+            AbsoluteOffset Offset;
+
+            // The size of the whole instruction with its argument, in bytes.
+            AbsoluteOffset Size;
+
+            // The size of the instruction code, in bytes.
+            uint8_t CodeSize;
+
+            // ShortInlineBrTarget, InlineBrTarget, or InlineSwitch.
+            OpCodeArgumentKind ArgumentKind;
+        };
+
+        // Instructions queued for insertion.
+        struct Insertion
+        {
+            // The offset of the original instruction, before which to insert.
+            AbsoluteOffset Offset;
+
+            // The index of the first byte of the instructions in m_insertedCode.
+            size_t Begin;
+
+            // The size of the instructions, in bytes.
+            AbsoluteOffset Size;
+        };
+
+        // A section of exception handling clauses.
+        struct Section
+        {
+            // Value indicating whether the section has a fat header.
+            bool Fat;
+
+            // Value indicating whether more sections follow this one.
+            bool HasMoreSections;
+
+            // The clauses, with offsets in the original code.
+            // Small clauses are stored in the fat form.
+            std::vector<IMAGE_COR_ILMETHOD_SECT_EH_CLAUSE_FAT> Clauses;
+        };
+
+        // The original method body bytes.
+        std::span<const std::byte> m_body;
+
+        // The header of the original method.
+        MethodHeader m_header;
+
+        // The offsets of the original instructions, in ascending order.
+        std::vector<AbsoluteOffset> m_instructionOffsets;
+
+        // Branching instructions and switches of the original code, in ascending order.
+        std::vector<BranchSite> m_branches;
+
+        // Exception handling sections of the original method.
+        std::vector<Section> m_sections;
+
+        // Queued insertions, sorted by offset. Insertions
+        // at the same offset keep the order of the calls.
+        std::vector<Insertion> m_insertions;
+
+        // The bytes of all queued insertions.
+        std::vector<std::byte> m_insertedCode;
+
+        // For each count of first insertions, their total size.
+        // Rebuilt lazily, like the index of InstructionStream.
+        mutable std::vector<AbsoluteOffset> m_insertedSizes;
+
+        // For each element of m_branches, indicates whether
+        // the instruction is a short branching instruction,
+        // which has to get the long form.
+        mutable std::vector<bool> m_widened;
+
+        // The offsets of the original instructions, which
+        // have to get the long form, in ascending order.
+        mutable std::vector<AbsoluteOffset> m_widenedOffsets;
+
+        // Indicates whether m_insertedSizes, m_widened
+        // and m_widenedOffsets correspond to m_insertions.
+        mutable bool m_layoutValid { false };
+
+        // Gets the span of the original code bytes.
+        std::span<const std::byte> Code() const noexcept
+        {
+            return m_body.subspan(m_header.Size(), m_header.CodeSize());
+        }
+
+        // Reads the instruction boundaries and branching instructions of the code.
+        // Throws std::runtime_error if the code is malformed.
+        void ScanCode();
+
+        // Reads the exception handling sections following the code.
+        // Throws std::runtime_error if the sections are malformed.
+        void ReadSections();
+
+        // Throws std::runtime_error, if a jump or an exception clause
+        // points to the middle of an instruction.
+        void ValidateTargets() const;
+
+        // Gets the value indicating whether the given offset
+        // is the beginning of an original instruction.
+        // @param offset : the offset from the beginning of the code.
+        bool IsInstructionBoundary(const AbsoluteOffset offset) const;
+
+        // Computes m_insertedSizes and decides which short
+        // branching instructions have to get the long form,
+        // if they are not valid.
+        void EnsureLayout() const;
+
+        // Gets the amount of bytes the code grows by
+        // before the given offset of the original code.
+        // @param offset : the offset in the original code.
+        // @param includeInsertionsAtOffset : whether to count
+        //     the instructions inserted at the offset itself.
+        AbsoluteOffset GrowthBefore(
+            const AbsoluteOffset offset,
+            const bool includeInsertionsAtOffset) const;
+
+        // Gets the new offset of the original instruction.
+        // @param offset : the offset of the instruction in the original code.
+        AbsoluteOffset NewInstructionOffset(const AbsoluteOffset offset) const;
+
+        // Gets the new offset, which jumps and exception clauses
+        // pointing to the given offset must point to.
+        // The instructions inserted at the offset are included.
+        // @param offset : the offset in the original code.
+        AbsoluteOffset NewTargetOffset(const AbsoluteOffset offset) const;
+
+        // Gets the new size of the given branching instruction, in bytes.
+        // @param index : the index of the instruction in m_branches.
+        AbsoluteOffset NewBranchSize(const size_t index) const;
+
+        // Gets the jump offset to store in the given branching
+        // instruction, after the code is patched.
+        // @param index : the index of the instruction in m_branches.
+        // @param originalJump : the jump offset in the original code.
+        int64_t NewJumpOffset(const size_t index, const LongJump::Offset originalJump) const;
+
+        // Gets the size of the patched code, in bytes.
+        AbsoluteOffset NewCodeSize() const;
+
+        // Gets the method header of the patched code: the original one
+        // with the new code size, promoted to a fat one if the code no
+        // longer fits a tiny header.
+        MethodHeader NewHeader() const;
+
+        // Gets the value indicating whether the given section
+        // has to be written with the fat header after patching.
+        // @param section : the original section.
+        bool ShouldBeFat(const Section& section) const;
+
+        // Gets the clause with the offsets in the patched code.
+        // @param clause : the clause with the offsets in the original code.
+        IMAGE_COR_ILMETHOD_SECT_EH_CLAUSE_FAT PatchClause(
+            const IMAGE_COR_ILMETHOD_SECT_EH_CLAUSE_FAT& clause) const;
+
+        // Writes the given branching instruction with the new jump offsets.
+        // @param index : the index of the instruction in m_branches.
+        // @param target : the writer to write with.
+        void WriteBranch(const size_t index, ByteWriter& target) const;
+
+        // Writes the given exception handling section with the new offsets.
+        // @param section : the original section.
+        // @param target : the writer to write with.
+        void WriteSection(const Section& section, ByteWriter& target) const;
+
+    public:
+        // Reads the given method body bytes.
+        // Throws std::runtime_error if the bytes are malformed.
+        // @param bodyBytes : the bytes of method body,
+        //     must outlive the patcher.
+        explicit MethodPatcher(const std::vector<std::byte>& bodyBytes);
+
+        // Queues the given instructions for insertion before the original
+        // instruction at the given offset. Jumps and exception clauses,
+        // which pointed to that instruction, will point to the inserted
+        // instructions, as with MethodBody::Insert() at the position
+        // right after the labels of the instruction. Instructions inserted
+        // at the same offset keep the order of the calls.
+        // Throws std::logic_error if the offset is not
+        // the beginning of an instruction or the end of the code.
+        // @param offset : the offset from the beginning of the original code.
+        // @param code : the bytes of instructions to insert. Must not
+        //     contain jumps outside of the inserted instructions.
+        void Insert(const AbsoluteOffset offset, const std::span<const std::byte> code);
+
+        // Gets the size of the patched method body, in bytes.
+        size_t ComputePatchedSize() const;
+
+        // Writes the patched method body to the beginning of the
+        // given buffer, which must have at least ComputePatchedSize()
+        // bytes. Allows to patch directly into memory allocated
+        // by the runtime.
+        // A tiny header is promoted to a fat one, if the code grows
+        // too big for it.
+        // Throws std::overflow_error if the buffer is too small,
+        // or a jump becomes too far.
+        // @param target : the buffer to write to.
+        void PatchInto(std::span<std::byte> target) const;
+
+        // Makes the patched method body.
+        // Throws std::overflow_error if a jump becomes too far.
+        std::vector<std::byte> Patch() const;
+    };
+}
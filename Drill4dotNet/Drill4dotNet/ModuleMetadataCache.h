@@ -0,0 +1,141 @@
+#pragma once
+
+#include "framework.h"
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace Drill4dotNet
+{
+    // Keeps the metadata import object of each loaded module, so the
+    // metadata are opened once when the module loads, instead of on each
+    // callback needing them. The objects are shared with the callbacks
+    // using them, so a module unloading meanwhile does not destroy the
+    // object in use. Can be used from many threads at once.
+    // TMetadataImport : the metadata import object, need not be
+    //     copyable or movable.
+    template <typename TMetadataImport>
+    class ModuleMetadataCache
+    {
+    private:
+        // The metadata of one module, opened by the first caller asking
+        // for them. The other callers wait for the same result.
+        struct Entry
+        {
+            // Is given the opened metadata, or the error opening them.
+            std::promise<std::shared_ptr<const TMetadataImport>> Opening {};
+
+            // The result of Opening, shared by the callers
+            // which have come while the metadata were opened.
+            std::shared_future<std::shared_ptr<const TMetadataImport>> Opened { Opening.get_future().share() };
+
+            // The opened metadata, set once before IsOpened, so the
+            // later callers take them without waiting for Opened.
+            std::shared_ptr<const TMetadataImport> Metadata {};
+
+            // Whether Metadata have been set.
+            std::atomic<bool> IsOpened { false };
+        };
+
+        // Guards m_imports.
+        mutable std::shared_mutex m_mutex {};
+
+        // The metadata import objects by the modules.
+        std::unordered_map<ModuleID, std::shared_ptr<Entry>> m_imports {};
+
+    public:
+        // Gets the metadata of the module, opening them if they
+        // have not been opened since the module was loaded. The
+        // metadata are opened once for each module, even if many
+        // threads ask for them at once. The metadata are opened
+        // without holding the lock, so the callers asking for the
+        // other modules do not wait for the opening.
+        // TOpen : callable accepting ModuleID, returning TMetadataImport.
+        // @param moduleId : the module to get the metadata of.
+        // @param open : opens the metadata, the exceptions of which are
+        //     passed to the callers waiting for them.
+        template <typename TOpen>
+        std::shared_ptr<const TMetadataImport> Get(const ModuleID moduleId, TOpen&& open)
+        {
+            std::shared_ptr<Entry> entry {};
+            {
+                std::shared_lock lock { m_mutex };
+                if (const auto found { m_imports.find(moduleId) }
+                    ; found != m_imports.cend())
+                {
+                    if (found->second->IsOpened.load(std::memory_order_acquire))
+                    {
+                        return found->second->Metadata;
+                    }
+
+                    entry = found->second;
+                }
+            }
+
+            if (entry == nullptr)
+            {
+                const auto created { std::make_shared<Entry>() };
+                {
+                    std::unique_lock lock { m_mutex };
+                    entry = m_imports.try_emplace(moduleId, created).first->second;
+                }
+
+                if (entry == created)
+                {
+                    try
+                    {
+                        // Constructed in place, as the object may be not movable.
+                        entry->Metadata = std::shared_ptr<const TMetadataImport> { new TMetadataImport(open(moduleId)) };
+                        entry->IsOpened.store(true, std::memory_order_release);
+                        entry->Opening.set_value(entry->Metadata);
+                    }
+                    catch (...)
+                    {
+                        // Forgotten, so the next caller tries to open the metadata again.
+                        {
+                            std::unique_lock lock { m_mutex };
+                            if (const auto found { m_imports.find(moduleId) }
+                                ; found != m_imports.cend() && found->second == entry)
+                            {
+                                m_imports.erase(found);
+                            }
+                        }
+
+                        entry->Opening.set_exception(std::current_exception());
+                        throw;
+                    }
+                }
+            }
+
+            return entry->Opened.get();
+        }
+
+        // Forgets the metadata of the unloading module. The object
+        // is destroyed, when the last callback using it ends.
+        // @param moduleId : the module unloading.
+        void Release(const ModuleID moduleId)
+        {
+            std::unique_lock lock { m_mutex };
+            m_imports.erase(moduleId);
+        }
+
+        // Forgets the metadata of all modules.
+        void Clear()
+        {
+            std::unique_lock lock { m_mutex };
+            m_imports.clear();
+        }
+
+        // Gets the count of the modules, the metadata of which are
+        // kept or being opened.
+        size_t Size() const
+        {
+            std::shared_lock lock { m_mutex };
+            return m_imports.size();
+        }
+    };
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "OpCodes.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace Drill4dotNet
+{
+    // Describes an Intermediate Language instruction,
+    // allowing to decode it without knowing its OpCode::CEE_* type.
+    struct OpCodeInfo
+    {
+        // Indicates whether there is an instruction with this code.
+        bool IsDefined { false };
+
+        // The kind of the inline argument.
+        OpCodeArgumentKind ArgumentKind { OpCodeArgumentKind::InlineNone };
+
+        // The size of the inline argument, in bytes.
+        // For InlineSwitch and InlinePhi, it is the size of
+        // the elements count, which precedes the elements.
+        uint8_t ArgumentSize { 0 };
+
+        // How the instruction affects control flow.
+        OpCodeFlowBehavior FlowBehavior { OpCodeFlowBehavior::Next };
+
+        // The amount of items the instruction pops from the stack,
+        // std::nullopt if it depends on the usage context.
+        std::optional<uint8_t> ItemsPoppedFromStack {};
+
+        // The amount of items the instruction pushes onto the stack,
+        // std::nullopt if it depends on the usage context.
+        std::optional<uint8_t> ItemsPushedToStack {};
+    };
+
+    // Descriptions of instructions. The first array is indexed
+    // by the code of one-byte instructions, the second one is
+    // indexed by the second byte of two-byte instructions.
+    using OpCodeInfoTable = std::array<std::array<OpCodeInfo, 256>, 2>;
+
+    // The value opcode.def puts to the first byte
+    // of the codes of one-byte instructions.
+    inline constexpr std::byte OneByteOpCodeMarker { 0xFF };
+
+    // The first byte of two-byte instruction codes.
+    inline constexpr std::byte TwoByteOpCodePrefix { 0xFE };
+
+    // Gets the size of the given kind of inline argument, in bytes.
+    // TArgument : the inline argument type, see OpCodeArgumentType.
+    template <typename TArgument>
+    constexpr uint8_t OpCodeArgumentSize() noexcept
+    {
+        if constexpr (std::is_same_v<TArgument, OpCodeArgumentType::InlineNone>)
+        {
+            return 0;
+        }
+        else if constexpr (std::is_same_v<TArgument, OpCodeArgumentType::InlineSwitch>)
+        {
+            return sizeof(uint32_t);
+        }
+        else if constexpr (std::is_same_v<TArgument, OpCodeArgumentType::InlinePhi>)
+        {
+            return sizeof(uint8_t);
+        }
+        else if constexpr (std::is_same_v<TArgument, OpCodeArgumentType::InlineBrTarget>
+            || std::is_same_v<TArgument, OpCodeArgumentType::ShortInlineBrTarget>)
+        {
+            return sizeof(typename TArgument::Offset);
+        }
+        else
+        {
+            return sizeof(TArgument);
+        }
+    }
+
+    // Creates the description of the given instruction.
+    // TOpCode : one of OpCode::CEE_* classes.
+    template <IsOpCode TOpCode>
+    constexpr OpCodeInfo DescribeOpCode() noexcept
+    {
+        OpCodeInfo result {};
+        result.IsDefined = true;
+        result.ArgumentKind = TOpCode::ArgumentKind;
+        result.ArgumentSize = OpCodeArgumentSize<typename TOpCode::ArgumentType>();
+        result.FlowBehavior = TOpCode::FlowBehavior;
+        if constexpr (TOpCode::IsStackPopBehaviorKnown)
+        {
+            result.ItemsPoppedFromStack = static_cast<uint8_t>(TOpCode::ItemsPoppedFromStack);
+        }
+
+        if constexpr (TOpCode::IsStackPushBehaviorKnown)
+        {
+            result.ItemsPushedToStack = static_cast<uint8_t>(TOpCode::ItemsPushedToStack);
+        }
+
+        return result;
+    }
+
+    // Generates descriptions of all instructions from opcode.def.
+    constexpr OpCodeInfoTable BuildOpCodeInfoTable() noexcept
+    {
+        OpCodeInfoTable result {};
+
+#define OPDEF_REAL_INSTRUCTION( \
+    canonicalName, \
+    stringName, \
+    stackPop, \
+    stackPush, \
+    inlineArgumentType, \
+    operationKind, \
+    codeLength, \
+    byte1, \
+    byte2, \
+    controlBehavior) \
+        result[codeLength - 1][byte2] = DescribeOpCode<OpCode :: ## canonicalName>();
+
+#include "DefineOpCodesGeneratorSpecializations.h"
+#include <opcode.def>
+#include "UnDefineOpCodesGeneratorSpecializations.h"
+#undef OPDEF_REAL_INSTRUCTION
+
+        return result;
+    }
+
+    // Descriptions of all instructions, generated at compile time.
+    inline constexpr OpCodeInfoTable OpCodeInfos { BuildOpCodeInfoTable() };
+
+    // Gets the description of the one-byte instruction with the given code.
+    // @param code : the instruction code.
+    constexpr const OpCodeInfo& FindOneByteOpCode(const std::byte code) noexcept
+    {
+        return OpCodeInfos[0][static_cast<size_t>(code)];
+    }
+
+    // Gets the description of the two-byte instruction
+    // with the given second byte of the code.
+    // @param secondByte : the byte following TwoByteOpCodePrefix.
+    constexpr const OpCodeInfo& FindTwoByteOpCode(const std::byte secondByte) noexcept
+    {
+        return OpCodeInfos[1][static_cast<size_t>(secondByte)];
+    }
+}
@@ -3,29 +3,73 @@
 
 namespace Drill4dotNet
 {
-    OpCodeVariant::OpCodeVariant(
-        InstructionCode code,
-        VariantType argument)
-        : m_code(code),
-        m_argument { argument }
+    OpCodeVariant::OpCodeVariant() noexcept
+        : OpCodeVariant(OpCodeInstruction<OpCode::CEE_NOP>::Code)
     {
     }
 
-    OpCodeVariant::OpCodeVariant()
-        : m_code(OpCodeInstruction<OpCode::CEE_NOP>::Code),
-        m_argument {}
+    OpCodeVariant::OpCodeVariant(const OpCodeVariant& other)
+        : m_code { other.m_code },
+        m_kind { other.m_kind },
+        m_operand { other.m_operand }
     {
+        if (m_kind == OpCodeArgumentKind::InlineSwitch)
+        {
+            m_operand.Switch = new OpCodeArgumentType::InlineSwitch(*other.m_operand.Switch);
+        }
+        else if (m_kind == OpCodeArgumentKind::InlinePhi)
+        {
+            m_operand.Phi = new OpCodeArgumentType::InlinePhi(*other.m_operand.Phi);
+        }
+    }
+
+    OpCodeVariant& OpCodeVariant::operator=(const OpCodeVariant& other)
+    {
+        if (this != &other)
+        {
+            *this = OpCodeVariant(other);
+        }
+
+        return *this;
+    }
+
+    OpCodeVariant& OpCodeVariant::operator=(OpCodeVariant&& other) noexcept
+    {
+        if (this != &other)
+        {
+            ReleaseArgument();
+            m_code = other.m_code;
+            m_kind = other.m_kind;
+            m_operand = other.m_operand;
+            other.m_kind = OpCodeArgumentKind::InlineNone;
+        }
+
+        return *this;
+    }
+
+    void OpCodeVariant::ReleaseArgument() noexcept
+    {
+        if (m_kind == OpCodeArgumentKind::InlineSwitch)
+        {
+            delete m_operand.Switch;
+        }
+        else if (m_kind == OpCodeArgumentKind::InlinePhi)
+        {
+            delete m_operand.Phi;
+        }
+
+        m_kind = OpCodeArgumentKind::InlineNone;
     }
 
     bool OpCodeVariant::HasArgument() const
     {
-        return !std::holds_alternative<std::monostate>(m_argument);
+        return m_kind != OpCodeArgumentKind::InlineNone;
     }
 
     AbsoluteOffset OpCodeVariant::SizeWithArgument() const
     {
         AbsoluteOffset instructionSize { m_code.Size() };
-        return instructionSize + std::visit([](const auto& argument)
+        return instructionSize + VisitArgument([](const auto& argument)
             {
                 using T = std::decay_t<decltype(argument)>;
                 if constexpr (std::is_same_v<T, std::monostate>)
@@ -49,18 +93,17 @@ namespace Drill4dotNet
                 {
                     return static_cast<AbsoluteOffset>(sizeof(argument));
                 }
-            },
-            m_argument);
+            });
     }
 
-    void OpCodeVariant::InstructionCode::AppendToVector(std::vector<std::byte>& target) const
+    void OpCodeVariant::InstructionCode::WriteToBytes(ByteWriter& target) const
     {
         if (!IsOneByte())
         {
-            target.push_back(FirstByte);
+            target.Write(FirstByte);
         }
 
-        target.push_back(SecondByte);
+        target.Write(SecondByte);
     }
 
 
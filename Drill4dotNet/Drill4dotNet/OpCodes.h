@@ -1,6 +1,9 @@
 #pragma once
 
+#include <array>
+#include <bit>
 #include <cstdint>
+#include <cstring>
 #include <vector>
 #include <string_view>
 #include <optional>
@@ -194,6 +197,34 @@ namespace Drill4dotNet
         using ShortInlineBrTarget = ShortJump;
     };
 
+    // Kinds of instruction inline arguments, named exactly as
+    // opcode.def and OpCodeArgumentType name them.
+    enum class OpCodeArgumentKind : uint8_t
+    {
+        InlineNone,
+        InlineVar,
+        InlineI,
+        InlineR,
+        InlineBrTarget,
+        InlineI8,
+        InlineMethod,
+        InlineField,
+        InlineType,
+        InlineString,
+        InlineSig,
+        InlineRVA,
+        InlineTok,
+        InlineSwitch,
+        InlinePhi,
+        ShortInlineVar,
+        ShortInlineI,
+        ShortInlineR,
+        ShortInlineBrTarget
+    };
+
+    // The amount of values in OpCodeArgumentKind.
+    inline constexpr size_t OpCodeArgumentKindsCount { 19 };
+
     // How the instruction affect flow control.
     enum class OpCodeFlowBehavior
     {
@@ -521,6 +552,7 @@ namespace Drill4dotNet
     { \
     public: \
         inline static constexpr std::wstring_view CanonicalName { L ## stringName }; \
+        inline static constexpr OpCodeArgumentKind ArgumentKind { OpCodeArgumentKind:: ## inlineArgumentType }; \
         using OpCodeArgument::OpCodeArgument; \
     };
 #include "DefineOpCodesGeneratorSpecializations.h"
@@ -530,80 +562,30 @@ namespace Drill4dotNet
 
     }; // end of OpCode class
 
-    // Provides compile-time operations on a set of types.
-    template <typename ...>
-    class ParameterPack;
-
-    // Allows to merge two sets of types.
-    template <typename TPack1, typename TPack2>
-    class Tail;
-
-    // Merging two sets of types: primary specialization.
-    template <typename ... TFirst, typename ... TSecond>
-    class Tail<ParameterPack<TFirst ...>, ParameterPack<TSecond ...>>
-    {
-    public:
-        using Type = typename ParameterPack<TFirst ..., TSecond ...>;
-    };
-
-    // Compile-time operations for 1 type.
-    template <typename T>
-    class ParameterPack<T>
-    {
-    public:
-        // Applies the type to the given template.
-        template <template <typename T> class TTemplate>
-        using Apply = TTemplate<T>;
-
-        // Provides a set of types with removed duplicates.
-        using RemoveDuplicates = typename ParameterPack<T>;
-    };
-
-    // Compile-time operations for 2 or more types.
-    template <typename T, typename T2, typename ... Ts>
-    class ParameterPack<T, T2, Ts...>
-    {
-    public:
-        // Applies the given types to given template.
-        template <template <typename T, typename T2, typename ... Ts> class TTemplate>
-        using Apply = TTemplate<T, T2, Ts ...>;
-
-        // Provides a set of types with duplicates removed.
-        using RemoveDuplicates = typename std::conditional_t <
-            std::is_same_v<T, T2> || ( std::is_same_v<T, Ts> || ... ),
-            typename ParameterPack<T2, Ts ...>::RemoveDuplicates,
-            typename Tail<ParameterPack<T>, typename ParameterPack<T2, Ts ...>::RemoveDuplicates>::Type>;
-    };
-
     // Stores one of possible Intermediate Language instructions.
+    // Takes 16 bytes: inline arguments up to 8 bytes are stored
+    // in place, the jump tables of switch and the variables of
+    // phi are stored out of line. InstructionStream does not keep
+    // the variants, but their parts, in parallel arrays.
     class OpCodeVariant
     {
     private:
         friend class MethodBody;
+        friend class InstructionStream;
+
+        // Stores the inline argument. Which member is active
+        // is determined by the argument kind.
+        union Operand
+        {
+            // The binary representation of an argument of up to 8 bytes.
+            std::array<std::byte, sizeof(uint64_t)> Bytes;
 
-        // Variant which can store any possible inline argument type,
-        // std::monostate is for no inline argument case.
-        using VariantType = ParameterPack<
-            std::monostate,
-            OpCodeArgumentType::InlineBrTarget,
-            OpCodeArgumentType::InlineField,
-            OpCodeArgumentType::InlineI,
-            OpCodeArgumentType::InlineI8,
-            OpCodeArgumentType::InlineMethod,
-            OpCodeArgumentType::InlinePhi,
-            OpCodeArgumentType::InlineR,
-            OpCodeArgumentType::InlineRVA,
-            OpCodeArgumentType::InlineSig,
-            OpCodeArgumentType::InlineString,
-            OpCodeArgumentType::InlineSwitch,
-            OpCodeArgumentType::InlineTok,
-            OpCodeArgumentType::InlineType,
-            OpCodeArgumentType::InlineVar,
-            OpCodeArgumentType::ShortInlineBrTarget,
-            OpCodeArgumentType::ShortInlineI,
-            OpCodeArgumentType::ShortInlineR,
-            OpCodeArgumentType::ShortInlineVar
-        >::RemoveDuplicates::Apply<std::variant>;
+            // The jump table of a switch instruction.
+            OpCodeArgumentType::InlineSwitch* Switch;
+
+            // The variables of a phi instruction.
+            OpCodeArgumentType::InlinePhi* Phi;
+        };
 
         // Represents instruction code. Has maximum 2 bytes,
         // but some codes can be in 1-byte form.
@@ -638,9 +620,9 @@ namespace Drill4dotNet
                 return static_cast<uint16_t>(FirstByte) << 8 | static_cast<uint16_t>(SecondByte);
             }
 
-            // Append the binary representation to the given vector.
-            // @param target : the vector to append to.
-            void AppendToVector(std::vector<std::byte>& target) const;
+            // Writes the binary representation with the given writer.
+            // @param target : the writer to write with.
+            void WriteToBytes(ByteWriter& target) const;
 
             // Compares two codes for equality.
             constexpr bool operator==(const InstructionCode other) const
@@ -688,13 +670,137 @@ public: \
         // Stores the instruction code.
         InstructionCode m_code;
 
+        // The kind of the inline argument, tells which
+        // member of m_operand is active.
+        OpCodeArgumentKind m_kind;
+
         // Stores the inline argument.
-        VariantType m_argument;
+        Operand m_operand;
 
         // Intended to use from MethodBody.
+        // TArgument : the inline argument type, see OpCodeArgumentType.
+        // @param code : the instruction code.
+        // @param kind : the kind of the inline argument.
+        // @param argument : the inline argument.
+        template <typename TArgument>
         OpCodeVariant(
-            InstructionCode code,
-            VariantType argument);
+            const InstructionCode code,
+            const OpCodeArgumentKind kind,
+            TArgument argument)
+            : m_code { code },
+            m_kind { kind },
+            m_operand {}
+        {
+            SetArgument(std::move(argument));
+        }
+
+        // Intended to use from MethodBody, for instructions without inline argument.
+        // @param code : the instruction code.
+        explicit OpCodeVariant(const InstructionCode code) noexcept
+            : m_code { code },
+            m_kind { OpCodeArgumentKind::InlineNone },
+            m_operand {}
+        {
+        }
+
+        // Stores the given inline argument to m_operand.
+        // m_operand must not own an out of line argument.
+        // TArgument : the inline argument type, see OpCodeArgumentType.
+        // @param argument : the value to store.
+        template <typename TArgument>
+        void SetArgument(TArgument argument)
+        {
+            if constexpr (std::is_same_v<TArgument, OpCodeArgumentType::InlineSwitch>)
+            {
+                m_operand.Switch = new OpCodeArgumentType::InlineSwitch(std::move(argument));
+            }
+            else if constexpr (std::is_same_v<TArgument, OpCodeArgumentType::InlinePhi>)
+            {
+                m_operand.Phi = new OpCodeArgumentType::InlinePhi(std::move(argument));
+            }
+            else
+            {
+                static_assert(std::is_trivially_copyable_v<TArgument>);
+                static_assert(sizeof(TArgument) <= sizeof(Operand::Bytes));
+                m_operand.Bytes = {};
+                std::memcpy(m_operand.Bytes.data(), &argument, sizeof(TArgument));
+            }
+        }
+
+        // Gets the inline argument stored in m_operand.
+        // Does not do any checks, so made private.
+        // TArgument : the inline argument type, see OpCodeArgumentType.
+        template <typename TArgument>
+        decltype(auto) GetArgument() const noexcept
+        {
+            if constexpr (std::is_same_v<TArgument, OpCodeArgumentType::InlineSwitch>)
+            {
+                return static_cast<const OpCodeArgumentType::InlineSwitch&>(*m_operand.Switch);
+            }
+            else if constexpr (std::is_same_v<TArgument, OpCodeArgumentType::InlinePhi>)
+            {
+                return static_cast<const OpCodeArgumentType::InlinePhi&>(*m_operand.Phi);
+            }
+            else
+            {
+                std::array<std::byte, sizeof(TArgument)> bytes;
+                std::memcpy(bytes.data(), m_operand.Bytes.data(), sizeof(TArgument));
+                return std::bit_cast<TArgument>(bytes);
+            }
+        }
+
+        // Calls the visitor with the inline argument, or with
+        // std::monostate if the instruction has no inline argument.
+        // Returns the value the visitor returns.
+        // @param visitor : must accept each of OpCodeArgumentType types.
+        template <typename TVisitor>
+        auto VisitArgument(TVisitor&& visitor) const
+        {
+            switch (m_kind)
+            {
+            case OpCodeArgumentKind::InlineVar:
+                return visitor(GetArgument<OpCodeArgumentType::InlineVar>());
+            case OpCodeArgumentKind::InlineI:
+                return visitor(GetArgument<OpCodeArgumentType::InlineI>());
+            case OpCodeArgumentKind::InlineR:
+                return visitor(GetArgument<OpCodeArgumentType::InlineR>());
+            case OpCodeArgumentKind::InlineBrTarget:
+                return visitor(GetArgument<OpCodeArgumentType::InlineBrTarget>());
+            case OpCodeArgumentKind::InlineI8:
+                return visitor(GetArgument<OpCodeArgumentType::InlineI8>());
+            case OpCodeArgumentKind::InlineMethod:
+                return visitor(GetArgument<OpCodeArgumentType::InlineMethod>());
+            case OpCodeArgumentKind::InlineField:
+                return visitor(GetArgument<OpCodeArgumentType::InlineField>());
+            case OpCodeArgumentKind::InlineType:
+                return visitor(GetArgument<OpCodeArgumentType::InlineType>());
+            case OpCodeArgumentKind::InlineString:
+                return visitor(GetArgument<OpCodeArgumentType::InlineString>());
+            case OpCodeArgumentKind::InlineSig:
+                return visitor(GetArgument<OpCodeArgumentType::InlineSig>());
+            case OpCodeArgumentKind::InlineRVA:
+                return visitor(GetArgument<OpCodeArgumentType::InlineRVA>());
+            case OpCodeArgumentKind::InlineTok:
+                return visitor(GetArgument<OpCodeArgumentType::InlineTok>());
+            case OpCodeArgumentKind::InlineSwitch:
+                return visitor(GetArgument<OpCodeArgumentType::InlineSwitch>());
+            case OpCodeArgumentKind::InlinePhi:
+                return visitor(GetArgument<OpCodeArgumentType::InlinePhi>());
+            case OpCodeArgumentKind::ShortInlineVar:
+                return visitor(GetArgument<OpCodeArgumentType::ShortInlineVar>());
+            case OpCodeArgumentKind::ShortInlineI:
+                return visitor(GetArgument<OpCodeArgumentType::ShortInlineI>());
+            case OpCodeArgumentKind::ShortInlineR:
+                return visitor(GetArgument<OpCodeArgumentType::ShortInlineR>());
+            case OpCodeArgumentKind::ShortInlineBrTarget:
+                return visitor(GetArgument<OpCodeArgumentType::ShortInlineBrTarget>());
+            default:
+                return visitor(std::monostate {});
+            }
+        }
+
+        // Releases the out of line argument, if any.
+        void ReleaseArgument() noexcept;
 
         // Gets the opcode of the given type,
         // with the argument stored in this variant.
@@ -704,7 +810,7 @@ public: \
         {
             if constexpr (TOpCode::HasArgument())
             {
-                return TOpCode(std::get<TOpCode::ArgumentType>(m_argument));
+                return TOpCode(GetArgument<typename TOpCode::ArgumentType>());
             }
             else
             {
@@ -715,18 +821,54 @@ public: \
     public:
         // Constructs a variant holding OpCode::CEE_NOP instruction,
         // which means no operation.
-        OpCodeVariant();
+        OpCodeVariant() noexcept;
 
         // Constructs the variant holding the given opcode.
         // @param opCode : instruction to store.
         template <IsOpCode TOpCode>
         OpCodeVariant(const TOpCode opCode)
             : m_code (OpCodeInstruction<TOpCode>::Code),
-            m_argument{}
+            m_kind { TOpCode::ArgumentKind },
+            m_operand {}
         {
             if constexpr (TOpCode::HasArgument())
             {
-                m_argument = opCode.Argument();
+                SetArgument(opCode.Argument());
+            }
+        }
+
+        // Copies the instruction, including
+        // the out of line argument, if any.
+        // @param other : the instruction to copy.
+        OpCodeVariant(const OpCodeVariant& other);
+
+        // Takes the instruction, including
+        // the out of line argument, if any.
+        // @param other : the instruction to take.
+        OpCodeVariant(OpCodeVariant&& other) noexcept
+            : m_code { other.m_code },
+            m_kind { other.m_kind },
+            m_operand { other.m_operand }
+        {
+            // The other instruction no longer owns the out of line argument.
+            other.m_kind = OpCodeArgumentKind::InlineNone;
+        }
+
+        // Copies the instruction, including
+        // the out of line argument, if any.
+        // @param other : the instruction to copy.
+        OpCodeVariant& operator=(const OpCodeVariant& other);
+
+        // Takes the instruction, including
+        // the out of line argument, if any.
+        // @param other : the instruction to take.
+        OpCodeVariant& operator=(OpCodeVariant&& other) noexcept;
+
+        ~OpCodeVariant()
+        {
+            if (m_kind == OpCodeArgumentKind::InlineSwitch || m_kind == OpCodeArgumentKind::InlinePhi)
+            {
+                ReleaseArgument();
             }
         }
 
@@ -735,17 +877,7 @@ public: \
         template <IsOpCode TOpCode>
         OpCodeVariant& operator=(const TOpCode opCode)
         {
-            m_code = OpCodeInstruction<TOpCode>::Code;
-            if constexpr (TOpCode::HasArgument())
-            {
-                m_argument = opCode.Argument();
-            }
-            else
-            {
-                m_argument = std::monostate{};
-            }
-
-            return *this;
+            return *this = OpCodeVariant(opCode);
         }
 
         // Gets the value indicating whether the
@@ -853,7 +985,23 @@ public: \
         // @param other : the OpCodeVariant to compare with.
         bool operator==(const OpCodeVariant& other) const noexcept
         {
-            return m_code == other.m_code && m_argument == other.m_argument;
+            if (m_code != other.m_code || m_kind != other.m_kind)
+            {
+                return false;
+            }
+
+            return VisitArgument([&other](const auto& argument)
+                {
+                    using T = std::decay_t<decltype(argument)>;
+                    if constexpr (std::is_same_v<T, std::monostate>)
+                    {
+                        return true;
+                    }
+                    else
+                    {
+                        return argument == other.GetArgument<T>();
+                    }
+                });
         }
 
         // Compares with another OpCodeVariant.
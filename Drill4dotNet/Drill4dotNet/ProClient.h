@@ -17,7 +17,9 @@ namespace Drill4dotNet
         InfoHandler m_infoHandler;
         TConnector m_connector {
             std::function<std::vector<AstEntity>()>{},
-            std::function<void(const PackagesPrefixes&)>{} };
+            std::function<void(const PackagesPrefixes&)>{},
+            std::function<void(const SessionChange&)>{},
+            std::function<std::vector<ExecClassData>()>{} };
 
     public:
         ProClient()
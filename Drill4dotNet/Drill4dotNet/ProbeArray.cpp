@@ -0,0 +1,105 @@
+#include "pch.h"
+#include "ProbeArray.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace Drill4dotNet
+{
+    ProbeArray::ProbeArray(const size_t count)
+        : m_probes { std::make_unique<std::byte[]>(count) },
+        m_count { count }
+    {
+    }
+
+    uintptr_t ProbeArray::Address(const size_t probe) const
+    {
+        if (probe >= m_count)
+        {
+            throw std::logic_error("There is no probe with the given index.");
+        }
+
+        return reinterpret_cast<uintptr_t>(m_probes.get() + probe);
+    }
+
+    bool ProbeArray::IsHit(const size_t probe) const
+    {
+        if (probe >= m_count)
+        {
+            throw std::logic_error("There is no probe with the given index.");
+        }
+
+        // The instrumented code writes the byte behind the compiler's back.
+        return *static_cast<const volatile std::byte*>(m_probes.get() + probe) != std::byte { 0 };
+    }
+
+    std::vector<bool> ProbeArray::Hits() const
+    {
+        std::vector<bool> result(m_count);
+        for (size_t probe = 0; probe != m_count; ++probe)
+        {
+            result[probe] = IsHit(probe);
+        }
+
+        return result;
+    }
+
+    void ProbeArray::Reset() noexcept
+    {
+        std::fill_n(m_probes.get(), m_count, std::byte { 0 });
+    }
+
+    // Creates the instruction loading the given native address to
+    // the evaluation stack, see MakeNativeProbe and MakeNativeCounter.
+    // Throws std::logic_error if the pointer size is neither 4 nor 8
+    // bytes, or if the address does not fit the pointer.
+    // @param address : the address to load.
+    // @param pointerSize : the size of a native pointer, in bytes.
+    static OpCodeVariant MakeLoadAddress(
+        const uint64_t address,
+        const size_t pointerSize)
+    {
+        switch (pointerSize)
+        {
+        case sizeof(uint32_t):
+            if (address > std::numeric_limits<uint32_t>::max())
+            {
+                throw std::logic_error("The address does not fit a 32-bit pointer.");
+            }
+
+            return OpCode::CEE_LDC_I4 { static_cast<int32_t>(static_cast<uint32_t>(address)) };
+        case sizeof(uint64_t):
+            return OpCode::CEE_LDC_I8 { static_cast<int64_t>(address) };
+        default:
+            throw std::logic_error("Only 32-bit and 64-bit pointers are supported.");
+        }
+    }
+
+    std::array<OpCodeVariant, 4> MakeNativeProbe(
+        const uint64_t address,
+        const size_t pointerSize)
+    {
+        return {
+            MakeLoadAddress(address, pointerSize),
+            OpCode::CEE_CONV_U {},
+            OpCode::CEE_LDC_I4_1 {},
+            OpCode::CEE_STIND_I1 {}
+        };
+    }
+
+    std::array<OpCodeVariant, 8> MakeNativeCounter(
+        const uint64_t address,
+        const size_t pointerSize)
+    {
+        return {
+            MakeLoadAddress(address, pointerSize),
+            OpCode::CEE_CONV_U {},
+            OpCode::CEE_DUP {},
+            OpCode::CEE_LDIND_I8 {},
+            OpCode::CEE_LDC_I4_1 {},
+            OpCode::CEE_CONV_I8 {},
+            OpCode::CEE_ADD {},
+            OpCode::CEE_STIND_I8 {}
+        };
+    }
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "OpCodes.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Drill4dotNet
+{
+    // Native memory, which the probes inserted into methods write to.
+    // Each probe owns one byte, which becomes non-zero once the probe is
+    // hit. The bytes are allocated once and never move, so their addresses
+    // can be compiled into the code of methods. The array must outlive the
+    // code using it: the runtime never unloads the code of a method.
+    // The bytes are written by the instrumented code without synchronization,
+    // a hit becomes visible to the readers eventually.
+    class ProbeArray
+    {
+    private:
+        // The bytes of the probes.
+        std::unique_ptr<std::byte[]> m_probes;
+
+        // The count of probes.
+        size_t m_count;
+
+    public:
+        // Allocates the bytes for the given count of probes, none of them hit.
+        // @param count : the count of probes.
+        explicit ProbeArray(const size_t count);
+
+        // Gets the count of probes.
+        size_t Count() const noexcept
+        {
+            return m_count;
+        }
+
+        // Gets the native address of the byte of the given probe.
+        // Throws std::logic_error if there is no such probe.
+        // @param probe : the index of the probe.
+        uintptr_t Address(const size_t probe) const;
+
+        // Gets the value indicating whether the given probe has been hit.
+        // Throws std::logic_error if there is no such probe.
+        // @param probe : the index of the probe.
+        bool IsHit(const size_t probe) const;
+
+        // For each probe, gets whether it has been hit.
+        std::vector<bool> Hits() const;
+
+        // Marks all probes as not hit.
+        void Reset() noexcept;
+    };
+
+    // Creates the instructions storing 1 to the byte at the given native
+    // address: ldc.i8 address (ldc.i4 for 32-bit targets); conv.u; ldc.i4.1;
+    // stind.i1. The probe does not call methods, does not refer to metadata,
+    // and is not tracked by the garbage collector. It keeps the evaluation
+    // stack as is, but needs 2 more items on it, so the max stack must be
+    // computed again after the probes are inserted.
+    // Throws std::logic_error if the pointer size is neither 4 nor 8 bytes,
+    // or if the address does not fit the pointer.
+    // @param address : the address of the byte, usually ProbeArray::Address().
+    // @param pointerSize : the size of a native pointer of the target
+    //     process, in bytes. The profiler runs in the target process,
+    //     so the own pointer size suits it.
+    std::array<OpCodeVariant, 4> MakeNativeProbe(
+        const uint64_t address,
+        const size_t pointerSize = sizeof(void*));
+
+    // Creates the instructions adding 1 to the 64-bit counter at the given
+    // native address: ldc.i8 address (ldc.i4 for 32-bit targets); conv.u;
+    // dup; ldind.i8; ldc.i4.1; conv.i8; add; stind.i8. Like the probe, the
+    // counter does not call methods, does not refer to metadata, keeps
+    // the evaluation stack as is, and needs 3 more items on it. The
+    // counter is not incremented atomically, so the calls made by several
+    // threads at once may be counted once. The counter must be aligned
+    // to 8 bytes, so it is never read or written partially.
+    // Throws std::logic_error if the pointer size is neither 4 nor 8 bytes,
+    // or if the address does not fit the pointer.
+    // @param address : the address of the counter.
+    // @param pointerSize : the size of a native pointer of the target
+    //     process, in bytes, see MakeNativeProbe.
+    std::array<OpCodeVariant, 8> MakeNativeCounter(
+        const uint64_t address,
+        const size_t pointerSize = sizeof(void*));
+}
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+namespace Drill4dotNet
+{
+    // An array growing at the end, the elements of which never move.
+    // The elements are kept in segments: the first one has
+    // FirstSegmentSize elements, and each next one is twice as large
+    // as the previous one. So a scan over the elements goes over a few
+    // contiguous blocks of memory, and the code compiled with the address
+    // of an element can keep using it. One thread at a time may add
+    // elements, while other threads read the ones added before, see Size().
+    // T : the element, need not be copyable or movable.
+    template <typename T>
+    class SegmentedArray
+    {
+    private:
+        // The count of elements in the first segment.
+        inline static constexpr uint32_t FirstSegmentSize { 1024 };
+
+        // Enough segments for any 32-bit index.
+        inline static constexpr size_t MaxSegments {
+            32 - std::countr_zero(FirstSegmentSize) + 1 };
+
+        // The segments, allocated when the first element of each is added.
+        std::array<std::atomic<T*>, MaxSegments> m_segments {};
+
+        // The count of elements added.
+        std::atomic<uint32_t> m_size { 0 };
+
+        // Gets the segment of the element, and the index in the segment.
+        // @param index : the index of the element.
+        static std::pair<size_t, uint32_t> Locate(const uint32_t index) noexcept
+        {
+            const uint64_t position { uint64_t { index } + FirstSegmentSize };
+            const size_t segment { static_cast<size_t>(std::bit_width(position / FirstSegmentSize) - 1) };
+            return {
+                segment,
+                static_cast<uint32_t>(position - (uint64_t { FirstSegmentSize } << segment)) };
+        }
+
+    public:
+        SegmentedArray() = default;
+        SegmentedArray(const SegmentedArray&) = delete;
+        SegmentedArray& operator=(const SegmentedArray&) = delete;
+
+        ~SegmentedArray()
+        {
+            for (std::atomic<T*>& segment : m_segments)
+            {
+                delete[] segment.load(std::memory_order_relaxed);
+            }
+        }
+
+        // Adds an element, and returns its index. The element is
+        // value-initialized, then given to the initializer, and then
+        // becomes visible to the readers.
+        // Throws std::length_error if there are 2^32 - 1 elements already.
+        // TInitializer : callable accepting T&.
+        // @param initialize : sets the element up.
+        template <typename TInitializer>
+        uint32_t Add(TInitializer&& initialize)
+        {
+            const uint32_t index { m_size.load(std::memory_order_relaxed) };
+            if (index == UINT32_MAX)
+            {
+                throw std::length_error("Too many elements in SegmentedArray.");
+            }
+
+            const auto [segment, offset] { Locate(index) };
+            if (offset == 0)
+            {
+                m_segments[segment].store(
+                    new T[size_t { FirstSegmentSize } << segment] {},
+                    std::memory_order_release);
+            }
+
+            initialize(m_segments[segment].load(std::memory_order_relaxed)[offset]);
+            m_size.store(index + 1, std::memory_order_release);
+            return index;
+        }
+
+        // Adds a value-initialized element, and returns its index.
+        // Throws std::length_error if there are 2^32 - 1 elements already.
+        uint32_t Add()
+        {
+            return Add([](T&) {});
+        }
+
+        // Adds value-initialized elements up to the end of the segment
+        // the next element belongs to, allocating the segment once instead
+        // of adding the elements one by one. Returns the new count.
+        // Throws std::length_error if there are 2^32 - 1 elements already.
+        uint32_t AddSegment()
+        {
+            const uint32_t index { m_size.load(std::memory_order_relaxed) };
+            if (index == UINT32_MAX)
+            {
+                throw std::length_error("Too many elements in SegmentedArray.");
+            }
+
+            const auto [segment, offset] { Locate(index) };
+            if (offset == 0)
+            {
+                m_segments[segment].store(
+                    new T[size_t { FirstSegmentSize } << segment] {},
+                    std::memory_order_release);
+            }
+
+            const uint32_t size { static_cast<uint32_t>(std::min(
+                (uint64_t { FirstSegmentSize } << (segment + 1)) - FirstSegmentSize,
+                uint64_t { UINT32_MAX })) };
+
+            m_size.store(size, std::memory_order_release);
+            return size;
+        }
+
+        // Gets the count of elements. The elements with smaller
+        // indices can be read without other synchronization.
+        uint32_t Size() const noexcept
+        {
+            return m_size.load(std::memory_order_acquire);
+        }
+
+        // Gets the element by its index, which must be less than Size().
+        // @param index : the index of the element.
+        T& operator[](const uint32_t index) noexcept
+        {
+            const auto [segment, offset] { Locate(index) };
+            return m_segments[segment].load(std::memory_order_acquire)[offset];
+        }
+
+        // Gets the element by its index, which must be less than Size().
+        // @param index : the index of the element.
+        const T& operator[](const uint32_t index) const noexcept
+        {
+            const auto [segment, offset] { Locate(index) };
+            return m_segments[segment].load(std::memory_order_acquire)[offset];
+        }
+
+        // Calls the visitor with each element, in the order of indices,
+        // going over each segment as a contiguous block of memory.
+        // TVisitor : callable accepting const T&.
+        // @param visitor : is called with the elements.
+        template <typename TVisitor>
+        void ForEach(TVisitor&& visitor) const
+        {
+            const uint32_t size { Size() };
+            uint32_t visited { 0 };
+            for (size_t segment = 0; visited != size; ++segment)
+            {
+                const T* const elements { m_segments[segment].load(std::memory_order_acquire) };
+                const uint32_t count { static_cast<uint32_t>(std::min(
+                    uint64_t { FirstSegmentSize } << segment,
+                    uint64_t { size - visited })) };
+
+                for (uint32_t i = 0; i != count; ++i)
+                {
+                    visitor(elements[i]);
+                }
+
+                visited += count;
+            }
+        }
+    };
+}
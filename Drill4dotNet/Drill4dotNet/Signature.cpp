@@ -48,7 +48,12 @@ namespace Drill4dotNet
     static const std::byte s_TwoByteEncodingMarker { 0x80 };
     static const std::byte s_FourByteEncodingMarker{ 0xC0 };
 
-    std::vector<std::byte> CompressSignatureInteger(const int32_t signedValue)
+    // The markers of the compressed integer sizes,
+    // placed to the most significant bits of the value.
+    static const uint16_t s_TwoByteEncodingValueMarker { 0x8000 };
+    static const uint32_t s_FourByteEncodingValueMarker { 0xC000'0000 };
+
+    void CompressSignatureInteger(const int32_t signedValue, ByteWriter& target)
     {
         if (-(1 << 6) <= signedValue && signedValue <= (1 << 6) - 1)
         {
@@ -60,9 +65,7 @@ namespace Drill4dotNet
                 7,
                 1) };
 
-            return {
-                std::byte { value }
-            };
+            target.Write(value);
         }
         else if (-(1 << 13) <= signedValue && signedValue <= (1 << 13) - 1)
         {
@@ -74,10 +77,7 @@ namespace Drill4dotNet
                 14,
                 1) };
 
-            return {
-                s_TwoByteEncodingMarker | std::byte { value >> 8 },
-                std::byte { value }
-            };
+            target.Write<ByteOrder::BigEndian>(static_cast<uint16_t>(s_TwoByteEncodingValueMarker | value));
         }
         else if (MinCompressedSignatureInteger <= signedValue && signedValue <= MaxCompressedSignatureInteger)
         {
@@ -89,12 +89,7 @@ namespace Drill4dotNet
                 29,
                 1) };
 
-            return {
-                s_FourByteEncodingMarker | std::byte { value >> 24 },
-                std::byte { value >> 16 },
-                std::byte { value >> 8 },
-                std::byte { value }
-            };
+            target.Write<ByteOrder::BigEndian>(s_FourByteEncodingValueMarker | value);
         }
         else
         {
@@ -102,29 +97,19 @@ namespace Drill4dotNet
         }
     }
 
-    std::vector<std::byte> CompressSignatureInteger(const uint32_t unsignedValue)
+    void CompressSignatureInteger(const uint32_t unsignedValue, ByteWriter& target)
     {
         if (unsignedValue <= 0x7F)
         {
-            return {
-                std::byte { unsignedValue }
-            };
+            target.Write(static_cast<uint8_t>(unsignedValue));
         }
-        else if (0x80 <= unsignedValue && unsignedValue <= 0x3FFF)
+        else if (unsignedValue <= 0x3FFF)
         {
-            return {
-                s_TwoByteEncodingMarker | std::byte { unsignedValue >> 8 },
-                std::byte { unsignedValue }
-            };
+            target.Write<ByteOrder::BigEndian>(static_cast<uint16_t>(s_TwoByteEncodingValueMarker | unsignedValue));
         }
         else if (unsignedValue <= MaxCompressedSignatureUnsignedInteger)
         {
-            return {
-                s_FourByteEncodingMarker | std::byte { unsignedValue >> 24 },
-                std::byte { unsignedValue >> 16 },
-                std::byte { unsignedValue >> 8 },
-                std::byte { unsignedValue }
-            };
+            target.Write<ByteOrder::BigEndian>(s_FourByteEncodingValueMarker | unsignedValue);
         }
         else
         {
@@ -132,6 +117,22 @@ namespace Drill4dotNet
         }
     }
 
+    std::vector<std::byte> CompressSignatureInteger(const int32_t signedValue)
+    {
+        std::vector<std::byte> result{};
+        ByteWriter writer { result };
+        CompressSignatureInteger(signedValue, writer);
+        return result;
+    }
+
+    std::vector<std::byte> CompressSignatureInteger(const uint32_t unsignedValue)
+    {
+        std::vector<std::byte> result{};
+        ByteWriter writer { result };
+        CompressSignatureInteger(unsignedValue, writer);
+        return result;
+    }
+
     class DecomplessIntegerCoreResult
     {
     public:
@@ -161,39 +162,27 @@ namespace Drill4dotNet
             throw std::runtime_error("Encoded integer value ended expectedly");
         }
 
+        ByteReader reader { std::span<const std::byte> { &*integerPosition, size } };
         if (size == 1)
         {
             return {
-                static_cast<uint32_t>(firstByte),
+                reader.Read<uint8_t>(),
                 7,
                 size
             };
         }
 
-        std::vector<std::byte>::const_iterator position { integerPosition };
-        ++position;
-        const std::byte secondByte { *position };
         if (size == 2)
         {
             return {
-                (static_cast<uint32_t>(firstByte & ~s_TwoByteEncodingMarker) << 8)
-                    | static_cast<uint32_t>(secondByte),
+                static_cast<uint32_t>(reader.Read<uint16_t, ByteOrder::BigEndian>() & ~s_TwoByteEncodingValueMarker),
                 14,
                 size
             };
         }
 
-        ++position;
-        const std::byte thirdByte { *position };
-
-        ++position;
-        const std::byte forthByte { *position };
-
         return {
-            (static_cast<uint32_t>(firstByte & ~s_FourByteEncodingMarker) << 24)
-                | (static_cast<uint32_t>(secondByte) << 16)
-                | (static_cast<uint32_t>(thirdByte) << 8)
-                | static_cast<uint32_t>(forthByte),
+            reader.Read<uint32_t, ByteOrder::BigEndian>() & ~s_FourByteEncodingValueMarker,
             29,
             size
         };
@@ -457,24 +446,15 @@ namespace Drill4dotNet
             firstByte |= std::byte { IMAGE_CEE_CS_CALLCONV_GENERIC };
         }
 
-        target.push_back(firstByte);
+        ByteWriter writer { target };
+        writer.Write(firstByte);
 
         if (m_genericParameters.has_value())
         {
-            const std::vector<std::byte> genericParametersCount {
-                CompressSignatureInteger(static_cast<uint32_t>(*m_genericParameters)) };
-            std::copy(
-                genericParametersCount.cbegin(),
-                genericParametersCount.cend(),
-                std::back_inserter(target));
+            CompressSignatureInteger(static_cast<uint32_t>(*m_genericParameters), writer);
         }
 
-        const std::vector<std::byte> parametersCount {
-            CompressSignatureInteger(static_cast<uint32_t>(m_parameterTypes.size())) };
-        std::copy(
-            parametersCount.cbegin(),
-            parametersCount.cend(),
-            std::back_inserter(target));
+        CompressSignatureInteger(static_cast<uint32_t>(m_parameterTypes.size()), writer);
 
         m_returnType.AppendToBytes(target);
 
@@ -533,30 +513,19 @@ namespace Drill4dotNet
 
     void ArrayShape::AppendToBytes(std::vector<std::byte>& target) const
     {
-        const std::vector<std::byte> rankBytes { CompressSignatureInteger(Rank) };
-        target.insert(
-            target.cend(),
-            rankBytes.cbegin(),
-            rankBytes.cend());
+        ByteWriter writer { target };
+        CompressSignatureInteger(Rank, writer);
 
         if (Sizes.size() > MaxCompressedSignatureUnsignedInteger)
         {
             throw std::runtime_error("The Sizes vector contains too much elements to store in an ArrayShape");
         }
 
-        const std::vector<std::byte> numSizesBytes { CompressSignatureInteger(static_cast<uint32_t>(Sizes.size())) };
-        target.insert(
-            target.cend(),
-            numSizesBytes.cbegin(),
-            numSizesBytes.cend());
+        CompressSignatureInteger(static_cast<uint32_t>(Sizes.size()), writer);
 
         for (const auto& size : Sizes)
         {
-            const std::vector<std::byte> sizeBytes { CompressSignatureInteger(size) };
-            target.insert(
-                target.cend(),
-                sizeBytes.cbegin(),
-                sizeBytes.cend());
+            CompressSignatureInteger(size, writer);
         }
 
         if (LowerBounds.size() > MaxCompressedSignatureUnsignedInteger)
@@ -564,19 +533,11 @@ namespace Drill4dotNet
             throw std::runtime_error("The LowerBounds vector contains too much elements to store in an ArrayShape");
         }
 
-        const std::vector<std::byte> lowerBoundsBytes { CompressSignatureInteger(static_cast<uint32_t>(LowerBounds.size())) };
-        target.insert(
-            target.cend(),
-            lowerBoundsBytes.cbegin(),
-            lowerBoundsBytes.cend());
+        CompressSignatureInteger(static_cast<uint32_t>(LowerBounds.size()), writer);
 
         for (const auto& bound : LowerBounds)
         {
-            const std::vector<std::byte> boundBytes { CompressSignatureInteger(bound) };
-            target.insert(
-                target.cend(),
-                boundBytes.cbegin(),
-                boundBytes.cend());
+            CompressSignatureInteger(bound, writer);
         }
     }
 
@@ -625,11 +586,8 @@ namespace Drill4dotNet
         }
 
         intermediate |= ((typeToken & 0x00FF'FFFF) << 2);
-        const std::vector<std::byte> tokenBytes { CompressSignatureInteger(intermediate) };
-        target.insert(
-            target.cend(),
-            tokenBytes.cbegin(),
-            tokenBytes.cend());
+        ByteWriter writer { target };
+        CompressSignatureInteger(intermediate, writer);
     }
 
     std::optional<ParseResult<CustomMod>> CustomMod::Parse(
@@ -809,11 +767,8 @@ namespace Drill4dotNet
             throw std::runtime_error("The signature contains too many generic parameters to be stored");
         }
 
-        const std::vector<std::byte> parametersCount { CompressSignatureInteger(static_cast<uint32_t>(GenericParameters.size())) };
-        std::copy(
-            parametersCount.cbegin(),
-            parametersCount.cend(),
-            std::back_inserter(target));
+        ByteWriter writer { target };
+        CompressSignatureInteger(static_cast<uint32_t>(GenericParameters.size()), writer);
 
         for (const auto& genericParameter : GenericParameters)
         {
@@ -831,11 +786,8 @@ namespace Drill4dotNet
 
     void MethodGenericArgument::AppendToBytes(std::vector<std::byte>& target) const
     {
-        const std::vector<std::byte> compressed { CompressSignatureInteger(Index) };
-        std::copy(
-            compressed.cbegin(),
-            compressed.cend(),
-            std::back_inserter(target));
+        ByteWriter writer { target };
+        CompressSignatureInteger(Index, writer);
     }
 
     ParseResult<TypeGenericArgument> TypeGenericArgument::Parse(
@@ -848,11 +800,8 @@ namespace Drill4dotNet
 
     void TypeGenericArgument::AppendToBytes(std::vector<std::byte>& target) const
     {
-        const std::vector<std::byte> compressed { CompressSignatureInteger(Index) };
-        std::copy(
-            compressed.cbegin(),
-            compressed.cend(),
-            std::back_inserter(target));
+        ByteWriter writer { target };
+        CompressSignatureInteger(Index, writer);
     }
 
     ParseResult<PointerType> PointerType::Parse(
@@ -6,6 +6,7 @@
 #include <variant>
 #include <vector>
 #include "OutputUtils.h"
+#include "ByteUtils.h"
 
 namespace Drill4dotNet
 {
@@ -36,6 +37,21 @@ namespace Drill4dotNet
     //     should less than MaxCompressedSignatureUnsignedInteger.
     std::vector<std::byte> CompressSignatureInteger(const uint32_t unsignedValue);
 
+    // Compresses the given signed value to the form
+    // that can be used in method signature blobs.
+    // @param signedValue : the value to compress,
+    //     should be between MinCompressedSignatureInteger
+    //     and MaxCompressedSignatureInteger.
+    // @param target : the writer to write the compressed value with.
+    void CompressSignatureInteger(const int32_t signedValue, ByteWriter& target);
+
+    // Compresses the given unsigned value to the form
+    // that can be used in method signature blobs.
+    // @param unsignedValue : the value to compress,
+    //     should less than MaxCompressedSignatureUnsignedInteger.
+    // @param target : the writer to write the compressed value with.
+    void CompressSignatureInteger(const uint32_t unsignedValue, ByteWriter& target);
+
     // Stores the output produced by Parse methods.
     template <typename T>
     class ParseResult
@@ -0,0 +1,194 @@
+#include "pch.h"
+#include "StackDepth.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace Drill4dotNet
+{
+    // The amounts of items an instruction pops from
+    // the evaluation stack and pushes onto it.
+    struct StackEffect
+    {
+        // The amount of items popped.
+        int32_t Popped;
+
+        // The amount of items pushed.
+        int32_t Pushed;
+    };
+
+    // Gets how the instruction at the given position changes the
+    // evaluation stack. Reads the arrays of the stream, so the
+    // instruction is not made.
+    // @param instruction : the position of the instruction to inspect.
+    // @param getCallSignature : gets the signatures of the called methods.
+    static StackEffect GetStackEffect(
+        const ConstStreamPosition instruction,
+        const CallSignatureProvider& getCallSignature)
+    {
+        const OpCodeInfo& info { instruction.Info() };
+        if (info.ItemsPoppedFromStack.has_value() && info.ItemsPushedToStack.has_value())
+        {
+            return { *info.ItemsPoppedFromStack, *info.ItemsPushedToStack };
+        }
+
+        if (instruction.Holds<OpCode::CEE_RET>())
+        {
+            // The returned value, if any, is the only item
+            // on the stack, and nothing is executed after ret.
+            return { 0, 0 };
+        }
+
+        const bool isCalli { instruction.Holds<OpCode::CEE_CALLI>() };
+        if (!isCalli
+            && !instruction.Holds<OpCode::CEE_CALL>()
+            && !instruction.Holds<OpCode::CEE_CALLVIRT>()
+            && !instruction.Holds<OpCode::CEE_NEWOBJ>())
+        {
+            throw std::logic_error("Only calls depend on the signature");
+        }
+
+        const mdToken token { isCalli
+            ? instruction.Argument<OpCodeArgumentType::InlineSig>()
+            : instruction.Argument<OpCodeArgumentType::InlineMethod>() };
+        const MethodSignature signature { getCallSignature(token) };
+        StackEffect result { static_cast<int32_t>(signature.ParameterTypes().size()), 0 };
+        if (instruction.Holds<OpCode::CEE_NEWOBJ>())
+        {
+            // The constructor gets the new object as "this",
+            // which is pushed instead of being popped.
+            result.Pushed = 1;
+            return result;
+        }
+
+        if (signature.ThisUsage() == MethodThisUsage::This)
+        {
+            ++result.Popped;
+        }
+
+        if (isCalli)
+        {
+            // The function pointer.
+            ++result.Popped;
+        }
+
+        result.Pushed = signature.ReturnType().PassDescription.has_value() ? 1 : 0;
+        return result;
+    }
+
+    // Gets the value indicating whether the instruction at the
+    // given position is leave, which empties the evaluation stack.
+    // @param instruction : the position of the instruction to inspect.
+    static bool IsLeave(const ConstStreamPosition instruction) noexcept
+    {
+        return !instruction.IsLabel()
+            && (instruction.Holds<OpCode::CEE_LEAVE>() || instruction.Holds<OpCode::CEE_LEAVE_S>());
+    }
+
+    uint16_t ComputeMaxStack(
+        const MethodBody& method,
+        const ControlFlowGraph& graph,
+        const CallSignatureProvider& getCallSignature)
+    {
+        if (method.IsEditInProgress())
+        {
+            throw std::logic_error("Cannot compute the stack depth while an edit is in progress");
+        }
+
+        constexpr int32_t unreached { -1 };
+        const InstructionStream& stream { method.Stream() };
+        const std::pmr::vector<BasicBlock>& blocks { graph.Blocks() };
+        std::pmr::memory_resource* const resource { blocks.get_allocator().resource() };
+        std::pmr::vector<int32_t> entryDepths(blocks.size(), unreached, resource);
+        std::pmr::vector<BlockIndex> pending { resource };
+        const auto reach = [&entryDepths, &pending](const BlockIndex block, const int32_t depth)
+        {
+            if (entryDepths[block] == unreached)
+            {
+                entryDepths[block] = depth;
+                pending.push_back(block);
+            }
+            else if (entryDepths[block] != depth)
+            {
+                throw std::runtime_error("The evaluation stack has different depths on different paths to the same instruction.");
+            }
+        };
+
+        // Gets the block a handler or a filter starts with.
+        const auto handlerBlock = [&graph](const Label start)
+        {
+            const BlockIndex result { graph.BlockOf(start) };
+            if (result == NoBlock)
+            {
+                throw std::runtime_error("An exception handler does not start at an instruction of the method.");
+            }
+
+            return result;
+        };
+
+        if (!blocks.empty())
+        {
+            reach(0, 0);
+        }
+
+        for (const ExceptionsSection& section : method.ExceptionSections())
+        {
+            for (const ExceptionClause& clause : section.Clauses())
+            {
+                reach(handlerBlock(clause.HandlerOffset()), clause.IsFinally() ? 0 : 1);
+                const std::variant<mdTypeDef, Label> handler { clause.Handler() };
+                if (const Label* filter = std::get_if<Label>(&handler)
+                    ; filter != nullptr)
+                {
+                    reach(handlerBlock(*filter), 1);
+                }
+            }
+        }
+
+        int32_t result { 0 };
+        while (!pending.empty())
+        {
+            const BlockIndex block { pending.back() };
+            pending.pop_back();
+
+            int32_t depth { entryDepths[block] };
+            result = std::max(result, depth);
+            const ConstStreamPosition blockEnd { stream.cbegin() + blocks[block].End };
+            for (ConstStreamPosition current { stream.cbegin() + blocks[block].Begin }; current != blockEnd; ++current)
+            {
+                if (!current.IsLabel())
+                {
+                    const StackEffect effect { GetStackEffect(current, getCallSignature) };
+                    if (effect.Popped > depth)
+                    {
+                        throw std::runtime_error("An instruction pops more items than the evaluation stack has.");
+                    }
+
+                    depth += effect.Pushed - effect.Popped;
+                    result = std::max(result, depth);
+                }
+            }
+
+            if (IsLeave(stream.cbegin() + blocks[block].Last))
+            {
+                depth = 0;
+            }
+
+            for (const ControlFlowEdge& edge : graph.Successors(block))
+            {
+                // The handlers have been reached from the clauses.
+                if (edge.Kind != EdgeKind::Exception)
+                {
+                    reach(edge.Block, depth);
+                }
+            }
+        }
+
+        if (result > std::numeric_limits<uint16_t>::max())
+        {
+            throw std::overflow_error("The evaluation stack is deeper than a method header can declare.");
+        }
+
+        return static_cast<uint16_t>(result);
+    }
+}
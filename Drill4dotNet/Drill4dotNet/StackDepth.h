@@ -0,0 +1,38 @@
+#pragma once
+
+#include "ControlFlowGraph.h"
+#include "Signature.h"
+
+#include <functional>
+
+namespace Drill4dotNet
+{
+    // Gets the signature of the method called by an instruction.
+    // Accepts the token of the call, callvirt, or newobj instruction:
+    // mdMethodDef, mdMemberRef, or mdMethodSpec, in the last case the
+    // signature of the generic method is expected. Accepts the mdSignature
+    // token of the calli instruction.
+    using CallSignatureProvider = std::function<MethodSignature(const mdToken)>;
+
+    // Computes the maximal amount of items on the evaluation stack
+    // of the given method, to be declared in the method header.
+    // Follows the stack depth from the entry and from the beginning
+    // of each handler and filter through the basic blocks: catch
+    // handlers and filters start with the exception object on the
+    // stack, finally and fault handlers, and the targets of leave
+    // start with the empty stack. The stack effect of call, callvirt,
+    // newobj, and calli is taken from the signature of the called method.
+    // Takes the time linear in the size of the method, and calls
+    // getCallSignature once for each call instruction reached.
+    // Throws std::runtime_error if an instruction pops more items than
+    // the stack has, or if the stack has different depths on different
+    // paths to the same block. Throws std::overflow_error if the stack
+    // is deeper than a method header can declare.
+    // @param method : the method to inspect. An edit must not be in progress.
+    // @param graph : the control flow graph of the method.
+    // @param getCallSignature : gets the signatures of the called methods.
+    uint16_t ComputeMaxStack(
+        const MethodBody& method,
+        const ControlFlowGraph& graph,
+        const CallSignatureProvider& getCallSignature);
+}